@@ -0,0 +1,987 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+/*
+	Server hot path microbenchmarks
+
+	Times the steps every measurement request goes through: the http and xml request parsing,
+	the netlist parsing, solving and subset check against the maxlists, the equipment response
+	parsing and the xml response with full oscilloscope graphs.
+
+	Every benchmark is warmed up and then timed as a number of samples, each a batch of
+	iterations. The iteration count is calibrated so a sample takes at least the minimum
+	sample time unless it's given with -i. Results are nanoseconds per operation.
+
+	The sample request and circuit are embedded, recorded requests can be added with -q.
+	The component definitions and maxlists are read like the server reads them, run it from bin.
+
+	With -S the request schedulers are run through fixed scenarios instead and the order the
+	requests come out in is checked, and so are the circuit orders sent to the equipment server.
+	The exit code is nonzero if one of them fails.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+
+#include <contrib/base64.h>
+#include <eqcom/circuit.h>
+#include <eqcom/symbols.h>
+#include <httpserver/httprequest.h>
+#include <instruments/circuitlist.h>
+#include <instruments/circuitsolver3.h>
+#include <instruments/compdefreader.h>
+#include <instruments/instrumentblock.h>
+#include <instruments/listparser.h>
+#include <instruments/listproducer.h>
+#include <instruments/netlist2.h>
+#include <instruments/oscilloscope.h>
+#include <instruments/channel.h>
+#include <instruments/measurement.h>
+#include <instruments/trigger.h>
+#include <measureserver/client.h>
+#include <measureserver/request.h>
+#include <measureserver/requestqueue.h>
+#include <measureserver/requestscheduler.h>
+#include <protocol/protocol.h>
+#include <xmlprotocol/producer.h>
+#include <xmlprotocol/requestparser.h>
+#include <xmlutil/domparser.h>
+
+#include <util/basic_exception.h>
+#include <util/serializer.h>
+#include <util/stringop.h>
+#include <util/timer.h>
+
+using namespace std;
+
+/// Samples per channel in the oscilloscope benchmarks, the equipment allows up to 20000
+static const int cOscSamples = 2500;
+
+/// Components in the large maxlist made for the parser, larger than any real list
+static const int cLargeListComponents = 10000;
+
+/// Resistors in the chain circuit walked by tier one, far more than a breadboard holds
+static const int cLargeCircuitComponents = 2000;
+
+/// Results are added here so the compiler can't drop the benchmarked calls
+volatile size_t gSink = 0;
+
+static const char* sRequest =
+	"<protocol version=\"1.3\"><request sessionkey=\"d5f0e4c4a1b2c3d4e5f60718293a4b5c\">"
+	"<functiongenerator id=\"1\">"
+		"<fg_waveform value=\"sine\"/><fg_amplitude value=\"1.0\"/><fg_frequency value=\"1000\"/>"
+		"<fg_offset value=\"0\"/><fg_startphase value=\"0\"/><fg_triggermode value=\"continous\"/>"
+		"<fg_triggersource value=\"immediate\"/><fg_burstcount value=\"0\"/><fg_dutycycle value=\"0.5\"/>"
+	"</functiongenerator>"
+	"<oscilloscope id=\"1\">"
+		"<horizontal><horz_samplerate value=\"500000\"/><horz_refpos value=\"50\"/><horz_recordlength value=\"2500\"/></horizontal>"
+		"<channels>"
+			"<channel number=\"1\"><chan_enabled value=\"1\"/><chan_coupling value=\"dc\"/><chan_range value=\"1\"/>"
+				"<chan_offset value=\"0\"/><chan_attenuation value=\"1\"/></channel>"
+			"<channel number=\"2\"><chan_enabled value=\"1\"/><chan_coupling value=\"dc\"/><chan_range value=\"1\"/>"
+				"<chan_offset value=\"0\"/><chan_attenuation value=\"1\"/></channel>"
+		"</channels>"
+		"<trigger><trig_source value=\"channel 1\"/><trig_slope value=\"positive\"/><trig_coupling value=\"dc\"/>"
+			"<trig_level value=\"0\"/><trig_mode value=\"autolevel\"/><trig_timeout value=\"1\"/><trig_delay value=\"0\"/></trigger>"
+		"<measurements>"
+			"<measurement number=\"1\"><meas_channel value=\"channel 1\"/><meas_selection value=\"frequency\"/></measurement>"
+			"<measurement number=\"2\"><meas_channel value=\"channel 2\"/><meas_selection value=\"none\"/></measurement>"
+			"<measurement number=\"3\"><meas_channel value=\"channel 1\"/><meas_selection value=\"none\"/></measurement>"
+		"</measurements>"
+	"</oscilloscope>"
+	"<multimeter id=\"1\"><dmm_function value=\"dc volts\"/><dmm_resolution value=\"3.5\"/><dmm_range value=\"-1\"/></multimeter>"
+	"<circuit><circuitlist>"
+		"W_X A26 0&#10;W_X A22 F22&#10;W_X F30 0&#10;R_X A14 A18 1k&#10;R_X A10 A14 1.8k&#10;R_X A6 A10 1.5k&#10;"
+		"R_X A18 A22 10k&#10;R_X A22 A26 82k&#10;R_X F22 F26 220k&#10;R_X F26 F30 120k&#10;"
+	"</circuitlist></circuit>"
+	"</request></protocol>";
+
+/// Same as the circuitlist in the request
+static const char* sCircuit =
+	"W_X A26 0\n"
+	"W_X A22 F22\n"
+	"W_X F30 0\n"
+	"R_X A14 A18 1k\n"
+	"R_X A10 A14 1.8k\n"
+	"R_X A6 A10 1.5k\n"
+	"R_X A18 A22 10k\n"
+	"R_X A22 A26 82k\n"
+	"R_X F22 F26 220k\n"
+	"R_X F26 F30 120k\n";
+
+void usage(char* cmdname)
+{
+	cout << cmdname << " <flags>" << endl;
+	cout << " Flags:" << endl;
+	cout << "  -d <compdef>       component definitions, default conf/component.types" << endl;
+	cout << "  -m <maxlistconf>   maxlist config, default conf/maxlists.conf" << endl;
+	cout << "  -c <circuit>       circuit to parse and solve instead of the embedded one" << endl;
+	cout << "  -L <components>    size of the large maxlist parsed, default 10000" << endl;
+	cout << "  -q <request>       recorded xml request, can be repeated" << endl;
+	cout << "  -b <name>          only run benchmarks with names containing this" << endl;
+	cout << "  -w <iterations>    warmup iterations, default 10" << endl;
+	cout << "  -i <iterations>    iterations per sample, calibrated if not given" << endl;
+	cout << "  -s <samples>       samples per benchmark, default 20" << endl;
+	cout << "  -t <ms>            minimum sample time when calibrating, default 10" << endl;
+	cout << "  -f <format>        text, csv or json, default text" << endl;
+	cout << "  -o <file>          write the results to a file instead of stdout" << endl;
+	cout << "  -l                 list the benchmarks and exit" << endl;
+	cout << "  -S                 check the request scheduler and circuit change scenarios and exit" << endl;
+	exit(1);
+}
+
+/// One benchmarked operation, the runner repeats Run
+class Benchmark
+{
+public:
+	const string&	GetName() const { return mName; }
+	virtual void	Run() = 0;
+
+	Benchmark(const string& name) : mName(name) {}
+	virtual ~Benchmark() {}
+private:
+	string mName;
+};
+
+typedef vector<Benchmark*> tBenchmarks;
+
+class ListParserBench : public Benchmark
+{
+public:
+	ListParserBench(const string& name, const ListParser::tComponentDefinitions& defs, const string& text)
+		: Benchmark(name), mDefs(defs), mText(text) {}
+	void Run()
+	{
+		ListParser parser(mDefs);
+		parser.Parse(mText);
+		gSink += parser.GetList().size();
+	}
+private:
+	const ListParser::tComponentDefinitions& mDefs;
+	string mText;
+};
+
+class SolveBench : public Benchmark
+{
+public:
+	SolveBench(const ListComponent::tComponentList& circuit, const ListComponent::tComponentList& maxlist)
+		: Benchmark("CircuitSolver3::Solve"), mCircuit(circuit), mMaxList(maxlist) {}
+	void Run()
+	{
+		CircuitList solver;
+		gSink += solver.Solve(mCircuit, mMaxList);
+	}
+private:
+	ListComponent::tComponentList mCircuit;
+	ListComponent::tComponentList mMaxList;
+};
+
+class PlacedBench : public Benchmark
+{
+public:
+	PlacedBench(const string& name, const ListComponent::tComponentList& circuit)
+		: Benchmark(name), mCircuit(circuit.begin(), circuit.end()) {}
+	void Run()
+	{
+		CircuitSolver3 solver;
+		vector<ListComponent> placed;
+		solver.GetPlacedComponents(mCircuit, placed);
+		gSink += placed.size();
+	}
+private:
+	vector<ListComponent> mCircuit;
+};
+
+class SubsetBench : public Benchmark
+{
+public:
+	SubsetBench(const ListComponent::tComponentList& solution, const ListComponent::tComponentList& maxlist)
+		: Benchmark("NetList2::IsSubsetOf"), mSolution(solution), mMaxList(maxlist) {}
+	void Run()
+	{
+		gSink += mSolution.IsSubsetOf(mMaxList);
+	}
+private:
+	NetList2 mSolution;
+	NetList2 mMaxList;
+};
+
+class DomParserBench : public Benchmark
+{
+public:
+	DomParserBench(const string& name, const string& xml) : Benchmark(name), mXml(xml) {}
+	void Run()
+	{
+		XMLUtil::DOMParser parser;
+		XMLUtil::DOMNode root;
+		gSink += parser.Parse(mXml, &root);
+	}
+private:
+	string mXml;
+};
+
+class RequestParserBench : public Benchmark
+{
+public:
+	RequestParserBench(const string& name, const string& xml) : Benchmark(name), mXml(xml) {}
+	void Run()
+	{
+		xmlprotocol::RequestParser parser;
+		xmlprotocol::RequestParser::tTransactions transactions;
+		parser.ParsePacket(mXml.c_str(), mXml.size(), transactions);
+		gSink += transactions.size();
+		for(xmlprotocol::RequestParser::tTransactions::iterator it = transactions.begin(); it != transactions.end(); ++it)
+		{
+			delete *it;
+		}
+	}
+private:
+	string mXml;
+};
+
+class HttpRequestBench : public Benchmark
+{
+public:
+	HttpRequestBench(const string& request) : Benchmark("HTTPRequest::ParseRequest"), mBuffer(request.begin(), request.end()) {}
+	void Run()
+	{
+		HTTPRequest request;
+		int error = 0;
+		if (request.ParseRequest(&mBuffer[0], mBuffer.size(), error))
+		{
+			gSink += (size_t)request.GetPayload(&mBuffer[0], mBuffer.size());
+		}
+	}
+private:
+	vector<char> mBuffer;
+};
+
+class Base64EncodeBench : public Benchmark
+{
+public:
+	Base64EncodeBench(const string& data) : Benchmark("base64_encode"), mData(data) {}
+	void Run()
+	{
+		gSink += base64::base64_encode((const unsigned char*)mData.data(), (unsigned int)mData.size()).size();
+	}
+private:
+	string mData;
+};
+
+class Base64DecodeBench : public Benchmark
+{
+public:
+	Base64DecodeBench(const string& encoded) : Benchmark("base64_decode"), mEncoded(encoded) {}
+	void Run()
+	{
+		gSink += base64::base64_decode(mEncoded).size();
+	}
+private:
+	string mEncoded;
+};
+
+/// Reads an oscilloscope fetch response the way eqcom does, the module isn't linked in
+void ParseFetch(Serializer& in, Oscilloscope& osc)
+{
+	int func = 0, notimeout = 0, samples = 0, numchannels = 0;
+	double samplerate = 0.0;
+
+	in.GetInteger(func, " \t");
+	in.GetInteger(notimeout, " ");
+	in.GetDouble(samplerate, " ");
+	in.GetInteger(samples, " ");
+	in.GetInteger(numchannels, " ");
+
+	for(int i = 0; i < numchannels; i++)
+	{
+		int channel = 0;
+		double probeAttenuation = 0.0, verticalRange = 0.0, offset = 0.0, gain = 0.0;
+		in.GetInteger(channel, " ");
+		if (channel < 0 || channel >= 2) throw BasicException("Channel out of range");
+
+		in.GetDouble(probeAttenuation, " ");
+		in.GetDouble(verticalRange, " ");
+		in.GetDouble(offset, " ");
+		in.GetDouble(gain, " ", false);
+
+		string base64graph;
+		in.GetString(base64graph, " ");
+		string graph = base64::base64_decode(base64graph);
+		if ((int)graph.size() != samples) throw BasicException("Graph length and actual samples doesn't match");
+		osc.GetChannelPointer(channel)->SetGraph(graph.data(), graph.size(), gain);
+	}
+
+	for(int i = 0; i < 3; i++)
+	{
+		double measurement = 0.0;
+		in.GetDouble(measurement, " ");
+		osc.GetMeasurementPointer(i)->SetMeasureResult(measurement);
+	}
+
+	int triggerReceived = 0;
+	double triggerLevel = 0.0;
+	in.GetInteger(triggerReceived, " ");
+	in.GetDouble(triggerLevel, " \n");
+	osc.GetTriggerPointer()->SetTriggerReceived(triggerReceived == 1);
+	osc.GetTriggerPointer()->SetLevel(triggerLevel);
+}
+
+class FetchResponseBench : public Benchmark
+{
+public:
+	FetchResponseBench(const string& response) : Benchmark("Serializer OscilloscopeFetch"), mResponse(response)
+	{
+		mpOsc = mBlock.Acquire<Oscilloscope>();
+	}
+	void Run()
+	{
+		Serializer in(mResponse);
+		ParseFetch(in, *mpOsc);
+		gSink += mpOsc->GetChannelPointer(0)->GetNumSamples();
+	}
+private:
+	string			mResponse;
+	InstrumentBlock	mBlock;
+	Oscilloscope*	mpOsc;
+};
+
+class ProduceResponseBench : public Benchmark
+{
+public:
+	ProduceResponseBench(const string& graph) : Benchmark("XmlProducer::ProduceResponse")
+	{
+		mPrev.Acquire<Oscilloscope>();
+		Oscilloscope* pOsc = mCurrent.Acquire<Oscilloscope>();
+		for(int i = 0; i < 2; i++)
+		{
+			pOsc->GetChannelPointer(i)->SetEnabled(true);
+			pOsc->GetChannelPointer(i)->SetGraph(graph.data(), graph.size(), 0.04);
+		}
+	}
+	void Run()
+	{
+		ostringstream out;
+		xmlprotocol::XmlProducer::ProduceResponse(out, &mPrev, &mCurrent, false);
+		gSink += out.str().size();
+	}
+private:
+	InstrumentBlock mPrev;
+	InstrumentBlock mCurrent;
+};
+
+/// Timings of one benchmark in nanoseconds per operation
+struct Result
+{
+	string	name;
+	int		iterations;
+	int		samples;
+	double	min;
+	double	mean;
+	double	median;
+	double	p90;
+	double	p99;
+	double	max;
+	double	stddev;
+};
+
+typedef vector<Result> tResults;
+
+/// Nearest rank percentile of sorted times
+double Percentile(const vector<double>& sorted, double p)
+{
+	if (sorted.empty()) return 0;
+	size_t rank = (size_t)ceil(p * sorted.size());
+	if (rank < 1) rank = 1;
+	return sorted[min(rank, sorted.size()) - 1];
+}
+
+/// Time one batch of iterations, in seconds
+double RunBatch(Benchmark& bench, int iterations)
+{
+	timer batchtimer;
+	for(int i = 0; i < iterations; i++) bench.Run();
+	return batchtimer.elapsed();
+}
+
+Result Measure(Benchmark& bench, int warmup, int iterations, int samples, double minSampleTime)
+{
+	RunBatch(bench, warmup);
+
+	if (iterations <= 0)
+	{
+		iterations = 1;
+		while(RunBatch(bench, iterations) < minSampleTime && iterations < (1 << 24)) iterations *= 2;
+	}
+
+	vector<double> times;
+	for(int i = 0; i < samples; i++)
+	{
+		times.push_back(RunBatch(bench, iterations) * 1e9 / iterations);
+	}
+	sort(times.begin(), times.end());
+
+	Result result;
+	result.name = bench.GetName();
+	result.iterations = iterations;
+	result.samples = samples;
+	result.min = times.front();
+	result.max = times.back();
+	result.median = Percentile(times, 0.5);
+	result.p90 = Percentile(times, 0.9);
+	result.p99 = Percentile(times, 0.99);
+
+	double sum = 0;
+	for(size_t i = 0; i < times.size(); i++) sum += times[i];
+	result.mean = sum / times.size();
+
+	double var = 0;
+	for(size_t i = 0; i < times.size(); i++) var += (times[i] - result.mean) * (times[i] - result.mean);
+	result.stddev = sqrt(var / times.size());
+	return result;
+}
+
+string JsonString(const string& in)
+{
+	string out = "\"";
+	for(size_t i = 0; i < in.size(); i++)
+	{
+		if (in[i] == '"' || in[i] == '\\') out += '\\';
+		out += in[i];
+	}
+	return out + "\"";
+}
+
+void WriteText(ostream& out, const tResults& results)
+{
+	out << "benchmark                                 iterations     min ns  median ns    mean ns     p90 ns     p99 ns  stddev ns" << endl;
+	for(tResults::const_iterator it = results.begin(); it != results.end(); ++it)
+	{
+		out << it->name << string(it->name.size() < 40 ? 40 - it->name.size() : 1, ' ');
+		out.width(12); out << it->iterations;
+		out << std::fixed;
+		out.precision(0);
+		const double values[] = { it->min, it->median, it->mean, it->p90, it->p99, it->stddev };
+		for(int i = 0; i < 6; i++)
+		{
+			out << " ";
+			out.width(10);
+			out << values[i];
+		}
+		out << endl;
+	}
+}
+
+void WriteCsv(ostream& out, const tResults& results)
+{
+	out << "benchmark,iterations,samples,min_ns,median_ns,mean_ns,p90_ns,p99_ns,max_ns,stddev_ns" << endl;
+	for(tResults::const_iterator it = results.begin(); it != results.end(); ++it)
+	{
+		out << it->name << "," << it->iterations << "," << it->samples << "," << std::fixed
+			<< it->min << "," << it->median << "," << it->mean << "," << it->p90 << ","
+			<< it->p99 << "," << it->max << "," << it->stddev << endl;
+	}
+}
+
+void WriteJson(ostream& out, const tResults& results)
+{
+	out << "{" << endl << "\"benchmarks\": [" << endl;
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		const Result& r = results[i];
+		out << "{\"name\": " << JsonString(r.name) << ", \"iterations\": " << r.iterations << ", \"samples\": " << r.samples
+			<< ", \"min_ns\": " << std::fixed << r.min << ", \"median_ns\": " << r.median << ", \"mean_ns\": " << r.mean
+			<< ", \"p90_ns\": " << r.p90 << ", \"p99_ns\": " << r.p99 << ", \"max_ns\": " << r.max
+			<< ", \"stddev_ns\": " << r.stddev << "}" << (i + 1 < results.size() ? "," : "") << endl;
+	}
+	out << "]" << endl << "}" << endl;
+}
+
+bool ReadFile(const string& filename, string& out)
+{
+	fstream file(filename.c_str(), fstream::in | fstream::binary);
+	if (!file.is_open()) return false;
+	stringstream buffer;
+	buffer << file.rdbuf();
+	out = buffer.str();
+	return true;
+}
+
+/// Reads the maxlists in config order, lists that can't be read are left out
+bool LoadMaxlists(const string& maxlistConf, vector<ListComponent::tComponentList>& maxLists, const ListParser::tComponentDefinitions& compdefs)
+{
+	string path;
+	size_t sep = maxlistConf.find_last_of("/\\");
+	if (sep != string::npos) path = string(maxlistConf, 0, sep + 1);
+
+	fstream file(maxlistConf.c_str());
+	if (!file.is_open()) return false;
+
+	string line;
+	while(getline(file, line))
+	{
+		if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+		if (line.empty() || line[0] == '#' || line[0] == '*') continue;
+
+		ListParser parser(compdefs, true);
+		if (parser.ParseFile(path + line)) maxLists.push_back(parser.GetList());
+		else cerr << "failed to read maxlist, skipping it: " << path + line << endl;
+	}
+	return true;
+}
+
+/// A graph that looks like a sampled sine
+string MakeGraph(int samples)
+{
+	string graph(samples, 0);
+	for(int i = 0; i < samples; i++) graph[i] = (char)(100.0 * sin(i * 0.05));
+	return graph;
+}
+
+/// What the equipment sends back for a fetch of both channels
+string MakeFetchResponse(const string& graph)
+{
+	const string encoded = base64::base64_encode((const unsigned char*)graph.data(), (unsigned int)graph.size());
+	stringstream out;
+	out << "1 1 500000 " << graph.size() << " 2";
+	for(int i = 0; i < 2; i++)
+	{
+		out << " " << i << " 1 8 0 0.04 " << encoded;
+	}
+	out << " 1000.5 0 0 1 0.12\n";
+	return out.str();
+}
+
+string MakeHttpRequest(const string& body)
+{
+	stringstream out;
+	out << "POST /measureserver HTTP/1.1\r\n"
+		<< "Host: localhost:8080\r\n"
+		<< "User-Agent: Mozilla/5.0 (Windows NT 6.1; rv:2.0) Gecko/20100101 Firefox/4.0\r\n"
+		<< "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+		<< "Accept-Language: en-us,en;q=0.5\r\n"
+		<< "Accept-Encoding: gzip, deflate\r\n"
+		<< "Connection: keep-alive\r\n"
+		<< "Content-Type: text/xml; charset=UTF-8\r\n"
+		<< "Content-Length: " << body.size() << "\r\n"
+		<< "\r\n" << body;
+	return out.str();
+}
+
+string BaseName(const string& filename)
+{
+	size_t sep = filename.find_last_of("/\\");
+	return sep == string::npos ? filename : filename.substr(sep + 1);
+}
+
+/// Request that only records that it was sent
+class ScenarioRequest : public Request
+{
+public:
+	const string&	GetName() const { return mName; }
+
+	virtual void	Send()			{ mpSent->push_back(mName); if (mpQueue) mpQueue->RequestDone(this); }
+	virtual bool	BuildRequest()	{ return true; }
+	virtual void	Cancel()		{}
+	virtual const vector<string>*	GetSwitched() { return mSwitched.empty() ? NULL : &mSwitched; }
+
+	ScenarioRequest(const string& name, const string& switched = "", RequestQueue* pQueue = NULL, Client* pOwner = NULL, vector<string>* pSent = NULL)
+		: Request(pQueue, pOwner), mName(name), mpSent(pSent)
+	{
+		// space separated, sorted like the equipment control does
+		stringstream in(switched);
+		string component;
+		while(in >> component) mSwitched.push_back(component);
+		sort(mSwitched.begin(), mSwitched.end());
+	}
+private:
+	string			mName;
+	vector<string>	mSwitched;
+	vector<string>*	mpSent;
+};
+
+/// A request for the scheduler scenarios, the flows are the request names without the number
+struct ScenarioStep
+{
+	const char*	name;
+	int			priority;
+	const char*	switched;
+};
+
+/// Pushes the steps, a NULL name pops one instead, and pops the rest at the end.
+/// Checks the pop order against the expected space separated names
+bool CheckScenario(const char* title, RequestScheduler* pScheduler, const ScenarioStep* steps, size_t numSteps, const string& expected)
+{
+	// flows are the name up to the digits, so A1 and A2 are the same session
+	map<string, int> flows;
+	list<ScenarioRequest*> requests;
+	string order;
+	for(size_t i = 0; i <= numSteps; i++)
+	{
+		if (i < numSteps && steps[i].name)
+		{
+			const string name = steps[i].name;
+			const string flow = name.substr(0, name.find_first_of("0123456789"));
+			flows.insert(make_pair(flow, (int)flows.size()));
+
+			requests.push_back(new ScenarioRequest(name, steps[i].switched ? steps[i].switched : ""));
+			pScheduler->Push(requests.back(), &flows[flow], steps[i].priority, requests.back()->GetSwitched());
+			continue;
+		}
+
+		// a pop step, or everything that is left at the end
+		while(Request* pRequest = pScheduler->Pop())
+		{
+			order += (order.empty() ? "" : " ") + ((ScenarioRequest*)pRequest)->GetName();
+			if (i < numSteps) break;
+		}
+	}
+
+	for(list<ScenarioRequest*>::iterator it = requests.begin(); it != requests.end(); it++) delete *it;
+	delete pScheduler;
+
+	if (order == expected)
+	{
+		cout << "ok      " << title << endl;
+		return true;
+	}
+	cout << "FAILED  " << title << ": expected " << expected << ", got " << order << endl;
+	return false;
+}
+
+/// The queue rejects requests over the per session cap and takes them again once some are handled
+bool CheckSessionCap()
+{
+	vector<string> sent;
+	Client client;
+	Client other;
+	RequestQueue queue(NULL, RequestQueue::eFair, 2);
+
+	bool ok = queue.AddRequest(new ScenarioRequest("A1", "", &queue, &client, &sent));
+	ok = queue.AddRequest(new ScenarioRequest("A2", "", &queue, &client, &sent)) && ok;
+
+	ScenarioRequest* pOver = new ScenarioRequest("A3", "", &queue, &client, &sent);
+	if (queue.AddRequest(pOver)) ok = false;
+	else delete pOver;
+
+	ok = queue.AddRequest(new ScenarioRequest("B1", "", &queue, &other, &sent)) && ok;
+	queue.ProcessQueue();
+	ok = queue.AddRequest(new ScenarioRequest("A3", "", &queue, &client, &sent)) && ok;
+	for(int i = 0; i < 8 && sent.size() < 4; i++) queue.ProcessQueue();
+
+	const RequestQueue::tWaitStats& wait = queue.GetQueueWait();
+	const bool waited = wait.size() == 1 && wait.begin()->second.count == 4;
+
+	string order;
+	for(size_t i = 0; i < sent.size(); i++) order += (i ? " " : "") + sent[i];
+	if (ok && waited && order == "A1 B1 A2 A3")
+	{
+		cout << "ok      per session cap" << endl;
+		return true;
+	}
+	cout << "FAILED  per session cap: " << (ok ? "" : "the cap wasn't kept, ") << (waited ? "" : "the queue wait isn't counted, ") << "order " << order << endl;
+	return false;
+}
+
+/// The circuit is only sent as a change from a circuit the equipment server is known to have
+bool CheckCircuitChanges()
+{
+	using namespace EqSrv;
+
+	CircuitState plain, other, switched;
+	plain.components.push_back("R1");
+	plain.components.push_back("R2");
+	other.components.push_back("R1");
+	other.components.push_back("R3");
+	switched.components.push_back("R1");
+	switched.components.push_back("SHORTCUT1");
+
+	const string head = InstrumentHeadType(V3_CircuitBuilder);
+	const string setupPlain = head + "3 R1?R2\n";
+
+	CircuitTracker tracker;
+	tracker.SetCanChange(true);
+
+	stringstream first, change, afterSwitch, afterError, again;
+	tracker.Write(first, plain, false);
+	tracker.Applied();
+	tracker.Write(change, other, false);
+	tracker.Applied();
+
+	// the switch toggles its shortcut after the setup, the next circuit can't be a change
+	tracker.Write(afterSwitch, switched, true);
+	tracker.Applied();
+	tracker.Write(afterSwitch, plain, false);
+
+	// not confirmed, so not known either
+	tracker.Write(afterError, other, false);
+	tracker.Applied();
+	tracker.Write(again, plain, false);
+
+	bool ok = true;
+	ok = (first.str() == setupPlain) && ok;
+	ok = (change.str() == head + "10 R2\n" + head + "9 R3\n") && ok;
+	ok = (afterSwitch.str() == head + "10 R3\n" + head + "9 SHORTCUT1\n" + setupPlain) && ok;
+	ok = (afterError.str() == head + "3 R1?R3\n") && ok;
+	ok = (again.str() == head + "10 R3\n" + head + "9 R2\n") && ok;
+	if (ok)
+	{
+		cout << "ok      circuit changes" << endl;
+		return true;
+	}
+	cout << "FAILED  circuit changes:" << endl << first.str() << change.str() << afterSwitch.str() << afterError.str() << again.str();
+	return false;
+}
+
+#define STEPS(x) x, sizeof(x) / sizeof(x[0])
+
+bool RunSchedulerScenarios()
+{
+	static const ScenarioStep arrival[] = { { "A1", 0, 0 }, { "B1", 0, 0 }, { "A2", 0, 0 }, { "C1", 1, 0 } };
+
+	// A fires four requests before the others get theirs in, they still take turns
+	static const ScenarioStep turns[] = {
+		{ "A1", 0, 0 }, { "A2", 0, 0 }, { "A3", 0, 0 }, { "A4", 0, 0 },
+		{ "B1", 0, 0 }, { "B2", 0, 0 }, { "C1", 0, 0 }, { "C2", 0, 0 } };
+
+	// a session arriving while A is being served doesn't wait for A's backlog
+	static const ScenarioStep late[] = { { "A1", 0, 0 }, { "A2", 0, 0 }, { "A3", 0, 0 }, { NULL, 0, 0 }, { "B1", 0, 0 } };
+
+	// strict priority between the classes
+	static const ScenarioStep priority[] = { { "L1", 0, 0 }, { "L2", 0, 0 }, { "H1", 1, 0 }, { "H2", 1, 0 }, { "M1", 0, 0 } };
+
+	// A3 switches the same as A1 but A2 has to go first
+	static const ScenarioStep flowOrder[] = {
+		{ "A1", 0, "R1 W1" }, { "A2", 0, "R2 W2" }, { "A3", 0, "R1 W1" }, { "B1", 0, "R3 W3" } };
+
+	// the closest circuit is picked, but D is only passed over window times
+	static const ScenarioStep passed[] = {
+		{ "P1", 0, "R1" }, { "D1", 0, "R9" }, { "E1", 0, "R1" }, { "F1", 0, "R1" }, { "G1", 0, "R1" }, { "H1", 0, "R1" } };
+
+	bool ok = true;
+	ok = CheckScenario("fifo keeps the arrival order", CreateFifoScheduler(), STEPS(arrival), "A1 B1 A2 C1") && ok;
+	ok = CheckScenario("fair sessions take turns", CreateFairScheduler(), STEPS(turns), "A1 B1 C1 A2 B2 C2 A3 A4") && ok;
+	ok = CheckScenario("fair late session gets the next turn", CreateFairScheduler(), STEPS(late), "A1 B1 A2 A3") && ok;
+	ok = CheckScenario("fair higher priority first", CreateFairScheduler(), STEPS(priority), "H1 H2 L1 M1 L2") && ok;
+	ok = CheckScenario("relay keeps the order within a session", CreateRelayScheduler(4), STEPS(flowOrder), "A1 B1 A2 A3") && ok;
+	ok = CheckScenario("relay passes a request over at most window times", CreateRelayScheduler(2), STEPS(passed), "P1 E1 F1 D1 G1 H1") && ok;
+	ok = CheckSessionCap() && ok;
+	ok = CheckCircuitChanges() && ok;
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	string compDefFile = "conf/component.types";
+	string maxListConf = "conf/maxlists.conf";
+	string circuitFile;
+	vector<string> requestFiles;
+	string filter;
+	string format = "text";
+	string outFile;
+	int largeList = cLargeListComponents;
+	int warmup = 10;
+	int iterations = 0;
+	int samples = 20;
+	double minSampleTime = 0.010;
+	bool listOnly = false;
+
+	for(int i = 1; i < argc; i++)
+	{
+		string option = argv[i];
+		if (option == "-l")
+		{
+			listOnly = true;
+			continue;
+		}
+		if (option == "-S") return RunSchedulerScenarios() ? 0 : 1;
+
+		if (option[0] != '-' || i + 1 >= argc) usage(argv[0]);
+		if (option == "-d") compDefFile = argv[++i];
+		else if (option == "-m") maxListConf = argv[++i];
+		else if (option == "-c") circuitFile = argv[++i];
+		else if (option == "-L") largeList = atoi(argv[++i]);
+		else if (option == "-q") requestFiles.push_back(argv[++i]);
+		else if (option == "-b") filter = argv[++i];
+		else if (option == "-w") warmup = atoi(argv[++i]);
+		else if (option == "-i") iterations = atoi(argv[++i]);
+		else if (option == "-s") samples = atoi(argv[++i]);
+		else if (option == "-t") minSampleTime = atof(argv[++i]) / 1000.0;
+		else if (option == "-f") format = argv[++i];
+		else if (option == "-o") outFile = argv[++i];
+		else usage(argv[0]);
+	}
+	if (samples <= 0 || warmup < 0 || (format != "text" && format != "csv" && format != "json")) usage(argv[0]);
+
+	tBenchmarks benchmarks;
+
+	// request path
+	const string request = sRequest;
+	benchmarks.push_back(new HttpRequestBench(MakeHttpRequest(request)));
+	benchmarks.push_back(new DomParserBench("DOMParser::Parse", request));
+	benchmarks.push_back(new RequestParserBench("RequestParser::ParsePacket", request));
+	for(size_t i = 0; i < requestFiles.size(); i++)
+	{
+		string recorded;
+		if (!ReadFile(requestFiles[i], recorded))
+		{
+			cerr << "Unable to read request: " << requestFiles[i] << endl;
+			return 1;
+		}
+		benchmarks.push_back(new DomParserBench("DOMParser::Parse " + BaseName(requestFiles[i]), recorded));
+		benchmarks.push_back(new RequestParserBench("RequestParser::ParsePacket " + BaseName(requestFiles[i]), recorded));
+	}
+
+	// circuit path, needs the component definitions and maxlists
+	ComponentDefinitionReader compdef;
+	if (compdef.ReadFile(compDefFile))
+	{
+		string circuitText = sCircuit;
+		if (!circuitFile.empty() && !ReadFile(circuitFile, circuitText))
+		{
+			cerr << "Unable to read circuit: " << circuitFile << endl;
+			return 1;
+		}
+
+		ListParser parser(compdef.GetDefinitions());
+		if (!parser.Parse(circuitText))
+		{
+			cerr << "Unable to parse circuit" << endl;
+			return 1;
+		}
+		const ListComponent::tComponentList circuit = parser.GetList();
+		benchmarks.push_back(new ListParserBench("ListParser::Parse", compdef.GetDefinitions(), circuitText));
+
+		vector<ListComponent::tComponentList> maxLists;
+		if (!LoadMaxlists(maxListConf, maxLists, compdef.GetDefinitions()))
+		{
+			cerr << "Can't read maxlists " << maxListConf << ", skipping the solver benchmarks" << endl;
+		}
+
+		// the maxlists written out and repeated, parsing time should grow linearly with the size
+		string largeText;
+		int largeSize = 0;
+		for(size_t l = 0; largeSize < largeList && l < maxLists.size() * (size_t)largeList; l++)
+		{
+			const ListComponent::tComponentList& maxList = maxLists[l % maxLists.size()];
+			largeText += ListProducer::Produce(maxList);
+			largeSize += (int)maxList.size();
+		}
+		if (largeSize > 0) benchmarks.push_back(new ListParserBench("ListParser::Parse " + ToString(largeSize) + " components", compdef.GetDefinitions(), largeText));
+
+		// a resistor chain from the dc supply to ground, tier one walks it node by node
+		ListComponent::tComponentList chain;
+		for(int i = 0; i < cLargeCircuitComponents; i++)
+		{
+			const string from = i ? "N" + ToString(i) : string("DC_+6V");
+			const string to = i + 1 < cLargeCircuitComponents ? "N" + ToString(i + 1) : string("0");
+			chain.push_back(ListComponent("R", "X", from, to));
+			chain.back().SetValue("1k");
+		}
+		benchmarks.push_back(new PlacedBench("CircuitSolver3::GetPlacedComponents " + ToString(cLargeCircuitComponents) + " components", chain));
+
+		size_t solvedBy = 0;
+		ListComponent::tComponentList solution;
+		for(; solvedBy < maxLists.size(); solvedBy++)
+		{
+			CircuitList solver;
+			if (solver.Solve(circuit, maxLists[solvedBy]))
+			{
+				solution = solver.GetSolution();
+				break;
+			}
+		}
+
+		if (solvedBy < maxLists.size())
+		{
+			benchmarks.push_back(new SolveBench(circuit, maxLists[solvedBy]));
+			benchmarks.push_back(new SubsetBench(solution, maxLists[solvedBy]));
+		}
+		else if (!maxLists.empty())
+		{
+			cerr << "The circuit isn't solved by any maxlist, skipping the solver benchmarks" << endl;
+		}
+	}
+	else
+	{
+		cerr << "Can't find component definitions file " << compDefFile << ", skipping the circuit benchmarks" << endl;
+	}
+
+	// response path
+	const string graph = MakeGraph(cOscSamples);
+	const string encoded = base64::base64_encode((const unsigned char*)graph.data(), (unsigned int)graph.size());
+	benchmarks.push_back(new Base64EncodeBench(graph));
+	benchmarks.push_back(new Base64DecodeBench(encoded));
+	benchmarks.push_back(new FetchResponseBench(MakeFetchResponse(graph)));
+	benchmarks.push_back(new ProduceResponseBench(graph));
+
+	tResults results;
+	for(tBenchmarks::iterator it = benchmarks.begin(); it != benchmarks.end(); ++it)
+	{
+		Benchmark* pBench = *it;
+		if (listOnly) cout << pBench->GetName() << endl;
+		else if (pBench->GetName().find(filter) != string::npos)
+		{
+			try
+			{
+				results.push_back(Measure(*pBench, warmup, iterations, samples, minSampleTime));
+			}
+			catch(BasicException& e)
+			{
+				cerr << pBench->GetName() << " failed: " << e.what() << endl;
+				return 1;
+			}
+		}
+		delete pBench;
+	}
+	if (listOnly) return 0;
+
+	fstream file;
+	if (!outFile.empty())
+	{
+		file.open(outFile.c_str(), fstream::out);
+		if (!file.is_open())
+		{
+			cerr << "Unable to write: " << outFile << endl;
+			return 1;
+		}
+	}
+	ostream& out = outFile.empty() ? cout : file;
+
+	if (format == "csv") WriteCsv(out, results);
+	else if (format == "json") WriteJson(out, results);
+	else WriteText(out, results);
+
+	return 0;
+}
@@ -0,0 +1,221 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+/*
+	Circuit archive tool
+
+	Looks into the archive the server saves circuits in (SaveCircuits in measureserver.conf, see
+	CircuitArchive). Export writes the circuits as <md5>.circuit files like the server used to, import
+	adds such files to an archive, and compact copies an archive to a new directory in full segments,
+	leaving out damaged and, with -s, old records.
+
+		circuitarchive list savedcircuits
+		circuitarchive export savedcircuits corpus
+		circuitarchive compact -s 1300000000 savedcircuits savedcircuits.new
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include <measureserver/circuitarchive.h>
+
+using namespace std;
+
+void usage(char* cmdname)
+{
+	cout << cmdname << " <command> [flags] <archive> ..." << endl;
+	cout << " Commands:" << endl;
+	cout << "  list <archive>                      md5, time and size of every circuit" << endl;
+	cout << "  cat <archive> <md5>                 print one circuit" << endl;
+	cout << "  export <archive> <dir>              write every circuit to <dir>/<md5>.circuit" << endl;
+	cout << "  import <archive> <files>            add circuit files, the archive directory must exist" << endl;
+	cout << "  compact <archive> <newarchive>      copy the readable circuits to a new archive, the directory must exist" << endl;
+	cout << " Flags:" << endl;
+	cout << "  -s <time>                           only circuits first seen at this unix time or later" << endl;
+	exit(1);
+}
+
+string FormatTime(unsigned int seconds)
+{
+	time_t t = (time_t)seconds;
+	char buffer[32];
+	if (strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", localtime(&t)) == 0) return "?";
+	return buffer;
+}
+
+bool ReadFile(const string& filename, string& contents)
+{
+	ifstream file(filename.c_str(), ios::in | ios::binary);
+	if (!file.is_open()) return false;
+
+	stringstream buffer;
+	buffer << file.rdbuf();
+	contents = buffer.str();
+	return true;
+}
+
+int List(const CircuitArchive& archive, unsigned int since)
+{
+	CircuitArchive::Record record;
+	size_t bytes = 0;
+	size_t listed = 0;
+	for(size_t i = 0; i < archive.Size(); i++)
+	{
+		if (!archive.Read(i, record))
+		{
+			cerr << "Can't read record " << i << endl;
+			continue;
+		}
+		if (record.time < since) continue;
+
+		cout << record.md5 << "\t" << FormatTime(record.time) << "\t" << record.circuit.size() << endl;
+		bytes += record.circuit.size();
+		listed++;
+	}
+	cerr << listed << " circuits, " << bytes << " bytes" << endl;
+	return 0;
+}
+
+int Export(const CircuitArchive& archive, string dir, unsigned int since)
+{
+	if (!dir.empty() && dir[dir.size() - 1] != '/' && dir[dir.size() - 1] != '\\') dir += "/";
+
+	CircuitArchive::Record record;
+	size_t written = 0;
+	for(size_t i = 0; i < archive.Size(); i++)
+	{
+		if (!archive.Read(i, record) || record.time < since) continue;
+
+		string filename = dir + record.md5 + ".circuit";
+		ofstream file(filename.c_str(), ios::out | ios::binary);
+		if (!file.is_open() || !file.write(record.circuit.data(), record.circuit.size()))
+		{
+			cerr << "Failed to write: " << filename << endl;
+			return 1;
+		}
+		written++;
+	}
+	cerr << "Exported " << written << " circuits" << endl;
+	return 0;
+}
+
+int Import(const string& dir, const vector<string>& files)
+{
+	CircuitArchive archive;
+	if (!archive.OpenForAppend(dir))
+	{
+		cerr << "Can't open archive: " << dir << endl;
+		return 1;
+	}
+
+	size_t added = 0;
+	for(size_t i = 0; i < files.size(); i++)
+	{
+		string circuit;
+		if (!ReadFile(files[i], circuit))
+		{
+			cerr << "Can't read: " << files[i] << endl;
+			continue;
+		}
+
+		// the old files were written when the circuit was first seen
+		struct stat info;
+		unsigned int seen = (stat(files[i].c_str(), &info) == 0) ? (unsigned int)info.st_mtime : (unsigned int)time(NULL);
+		if (archive.Add(circuit, seen)) added++;
+		if ((i % 1000) == 999) archive.Flush();
+	}
+
+	archive.Close();
+	cerr << "Added " << added << " of " << files.size() << " circuits" << endl;
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3) usage(argv[0]);
+
+	string command = argv[1];
+	unsigned int since = 0;
+	vector<string> args;
+	for(int i = 2; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (arg == "-s" && i + 1 < argc) since = (unsigned int)strtoul(argv[++i], NULL, 10);
+		else args.push_back(arg);
+	}
+	if (args.empty()) usage(argv[0]);
+
+	if (command == "import")
+	{
+		if (args.size() < 2) usage(argv[0]);
+		return Import(args[0], vector<string>(args.begin() + 1, args.end()));
+	}
+
+	if (command == "compact")
+	{
+		if (args.size() != 2) usage(argv[0]);
+		if (!CircuitArchive::Compact(args[0], args[1], since))
+		{
+			cerr << "Failed to compact " << args[0] << " to " << args[1] << endl;
+			return 1;
+		}
+
+		CircuitArchive compacted;
+		compacted.Open(args[1]);
+		cerr << "Compacted to " << compacted.Size() << " circuits" << endl;
+		return 0;
+	}
+
+	CircuitArchive archive;
+	if (!archive.Open(args[0]))
+	{
+		cerr << "Can't open archive: " << args[0] << endl;
+		return 1;
+	}
+
+	if (command == "list" && args.size() == 1) return List(archive, since);
+	if (command == "export" && args.size() == 2) return Export(archive, args[1], since);
+	if (command == "cat" && args.size() == 2)
+	{
+		CircuitArchive::Record record;
+		if (!archive.Find(args[1], record))
+		{
+			cerr << "No circuit " << args[1] << " in " << args[0] << endl;
+			return 1;
+		}
+		cout << record.circuit;
+		return 0;
+	}
+
+	usage(argv[0]);
+	return 1;
+}
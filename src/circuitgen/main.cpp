@@ -0,0 +1,759 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+/*
+	Synthetic circuit and maxlist generator
+
+	Makes random maxlists from the types in component.types and circuits that fit them, to see how
+	the solver scales past what the saved circuits cover. A maxlist is a connected net of two pin
+	components with shortcuts between some of its nodes, optionally with components in parallel and
+	@group alternatives. A circuit picks components from a maxlist, closes some of the shortcuts,
+	renames the nodes like a breadboard and routes some connections through wires. Circuits that
+	shouldn't be solvable get one component moved to another node or given a value no maxlist has,
+	and are checked with the solver.
+
+	With -o the lists and circuits are written to a directory for circuittester and measureserver_bench:
+		circuitgen -d component.types -o gen
+		circuittester -d component.types -m gen/maxlists.conf "gen/gen*.circuit"
+		measureserver_bench -d component.types -m gen/maxlists.conf -c gen/gen0_0000.circuit
+
+	With -S one parameter is swept and the solve times are reported for each value.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <instruments/circuitlist.h>
+#include <instruments/circuitsolver3.h>
+#include <instruments/compdefreader.h>
+#include <instruments/listparser.h>
+
+#include <util/basic_exception.h>
+#include <util/stringop.h>
+#include <util/timer.h>
+
+using namespace std;
+
+/// Group ids above this are rejected by ListParser
+static const int cMaxGroups = 20;
+
+/// The solver's symbol table only knows maxlist nodes 0 and A to I
+static const int cMaxNodes = 9;
+
+/// Chance that a circuit closes each shortcut of its maxlist
+static const double cCloseShortcut = 0.3;
+
+/// Moved components tried before an unsolvable circuit gets a value no maxlist has
+static const int cMoveAttempts = 5;
+
+void usage(char* cmdname)
+{
+	cout << cmdname << " <flags>" << endl;
+	cout << " Flags:" << endl;
+	cout << "  -d <compdef>         component definitions, default component.types" << endl;
+	cout << "  -o <dir>             write maxlists.conf, the maxlists and circuits to an existing directory" << endl;
+	cout << "  -S <parameter>       sweep a parameter and report the solve times, see below" << endl;
+	cout << "  -V <v1,v2,..>        values for the sweep instead of the default ones" << endl;
+	cout << "  -l <lists>           maxlists to generate, default 5" << endl;
+	cout << "  -n <circuits>        circuits per maxlist, default 20" << endl;
+	cout << "  -r <seed>            random seed, default 1" << endl;
+	cout << "  -T <t1,t2,..>        component types to pick from, repeat a type to make it more common" << endl;
+	cout << "  -H <heuristics>      solver heuristics flags, default 7 (all)" << endl;
+	cout << "  -b <seconds>         solver time limit per circuit, default 5" << endl;
+	cout << "  -f <format>          sweep report as text or csv, default text" << endl;
+	cout << " Parameters, set with -P <name>=<value> or swept with -S <name>:" << endl;
+	cout << "  components           maxlist components, default 40" << endl;
+	cout << "  nodes                maxlist nodes besides ground, default 0 for half the components, at most 9" << endl;
+	cout << "  shortcuts            shortcuts per maxlist node, default 0.2" << endl;
+	cout << "  groups               share of the components with @group alternatives, default 0" << endl;
+	cout << "  parallel             share of the components in parallel with another, default 0.1" << endl;
+	cout << "  size                 components per circuit, default 8" << endl;
+	cout << "  unsolvable           share of the circuits that shouldn't be solvable, default 0.3" << endl;
+	cout << "  wires                share of the circuit connections made through a wire, default 0.2" << endl;
+	exit(1);
+}
+
+/// Small xorshift generator, a seed gives the same lists on every platform
+class Random
+{
+public:
+	unsigned int Next()
+	{
+		mState ^= mState << 13;
+		mState ^= mState >> 17;
+		mState ^= mState << 5;
+		return mState;
+	}
+	int		Range(int n)		{ return n > 0 ? (int)(Next() % (unsigned int)n) : 0; }
+	bool	Chance(double p)	{ return (Next() % 1000000) < p * 1000000.0; }
+
+	template<class T>
+	void	Shuffle(vector<T>& v)
+	{
+		for(size_t i = v.size(); i > 1; i--) swap(v[i - 1], v[Range((int)i)]);
+	}
+
+	Random(unsigned int seed) : mState(seed ? seed : 0x9e3779b9) {}
+private:
+	unsigned int mState;
+};
+
+struct GenParams
+{
+	double	components;
+	double	nodes;
+	double	shortcuts;
+	double	groups;
+	double	parallel;
+	double	size;
+	double	unsolvable;
+	double	wires;
+
+	bool Set(const string& name, double value)
+	{
+		if (name == "components")		components = value;
+		else if (name == "nodes")		nodes = value;
+		else if (name == "shortcuts")	shortcuts = value;
+		else if (name == "groups")		groups = value;
+		else if (name == "parallel")	parallel = value;
+		else if (name == "size")		size = value;
+		else if (name == "unsolvable")	unsolvable = value;
+		else if (name == "wires")		wires = value;
+		else return false;
+		return true;
+	}
+
+	GenParams() : components(40), nodes(0), shortcuts(0.2), groups(0), parallel(0.1), size(8), unsolvable(0.3), wires(0.2) {}
+};
+
+/// Default sweep values
+string DefaultSweep(const string& name)
+{
+	if (name == "components")	return "10,20,40,80,160,320";
+	if (name == "nodes")		return "2,3,5,7,9";
+	if (name == "shortcuts")	return "0,0.1,0.2,0.4,0.8";
+	if (name == "groups")		return "0,0.1,0.2,0.4";
+	if (name == "parallel")		return "0,0.1,0.2,0.4,0.8";
+	if (name == "size")			return "2,4,8,12,16,24";
+	if (name == "unsolvable")	return "0,0.5,1";
+	if (name == "wires")		return "0,0.2,0.5,1";
+	return "";
+}
+
+struct GenComponent
+{
+	string	type;
+	string	name;
+	string	value;
+	int		group;
+	int		a, b;
+};
+
+/// A maxlist, node 0 is ground
+struct GenList
+{
+	vector<GenComponent>		components;
+	vector< pair<int, int> >	shortcuts;
+	int							nodes;
+	string						text;
+};
+
+/// A circuit line, the nodes are breadboard names
+struct GenLine
+{
+	string	type;
+	string	a, b;
+	string	value;
+	bool	wire;
+};
+
+class Generator
+{
+public:
+	enum Outcome
+	{
+		eSolved,
+		eUnsolved,
+		eTooComplex,
+	};
+
+	struct Case
+	{
+		string		text;
+		bool		wantSolvable;
+		Outcome		outcome;
+		double		seconds;
+		SolverStats	stats;
+	};
+
+	bool	SetTypes(const vector<string>& types);
+	void	MakeList(const GenParams& params, GenList& list);
+	bool	MakeCase(const GenParams& params, const GenList& list, const ListComponent::tComponentList& maxlist, Case& out);
+	bool	Parse(const string& text, ListComponent::tComponentList& out) const;
+
+	Generator(const ListParser::tComponentDefinitions& defs, unsigned int seed, int heuristics, double budget);
+private:
+	string	NodeName(int node) const;
+	string	BoardName(set<string>& used);
+	string	MakeValue(const string& type, bool unused);
+	void	MakeLines(const GenParams& params, const GenList& list, vector<GenLine>& lines);
+	string	LinesToText(const vector<GenLine>& lines) const;
+	Outcome	Solve(const string& text, const ListComponent::tComponentList& maxlist, Case& out);
+
+	const ListParser::tComponentDefinitions&	mDefs;
+	map<string, const ComponentTypeDefinition*>	mTypes;
+	vector<string>	mPool;
+	Random			mRandom;
+	int				mHeuristics;
+	double			mBudget;
+};
+
+Generator::Generator(const ListParser::tComponentDefinitions& defs, unsigned int seed, int heuristics, double budget)
+	: mDefs(defs), mRandom(seed), mHeuristics(heuristics), mBudget(budget)
+{
+	for(ListParser::tComponentDefinitions::const_iterator it = defs.begin(); it != defs.end(); ++it)
+	{
+		mTypes[it->Type()] = &*it;
+	}
+}
+
+/// Only plain two pin components with a value can be picked
+bool Generator::SetTypes(const vector<string>& types)
+{
+	mPool.clear();
+	for(size_t i = 0; i < types.size(); i++)
+	{
+		map<string, const ComponentTypeDefinition*>::const_iterator it = mTypes.find(ToUpper(types[i]));
+		if (it == mTypes.end() || it->second->NumConnections() != 2 || it->second->IgnoreValue()
+			|| it->second->HasSpecialValue() || it->first == "SHORTCUT" || it->first == "W")
+		{
+			cerr << "Can't generate components of type " << types[i] << endl;
+			return false;
+		}
+		mPool.push_back(it->first);
+	}
+	return !mPool.empty() && mTypes.count("SHORTCUT") > 0;
+}
+
+string Generator::NodeName(int node) const
+{
+	if (node == 0) return "0";
+	return string(1, (char)('A' + node - 1));
+}
+
+/// A free breadboard connection like A14
+string Generator::BoardName(set<string>& used)
+{
+	for(;;)
+	{
+		string name = string(1, (char)('A' + mRandom.Range(10))) + ToString(1 + mRandom.Range(30 + (int)used.size()));
+		if (used.insert(name).second) return name;
+	}
+}
+
+/// An E12 value, or with unused one that only E24 has so no generated maxlist contains it
+string Generator::MakeValue(const string& type, bool unused)
+{
+	static const double sE12[] = { 1.0, 1.2, 1.5, 1.8, 2.2, 2.7, 3.3, 3.9, 4.7, 5.6, 6.8, 8.2 };
+	static const double sE24[] = { 1.1, 1.3, 1.6, 2.0, 2.4, 3.0, 3.6, 4.3, 5.1, 6.2, 7.5, 9.1 };
+	static const double sDecade[] = { 1.0, 10.0, 100.0 };
+
+	const double value = (unused ? sE24 : sE12)[mRandom.Range(12)] * sDecade[mRandom.Range(3)];
+	string suffix;
+	if (type == "R") suffix = "K";
+	else if (type == "C") suffix = "N";
+	else if (type == "L") suffix = "M";
+
+	stringstream out;
+	out << value << suffix;
+	return out.str();
+}
+
+void Generator::MakeList(const GenParams& params, GenList& list)
+{
+	const int components = max(1, (int)params.components);
+	list.nodes = min(cMaxNodes, params.nodes >= 1 ? (int)params.nodes : max(2, components / 2));
+	list.components.clear();
+	list.shortcuts.clear();
+
+	int groups = 0;
+	for(int i = 0; i < components; i++)
+	{
+		GenComponent c;
+		c.type = mPool[mRandom.Range((int)mPool.size())];
+		c.name = c.type + ToString(i + 1);
+		c.value = MakeValue(c.type, false);
+		c.group = 0;
+
+		if (i < list.nodes)
+		{
+			// the first components connect every node
+			c.a = i + 1;
+			c.b = mRandom.Range(i + 1);
+		}
+		else if (mRandom.Chance(params.parallel))
+		{
+			const GenComponent& other = list.components[mRandom.Range((int)list.components.size())];
+			c.a = other.a;
+			c.b = other.b;
+		}
+		else
+		{
+			c.a = mRandom.Range(list.nodes + 1);
+			do c.b = mRandom.Range(list.nodes + 1); while(c.b == c.a);
+		}
+
+		if (groups < cMaxGroups && mRandom.Chance(params.groups))
+		{
+			c.group = ++groups;
+			const int alternatives = 1 + mRandom.Range(2);
+			for(int alt = 0; alt < alternatives; alt++)
+			{
+				GenComponent other = c;
+				other.name += (char)('A' + alt);
+				other.value = MakeValue(c.type, false);
+				list.components.push_back(other);
+			}
+		}
+		list.components.push_back(c);
+	}
+
+	set< pair<int, int> > used;
+	const int shortcuts = min((int)(params.shortcuts * list.nodes + 0.5), list.nodes * (list.nodes + 1) / 2);
+	while((int)list.shortcuts.size() < shortcuts)
+	{
+		int a = mRandom.Range(list.nodes + 1);
+		int b = mRandom.Range(list.nodes + 1);
+		if (a == b) continue;
+		if (a > b) swap(a, b);
+		if (used.insert(make_pair(a, b)).second) list.shortcuts.push_back(make_pair(a, b));
+	}
+
+	stringstream out;
+	if (mTypes.count("VDC+6V")) out << "VDC+6V_1\t" << NodeName(1) << "\tmax:6\timax:0.5" << endl << endl;
+	for(size_t i = 0; i < list.components.size(); i++)
+	{
+		const GenComponent& c = list.components[i];
+		out << c.type << "_" << c.name;
+		if (c.group) out << "@" << c.group;
+		out << "\t" << NodeName(c.a) << " " << NodeName(c.b) << "\t" << c.value << endl;
+	}
+	out << endl;
+	for(size_t i = 0; i < list.shortcuts.size(); i++)
+	{
+		out << "SHORTCUT_S" << (i + 1) << "\t" << NodeName(list.shortcuts[i].first) << " " << NodeName(list.shortcuts[i].second) << endl;
+	}
+	list.text = out.str();
+}
+
+int Find(vector<int>& parent, int node)
+{
+	while(parent[node] != node) node = parent[node] = parent[parent[node]];
+	return node;
+}
+
+/// Pick components from the list with some shortcuts closed, each group used at most once
+void Generator::MakeLines(const GenParams& params, const GenList& list, vector<GenLine>& lines)
+{
+	vector<int> parent(list.nodes + 1);
+	for(size_t i = 0; i < parent.size(); i++) parent[i] = (int)i;
+	for(size_t i = 0; i < list.shortcuts.size(); i++)
+	{
+		if (!mRandom.Chance(cCloseShortcut)) continue;
+		int a = Find(parent, list.shortcuts[i].first);
+		int b = Find(parent, list.shortcuts[i].second);
+		// ground stays the root so it keeps its name
+		if (a < b) parent[b] = a;
+		else parent[a] = b;
+	}
+
+	vector<int> order(list.components.size());
+	for(size_t i = 0; i < order.size(); i++) order[i] = (int)i;
+	mRandom.Shuffle(order);
+
+	set<int> usedGroups;
+	set<string> usedNames;
+	map<int, string> names;
+	names[0] = "0";
+	const bool wires = mTypes.count("W") > 0;
+
+	lines.clear();
+	for(size_t i = 0; i < order.size() && (int)lines.size() < (int)params.size; i++)
+	{
+		const GenComponent& c = list.components[order[i]];
+		const int a = Find(parent, c.a);
+		const int b = Find(parent, c.b);
+		if (a == b) continue;
+		if (c.group && !usedGroups.insert(c.group).second) continue;
+
+		GenLine line;
+		line.type = c.type;
+		line.value = c.value;
+		line.wire = false;
+
+		string* terminals[2] = { &line.a, &line.b };
+		const int nodes[2] = { a, b };
+		for(int t = 0; t < 2; t++)
+		{
+			string& name = names[nodes[t]];
+			if (name.empty()) name = BoardName(usedNames);
+			*terminals[t] = name;
+
+			if (wires && name != "0" && mRandom.Chance(params.wires))
+			{
+				GenLine wire;
+				wire.type = "W";
+				wire.a = BoardName(usedNames);
+				wire.b = name;
+				wire.wire = true;
+				*terminals[t] = wire.a;
+				lines.push_back(wire);
+			}
+		}
+
+		if (mTypes[c.type]->CanTurn() && mRandom.Chance(0.5)) swap(line.a, line.b);
+		lines.push_back(line);
+	}
+	mRandom.Shuffle(lines);
+}
+
+string Generator::LinesToText(const vector<GenLine>& lines) const
+{
+	stringstream out;
+	for(size_t i = 0; i < lines.size(); i++)
+	{
+		out << lines[i].type << "_X " << lines[i].a << " " << lines[i].b;
+		if (!lines[i].wire) out << " " << lines[i].value;
+		out << endl;
+	}
+	return out.str();
+}
+
+bool Generator::Parse(const string& text, ListComponent::tComponentList& out) const
+{
+	ListParser parser(mDefs);
+	if (!parser.Parse(text)) return false;
+	out = parser.GetList();
+	return true;
+}
+
+Generator::Outcome Generator::Solve(const string& text, const ListComponent::tComponentList& maxlist, Case& out)
+{
+	ListComponent::tComponentList circuit;
+	if (!Parse(text, circuit)) throw BasicException("generated circuit doesn't parse: " + text);
+
+	CircuitList solver;
+	solver.SetHeuristics(mHeuristics);
+	solver.SetBudget(0, mBudget);
+
+	timer solvetimer;
+	const bool solved = solver.Solve(circuit, maxlist);
+	out.seconds = solvetimer.elapsed();
+	out.stats = solver.GetStats();
+	out.text = text;
+
+	if (solved) out.outcome = eSolved;
+	else out.outcome = out.stats.aborted ? eTooComplex : eUnsolved;
+	return out.outcome;
+}
+
+/// One circuit for the list, solved once to find out what it is and how long it takes
+bool Generator::MakeCase(const GenParams& params, const GenList& list, const ListComponent::tComponentList& maxlist, Case& out)
+{
+	vector<GenLine> lines;
+	MakeLines(params, list, lines);
+
+	vector<size_t> parts;
+	set<string> nodes;
+	for(size_t i = 0; i < lines.size(); i++)
+	{
+		if (!lines[i].wire) parts.push_back(i);
+		nodes.insert(lines[i].a);
+		nodes.insert(lines[i].b);
+	}
+	if (parts.empty()) return false;
+
+	out.wantSolvable = !mRandom.Chance(params.unsolvable);
+	if (out.wantSolvable)
+	{
+		Solve(LinesToText(lines), maxlist, out);
+		return true;
+	}
+
+	// move one end of a component to another node, that usually leaves no way to place it
+	const vector<string> nodelist(nodes.begin(), nodes.end());
+	for(int attempt = 0; attempt < cMoveAttempts && nodelist.size() > 2; attempt++)
+	{
+		vector<GenLine> moved = lines;
+		GenLine& line = moved[parts[mRandom.Range((int)parts.size())]];
+		string node = nodelist[mRandom.Range((int)nodelist.size())];
+		if (node == line.a || node == line.b) continue;
+		line.a = node;
+
+		if (Solve(LinesToText(moved), maxlist, out) != eSolved) return true;
+	}
+
+	GenLine& line = lines[parts[mRandom.Range((int)parts.size())]];
+	line.value = MakeValue(line.type, true);
+	Solve(LinesToText(lines), maxlist, out);
+	return true;
+}
+
+/// Solve times for one value of a swept parameter
+struct Step
+{
+	double			value;
+	int				solved;
+	int				unsolved;
+	int				tooComplex;
+	int				missed;
+	double			nodes;
+	vector<double>	times;
+
+	Step(double v) : value(v), solved(0), unsolved(0), tooComplex(0), missed(0), nodes(0) {}
+	void Add(const Generator::Case& c)
+	{
+		if (c.outcome == Generator::eSolved) solved++;
+		else if (c.outcome == Generator::eTooComplex) tooComplex++;
+		else unsolved++;
+		if (c.wantSolvable && c.outcome != Generator::eSolved) missed++;
+		nodes += c.stats.nodes;
+		times.push_back(c.seconds);
+	}
+};
+
+/// Nearest rank percentile of sorted times
+double Percentile(const vector<double>& sorted, double p)
+{
+	if (sorted.empty()) return 0;
+	size_t rank = (size_t)(p * sorted.size() + 0.999999);
+	if (rank < 1) rank = 1;
+	return sorted[min(rank, sorted.size()) - 1];
+}
+
+double Mean(const vector<double>& values)
+{
+	double sum = 0;
+	for(size_t i = 0; i < values.size(); i++) sum += values[i];
+	return values.empty() ? 0 : sum / values.size();
+}
+
+void WriteSweep(ostream& out, const string& name, const vector<Step>& steps, bool csv)
+{
+	if (csv) out << name << ",circuits,solved,unsolved,too_complex,missed,mean_ms,p50_ms,p90_ms,max_ms,mean_nodes,growth" << endl;
+	else out << name << "\tcircuits\tsolved\tunsolved\ttoocomplex\tmissed\tmean ms\tp50 ms\tp90 ms\tmax ms\tnodes\tgrowth" << endl;
+
+	const char* sep = csv ? "," : "\t";
+	for(size_t i = 0; i < steps.size(); i++)
+	{
+		vector<double> times = steps[i].times;
+		sort(times.begin(), times.end());
+		const double mean = Mean(times);
+		const double prev = i > 0 ? Mean(steps[i - 1].times) : 0;
+
+		out.unsetf(ios::floatfield);
+		out.precision(6);
+		out << steps[i].value << sep << times.size() << sep << steps[i].solved << sep << steps[i].unsolved << sep
+			<< steps[i].tooComplex << sep << steps[i].missed << sep << std::fixed;
+		out.precision(3);
+		out << mean * 1000.0 << sep << Percentile(times, 0.5) * 1000.0 << sep << Percentile(times, 0.9) * 1000.0 << sep
+			<< (times.empty() ? 0 : times.back() * 1000.0) << sep;
+		out.precision(0);
+		out << (times.empty() ? 0 : steps[i].nodes / times.size()) << sep;
+		out.precision(2);
+		if (prev > 0) out << mean / prev << (csv ? "" : "x");
+		out << endl;
+	}
+}
+
+vector<string> Split(const string& in)
+{
+	vector<string> out;
+	stringstream stream(in);
+	string item;
+	while(getline(stream, item, ',')) if (!item.empty()) out.push_back(item);
+	return out;
+}
+
+bool WriteFile(const string& filename, const string& text)
+{
+	fstream file(filename.c_str(), fstream::out);
+	if (!file.is_open())
+	{
+		cerr << "Unable to write: " << filename << endl;
+		return false;
+	}
+	file << text;
+	return true;
+}
+
+const char* OutcomeName(Generator::Outcome outcome)
+{
+	switch(outcome)
+	{
+	case Generator::eSolved:		return "solved";
+	case Generator::eTooComplex:	return "toocomplex";
+	default:						return "unsolved";
+	}
+}
+
+int main(int argc, char** argv)
+{
+	string compDefFile = "component.types";
+	string outDir;
+	string sweep;
+	string sweepValues;
+	string types = "R,R,R,R,C,C,L,D";
+	string format = "text";
+	int lists = 5;
+	int circuits = 20;
+	unsigned int seed = 1;
+	int heuristics = CircuitSolver3::eAllHeuristics;
+	double budget = 5.0;
+	GenParams params;
+
+	for(int i = 1; i < argc; i++)
+	{
+		string option = argv[i];
+		if (option[0] != '-' || i + 1 >= argc) usage(argv[0]);
+
+		string value = argv[++i];
+		if (option == "-d") compDefFile = value;
+		else if (option == "-o") outDir = value;
+		else if (option == "-S") sweep = value;
+		else if (option == "-V") sweepValues = value;
+		else if (option == "-l") lists = atoi(value.c_str());
+		else if (option == "-n") circuits = atoi(value.c_str());
+		else if (option == "-r") seed = (unsigned int)atoi(value.c_str());
+		else if (option == "-T") types = value;
+		else if (option == "-H") heuristics = atoi(value.c_str());
+		else if (option == "-b") budget = atof(value.c_str());
+		else if (option == "-f") format = value;
+		else if (option == "-P")
+		{
+			size_t eq = value.find('=');
+			if (eq == string::npos || !params.Set(value.substr(0, eq), atof(value.substr(eq + 1).c_str()))) usage(argv[0]);
+		}
+		else usage(argv[0]);
+	}
+	if (lists <= 0 || circuits <= 0 || (outDir.empty() == sweep.empty())) usage(argv[0]);
+	if (!sweep.empty() && sweepValues.empty()) sweepValues = DefaultSweep(sweep);
+	if (!sweep.empty() && (sweepValues.empty() || !GenParams().Set(sweep, 0))) usage(argv[0]);
+
+	ComponentDefinitionReader compdef;
+	if (!compdef.ReadFile(compDefFile))
+	{
+		cerr << "Can't find component definitions file: " << compDefFile << endl;
+		return 1;
+	}
+
+	Generator generator(compdef.GetDefinitions(), seed, heuristics, budget);
+	if (!generator.SetTypes(Split(types)))
+	{
+		cerr << "No usable component types, the definitions need SHORTCUT and two pin types with values" << endl;
+		return 1;
+	}
+
+	try
+	{
+		if (!outDir.empty())
+		{
+			string conf;
+			stringstream index;
+			Step totals(0);
+			for(int l = 0; l < lists; l++)
+			{
+				GenList list;
+				generator.MakeList(params, list);
+				ListComponent::tComponentList maxlist;
+				if (!generator.Parse(list.text, maxlist)) throw BasicException("generated maxlist doesn't parse");
+
+				const string listName = "gen" + ToString(l);
+				if (!WriteFile(outDir + "/" + listName + ".max", list.text)) return 1;
+				conf += listName + ".max\n";
+
+				for(int c = 0; c < circuits; c++)
+				{
+					Generator::Case genCase;
+					if (!generator.MakeCase(params, list, maxlist, genCase)) continue;
+					totals.Add(genCase);
+
+					char fileName[64];
+					sprintf(fileName, "%s_%04d.circuit", listName.c_str(), c);
+					if (!WriteFile(outDir + "/" + fileName, genCase.text)) return 1;
+					index << fileName << " " << listName << " " << OutcomeName(genCase.outcome) << endl;
+				}
+			}
+			if (!WriteFile(outDir + "/maxlists.conf", conf) || !WriteFile(outDir + "/circuits.txt", index.str())) return 1;
+
+			cout << "Wrote " << lists << " maxlists and " << totals.times.size() << " circuits to " << outDir
+				<< ": " << totals.solved << " solved, " << totals.unsolved << " unsolved, " << totals.tooComplex << " too complex" << endl;
+			if (totals.missed) cout << totals.missed << " circuits built to be solvable were not solved" << endl;
+			return 0;
+		}
+
+		vector<Step> steps;
+		vector<string> values = Split(sweepValues);
+		for(size_t v = 0; v < values.size(); v++)
+		{
+			GenParams stepParams = params;
+			stepParams.Set(sweep, atof(values[v].c_str()));
+			Step step(atof(values[v].c_str()));
+
+			for(int l = 0; l < lists; l++)
+			{
+				GenList list;
+				generator.MakeList(stepParams, list);
+				ListComponent::tComponentList maxlist;
+				if (!generator.Parse(list.text, maxlist)) throw BasicException("generated maxlist doesn't parse");
+
+				for(int c = 0; c < circuits; c++)
+				{
+					Generator::Case genCase;
+					if (generator.MakeCase(stepParams, list, maxlist, genCase)) step.Add(genCase);
+				}
+			}
+			steps.push_back(step);
+		}
+		WriteSweep(cout, sweep, steps, format == "csv");
+	}
+	catch(BasicException& e)
+	{
+		cerr << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
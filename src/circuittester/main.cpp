@@ -2,7 +2,11 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <sstream>
 #include <algorithm>
+#include <map>
+#include <math.h>
+#include <stdlib.h>
 
 #include <instruments/circuitlist.h>
 #include <instruments/circuitsolver3.h>
@@ -10,8 +14,10 @@
 #include <instruments/compdefreader.h>
 #include <instruments/listproducer.h>
 #include <instruments/netlist2.h>
+#include <measureserver/circuitarchive.h>
 
 #include <util/timer.h>
+#include <util/thread.h>
 
 #include <contrib/md5.h>
 
@@ -22,6 +28,7 @@
 #else
 #include <glob.h>
 #include <libgen.h>
+#include <time.h>
 #define DIR_SEPARATOR "/"
 #endif
 
@@ -40,7 +47,13 @@ void usage(char* cmdname)
 	cout << "  -d <compdef>" << endl;
 	cout << "  -o <output>" << endl;
 	cout << "  -m <maxlistconf>" << endl;
+	cout << "  -a <archive>            also solve the circuits in a server circuit archive" << endl;
 	cout << "  -v" << endl;
+	cout << "  -s                      silent, only print the totals" << endl;
+	cout << "  -j <threads>            solve the files on this many threads, circuits are timed in thread cpu time" << endl;
+	cout << "  -r <report>             write per circuit results, json if the name ends with .json, else csv" << endl;
+	cout << "  --compare <baseline>    flag circuits whose solution or time differs from a json report" << endl;
+	cout << "  -t <factor>             time change that is flagged by --compare, default 2" << endl;
 
 	exit(1); // sale del programa, para que puedas reintentar el enviar datos en formato correcto.
 }
@@ -132,7 +145,7 @@ bool ReadMaxList(string file, tMaxLists& maxLists, const ListParser::tComponentD
 {
 	NormalizeWinPath(file); // Cambiamos la barra / por doble barra //
 
-	ListParser parser(compdefs); // creamos un objeto lipo parser y le pasamos la definicion de los componentes
+	ListParser parser(compdefs, true); // creamos un objeto lipo parser y le pasamos la definicion de los componentes
 	if (!parser.ParseFile(file)) // Ha podido parsear el archivo .max?
 	{
 		cerr << "failed to read maxlist: " << file << endl; //imprimimos que fallo la lectura del archivo .max
@@ -176,6 +189,387 @@ bool LoadMaxlists(string maxlistConf, tMaxLists& maxLists, const ListParser::tCo
 	return true; //lectura correcta, retornamos true
 }
 
+/// The outcome of one input file
+struct CircuitResult
+{
+	enum Status { eParseError, eSolved, eUnsolved };
+
+	string		file;
+	Status		status;
+	string		maxlist;	///< the matching maxlist when solved
+	string		md5;		///< of the sorted solution
+	string		solution;	///< sorted, as written with -o
+	string		netlist;	///< only kept with -v
+	double		time;		///< thread cpu seconds spent solving
+	SolverStats	stats;		///< summed over the maxlists tried
+
+	CircuitResult() : status(eParseError), time(0) {}
+};
+typedef vector<CircuitResult> tResults;
+
+const char* StatusName(CircuitResult::Status status)
+{
+	switch(status)
+	{
+		case CircuitResult::eSolved:	return "solved";
+		case CircuitResult::eUnsolved:	return "unsolved";
+		default:						return "parse error";
+	}
+}
+
+string SolutionMd5(const string& solutionstr)
+{
+	unsigned char md5sum[16];
+	md5((unsigned char*)solutionstr.c_str(), solutionstr.size(), md5sum);
+
+	char output[33];
+	for( int i = 0; i < 16; i++ )
+	{
+		sprintf(&output[i*2] , "%02x", md5sum[i]);
+	}
+	output[32] = '\0';
+	return output;
+}
+
+/// CPU time used by the calling thread in seconds. Circuits are timed with it
+/// so the times don't depend on how many other threads share the cores
+double ThreadTime()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) return 0;
+	ULARGE_INTEGER k, u;
+	k.LowPart = kernel.dwLowDateTime;
+	k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime;
+	u.HighPart = user.dwHighDateTime;
+	return (double)(k.QuadPart + u.QuadPart) / 10000000.0;
+#else
+	timespec now;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0) return 0;
+	return now.tv_sec + now.tv_nsec / 1000000000.0;
+#endif
+}
+
+/// Everything the workers share, the results are indexed like the files followed by the archived circuits
+struct Batch
+{
+	const vector<string>*	pFiles;
+	const CircuitArchive*	pArchive;
+	string					archiveDir;
+	const tMaxLists*		pMaxLists;
+	const ListParser::tComponentDefinitions* pCompDefs;
+	int						verbose;
+	tResults				results;
+
+	Mutex					mutex;
+	size_t					next;
+};
+
+void SolveFile(Batch& batch, size_t index)
+{
+	CircuitResult& result = batch.results[index];
+
+	ListParser parser(*batch.pCompDefs);
+	bool parsed = false;
+	if (index < batch.pFiles->size())
+	{
+		result.file = (*batch.pFiles)[index];
+		parsed = parser.ParseFile(result.file);
+	}
+	else
+	{
+		// named like the file circuitarchive exports it to, so reports compare with an exported corpus
+		CircuitArchive::Record record;
+		const size_t archiveIndex = index - batch.pFiles->size();
+		if (batch.pArchive->Read(archiveIndex, record))
+		{
+			result.file = batch.archiveDir + DIR_SEPARATOR + record.md5 + ".circuit";
+			parsed = parser.Parse(record.circuit);
+		}
+		else
+		{
+			stringstream name;
+			name << batch.archiveDir << " record " << archiveIndex;
+			result.file = name.str();
+		}
+	}
+
+	if (!parsed)
+	{
+		result.status = CircuitResult::eParseError;
+		return;
+	}
+
+	const double start = ThreadTime();
+	result.status = CircuitResult::eUnsolved;
+
+	for(tMaxLists::const_iterator maxit = batch.pMaxLists->begin(); maxit != batch.pMaxLists->end(); ++maxit)
+	{
+		CircuitList solver;
+		if (batch.verbose) solver.EnableLogging();
+
+		const bool found = solver.Solve(parser.GetList(), maxit->second);
+		result.stats.Add(solver.GetStats());
+		if (!found) continue;
+
+		result.status = CircuitResult::eSolved;
+		result.maxlist = maxit->first;
+
+		CircuitList::tCircuitList solution = solver.GetSolution();
+		if (batch.verbose)
+		{
+			NetList2 solvednetlist;
+			solvednetlist.SetNodeList(solution);
+			result.netlist = solvednetlist.GetNetListAsString();
+		}
+
+		sort(solution.begin(), solution.end());
+		result.solution = ListProducer::Produce(solution);
+		result.md5 = SolutionMd5(result.solution);
+		break;
+	}
+
+	result.time = ThreadTime() - start;
+}
+
+class BatchWorker : public Thread
+{
+public:
+	BatchWorker(Batch* pBatch) : mpBatch(pBatch) {}
+
+	virtual void Run()
+	{
+		for(;;)
+		{
+			mpBatch->mutex.Lock();
+			size_t index = mpBatch->next++;
+			mpBatch->mutex.Unlock();
+
+			if (index >= mpBatch->results.size()) return;
+			SolveFile(*mpBatch, index);
+		}
+	}
+private:
+	Batch* mpBatch;
+};
+
+string JsonString(const string& in)
+{
+	string out = "\"";
+	for(size_t i = 0; i < in.size(); i++)
+	{
+		if (in[i] == '"' || in[i] == '\\') out += '\\';
+		out += in[i];
+	}
+	return out + "\"";
+}
+
+/// Nearest rank percentile of sorted times
+double Percentile(const vector<double>& sorted, double p)
+{
+	if (sorted.empty()) return 0;
+	size_t rank = (size_t)ceil(p * sorted.size());
+	if (rank < 1) rank = 1;
+	return sorted[rank - 1];
+}
+
+struct Summary
+{
+	int		processed;
+	int		solved;
+	int		unsolved;
+	int		parseErrors;
+	double	p50, p90, p99, max;
+	map<string, int>	hits;		// per maxlist
+	vector<size_t>		slowest;	// result indices, slowest first
+};
+
+bool SlowerThan(const CircuitResult* a, const CircuitResult* b)
+{
+	return a->time > b->time;
+}
+
+void Summarize(const tResults& results, const tMaxLists& maxLists, Summary& summary)
+{
+	summary.processed = summary.solved = summary.unsolved = summary.parseErrors = 0;
+	for(tMaxLists::const_iterator it = maxLists.begin(); it != maxLists.end(); ++it) summary.hits[it->first] = 0;
+
+	vector<double> times;
+	vector<const CircuitResult*> bytime;
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		const CircuitResult& result = results[i];
+		if (result.status == CircuitResult::eParseError)
+		{
+			summary.parseErrors++;
+			continue;
+		}
+
+		summary.processed++;
+		if (result.status == CircuitResult::eSolved)
+		{
+			summary.solved++;
+			summary.hits[result.maxlist]++;
+		}
+		else summary.unsolved++;
+
+		times.push_back(result.time);
+		bytime.push_back(&result);
+	}
+
+	sort(times.begin(), times.end());
+	summary.p50 = Percentile(times, 0.50);
+	summary.p90 = Percentile(times, 0.90);
+	summary.p99 = Percentile(times, 0.99);
+	summary.max = times.empty() ? 0 : times.back();
+
+	stable_sort(bytime.begin(), bytime.end(), SlowerThan);
+	for(size_t i = 0; i < bytime.size() && i < 10; i++) summary.slowest.push_back(bytime[i] - &results[0]);
+}
+
+bool WriteCsvReport(const string& filename, const tResults& results)
+{
+	fstream out(filename.c_str(), fstream::out);
+	if (!out.is_open()) return false;
+
+	out << "file,result,maxlist,md5,time_ms,nodes,backtracks,shortcut_searches" << endl;
+	for(tResults::const_iterator it = results.begin(); it != results.end(); ++it)
+	{
+		out << it->file << "," << StatusName(it->status) << "," << it->maxlist << "," << it->md5 << ","
+			<< std::fixed << (it->time * 1000.0) << "," << it->stats.nodes << "," << it->stats.backtracks << ","
+			<< it->stats.shortcutSearches << endl;
+	}
+	return true;
+}
+
+bool WriteJsonReport(const string& filename, const tResults& results, const Summary& summary)
+{
+	fstream out(filename.c_str(), fstream::out);
+	if (!out.is_open()) return false;
+
+	// one circuit per line, --compare depends on it
+	out << "{" << endl << "\"circuits\": [" << endl;
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		const CircuitResult& r = results[i];
+		out << "{\"file\": " << JsonString(r.file) << ", \"result\": " << JsonString(StatusName(r.status))
+			<< ", \"maxlist\": " << JsonString(r.maxlist) << ", \"md5\": " << JsonString(r.md5)
+			<< ", \"time_ms\": " << std::fixed << (r.time * 1000.0) << ", \"nodes\": " << r.stats.nodes
+			<< ", \"backtracks\": " << r.stats.backtracks << ", \"shortcut_searches\": " << r.stats.shortcutSearches << "}"
+			<< (i + 1 < results.size() ? "," : "") << endl;
+	}
+	out << "]," << endl;
+
+	out << "\"summary\": {\"processed\": " << summary.processed << ", \"solved\": " << summary.solved
+		<< ", \"unsolved\": " << summary.unsolved << ", \"parse_errors\": " << summary.parseErrors
+		<< ", \"p50_ms\": " << (summary.p50 * 1000.0) << ", \"p90_ms\": " << (summary.p90 * 1000.0)
+		<< ", \"p99_ms\": " << (summary.p99 * 1000.0) << ", \"max_ms\": " << (summary.max * 1000.0) << "}," << endl;
+
+	out << "\"maxlists\": [";
+	for(map<string, int>::const_iterator it = summary.hits.begin(); it != summary.hits.end(); ++it)
+	{
+		out << (it == summary.hits.begin() ? "" : ", ") << "{\"name\": " << JsonString(it->first) << ", \"hits\": " << it->second << "}";
+	}
+	out << "]," << endl;
+
+	out << "\"slowest\": [";
+	for(size_t i = 0; i < summary.slowest.size(); i++)
+	{
+		const CircuitResult& r = results[summary.slowest[i]];
+		out << (i ? ", " : "") << "{\"file\": " << JsonString(r.file) << ", \"time_ms\": " << (r.time * 1000.0) << "}";
+	}
+	out << "]" << endl << "}" << endl;
+	return true;
+}
+
+/// Read the value of "name" from a line of a json report, strings are unescaped
+bool JsonField(const string& line, const string& name, string& value)
+{
+	const string key = "\"" + name + "\": ";
+	size_t pos = line.find(key);
+	if (pos == string::npos) return false;
+	pos += key.size();
+
+	value.clear();
+	if (pos < line.size() && line[pos] == '"')
+	{
+		for(pos++; pos < line.size() && line[pos] != '"'; pos++)
+		{
+			if (line[pos] == '\\') pos++;
+			if (pos < line.size()) value += line[pos];
+		}
+		return true;
+	}
+
+	size_t end = line.find_first_of(",}", pos);
+	value = line.substr(pos, end == string::npos ? string::npos : end - pos);
+	return true;
+}
+
+struct BaselineEntry
+{
+	string	md5;
+	double	time;
+};
+typedef map<string, BaselineEntry> tBaseline;
+
+bool ReadBaseline(const string& filename, tBaseline& baseline)
+{
+	fstream in(filename.c_str(), fstream::in);
+	if (!in.is_open()) return false;
+
+	string line;
+	while(getline(in, line))
+	{
+		string file, md5, time;
+		if (!JsonField(line, "file", file) || !JsonField(line, "md5", md5) || !JsonField(line, "time_ms", time)) continue;
+
+		BaselineEntry entry;
+		entry.md5 = md5;
+		entry.time = atof(time.c_str()) / 1000.0;
+		baseline[file] = entry;
+	}
+	return true;
+}
+
+/// Returns the number of circuits with another solution or slower than before
+int CompareBaseline(const tResults& results, const tBaseline& baseline, double factor)
+{
+	// small circuits solve in well under a millisecond, don't flag noise
+	const double minDifference = 0.0005;
+	int flagged = 0;
+
+	for(tResults::const_iterator it = results.begin(); it != results.end(); ++it)
+	{
+		if (it->status == CircuitResult::eParseError) continue;
+
+		tBaseline::const_iterator found = baseline.find(it->file);
+		if (found == baseline.end())
+		{
+			cout << "NEW " << it->file << endl;
+			continue;
+		}
+
+		const BaselineEntry& base = found->second;
+		if (base.md5 != it->md5)
+		{
+			cout << "CHANGED " << it->file << " solution " << (base.md5.empty() ? "none" : base.md5) << " -> " << (it->md5.empty() ? "none" : it->md5) << endl;
+			flagged++;
+		}
+
+		const double diff = fabs(it->time - base.time);
+		if (diff > minDifference && (it->time > base.time * factor || base.time > it->time * factor))
+		{
+			cout << (it->time > base.time ? "SLOWER " : "FASTER ") << it->file << " " << std::fixed
+				<< (base.time * 1000.0) << "ms -> " << (it->time * 1000.0) << "ms" << endl;
+			if (it->time > base.time) flagged++;
+		}
+	}
+
+	return flagged;
+}
+
 // argc contiene el numero de argumentos pasados por consola y argv los argumentos 
 // (argv[0] siempre es el nombre del programa
 // cada espacio en blanco cuenta un argumento 
@@ -188,8 +582,13 @@ int main(int argc, char** argv)
 	string aCompDefFile = COMPONENT_DEFINITION;
 	string aOutDir = "";
 	string aMaxListConf = "";
+	string aArchive = "";
 	int		aVerbose = 0;
 	int		aSilent = 0;
+	string	aThreads = "1";
+	string	aReport = "";
+	string	aBaseline = "";
+	string	aFactor = "2";
 
 	struct sOptions {
 		string option;
@@ -199,8 +598,12 @@ int main(int argc, char** argv)
 		{ "d:", &aCompDefFile, NULL }
 		, { "o:", &aOutDir, NULL }
 		, { "m:", &aMaxListConf, NULL }
+		, { "a:", &aArchive, NULL }
 		, { "v", NULL, &aVerbose }
 		, { "s", NULL, &aSilent }
+		, { "j:", &aThreads, NULL }
+		, { "r:", &aReport, NULL }
+		, { "t:", &aFactor, NULL }
 	};	
 
 	if (argc < 2) usage(argv[0]);
@@ -215,7 +618,12 @@ int main(int argc, char** argv)
 	while(parseFlags && i<argc)
 	{
 		string option = argv[i];
-		if (option[0] == '-') // debe empezar por -
+		if (option == "--compare")
+		{
+			if (i+1 < argc) aBaseline = argv[++i];
+			i++;
+		}
+		else if (option[0] == '-') // debe empezar por -
 		{
 			if (option.size() > 1) // el arguemento debe contener algo mas que -
 			{
@@ -257,7 +665,14 @@ int main(int argc, char** argv)
 		BuildFileList(argv[i], fileList); // creamos un fileList con esta netlist de circuito a testear
 	}
 
-	if (fileList.empty()) // ¿no se le ha pasado ninguna netlist de circuito a testear?
+	CircuitArchive archive;
+	if (!aArchive.empty() && !archive.Open(aArchive))
+	{
+		cerr << "Can't open circuit archive: " << aArchive << endl;
+		exit(1);
+	}
+
+	if (fileList.empty() && archive.Size() == 0) // ¿no se le ha pasado ninguna netlist de circuito a testear?
 	{
 		cerr << "No input files" << endl; //imprimimos error indicandolo
 		usage(argv[0]); // mostramos menu con opciones
@@ -278,118 +693,135 @@ int main(int argc, char** argv)
 		}
 	}
 
-	timer total_timer;
+	int threads = atoi(aThreads.c_str());
+	if (threads < 1) threads = 1;
+	if (aVerbose) threads = 1; // the solver log is shared
 
-	// statistics
-	int processed = 0;
-	int solved = 0;
-	int unsolved = 0;
-	double totalTime = 0;
-	double totalSolvedTime = 0;
-	double totalUnsolvedTime = 0;
+	tBaseline baseline;
+	if (!aBaseline.empty() && !ReadBaseline(aBaseline, baseline))
+	{
+		cerr << "Can't read baseline: " << aBaseline << endl;
+		exit(1);
+	}
+
+	timer total_timer;
 
-	for(vector<string>::const_iterator it = fileList.begin(); it != fileList.end(); it++)
+	// the maxlists of one circuit are tried in order on one thread, so the time per circuit
+	// is what the server spends on it, the files are spread over the threads
+	Batch batch;
+	batch.pFiles	= &fileList;
+	batch.pArchive	= &archive;
+	batch.archiveDir	= aArchive;
+	batch.pMaxLists	= &aMaxLists;
+	batch.pCompDefs	= &compdef.GetDefinitions();
+	batch.verbose	= aVerbose;
+	batch.results.resize(fileList.size() + archive.Size());
+	batch.next		= 0;
+
+	vector<BatchWorker*> workers;
+	for(int t = 1; t < threads; t++)
 	{
-		ListParser parser(compdef.GetDefinitions());
-		//cout << "Parsing: " << *it << endl;
-		if (!parser.ParseFile(*it))
+		BatchWorker* pWorker = new BatchWorker(&batch);
+		if (!pWorker->Start())
 		{
-			cerr << "Unable to parse: " << *it << endl;
-			continue;
+			cerr << "Failed to start worker thread" << endl;
+			delete pWorker;
+			break;
 		}
+		workers.push_back(pWorker);
+	}
 
-		bool found = false;
-		tMaxLists::const_iterator maxit = aMaxLists.begin();
+	BatchWorker(&batch).Run();
 
-		CircuitList solver;
-		if (aVerbose) solver.EnableLogging();
-		
-		timer solvetimer;
+	for(size_t t = 0; t < workers.size(); t++)
+	{
+		workers[t]->Join();
+		delete workers[t];
+	}
 
-		while(!found && maxit != aMaxLists.end())
-		{
-			//cout << "Testing against maxlist: " << maxit->first << endl;
-			if (solver.Solve(parser.GetList(), maxit->second))
-			{
-				//cout << "Found solution against: " << maxit->first << endl;
-				found = true;
+	double totalTime = 0;
+	double totalSolvedTime = 0;
+	double totalUnsolvedTime = 0;
 
-				if (aVerbose)
-				{
-					cout << "Solution:" << endl;
-					NetList2 solvednetlist;
-					solvednetlist.SetNodeList(solver.GetSolution());
-					cout << solvednetlist.GetNetListAsString() << endl;
-				}
-			}
-			else
-			{
-				maxit++;
-			}
+	for(tResults::const_iterator it = batch.results.begin(); it != batch.results.end(); ++it)
+	{
+		if (it->status == CircuitResult::eParseError)
+		{
+			cerr << "Unable to parse: " << it->file << endl;
+			continue;
 		}
 
-		double solvetime = solvetimer.elapsed();
-		totalTime += solvetime;
-		processed++;
-
-		if (found)
+		totalTime += it->time;
+		if (it->status == CircuitResult::eSolved)
 		{
-			solved++;
-			totalSolvedTime += solvetime;
+			totalSolvedTime += it->time;
 
 			if (aSilent) continue;
 
-			cout << *it << " matches " << maxit->first;
-
-			CircuitList::tCircuitList solution = solver.GetSolution();
-			sort(solution.begin(), solution.end());
-			string solutionstr = ListProducer::Produce(solution);			
-
-			unsigned char md5sum[16];
-			md5((unsigned char*)solutionstr.c_str(), solutionstr.size(), md5sum);
-
-			char output[33];
-			for( int i = 0; i < 16; i++ )
-			{
-				sprintf(&output[i*2] , "%02x", md5sum[i]);
-			}
-			output[32] = '\0';
-
-			cout << " " << output << endl;
+			if (aVerbose) cout << "Solution:" << endl << it->netlist << endl;
+			cout << it->file << " matches " << it->maxlist << " " << it->md5 << endl;
 
 			if (aOutDir != "")
 			{
-				string filename = string(aOutDir) + "\\" + BaseName(*it) + ".solved";
+				string filename = string(aOutDir) + "\\" + BaseName(it->file) + ".solved";
 				fstream ofile(filename.c_str(), fstream::out);
 				if (!ofile.is_open()) cerr << "Failed to write output file: " << filename << endl;
-				//ofile << "# Input:   " << *it << endl;
-				//ofile << "# Maxlist: " << maxit->first << endl;
-				//ofile << "# Solution: " << endl;
-				ofile << solutionstr << endl;
+				ofile << it->solution << endl;
 			}
 		}
 		else
 		{
-			unsolved++;
-			totalUnsolvedTime += solvetime;
-			
+			totalUnsolvedTime += it->time;
+
 			if (aSilent) continue;
-			cout << *it << " has no solution" << endl;
+			cout << it->file << " has no solution" << endl;
 		}
 	}
 
-	cerr << "Time: " << total_timer.elapsed() << endl;
+	Summary summary;
+	Summarize(batch.results, aMaxLists, summary);
 
-	double avgtot = totalTime / processed;
-	double avgsolved = totalSolvedTime / processed;
-	double avgunsolved = totalUnsolvedTime / unsolved;
+	cerr << "Time: " << total_timer.elapsed() << " on " << threads << " threads" << endl;
+
+	double avgtot = totalTime / summary.processed;
+	double avgsolved = totalSolvedTime / summary.processed;
+	double avgunsolved = totalUnsolvedTime / summary.unsolved;
 	avgtot *= 1000.0;
 	avgsolved *= 1000.0;
 	avgunsolved *= 1000.0;
 
-	cerr << "Total processed: " << processed << " avg time: " << std::fixed << avgtot << "ms" << endl;
-	cerr << "Solved: " << solved << " avg time: " << std::fixed << avgsolved << "ms" << endl;
-	cerr << "Unsolved: " << unsolved << " avg time: " << std::fixed << avgunsolved << "ms" << endl;
+	cerr << "Total processed: " << summary.processed << " avg time: " << std::fixed << avgtot << "ms" << endl;
+	cerr << "Solved: " << summary.solved << " avg time: " << std::fixed << avgsolved << "ms" << endl;
+	cerr << "Unsolved: " << summary.unsolved << " avg time: " << std::fixed << avgunsolved << "ms" << endl;
+	cerr << "Solve time p50: " << (summary.p50 * 1000.0) << "ms p90: " << (summary.p90 * 1000.0)
+		<< "ms p99: " << (summary.p99 * 1000.0) << "ms max: " << (summary.max * 1000.0) << "ms" << endl;
+
+	for(map<string, int>::const_iterator it = summary.hits.begin(); it != summary.hits.end(); ++it)
+	{
+		cerr << "Maxlist " << it->first << ": " << it->second << " hits" << endl;
+	}
+
+	for(size_t s = 0; s < summary.slowest.size(); s++)
+	{
+		const CircuitResult& r = batch.results[summary.slowest[s]];
+		cerr << "Slow: " << r.file << " " << (r.time * 1000.0) << "ms" << endl;
+	}
+
+	if (!aReport.empty())
+	{
+		const bool json = aReport.size() > 5 && aReport.compare(aReport.size() - 5, 5, ".json") == 0;
+		if (!(json ? WriteJsonReport(aReport, batch.results, summary) : WriteCsvReport(aReport, batch.results)))
+		{
+			cerr << "Failed to write report: " << aReport << endl;
+		}
+	}
+
+	if (!aBaseline.empty())
+	{
+		int flagged = CompareBaseline(batch.results, baseline, atof(aFactor.c_str()));
+		cerr << "Compared with " << aBaseline << ": " << flagged << " circuits changed or slower" << endl;
+		if (flagged > 0) return 2;
+	}
 
 	return 0;
 }
\ No newline at end of file
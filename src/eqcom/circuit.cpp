@@ -41,11 +41,21 @@
 #include "eqlog.h"
 
 #include <sstream>
+#include <algorithm>
+#include <iterator>
 
 using namespace EqSrv;
 using namespace std;
 
 bool Circuit::BuildCircuitSetup(std::ostream& out, InstrumentBlock* pBlock, NetList2& lookup)
+{
+	CircuitState state;
+	MatchCircuit(state, pBlock, lookup);
+	WriteCircuitSetup(out, state);
+	return true;
+}
+
+void Circuit::MatchCircuit(CircuitState& state, InstrumentBlock* pBlock, NetList2& lookup)
 {
 	NetList2 netlist = pBlock->GetNodeInterpreter()->GetNetList();
 	NetList2::tNodeList nodes = netlist.GetNodeList(); // copy
@@ -70,35 +80,25 @@ bool Circuit::BuildCircuitSetup(std::ostream& out, InstrumentBlock* pBlock, NetL
 	// check if we have all nodes in hw
 	if (ListAlgorithm::MatchIndex(nodes, componentList, matchedNodes))
 	{
-		if (matchedNodes.empty()) return true;
+		if (matchedNodes.empty()) return;
 
-		out << InstrumentHeadType(V3_CircuitBuilder) << "3 ";
-
-		bool first = true;
 		std::stringstream logMessage;
 		logMessage << "component numbers:";
 		for(ListAlgorithm::tIndexPairs::iterator it = matchedNodes.begin(); it != matchedNodes.end(); ++it)
 		{
-			if (!first)
-			{
-				out << "?";
-			}
-			else first = false;
-			out << componentList[it->first].GetName();
+			state.components.push_back(componentList[it->first].GetName());
 			logMessage << " " << componentList[it->first].GetName();
 		}
 
 		eqlog.Log(5) << logMessage.str() << endl;
-		out << "\n";
 
-		// output any potentiometer values
+		// collect any potentiometer values
 		for(ListAlgorithm::tIndexPairs::iterator it = matchedNodes.begin(); it != matchedNodes.end(); ++it)
 		{
 			if (componentList[it->first].GetType() == "POT")
 			{
 				if (!nodes[it->second].GetSpecial().empty()) {
-					out << InstrumentHeadType(V3_CircuitBuilder) << "7 "
-						<< componentList[it->first].GetName() << " " << nodes[it->second].GetSpecial() << "\n";
+					state.potentiometers[componentList[it->first].GetName()] = nodes[it->second].GetSpecial();
 					eqlog.Out(5) << "Potentiometer " << componentList[it->first].GetName()
 						<< " set to " << nodes[it->second].GetSpecial() << endl;
 				}
@@ -114,8 +114,91 @@ bool Circuit::BuildCircuitSetup(std::ostream& out, InstrumentBlock* pBlock, NetL
 			<< netlist.GetNetListAsString() << endl;
 		throw BasicException("Matched checklist is not a subset of the component list. Contact the administrator");
 	}
+}
+
+void Circuit::WriteComponents(std::ostream& out, int func, const CircuitState::tComponents& components)
+{
+	out << InstrumentHeadType(V3_CircuitBuilder) << func << " ";
+
+	for(CircuitState::tComponents::const_iterator it = components.begin(); it != components.end(); ++it)
+	{
+		if (it != components.begin()) out << "?";
+		out << *it;
+	}
+	out << "\n";
+}
 
-	return true;
+void Circuit::WriteCircuitSetup(std::ostream& out, const CircuitState& state)
+{
+	if (state.components.empty()) return;
+
+	WriteComponents(out, 3, state.components);
+
+	// the potentiometers are written in matching order
+	for(CircuitState::tComponents::const_iterator it = state.components.begin(); it != state.components.end(); ++it)
+	{
+		CircuitState::tSettings::const_iterator pot = state.potentiometers.find(*it);
+		if (pot != state.potentiometers.end())
+		{
+			out << InstrumentHeadType(V3_CircuitBuilder) << "7 " << pot->first << " " << pot->second << "\n";
+		}
+	}
+}
+
+void Circuit::WriteCircuitChange(std::ostream& out, const CircuitState& from, const CircuitState& to)
+{
+	CircuitState::tComponents before(from.components), after(to.components);
+	std::sort(before.begin(), before.end());
+	std::sort(after.begin(), after.end());
+
+	CircuitState::tComponents disconnect, connect;
+	std::set_difference(before.begin(), before.end(), after.begin(), after.end(), std::back_inserter(disconnect));
+	std::set_difference(after.begin(), after.end(), before.begin(), before.end(), std::back_inserter(connect));
+
+	// break before make
+	if (!disconnect.empty()) WriteComponents(out, V3_CircuitDisconnect, disconnect);
+	if (!connect.empty()) WriteComponents(out, V3_CircuitConnect, connect);
+
+	// potentiometers that were switched in or got another setting
+	for(CircuitState::tSettings::const_iterator it = to.potentiometers.begin(); it != to.potentiometers.end(); ++it)
+	{
+		CircuitState::tSettings::const_iterator old = from.potentiometers.find(it->first);
+		if (old == from.potentiometers.end() || old->second != it->second)
+		{
+			out << InstrumentHeadType(V3_CircuitBuilder) << "7 " << it->first << " " << it->second << "\n";
+		}
+	}
+
+	eqlog.Log(5) << "circuit change: " << disconnect.size() << " out, " << connect.size() << " in" << endl;
+}
+
+void CircuitTracker::Write(std::ostream& out, const CircuitState& circuit, bool hasSwitches)
+{
+	if (mCanChange && mHasApplied)
+	{
+		Circuit::WriteCircuitChange(out, mApplied, circuit);
+		mSendingKnown = true;
+	}
+	else
+	{
+		// an empty circuit isn't sent, so what is left switched in is unknown
+		Circuit::WriteCircuitSetup(out, circuit);
+		mSendingKnown = !circuit.components.empty();
+	}
+	if (hasSwitches) mSendingKnown = false;
+	mSending = circuit;
+
+	// unknown until the equipment server has confirmed this order, errors leave it unknown
+	mHasApplied = false;
+}
+
+void CircuitTracker::Applied()
+{
+	if (!mSendingKnown) return;
+
+	mApplied = mSending;
+	mHasApplied = true;
+	mSendingKnown = false;
 }
 
 bool Circuit::BuildCircuitSwitch(std::ostream& out, InstrumentBlock* pBlock, NetList2& lookup)
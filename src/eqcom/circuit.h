@@ -30,6 +30,9 @@
 #define __EQ_CIRCUIT_H__
 
 #include <ostream>
+#include <string>
+#include <vector>
+#include <map>
 
 class InstrumentBlock;
 class NetList2;
@@ -37,15 +40,60 @@ class NetList2;
 namespace EqSrv
 {
 
+/// The equipment components a circuit switches in and the potentiometer settings
+class CircuitState
+{
+public:
+	typedef std::vector<std::string>			tComponents; // in matching order
+	typedef std::map<std::string, std::string>	tSettings;
+
+	tComponents	components;
+	tSettings	potentiometers;
+};
+
+/// What the equipment server has switched in, so the next circuit can be sent as a change to it.
+/// Nothing is known until the server has confirmed an order with a full setup
+class CircuitTracker
+{
+public:
+	/// the equipment server accepts connect and disconnect orders
+	void	SetCanChange(bool canChange) { mCanChange = canChange; }
+
+	/// write the circuit in front of an order, as a change when what the server has is known.
+	/// A switch toggles its shortcut after the setup, so what is left switched in after that is unknown
+	void	Write(std::ostream& out, const CircuitState& circuit, bool hasSwitches);
+
+	/// the equipment server has carried out the last written order
+	void	Applied();
+
+	/// the server state is unknown, like after a restart or an order without the circuit
+	void	Forget() { mHasApplied = mSendingKnown = false; }
+
+	CircuitTracker() : mCanChange(false), mHasApplied(false), mSendingKnown(false) {}
+private:
+	bool			mCanChange;
+	CircuitState	mApplied;		// the circuit of the equipment server, if mHasApplied
+	bool			mHasApplied;
+	CircuitState	mSending;		// applied once the equipment server confirms it, if mSendingKnown
+	bool			mSendingKnown;
+};
+
 class Circuit
 {
 public:
 	static bool BuildCircuitSetup(std::ostream& out, InstrumentBlock* pBlock, NetList2& lookup);
+	/// match the translated circuit of the block against the equipment components, throws if not all are there
+	static void MatchCircuit(CircuitState& state, InstrumentBlock* pBlock, NetList2& lookup);
+	/// switch in the whole circuit
+	static void WriteCircuitSetup(std::ostream& out, const CircuitState& state);
+	/// switch from one circuit to the other, only writing what differs
+	static void WriteCircuitChange(std::ostream& out, const CircuitState& from, const CircuitState& to);
 	//static bool	BuildInstrumentSetup(std::ostream& out, InstrumentBlock* pBlock);
 	static bool	BuildInstrumentSetup2(std::ostream& out, InstrumentBlock* pBlock);
 	static bool BuildCircuitSwitch(std::ostream& out, InstrumentBlock* pBlock, NetList2& lookup);
 private:
 	static unsigned int NodeToAddress(int node, bool hi);
+	static void WriteComponents(std::ostream& out, int func, const CircuitState::tComponents& components);
 
 	static bool BuildOscilloscope(std::ostream& out, InstrumentBlock* pBlock);
 	static bool BuildDigitalMultimeters(std::ostream& out, InstrumentBlock* pBlock);
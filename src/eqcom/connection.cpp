@@ -34,6 +34,7 @@
 #include <network/multiplexer.h>
 
 #include <stringop.h>
+#include <string.h>
 
 #include <serializer.h>
 #include <basic_exception.h>
@@ -167,10 +168,11 @@ void EqConnection::HandleEvent(int flags)
 			else if (rv > 0)
 			{
 				mReadState = eReadPacket;
-				std::string lenstr;
-				lenstr.insert(lenstr.end(), (char*)mReceiveBuffer.GetBuffer(), (char*) mReceiveBuffer.GetBuffer() + 7); //mReceiveBuffer.GetSize());
+				char lenstr[8];
+				memcpy(lenstr, mReceiveBuffer.GetBuffer(), 7);
+				lenstr[7] = '\0';
 
-				int len = ToInt(lenstr.c_str());
+				int len = atoi(lenstr);
 
 				if (len < 0 || len > 65535)
 				{
@@ -195,12 +197,11 @@ void EqConnection::HandleEvent(int flags)
 			}
 			else if (rv > 0)
 			{
-				std::string out;
-				out.insert(out.end(), (char*) mReceiveBuffer.GetBuffer(), (char*) mReceiveBuffer.GetBuffer() + mReceiveBuffer.GetSize());
+				Serializer aResSer;
+				aResSer.SetStream((const char*) mReceiveBuffer.GetBuffer(), mReceiveBuffer.GetSize());
 
-				eqlog.Log(5) << "Eq response packet: " << endl << "'" << out << "'" << endl;
+				eqlog.Log(5) << "Eq response packet: " << endl << "'" << aResSer.GetCStream() << "'" << endl;
 
-				Serializer aResSer(out.c_str());
 				mReadState = eReadHeader;
 				mReceiveBuffer.Clear();
 
@@ -34,6 +34,8 @@
 #include "header.h"
 #include "eqlog.h"
 
+#include <instruments/instrumentblock.h>
+#include <instruments/nodeinterpreter.h>
 #include <network/multiplexer.h>
 #include <measureserver/module.h>
 
@@ -52,7 +54,7 @@ using namespace std;
 EquipmentServerControl::EquipmentServerControl(Net::Multiplexer* pServer, Config* pConfig, ModuleServices* pService)
 {
 	mInitDone = false;
-	mpMeasurement = new EqMeasurement();
+	mpMeasurement = new EqMeasurement(this);
 	mpTransactionHandler = new EqTransactionHandler(pService);
 	mpCookie = NULL;
 	mMatrixDisabled = false;
@@ -181,6 +183,10 @@ bool EquipmentServerControl::RequestServerInfo()
 {
 	eqlog.Out(1) << "Sending component list request to equipment server" << endl;
 	mFailed = false;
+
+	// the equipment server may have restarted, begin with a full circuit setup
+	mCircuit.SetCanChange(false);
+	mCircuit.Forget();
 	
 	std::stringstream sstream;
 	sstream.imbue(std::locale::classic());
@@ -202,6 +208,12 @@ void EquipmentServerControl::OnResponse(Serializer& in)
 		EquipmentServerResponse::ParseResponse(in, setupAdaptor, mpService->GetComponentDefinitions());
 		mServerNetlist = *setupAdaptor.GetNetList();
 
+		if (setupAdaptor.CanChangeCircuit() && mpConfig->GetInt("EQ.CircuitChanges", 1) != 0)
+		{
+			eqlog.Out(1) << "Equipment server accepts circuit changes" << endl;
+			mCircuit.SetCanChange(true);
+		}
+
 		eqlog.Log(3) << "Eqserver returned netlist:" << endl << mServerNetlist.GetNetListAsString() << endl;
 		if (!mpService->ValidateMaxlists(mServerNetlist))
 		{
@@ -224,11 +236,28 @@ void EquipmentServerControl::OnError(std::string msg)
 }
 
 bool EquipmentServerControl::SendBakedRequest(InstrumentBlock* pBlock, RequestCallback* pCallback)
+{
+	CircuitState circuit;
+	std::string request = BakeRequest(pBlock, circuit);
+	return SendPreparedRequest(pBlock, circuit, request, pCallback);
+}
+
+std::string EquipmentServerControl::BakeRequest(InstrumentBlock* pBlock, CircuitState& circuit)
+{
+	stringstream sstream;
+	Experiment::BuildExperiment(sstream, pBlock, mServerNetlist, mMatrixDisabled, &circuit);
+	return sstream.str();
+}
+
+bool EquipmentServerControl::SendPreparedRequest(InstrumentBlock* pBlock, const CircuitState& circuit, const std::string& request, RequestCallback* pCallback)
 {
 	mpCookie = pCallback; // keep the callback as a cookie, so we know if the matching cancel call is valid
 
 	stringstream sstream;
-	Experiment::BuildExperiment(sstream, pBlock, mServerNetlist, mMatrixDisabled);
+	sstream.imbue(std::locale::classic());
+	if (!mMatrixDisabled) mCircuit.Write(sstream, circuit, pBlock->GetNodeInterpreter()->ContainsSwitches());
+	else mCircuit.Forget();
+	sstream << request;
 
 	Serializer ser;
 	ser << sstream.str();
@@ -256,6 +285,11 @@ bool EquipmentServerControl::CancelRequest(RequestCallback* pCallback)
 	return true;
 }
 
+void EquipmentServerControl::RequestApplied()
+{
+	mCircuit.Applied();
+}
+
 bool EquipmentServerControl::Tick()
 {
 	return true;
@@ -31,6 +31,7 @@
 class InstrumentBlock;
 
 #include "connection.h"
+#include "circuit.h"
 
 #include <instruments/listparser.h>
 #include <instruments/netlist2.h>
@@ -69,8 +70,19 @@ public:
 
 	// send a request according to a pre-made setup order
 	bool	SendBakedRequest(InstrumentBlock* pBlock, RequestCallback* pCallback);
+
+	// serialize the setup order of the block, the translated circuit must already be in it.
+	// The circuit is matched into circuit and left out, it is written in front when sending
+	std::string	BakeRequest(InstrumentBlock* pBlock, CircuitState& circuit);
+
+	// send a setup order made by BakeRequest, the results are read back into the block.
+	// The circuit is sent as a change from the one the equipment server has when that is known
+	bool	SendPreparedRequest(InstrumentBlock* pBlock, const CircuitState& circuit, const std::string& request, RequestCallback* pCallback);
 	bool	CancelRequest(RequestCallback* pCallback);
 
+	// the equipment server has carried out the last setup order
+	void	RequestApplied();
+
 	//const NetList2&		GetServerNetlist() { return mServerNetlist; }
 
 	EquipmentServerControl(Net::Multiplexer* pServer, Config* pConfig, ModuleServices* pService);
@@ -88,6 +100,8 @@ private:
 	EqMeasurement*	mpMeasurement;
 	RequestCallback* mpCookie;
 	bool			mMatrixDisabled;
+
+	CircuitTracker	mCircuit;		// what the equipment server has switched in
 	EqTransactionHandler*	mpTransactionHandler;
 	Net::Multiplexer*	mpServer;
 	Config*				mpConfig;
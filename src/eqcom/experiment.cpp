@@ -103,7 +103,7 @@ private:
 	std::ostream&		mRefStream;
 };
 
-void Experiment::BuildExperiment(std::ostream& out, InstrumentBlock* pBlock, NetList2& lookup, bool noMatrix)
+void Experiment::BuildExperiment(std::ostream& out, InstrumentBlock* pBlock, NetList2& lookup, bool noMatrix, CircuitState* pCircuit)
 {
 	out.imbue(std::locale::classic());
 
@@ -112,7 +112,8 @@ void Experiment::BuildExperiment(std::ostream& out, InstrumentBlock* pBlock, Net
 
 	if (!noMatrix)
 	{
-		Circuit::BuildCircuitSetup(out, pBlock, lookup);
+		if (pCircuit) Circuit::MatchCircuit(*pCircuit, pBlock, lookup);
+		else Circuit::BuildCircuitSetup(out, pBlock, lookup);
 		Circuit::BuildInstrumentSetup2(out, pBlock);
 	}
 
@@ -37,10 +37,14 @@ class NetList2;
 namespace EqSrv
 {
 
+class CircuitState;
+
 class Experiment
 {
 public:
-	static void BuildExperiment(std::ostream& out, InstrumentBlock* pBlock, NetList2& lookup, bool noMatrix);
+	/// pCircuit, if set, gets the matched circuit instead of its setup being written,
+	/// the caller then writes the circuit setup in front of the rest
+	static void BuildExperiment(std::ostream& out, InstrumentBlock* pBlock, NetList2& lookup, bool noMatrix, CircuitState* pCircuit = NULL);
 private:
 };
 
@@ -49,8 +49,9 @@ private:
 
 ///////////////////
 
-EqMeasurement::EqMeasurement()
+EqMeasurement::EqMeasurement(EquipmentServerControl* pControl)
 {
+	mpControl = pControl;
 	mpBlock = NULL;
 	mpCallback = NULL;
 }
@@ -77,6 +78,7 @@ void EqMeasurement::OnResponse(Serializer& in)
 
 		MeasurementResponseAdaptor adaptor(mpBlock);
 		EquipmentServerResponse::ParseResponse(in, adaptor, NULL); // don't care about circuit information
+		mpControl->RequestApplied();
 		if (mpCallback)
 		{
 			mpCallback->RequestDone();
@@ -37,6 +37,7 @@ namespace EqSrv
 {
 
 class RequestCallback;
+class EquipmentServerControl;
 
 class EqMeasurement : public EqConnectionCallback
 {
@@ -45,9 +46,10 @@ public:
 	virtual void OnResponse(Serializer& in);
 	virtual void OnError(std::string msg);
 
-	EqMeasurement();
+	EqMeasurement(EquipmentServerControl* pControl);
 	virtual ~EqMeasurement();
 private:
+	EquipmentServerControl* mpControl;
 	InstrumentBlock* mpBlock;
 	RequestCallback* mpCallback;
 };
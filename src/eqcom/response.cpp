@@ -28,6 +28,7 @@
 
 #include "response.h"
 #include "commands.h"
+#include "symbols.h"
 #include "eqlog.h"
 
 #include <instruments/netlist2.h>
@@ -116,6 +117,16 @@ void EquipmentServerResponse::HandleCircuit(Serializer& in, ResponseAdaptor& ada
 	case 5:
 	case 6:
 	case 7:
+	case V3_CircuitConnect:
+	case V3_CircuitDisconnect:
+		break;
+
+	case V3_CircuitFeatures:
+		{
+			std::string features;
+			in.GetString(features, "\n");
+			adaptor.CircuitFeatures(features);
+		}
 		break;
 
 	case 4:
@@ -134,7 +145,7 @@ void EquipmentServerResponse::HandleCircuit(Serializer& in, ResponseAdaptor& ada
 				strlist += "\n";
 			}
 
-			ListParser parser(*compdefs);
+			ListParser parser(*compdefs, true);
 
 			if (!parser.Parse(strlist))
 			{
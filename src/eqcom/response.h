@@ -42,6 +42,7 @@ class ResponseAdaptor
 {
 public:
 	virtual void CircuitSetup(const NetList2& out) { NotHandled(); }
+	virtual void CircuitFeatures(const std::string& features) {}
 	virtual void NotHandled() {}
 	virtual InstrumentBlock* GetBlock() { return 0; }
 	virtual ~ResponseAdaptor() {}
@@ -29,10 +29,13 @@
 
 #include <instruments/netlist2.h>
 
+#include <sstream>
+
 using namespace EqSrv;
 
 SetupResponseAdaptor::SetupResponseAdaptor()
 {
+	mChangeCircuit = false;
 }
 
 SetupResponseAdaptor::~SetupResponseAdaptor()
@@ -43,3 +46,13 @@ void SetupResponseAdaptor::CircuitSetup(const NetList2& out)
 {
 	mServerNetList = out;
 }
+
+void SetupResponseAdaptor::CircuitFeatures(const std::string& features)
+{
+	std::istringstream in(features);
+	std::string feature;
+	while(in >> feature)
+	{
+		if (feature == "diff") mChangeCircuit = true;
+	}
+}
@@ -38,12 +38,16 @@ class SetupResponseAdaptor : public ResponseAdaptor
 {
 public:
 	virtual void CircuitSetup(const NetList2& out);
+	virtual void CircuitFeatures(const std::string& features);
 	NetList2*	GetNetList() { return &mServerNetList; }
+	/// the equipment server can change its circuit in place
+	bool		CanChangeCircuit() { return mChangeCircuit; }
 
 	SetupResponseAdaptor();
 	virtual ~SetupResponseAdaptor();
 private:
 	NetList2 mServerNetList;
+	bool	mChangeCircuit;
 };
 
 } // end of namespace
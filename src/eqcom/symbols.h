@@ -54,6 +54,17 @@ enum InstrumentID
 	V3_CircuitSwitch			= 44,
 };
 
+/// Circuit builder functions for changing the circuit in place.
+/// Only used once the equipment server has advertised "diff" in its component list reply,
+/// a setup order without any circuit builder function then keeps the previous circuit.
+/// An equipment server that lost its circuit should answer a change with an error
+enum CircuitBuilderFunction
+{
+	V3_CircuitFeatures			= 8,	// reply only, the features of the equipment server
+	V3_CircuitConnect			= 9,	// switch in the listed components
+	V3_CircuitDisconnect		= 10,	// switch out the listed components
+};
+
 static const char* endtoken			= "\n";
 static const char* InstrumentSpacer	= "\t";
 
@@ -36,6 +36,8 @@
 #include <basic_exception.h>
 #include <syslog.h>
 
+#include <algorithm>
+
 using namespace EqSrv;
 using namespace std;
 
@@ -58,6 +60,15 @@ private:
 	protocol::TransactionCallback* mpCallback;
 };
 
+/// The setup order of a measurement, serialized when the transaction was queued.
+/// The circuit setup depends on the circuit of the equipment server when sending, so it is kept apart
+class PreparedMeasurement : public protocol::PreparedData
+{
+public:
+	CircuitState	circuit;
+	std::string		request;
+};
+
 EqTransactionHandler::EqTransactionHandler(ModuleServices* pService)
 {
 	mpAdaptor = new CallbackAdaptor();
@@ -119,7 +130,7 @@ bool EqTransactionHandler::CanHandleMeasurement(protocol::MeasureRequest* pMeasu
 	return true;
 }
 
-bool EqTransactionHandler::Perform(protocol::Transaction* pTransaction, protocol::TransactionCallback* pCallback)
+protocol::MeasureRequest* EqTransactionHandler::GetMeasurement(protocol::Transaction* pTransaction)
 {
 	typedef protocol::Transaction::tRequests tRequests;
 	const tRequests& requests = pTransaction->GetRequests();
@@ -128,19 +139,42 @@ bool EqTransactionHandler::Perform(protocol::Transaction* pTransaction, protocol
 	{
 		if ((*it)->GetType() == protocol::RequestType::Measurement)
 		{
-			protocol::MeasureRequest* pMeasure = (protocol::MeasureRequest*) *it;
-			return PerformMeasurement(pTransaction, pMeasure, pCallback);
+			return (protocol::MeasureRequest*) *it;
 		}
-		else return false;
+		else return NULL;
 	}
 
-	return false;
+	return NULL;
 }
 
-bool EqTransactionHandler::PerformMeasurement(protocol::Transaction* pTransaction, protocol::MeasureRequest* pMeasureRq, protocol::TransactionCallback* pCallback)
+bool EqTransactionHandler::Prepare(protocol::Transaction* pTransaction, protocol::TransactionCallback* pCallback)
 {
+	protocol::MeasureRequest* pMeasure = GetMeasurement(pTransaction);
+	if (!pMeasure) return true;
+
+	// the session has one transaction at the time, so its block is ours until this one is done.
+	// Solving and serializing now overlaps with the measurements queued before us
 	InstrumentBlock* pBlock = pCallback->GetInstrumentBlock();
+	ApplyAndValidate(pBlock, pMeasure); // may throw
+
+	PreparedMeasurement* pPrepared = new PreparedMeasurement();
+	pPrepared->request = mpControl->BakeRequest(pBlock, pPrepared->circuit);
+	pPrepared->switched = pPrepared->circuit.components;
+	std::sort(pPrepared->switched.begin(), pPrepared->switched.end());
+	pTransaction->SetPrepared(pPrepared);
+	return true;
+}
 
+bool EqTransactionHandler::Perform(protocol::Transaction* pTransaction, protocol::TransactionCallback* pCallback)
+{
+	protocol::MeasureRequest* pMeasure = GetMeasurement(pTransaction);
+	if (!pMeasure) return false;
+
+	return PerformMeasurement(pTransaction, pMeasure, pCallback);
+}
+
+void EqTransactionHandler::ApplyAndValidate(InstrumentBlock* pBlock, protocol::MeasureRequest* pMeasureRq)
+{
 	// apply all the settings to the instrument block..
 	const protocol::MeasureRequest::tCmdList& cmds = pMeasureRq->GetCmdList();
 	for(protocol::MeasureRequest::tCmdList::const_iterator it = cmds.begin(); it != cmds.end(); it++)
@@ -148,10 +182,22 @@ bool EqTransactionHandler::PerformMeasurement(protocol::Transaction* pTransactio
 		(*it)->ApplySettings(pBlock);
 	}
 
+	if (!mMatrixDisabled) mpService->TranslateCircuitAndValidate(pBlock);
+}
+
+bool EqTransactionHandler::PerformMeasurement(protocol::Transaction* pTransaction, protocol::MeasureRequest* pMeasureRq, protocol::TransactionCallback* pCallback)
+{
+	InstrumentBlock* pBlock = pCallback->GetInstrumentBlock();
+
 	try
 	{
-		if (!mMatrixDisabled) mpService->TranslateCircuitAndValidate(pBlock);
 		mpAdaptor->SetCallback(pCallback);
+
+		// prepared when queued, only the sending is left
+		PreparedMeasurement* pPrepared = (PreparedMeasurement*) pTransaction->GetPrepared();
+		if (pPrepared) return mpControl->SendPreparedRequest(pBlock, pPrepared->circuit, pPrepared->request, mpAdaptor);
+
+		ApplyAndValidate(pBlock, pMeasureRq);
 		mpControl->SendBakedRequest(pBlock, mpAdaptor);
 		return true;
 	}
@@ -32,6 +32,8 @@
 
 namespace protocol { class MeasureRequest; }
 
+class InstrumentBlock;
+
 class ModuleServices;
 
 namespace EqSrv
@@ -44,6 +46,7 @@ class EqTransactionHandler : public protocol::TransactionHandler
 {
 public:
 	virtual bool	CanHandle(protocol::Transaction* pTransaction);
+	virtual bool	Prepare(protocol::Transaction* pTransaction, protocol::TransactionCallback* pCallback);
 	virtual bool	Perform(protocol::Transaction* pTransaction, protocol::TransactionCallback* pCallback);
 	virtual bool	Cancel(protocol::Transaction* pTransaction, protocol::TransactionCallback* pCallback);
 
@@ -52,6 +55,8 @@ public:
 	virtual ~EqTransactionHandler();
 private:
 	bool CanHandleMeasurement(protocol::MeasureRequest* pMeasureRq);
+	protocol::MeasureRequest* GetMeasurement(protocol::Transaction* pTransaction);
+	void ApplyAndValidate(InstrumentBlock* pBlock, protocol::MeasureRequest* pMeasureRq);
 	bool PerformMeasurement(protocol::Transaction* pTransaction, protocol::MeasureRequest* pMeasureRq, protocol::TransactionCallback* pCallback);
 
 	EquipmentServerControl* mpControl;
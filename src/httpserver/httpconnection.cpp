@@ -33,21 +33,16 @@
 #include <syslog.h>
 #include <sstream>
 
-#include <measureserver/clientmanager.h>
-#include <measureserver/protocolservice.h>
-#include <measureserver/session.h>
-#include <measureserver/service.h>
-#include <measureserver/transactionrequest.h>
-#include <measureserver/requestqueue.h>
-
 #include <xmlprotocol/producer.h>
 #include <xmlprotocol/requestparser.h>
 
 #include <basic_exception.h>
+#include <util/atomic.h>
 
 using namespace std;
 
 #define MAX_REQUEST_SIZE (128*1024)
+#define IDLE_TIMEOUT 300.0
 
 const char* indexPage = 
 "<html>"
@@ -57,12 +52,13 @@ const char* indexPage =
 "</body>"
 "</html>";
 
-HTTPConnection::HTTPConnection(Net::Connection* pConnection, HTTPServer* pServer, ServerProtocolService* pSrvProtSrvc, ClientManager* pClientMgr)
+HTTPConnection::HTTPConnection(Net::Connection* pConnection, HTTPServer* pServer, Reactor* pReactor)
 {
 	mpConnection = pConnection;
 	mpServer	= pServer;
-	mpSrvProtSrvc = pSrvProtSrvc;
-	mpClientMgr	= pClientMgr;
+	mpReactor	= pReactor;
+	mpTimers	= pReactor->GetTimerQueue();
+	mChannel	= 0;
 
 	mpRequest = new HTTPRequest();
 
@@ -74,32 +70,19 @@ HTTPConnection::HTTPConnection(Net::Connection* pConnection, HTTPServer* pServer
 	mState = eRequest;
 	mKeepAlive = false;
 
-	mpClient = NULL;
-
-	mpCurrentRequest = NULL;
+	// connections are created in several reactor threads
+	static volatile int sLastID = 0;
+	mRequestID = AtomicIncrement(&sLastID);
 
-	static int id = 1;
-	mRequestID = id++;
+	mpTimers->Schedule(this, IDLE_TIMEOUT);
 }
 
 HTTPConnection::~HTTPConnection()
 {
 	mpConnection->Destroy();
-	if (mpCurrentRequest)
-	{
-		mpCurrentRequest->ClientGone();
-	}
 
-	if (mpClient)
-	{
-		mpClient->RemoveListener(this);
-
-		mpSrvProtSrvc->GetRequestQueue()->RemoveRequestsFrom(mpClient);
-		mpClient->ConnectionClosed();
-		mpClientMgr->RemoveClient(mpClient);
-		delete mpClient;
-		mpClient = NULL;
-	}
+	// the scheduler cancels the transaction in flight and drops the client
+	if (mChannel) mpReactor->CloseChannel(mChannel);
 
 	delete mpRequest;
 	delete mpConnection;
@@ -107,15 +90,8 @@ HTTPConnection::~HTTPConnection()
 
 bool HTTPConnection::Init()
 {
-	mpClient = mpClientMgr->AddClient(mpConnection);
-	if (!mpClient)
-	{
-		HTTPError("Unable to create client, server overloaded");
-		mState = eClosing;
-		return false;
-	}
-	mpClient->AddListener(this);
-
+	// the client is created by the scheduler, a rejection arrives as ChannelRejected
+	mChannel = mpReactor->OpenChannel(this, Reactor::eRequireSession | Reactor::eOneTransaction);
 	return true;
 }
 
@@ -220,25 +196,25 @@ void HTTPConnection::HandleEvent(int flags)
 	}
 }
 
-void HTTPConnection::SendResponse(const char* buffer, size_t length)
+void HTTPConnection::SendResponse(std::string& data)
 {
-	httplog.Log(5) << "HTTP XML response: " << endl << string(buffer, length) << endl;
-
-	//string response(buffer, length);
+	if (httplog.GetLogLevel() >= 5) httplog.Log(5) << "HTTP XML response: " << endl << data << endl;
 
 	std::stringstream out;
 	out << "HTTP/1.1 200\r\n";
 	out << "Server: Measurementserver\r\n";
-	out << "Content-Length: " << length << "\r\n";
+	out << "Content-Length: " << data.size() << "\r\n";
 	out << "Content-Type: text/xml\r\n";
 	out << "Cache-Control: no-cache\r\n";
 	out << "Access-Control-Allow-Origin: *\r\n";
 	if (mKeepAlive) out << "Connection: keep-alive\r\n";
 	else out << "Connection: close\r\n";
 	out << "\r\n";
-	mSendBuffer.Fill((void*)out.str().c_str(), out.str().size());
 
-	mSendBuffer.Fill((void *)buffer, length);
+	// headers and body go out in one gathered send
+	std::string header = out.str();
+	mSendBuffer.Take(header);
+	mSendBuffer.Take(data);
 	mpConnection->SetSelectMask(NET_WRITE_FLAG | NET_READ_FLAG | NET_EXCEPTION_FLAG);
 }
 
@@ -246,7 +222,8 @@ void HTTPConnection::SendError(std::string msg)
 {
 	std::stringstream out;
 	xmlprotocol::XmlProducer::ProduceError(out, msg);
-	SendResponse(out.str().c_str(), out.str().size());
+	std::string response = out.str();
+	SendResponse(response);
 }
 
 Net::Socket* HTTPConnection::GetSocket()
@@ -256,11 +233,24 @@ Net::Socket* HTTPConnection::GetSocket()
 
 bool HTTPConnection::IsAlive()
 {
-	double timeout = 300.0;
-	if (mLifeTimer.elapsed() > timeout) return false;
+	if (mLifeTimer.elapsed() > IDLE_TIMEOUT) return false;
 	return true;
 }
 
+void HTTPConnection::TimerExpired()
+{
+	// the life timer is restarted on every request, only check it when the deadline passes
+	double left = IDLE_TIMEOUT - mLifeTimer.elapsed();
+	if (left > 0)
+	{
+		mpTimers->Schedule(this, left);
+		return;
+	}
+
+	syserr << timestamp << "Dead handler: kicking" << endl;
+	Shutdown(); // this will delete us
+}
+
 bool HTTPConnection::Shutdown()
 {
 	if (mState != eClosing) {
@@ -270,7 +260,6 @@ bool HTTPConnection::Shutdown()
 	//cout << "Shutdown socket: " << mRequestID << endl;
 
 
-	if (mpClient) mpClient->ConnectionClosed();
 	mpConnection->Disconnect();
 	mpConnection->Destroy();
 	mpServer->RemoveConnection(this); // this will delete us
@@ -298,26 +287,26 @@ bool HTTPConnection::ParseHTTPRequest(void* buffer, size_t datalength)
 
 			if (mpRequest->Verb() == "POST" && mpRequest->URL() == "/measureserver")
 			{
-				string payload = mpRequest->GetPayload((char*)buffer, datalength);
-				//cout << "payload" << endl << payload << endl;
-			
-				//mpClient->HandlePacket((char*)payload.c_str(), payload.size());
-				HandlePacket(payload.c_str(), payload.size());
+				// parsed in place, the receive buffer is consumed below
+				const char* payload = mpRequest->GetPayload((char*)buffer, datalength);
+				if (payload) HandlePacket(payload, mpRequest->ContentLength());
 			}
 			else if (mpRequest->Verb() == "GET" && mpRequest->URL() == "/crossdomain.xml")
 			{
 				sysout << "HTTP Policy file request" << endl;
 
 				std::stringstream out;
-				out << mpSrvProtSrvc->GetCrossDomainPolicy();
-				SendResponse(out.str().c_str(), out.str().size());
+				out << mpReactor->GetCrossDomainPolicy();
+				std::string response = out.str();
+				SendResponse(response);
 			}
 			else if (mpRequest->URL() == "/test")
 			{
 				std::stringstream out;
 				//sysout << "Test request: " << mRequestID << endl;
 				out << "Test response: " << mRequestID << endl;
-				SendResponse(out.str().c_str(), out.str().size());
+				std::string response = out.str();
+				SendResponse(response);
 			}
 			else if (mpRequest->URL() == "/")
 			{
@@ -330,8 +319,9 @@ bool HTTPConnection::ParseHTTPRequest(void* buffer, size_t datalength)
 				out << "Content-Type: text/html\r\n";
 				out << "Connection: close\r\n";
 				out << "\r\n";
-				out << indexPage;
-				mSendBuffer.Fill((void*)out.str().c_str(), out.str().size());
+				std::string header = out.str();
+				mSendBuffer.Take(header);
+				mSendBuffer.Borrow(indexPage, strlen(indexPage)); // static page, no need to copy
 				mpConnection->SetSelectMask(NET_WRITE_FLAG | NET_READ_FLAG | NET_EXCEPTION_FLAG);
 			}
 			else
@@ -427,67 +417,28 @@ bool HTTPConnection::HandlePacket(const char* pData, size_t length)
 		return false;
 	}
 
-	pTransaction->SetIssuer(this);
-	pTransaction->SetOwner(mpClient);
-
-	// hand over ownership to the handler
-	if (mpCurrentRequest != NULL)
-	{
-		SendError("Transaction already in progress");
-	}
-	else
-	{
-		mpCurrentRequest = mpSrvProtSrvc->ProcessTransaction(pTransaction, mpClient);
-		if (mpCurrentRequest == NULL) return false;
-	}
-	
+	// hand over ownership to the scheduler thread
+	mpReactor->Submit(mChannel, pTransaction);
 	return true;
 }
 
-void HTTPConnection::TransactionComplete(protocol::Transaction* pTransaction)
+void HTTPConnection::ChannelResponse(std::string& response)
 {
-	mpCurrentRequest = NULL;
-
-	Session* pSession = NULL;
-	if (mpClient) pSession = mpClient->GetSession();
-	if (!pSession)
-	{
-		SendError("Unable to get session when generating xml response");
-		return;
-	}
-
-	sysout << "request from session: " << pSession->GetKey() << endl;
-
-	std::stringstream out;
-	xmlprotocol::XmlProducer::TransactionResponse(pTransaction, pSession->GetBlock(), out, mpSrvProtSrvc);
-
-	protocol::TransactionErrorType errtype = pTransaction->GetErrorState();
-	if (errtype != protocol::NoError)
-	{
-		SendError(pTransaction->GetError());
-		return;
-	}
-
-	SendResponse(out.str().c_str(), out.str().size());
+	SendResponse(response);
 }
 
-void HTTPConnection::TransactionError(protocol::Transaction* pTransaction, const char* msg, protocol::TransactionErrorType type)
+void HTTPConnection::ChannelError(const std::string& msg)
 {
-	mpCurrentRequest = NULL;
 	SendError(msg);
 }
 
-void HTTPConnection::SessionDestroyed()
+void HTTPConnection::ChannelSessionGone()
 {
-	syserr << "Session is destroyed while client is connected!" << endl;
-
-	if (mpCurrentRequest)
-	{
-		// Cancel the request by pretending that the client has disconnected
-		mpCurrentRequest->ClientGone();
-		mpCurrentRequest = NULL;
-	}
-
 	SendError("Your session has timed out during measurement");
 	mState = eClosing;
+}
+
+void HTTPConnection::ChannelRejected(const std::string& msg)
+{
+	HTTPError(msg);
 }
\ No newline at end of file
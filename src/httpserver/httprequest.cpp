@@ -191,14 +191,19 @@ size_t HTTPRequest::ContentLength()
 	return mContentLength;
 }
 
+size_t HTTPRequest::HeaderSize()
+{
+	return mHeaderSize;
+}
+
 size_t HTTPRequest::RequestSize()
 {
 	return mContentLength + mHeaderSize;
 }
 
-std::string HTTPRequest::GetPayload(char* data, size_t length)
+const char* HTTPRequest::GetPayload(const char* data, size_t length)
 {
-	if (mHeaderSize + mContentLength > length) return "";
+	if (mHeaderSize + mContentLength > length) return NULL;
 
-	return string(data + mHeaderSize, mContentLength);
+	return data + mHeaderSize;
 }
\ No newline at end of file
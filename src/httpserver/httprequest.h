@@ -46,7 +46,8 @@ public:
 
 	eConnectionType ConnectionType() { return mConnectionType; }
 
-	std::string		GetPayload(char* data, size_t length);
+	/// Payload within the request data (not copied), NULL if it isn't complete
+	const char*		GetPayload(const char* data, size_t length);
 
 	size_t			RequestSize();
 	size_t			HeaderSize();
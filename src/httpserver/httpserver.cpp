@@ -64,7 +64,7 @@ void InitHTTPLog(Config* pConfig)
 class HTTPServerHandler : public Net::SocketHandler
 {
 public:
-	bool	ListenOn(int port);
+	bool	ListenOn(int port, bool shared);
 
 	virtual void			HandleEvent(int flags);
 
@@ -93,9 +93,9 @@ HTTPServerHandler::~HTTPServerHandler()
 	delete mpServerSocket;
 }
 
-bool HTTPServerHandler::ListenOn(int port)
+bool HTTPServerHandler::ListenOn(int port, bool shared)
 {
-	if (!mpServerSocket->StartServer(port, 100)) return false;
+	if (!mpServerSocket->StartServer(port, 100, shared)) return false;
 	return true;
 }
 
@@ -107,12 +107,11 @@ void HTTPServerHandler::HandleEvent(int flags)
 
 ///////////////////
 
-HTTPServer::HTTPServer(Net::Multiplexer* pServer, ServerProtocolService* pSrvProtSrvc, ClientManager* pClientMgr)
+HTTPServer::HTTPServer(Reactor* pReactor)
 {
 	mpServerHandler = new HTTPServerHandler(this);
-	mpServer	= pServer;
-	mpSrvProtSrvc = pSrvProtSrvc;
-	mpClientMgr = pClientMgr;
+	mpServer	= pReactor->GetMultiplexer();
+	mpReactor	= pReactor;
 }
 
 HTTPServer::~HTTPServer()
@@ -127,9 +126,9 @@ HTTPServer::~HTTPServer()
 	delete mpServerHandler;
 }
 
-bool HTTPServer::Init(int port, Config* pConfig)
+bool HTTPServer::Init(int port, Config* pConfig, bool shared)
 {
-	if (!mpServerHandler->ListenOn(port))
+	if (!mpServerHandler->ListenOn(port, shared))
 	{
 		return false;
 	}
@@ -148,7 +147,7 @@ void HTTPServer::AddConnection(Net::Connection* pConnection)
 	sysout << timestamp << "HTTP connection from: " << pConnection->GetPeerIPAsString() << endl;
 	httplog.Log(1) << timestamp << "HTTP connection from: " << pConnection->GetPeerIPAsString() << endl;
 
-	HTTPConnection* pHTTPCon = new HTTPConnection(pConnection, this, mpSrvProtSrvc, mpClientMgr);
+	HTTPConnection* pHTTPCon = new HTTPConnection(pConnection, this, mpReactor);
 	pHTTPCon->Init(); // even if we fail to init, we want the connection to send an error
 
 	mConnections.push_back(pHTTPCon);
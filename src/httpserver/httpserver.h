@@ -41,18 +41,20 @@ namespace Net
 
 class HTTPServerHandler;
 class Config;
+class Reactor;
 
 extern LogModule	httplog;
 
 class HTTPServer
 {
 public:
-	bool Init(int port, Config* pConfig);
+	///	shared: other reactors listen on the same port
+	bool Init(int port, Config* pConfig, bool shared = false);
 
 	void AddConnection(Net::Connection* pConnection);
 	void RemoveConnection(HTTPConnection* pHTTPCon);
 
-	HTTPServer(Net::Multiplexer* pServer, ServerProtocolService* pSrvProtSrvc, ClientManager* pClientMgr);
+	HTTPServer(Reactor* pReactor);
 	virtual ~HTTPServer();
 private:
 	HTTPServerHandler* mpServerHandler;
@@ -60,8 +62,7 @@ private:
 	typedef std::list<HTTPConnection*> tConnections;
 	tConnections			mConnections;
 	Net::Multiplexer*		mpServer;
-	ServerProtocolService*	mpSrvProtSrvc;
-	ClientManager*			mpClientMgr;
+	Reactor*				mpReactor;
 };
 
 #endif
@@ -37,6 +37,11 @@ CircuitList::CircuitList()
 {
 	mLogging = false;
 	//mLogging = true;
+	mpCancel = NULL;
+	mHeuristics = CircuitSolver3::eAllHeuristics;
+	mMaxNodes = 0;
+	mMaxSeconds = 0;
+	mpSharedBudget = NULL;
 }
 
 CircuitList::~CircuitList()
@@ -51,6 +56,10 @@ bool CircuitList::Solve(const tCircuitList& circuitlist, const tCircuitList& max
 
 	CircuitSolver3 aSolver;
 	if (mLogging) aSolver.EnableLogging();
+	aSolver.SetCancelFlag(mpCancel);
+	aSolver.SetHeuristics(mHeuristics);
+	aSolver.SetBudget(mMaxNodes, mMaxSeconds);
+	aSolver.SetSharedBudget(mpSharedBudget);
 	
 	CircuitSolver3::tCandidates candidates(maxlist.size());
 	copy(maxlist.begin(), maxlist.end(), candidates.begin()); // use back_inserter..
@@ -65,6 +74,7 @@ bool CircuitList::Solve(const tCircuitList& circuitlist, const tCircuitList& max
 		mSolution = comps;
 		foundsolution = true;
 	}
+	mStats = aSolver.GetStats();
 
 	return foundsolution;
 }
@@ -77,4 +87,25 @@ const CircuitList::tCircuitList& CircuitList::GetSolution() const
 void CircuitList::EnableLogging()
 {
 	mLogging = true;
+}
+
+void CircuitList::SetCancelFlag(volatile int* pCancel)
+{
+	mpCancel = pCancel;
+}
+
+void CircuitList::SetHeuristics(int heuristics)
+{
+	mHeuristics = heuristics;
+}
+
+void CircuitList::SetBudget(size_t maxNodes, double maxSeconds)
+{
+	mMaxNodes = maxNodes;
+	mMaxSeconds = maxSeconds;
+}
+
+void CircuitList::SetSharedBudget(SolverBudget* pBudget)
+{
+	mpSharedBudget = pBudget;
 }
\ No newline at end of file
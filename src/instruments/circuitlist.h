@@ -29,6 +29,7 @@
 #define __CIRCUIT_LIST_H__
 
 #include "listcomponent.h"
+#include "solverbudget.h"
 
 #include <vector>
 
@@ -64,6 +65,19 @@ public:
 
 	void	EnableLogging();
 
+	/// Stop solving when *pCancel becomes non-zero, see CircuitSolver3::SetCancelFlag
+	void	SetCancelFlag(volatile int* pCancel);
+
+	/// Search heuristics, see CircuitSolver3::SetHeuristics
+	void	SetHeuristics(int heuristics);
+
+	/// Work limits, see CircuitSolver3::SetBudget and SetSharedBudget
+	void	SetBudget(size_t maxNodes, double maxSeconds);
+	void	SetSharedBudget(SolverBudget* pBudget);
+
+	/// What the last Solve did, aborted is set if it ran out of budget
+	const SolverStats&	GetStats() const { return mStats; }
+
 	CircuitList();
 	virtual ~CircuitList();
 private:
@@ -73,6 +87,12 @@ private:
 	std::string	mMaxList;
 	ListComponent::tComponentList mSolution;
 	bool	mLogging;
+	volatile int*	mpCancel;
+	int		mHeuristics;
+	size_t	mMaxNodes;
+	double	mMaxSeconds;
+	SolverBudget*	mpSharedBudget;
+	SolverStats		mStats;
 };
 
 #endif
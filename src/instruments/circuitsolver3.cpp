@@ -31,24 +31,54 @@
 #include "circuitsolverinternal.h"
 
 #include <logmodule.h>
+#include <util/atomic.h>
 #include <sstream>
+#include <algorithm>
 
 using namespace std;
 
 #define ARR_SIZE(a) ( sizeof(a) / sizeof(a[0]) )
 
-const char* instrumentNodes[] = { "VFGENA", "DMM", "PROBE", "PROBE1", "PROBE2", "PROBE3", "PROBE4", "VDC+25V", "VDC-25V", "VDC+6V", "VDCCOM" };
+static const InternString instrumentNodes[] = {
+	InternString::Vocabulary("VFGENA"), InternString::Vocabulary("DMM"), InternString::Vocabulary("PROBE"), InternString::Vocabulary("PROBE1"), InternString::Vocabulary("PROBE2"), InternString::Vocabulary("PROBE3"),
+	InternString::Vocabulary("PROBE4"), InternString::Vocabulary("VDC+25V"), InternString::Vocabulary("VDC-25V"), InternString::Vocabulary("VDC+6V"), InternString::Vocabulary("VDCCOM")
+};
 const size_t numInstrumentNodes = ARR_SIZE(instrumentNodes);
 
+// measurement instruments are kept out of the circuit and inserted after solving
+static const InternString measurementNodes[] = {
+	InternString::Vocabulary("DMM"), InternString::Vocabulary("PROBE"), InternString::Vocabulary("PROBE1"), InternString::Vocabulary("PROBE2"), InternString::Vocabulary("PROBE3"), InternString::Vocabulary("PROBE4")
+};
+const size_t numMeasurementNodes = ARR_SIZE(measurementNodes);
+
+// upper bound on remembered failed states, roughly 64 bytes each
+static const size_t cMaxNogoods = 65536;
+
+static const InternString sGround = InternString::Vocabulary("0");
+static const InternString sWire = InternString::Vocabulary("W");
+static const InternString sDmm = InternString::Vocabulary(NamedNodes::Dmm);
+static const InternString sIProbe = InternString::Vocabulary(NamedNodes::DmmIProbe);
+static const InternString sShortcut = InternString::Vocabulary(NamedNodes::Shortcut);
+static const InternString sIProbeTurned = InternString::Vocabulary("1");
+static const InternString sIProbeNotTurned = InternString::Vocabulary("0");
+
 //const char* generatorNodes[] = { "VFGENA", "VDC+25V", "VDC-25V", "VDC+6V", "VDCCOM" };
 //const size_t numGeneratorNodes = ARR_SIZE(generatorNodes);
 
-static bool isInstrumentNode(const std::string& type)
+static bool isInstrumentNode(const InternString& type)
+{
+	for(size_t i=0; i< numInstrumentNodes; i++)
+	{
+		if (type == instrumentNodes[i]) return true;
+	}
+	return false;
+}
+
+static bool isMeasurementNode(const InternString& type)
 {
-	for(int i=0; i< numInstrumentNodes; i++)
+	for(size_t i=0; i< numMeasurementNodes; i++)
 	{
-		//if (type == instrumentNodes[i]) return true;
-		if (strcmp(type.c_str(), instrumentNodes[i]) == 0) return true;
+		if (type == measurementNodes[i]) return true;
 	}
 	return false;
 }
@@ -86,6 +116,11 @@ void InitLogging()
 
 CircuitSolver3::CircuitSolver3()
 {
+	mpCancel = NULL;
+	mHeuristics = eAllHeuristics;
+	mMaxNodes = 0;
+	mMaxSeconds = 0;
+	mpSharedBudget = NULL;
 }
 
 CircuitSolver3::~CircuitSolver3()
@@ -93,12 +128,24 @@ CircuitSolver3::~CircuitSolver3()
 }
 
 bool CircuitSolver3::Solve(const tCircuit& incircuit, const tCandidates& candidates)
+{
+	mStats = SolverStats();
+	mBudget.Reset(mMaxNodes, mMaxSeconds);
+
+	timer solvetimer;
+	const bool solved = SolveCircuit(incircuit, candidates);
+	mStats.seconds = solvetimer.elapsed();
+	return solved;
+}
+
+bool CircuitSolver3::SolveCircuit(const tCircuit& incircuit, const tCandidates& candidates)
 {
 	mCircuit = incircuit;
 
 	mSolution.clear();
 	
-	SymbolTable::ResetLookup();
+	mSymbols = tSymbols();
+	mSolutionSymbols = tSymbols();
 
 #ifdef DEBUG_OUT
 	OUTSTREAM << "input candidate dump" << endl;
@@ -188,6 +235,26 @@ bool CircuitSolver3::Solve(const tCircuit& incircuit, const tCandidates& candida
 	return true;
 }
 
+void CircuitSolver3::GetPlacedComponents(const tCircuit& incircuit, tCircuit& placed)
+{
+	tCandidates circuit(incircuit.size());
+	copy(incircuit.begin(), incircuit.end(), circuit.begin());
+	CircuitFixup(circuit);
+	InstrumentFixup(circuit);
+
+	tUsedInstrumentSymbols instrSymbols;
+	tUsedIndices used(circuit.size());
+	tOrderedIndices ordered;
+	TierOne(circuit, used, ordered, instrSymbols);
+
+	placed.clear();
+	for(size_t i=0, size=ordered.size(); i<size; i++)
+	{
+		const ListComponent& c = circuit[ordered[i]];
+		if (c.GetTypeId() != sWire && !isInstrumentNode(c.GetTypeId())) placed.push_back(c);
+	}
+}
+
 /*
 	Insert instrument nodes for old "magic" node names
 */
@@ -230,68 +297,58 @@ void CircuitSolver3::CircuitFixup(tCandidates& circuit)
 	circuit.push_back(ListComponent(NamedNodes::DmmIProbe, "1", "DMM_AHI", "DMM_ALO"));
 }
 
-bool CircuitSolver3::TierOne(const tCandidates& cand, tUsedIndices& used, tOrderedIndices& ordered, tUsedInstrumentSymbols& instrSymbols) const
+bool CircuitSolver3::TierOne(const tCandidates& cand, tUsedIndices& used, tOrderedIndices& ordered, tUsedInstrumentSymbols& instrSymbols)
 {
-	typedef list<string> tToVisit;
-	tToVisit toVisit;
-	
+	// breadth first from the instruments, each node is visited once
+	mCircuitGraph.Build(cand);
+	mVisited.assign(mCircuitGraph.NumNodes(), false);
+	mVisit.clear();
+
 	// Add all instrument nodes as nodes to visit
 	// and keep track of the instruments
 	// all connection names are symbolic
 	for(tCandidates::const_iterator it = cand.begin(); it != cand.end(); it++)
 	{
-		if (isInstrumentNode(it->GetType()))
+		if (isInstrumentNode(it->GetTypeId()))
 		{
 			typedef ListComponent::tConnections tCons;
 			const tCons& cons = it->GetCConnections();
 			
 			for(tCons::const_iterator conit = cons.begin(); conit != cons.end(); ++conit)
 			{
-				toVisit.push_back(*conit);
+				VisitOnce(mCircuitGraph.NodeIndex(*conit));
 				instrSymbols.push_back(*conit);
 			}
 		}
 	}
 
-	const char* nodesToVisit[] = { "0" };
-	size_t numNodes = sizeof(nodesToVisit) / sizeof(nodesToVisit[0]);
-	toVisit.insert(toVisit.end(), nodesToVisit, nodesToVisit + numNodes);
+	VisitOnce(mCircuitGraph.NodeIndex(sGround));
 	
-	while(!toVisit.empty())
+	for(size_t head = 0; head < mVisit.size(); head++)
 	{
-		const string current = toVisit.front();
-		toVisit.pop_front();
-		
-		//cout << current << endl;
+		const size_t node = mVisit[head];
+		const InternString& current = mCircuitGraph.Node(node);
 
 		OUT( OUTSTREAM << "VISIT: " << current << endl);
 		
-		for(size_t candidx=0, size=cand.size(); candidx<size; candidx++)
+		// the components connected to current, in candidate order
+		for(const size_t* it = mCircuitGraph.RowBegin(node), *end = mCircuitGraph.RowEnd(node); it != end; ++it)
 		{
-			bool found = false;
+			const size_t candidx = *it;
 			if (used[candidx]) continue;
 			
 			typedef ListComponent::tConnections tCons;
 			const tCons& cons = cand[candidx].GetCConnections();
-						
-			// check each component for any connection matching current symbol
-			for(size_t conidx = 0, consize=cons.size(); conidx < consize; conidx++)
+			const size_t consize = cons.size();
+
+			bool found = (consize == 1);
+			// add all other connection points to the list of symbols to visit
+			for(size_t i=0;i<consize; i++)
 			{
-				if (cons[conidx] == current) {
-					if (consize == 1) {
-						found = true;
-					}
-					// add all other connection points to the list of symbols to visit
-					for(size_t i=0;i<consize; i++)
-					{
-						if (i != conidx) {
-							// odd/old behaviour, count components directly connected to itself as not connected
-							if (cons[i] != cons[conidx]) {
-								toVisit.push_back(cons[i]);
-								found = true;
-							}
-						}
-					}
+				// odd/old behaviour, count components directly connected to itself as not connected
+				if (cons[i] != current) {
+					VisitOnce(mCircuitGraph.NodeIndex(cons[i]));
+					found = true;
 				}
 			}
 			
@@ -305,12 +362,19 @@ bool CircuitSolver3::TierOne(const tCandidates& cand, tUsedIndices& used, tOrder
 	return true;
 }
 
+inline void CircuitSolver3::VisitOnce(int node)
+{
+	if (node < 0 || mVisited[node]) return;
+	mVisited[node] = true;
+	mVisit.push_back(node);
+}
+
 bool CircuitSolver3::MarkWiresAsRefs(const tCandidates& candidates, tSymbols& symbols) const
 {
 	// insert wires from original list. That makes probes work
 	for(tCandidates::const_iterator it = candidates.begin(), end = candidates.end(); it != end; ++it)
 	{
-		if (it->GetType() == "W")
+		if (it->GetTypeId() == sWire)
 		{
 			// add ref and check that no symbol contains more than one nodename
 			if (!symbols.Ref(it->GetCConnections()[0], it->GetCConnections()[1]))
@@ -333,7 +397,7 @@ bool CircuitSolver3::TierTwo(const tCandidates& list, tUsedIndices& usedcmpnts,
 		if (!usedcmpnts[i]) continue;
 		const ListComponent& cmp = list[i];
 		
-		if (cmp.GetType() != "W" && !isInstrumentNode(cmp.GetType()))
+		if (cmp.GetTypeId() != sWire && !isInstrumentNode(cmp.GetTypeId()))
 		{
 			const ListComponent::tConnections& cons = cmp.GetCConnections();
 			
@@ -344,7 +408,7 @@ bool CircuitSolver3::TierTwo(const tCandidates& list, tUsedIndices& usedcmpnts,
 		}
 	}
 	
-	usedInstrumentNodes.push_back("0"); // XXX: verify that this actually does the right thing..
+	usedInstrumentNodes.push_back(sGround); // XXX: verify that this actually does the right thing..
 	
 	for(size_t i=0, size = usedInstrumentNodes.size(); i < size; i++)
 	{
@@ -366,8 +430,8 @@ bool CircuitSolver3::TierTwo(const tCandidates& list, tUsedIndices& usedcmpnts,
 		if (!usedcmpnts[i]) continue;
 
 		const ListComponent& cmp = list[i];
-		const std::string& type = cmp.GetType();
-		if (type == "W")
+		const InternString& type = cmp.GetTypeId();
+		if (type == sWire)
 		{
 			usedcmpnts[i] = false;
 		}
@@ -379,7 +443,7 @@ bool CircuitSolver3::TierTwo(const tCandidates& list, tUsedIndices& usedcmpnts,
 			const ListComponent::tConnections& cons = cmp.GetCConnections();
 			for(size_t ci = 0; ci < cons.size(); ++ci)
 			{
-				if (cons[ci] == "0") continue; //< instruments connected to node "0" usually never connect the node directly
+				if (cons[ci] == sGround) continue; //< instruments connected to node "0" usually never connect the node directly
 				if (!symbols.IsMarked(markData, cons[ci])) used = false;
 			}
 
@@ -400,13 +464,7 @@ bool CircuitSolver3::TierTwo(const tCandidates& list, tUsedIndices& usedcmpnts,
 
 				// measurement instruments are in use, but we don't want them in the input circuit
 				// we still need to keep track of them so we can insert them after the circuit is solved
-				if (type == "DMM"
-					|| type == "PROBE"
-					|| type == "PROBE1"
-					|| type == "PROBE2"
-					|| type == "PROBE3"
-					|| type == "PROBE4"
-					)
+				if (isMeasurementNode(type))
 				{
 					mMeasInstrument.push_back(cmp); // unnecessary copy
 					usedcmpnts[i] = false;
@@ -442,7 +500,7 @@ bool CircuitSolver3::BuildCandidateCache()
 	for(size_t i=0,size = mCandidates.size(); i<size; i++)
 	{
 		const ListComponent& c = mCandidates[i];
-		if (c.GetType() == "SHORTCUT" ) //|| c.GetType() == NamedNodes::DmmIProbe)
+		if (c.GetTypeId() == sShortcut ) //|| c.GetType() == NamedNodes::DmmIProbe)
 		{
 			mShortcuts.push_back(i);
 		}
@@ -470,23 +528,67 @@ bool CircuitSolver3::TierThree(const tCandidates& circuit, const tCandidates& ca
 
 	if (!BuildCandidateCache()) return false;
 
+	mShortcutGraph.Build(mCandidates, mShortcuts);
+	mUsableShortcut.assign(mCandidates.size(), false);
+	mTree.assign(mShortcutGraph.NumNodes(), 0);
+
+	mOrder.resize(mIndexCircuit.size());
+	for(size_t i=0,size=mOrder.size(); i<size; i++) mOrder[i] = i;
+	mPlaced.assign(mIndexCircuit.size(), false);
+	mNogoods.clear();
+
 	// the actual solver
 	// walk the list, sorted in connection order, and try to find a component matching and insertable
 	return TierThreeSolveRecursive(0, usage, symbols);
 }
 
-bool CircuitSolver3::TierThreeSolveRecursive(size_t circuitidx, tUsage& usage, tSymbols& symbols)
+/// True when the search has to end early, it was cancelled or the budget ran out
+bool CircuitSolver3::IsStopped()
+{
+	if (mpCancel && AtomicLoad(mpCancel)) return true;
+	if (mpSharedBudget && mpSharedBudget->IsExhausted()) mStats.aborted = true;
+	return mStats.aborted;
+}
+
+bool CircuitSolver3::TierThreeSolveRecursive(size_t depth, tUsage& usage, tSymbols& symbols)
 {
-	if (circuitidx >= mIndexCircuit.size())
+	if (IsStopped()) return false;
+
+	if ((++mStats.nodes % SolverBudget::cChunk) == 0)
+	{
+		// spend on both, the shared budget should see all the work
+		bool spent = mBudget.Spend();
+		if (mpSharedBudget && !mpSharedBudget->Spend()) spent = false;
+		if (!spent)
+		{
+			mStats.aborted = true;
+			return false;
+		}
+	}
+
+	if (depth >= mIndexCircuit.size())
 	{
 		mSolutionSymbols = symbols;
 		return true; // endcase
 	}
 
+	tStateKey key;
+	if (mHeuristics & eNogoods)
+	{
+		key = StateKey(usage, symbols);
+		if (mNogoods.find(key) != mNogoods.end()) return false;
+	}
+
+	if (mHeuristics & (eMostConstrainedFirst | eForwardCheck))
+	{
+		if (!SelectNext(depth, usage, symbols)) return false;
+	}
+
+	const size_t circuitidx = mOrder[depth];
 	const ListComponent& current = mIndexCircuit[circuitidx];
 
 #ifdef DEBUG_OUT
-	OUTSTREAM << endl << "Recurse - solving component: " << current.Dump() << endl << "size: " << circuitidx << endl;
+	OUTSTREAM << endl << "Recurse - solving component: " << current.Dump() << endl << "size: " << depth << endl;
 #endif
 
 	// make a list of usable candidates, filtered from the candidate cache
@@ -504,41 +606,150 @@ bool CircuitSolver3::TierThreeSolveRecursive(size_t circuitidx, tUsage& usage, t
 	
 	if (matching.empty()) return false;
 
-	circuitidx++;
-
-	if (TryCandidateList(current, matching, circuitidx, usage, symbols, false)) return true;
+	mPlaced[circuitidx] = true;
+	bool solved = TryCandidateList(current, matching, depth + 1, usage, symbols, false);
 #ifdef DEBUG_OUT
-	OUTSTREAM << "Unable to find a solution, trying with shortcuts" << endl;
+	if (!solved) OUTSTREAM << "Unable to find a solution, trying with shortcuts" << endl;
 #endif
-	if (TryCandidateList(current, matching, circuitidx, usage, symbols, true)) return true;
+	if (!solved) solved = TryCandidateList(current, matching, depth + 1, usage, symbols, true);
+	mPlaced[circuitidx] = false;
+
+	if (solved) return true;
+
+	// a stopped search says nothing about the state
+	if ((mHeuristics & eNogoods) && !IsStopped() && mNogoods.size() < cMaxNogoods)
+	{
+		mNogoods.insert(key);
+	}
 	return false;
 }
 
-bool CircuitSolver3::TryCandidateList(const ListComponent& current, const tUsage& matched, size_t circuitidx, tUsage& usage, const tSymbols& symbols, bool withShortcuts)
+/// Move the component to solve at depth into place, fails if some unplaced component has nothing left to match
+bool CircuitSolver3::SelectNext(size_t depth, const tUsage& usage, const tSymbols& symbols)
 {
+	const bool freeShortcut = HasFreeShortcut(usage);
+	size_t best = depth;
+	size_t bestCount = 0;
+
+	for(size_t pos=depth,size=mOrder.size(); pos<size; pos++)
+	{
+		const size_t circuitidx = mOrder[pos];
+		const ListComponent& comp = mIndexCircuit[circuitidx];
+		const tUsage& potential = mCandCache[circuitidx];
+
+		size_t count = 0;
+		for(size_t i=0,potsize=potential.size(); i<potsize; i++)
+		{
+			if (IsUsed(potential[i], usage)) continue;
+			if (CanInsert(comp, potential[i], 0, symbols, freeShortcut, true) || CanInsert(comp, potential[i], 1, symbols, freeShortcut, true)) count++;
+		}
+
+		if (count == 0 && (mHeuristics & eForwardCheck)) return false;
+		if (!(mHeuristics & eMostConstrainedFirst)) continue;
+
+		// ties go to the earlier component in connection order, the choice only depends on the search state
+		if (pos == depth || count < bestCount || (count == bestCount && circuitidx < mOrder[best]))
+		{
+			best = pos;
+			bestCount = count;
+		}
+	}
+
+	std::swap(mOrder[depth], mOrder[best]);
+	return true;
+}
+
+/// Cheap test that never rejects a candidate InsertIfValid would accept
+bool CircuitSolver3::CanInsert(const ListComponent& circomp, size_t netcomp_idx, int turn, const tSymbols& symbols, bool freeShortcut, bool shortcut) const
+{
+	const ListComponent& netcomp = mCandidates[netcomp_idx];
+	const ListComponent::tConnections& circons = circomp.GetCConnections();
+	const ListComponent::tConnections& netcons = netcomp.GetCConnections();
+
+	if (netcomp.CanTurn())
+	{
+		const InternString& net1 = netcons[turn ? 1 : 0];
+		const InternString& net2 = netcons[turn ? 0 : 1];
+		if (symbols.ContainsSymbol(circons[0], net2) || symbols.ContainsSymbol(circons[1], net1)) return false;
+
+		const bool bridge = freeShortcut && shortcut;
+		return symbols.CanInsert(circons[0], net1, bridge) && symbols.CanInsert(circons[1], net2, bridge);
+	}
+
+	if (turn == 1) return false;
+
+	// fixed components always search for shortcuts
+	for(size_t i = 0, size = circons.size(); i < size; ++i)
+	{
+		const string& netname = netcons[i].str();
+		if (netname.size() > 2 && netname[0] == 'N' && netname[1] == 'C') continue; // skip NC nodes
+		if (!symbols.CanInsert(circons[i], netcons[i], freeShortcut)) return false;
+	}
+	return true;
+}
+
+bool CircuitSolver3::HasFreeShortcut(const tUsage& usage) const
+{
+	for(size_t i=0,size=mShortcuts.size(); i<size; i++)
+	{
+		if (!IsUsed(mShortcuts[i], usage)) return true;
+	}
+	return false;
+}
+
+CircuitSolver3::tStateKey CircuitSolver3::StateKey(const tUsage& usage, const tSymbols& symbols)
+{
+	mStateBuffer.clear();
+	for(size_t i=0,size=mPlaced.size(); i<size; i++) mStateBuffer.push_back(mPlaced[i] ? 1 : 0);
+	for(size_t i=0,size=usage.size(); i<size; i++) mStateBuffer.push_back((int)usage[i]);
+	symbols.AppendState(mStateBuffer);
+
+	size_t h1 = 2166136261u;
+	size_t h2 = 0;
+	for(size_t i=0,size=mStateBuffer.size(); i<size; i++)
+	{
+		const size_t value = (size_t)mStateBuffer[i];
+		h1 = (h1 ^ value) * 16777619u;
+		h2 = (h2 + value + 1) * 2654435761u;
+		h2 ^= h2 >> 15;
+	}
+	return tStateKey(h1, h2);
+}
+
+bool CircuitSolver3::TryCandidateList(const ListComponent& current, const tUsage& matched, size_t depth, tUsage& usage, tSymbols& symbols, bool withShortcuts)
+{
+	const bool forwardCheck = (mHeuristics & eForwardCheck) != 0;
+	const bool freeShortcut = forwardCheck && HasFreeShortcut(usage);
+
 	for(size_t i=0,msize=matched.size(); i<msize; i++)
 	{
 		bool isIprobe = false;
-		if (current.GetType() == NamedNodes::DmmIProbe) {
+		if (current.GetTypeId() == sIProbe) {
 			isIprobe = true; // hack..
 			//if (withShortcuts) return false;
 		}
 		
 		for(int turn=0;turn<2;++turn)
 		{
-			tSymbols	symbolcopy = symbols;
+			if (forwardCheck && !CanInsert(current, matched[i], turn, symbols, freeShortcut, withShortcuts)) continue;
+
+			// each attempt starts from the same symbols, undo whatever a failed one changed
+			const SymbolTable::tCheckpoint checkpoint = symbols.Checkpoint();
 			tUsage		out;
 
-			if (!InsertIfValid(current, matched[i], turn, usage, symbolcopy, out, withShortcuts)) {
+			if (!InsertIfValid(current, matched[i], turn, usage, symbols, out, withShortcuts)) {
 				OUT(OUTSTREAM << "isn't valid" << endl);
+				symbols.Rollback(checkpoint);
 				continue;
 			}
 			
 			UpdateUsageMap(usage, out, 1);
 
-			if (!TierThreeSolveRecursive(circuitidx, usage, symbolcopy)) {
+			if (!TierThreeSolveRecursive(depth, usage, symbols)) {
 				// no solution found, mark components as free again and continue
+				mStats.backtracks++;
 				UpdateUsageMap(usage, out, 0);
+				symbols.Rollback(checkpoint);
 				continue;
 			}
 
@@ -553,15 +764,15 @@ bool CircuitSolver3::TryCandidateList(const ListComponent& current, const tUsage
 				if (isIprobe && nextit == out.end())
 				{
 					ListComponent iprobe = mCandidates[*solveit];
-					InsertIProbe(iprobe, turn, current.GetName());
+					InsertIProbe(iprobe, turn, current.GetNameId());
 					mSolution.push_back(iprobe);
 				}
 				else
 				{
 					ListComponent comp = mCandidates[*solveit];
-					if (current.GetSpecial() != "")
+					if (!current.GetSpecialId().empty())
 					{
-						comp.SetSpecial(current.GetSpecial());
+						comp.SetSpecial(current.GetSpecialId());
 					}
 					mSolution.push_back(comp);
 				}
@@ -575,7 +786,7 @@ bool CircuitSolver3::TryCandidateList(const ListComponent& current, const tUsage
 
 bool CircuitSolver3::SpecialCompare(const ListComponent& c1, const ListComponent& c2) const
 {
-	if (c1.GetType() == NamedNodes::DmmIProbe && c2.GetType() == "SHORTCUT")
+	if (c1.GetTypeId() == sIProbe && c2.GetTypeId() == sShortcut)
 	{
 		OUT(OUTSTREAM << "compare equal (iprobe/shortcut): " << c1.Dump() << " " << c2.Dump() << endl;);
 		return true;
@@ -641,14 +852,14 @@ bool CircuitSolver3::InsertIfValid(const ListComponent& circomp, size_t netcomp_
 	if (netcomp.CanTurn())
 	{
 		// turning case
-		const string& node1 = circomp.GetCConnections()[0];
-		const string& node2 = circomp.GetCConnections()[1];
+		const InternString& node1 = circomp.GetCConnections()[0];
+		const InternString& node2 = circomp.GetCConnections()[1];
 
-		const ListComponent::tConnections netcons = netcomp.GetCConnections();
+		const ListComponent::tConnections& netcons = netcomp.GetCConnections();
 
 #ifdef DEBUG_OUT
-		const string& debug1 = netcomp.GetCConnections()[turn ? 1 : 0];
-		const string& debug2 = netcomp.GetCConnections()[turn ? 0 : 1];
+		const InternString& debug1 = netcomp.GetCConnections()[turn ? 1 : 0];
+		const InternString& debug2 = netcomp.GetCConnections()[turn ? 0 : 1];
 		OUTSTREAM << "try match: " << node1 << " " << node2 << " " << debug1 << " " << debug2 << endl;
 #endif
 
@@ -697,10 +908,11 @@ bool CircuitSolver3::InsertIfValid(const ListComponent& circomp, size_t netcomp_
 		for(size_t i = 0; i < numCon; ++i)
 		{
 			// NC* nodes are only allowed on multi legged components, ignore them as not existing
-			const string& netnode = netcomp.GetCConnections()[i];
-			if (netnode.size() > 2 && netnode[0] == 'N' && netnode[1] == 'C') continue; // skip NC nodes
+			const InternString& netnode = netcomp.GetCConnections()[i];
+			const string& netname = netnode.str();
+			if (netname.size() > 2 && netname[0] == 'N' && netname[1] == 'C') continue; // skip NC nodes
 			
-			string symbol = circomp.GetCConnections()[i];
+			const InternString& symbol = circomp.GetCConnections()[i];
 			if (!symbolcopy.ContainsSymbolOrEmpty(symbol, netcomp.GetCConnections()[i]))
 			{
 				// check if we can insert a shortcut to help us
@@ -726,7 +938,7 @@ bool CircuitSolver3::InsertIfValid(const ListComponent& circomp, size_t netcomp_
 }
 
 /// This will modify the candidates and symbol table
-bool CircuitSolver3::SearchShortcuts(tSymbols& symbols2, const tUsage& usage, const string& endnode, const string& insertsymbol, tUsage& solution)
+bool CircuitSolver3::SearchShortcuts(tSymbols& symbols2, const tUsage& usage, const InternString& endnode, const InternString& insertsymbol, tUsage& solution)
 {
 	// find the shortest shortcut path between start and end
 	// end can be many symbols. XXX: ?
@@ -739,65 +951,66 @@ bool CircuitSolver3::SearchShortcuts(tSymbols& symbols2, const tUsage& usage, co
 	symbols2.Dump();
 #endif
 
-	// first make a list of all candidate shortcuts
-	tShorts usableshorts;
-	usableshorts.reserve(mShortcuts.size());
-	
+	mStats.shortcutSearches++;
+
+	// first mark all candidate shortcuts that can be used
+	bool usable = false;
 	for(size_t i=0, size = mShortcuts.size(); i < size; i++)
 	{
 		size_t shrtidx = mShortcuts[i];
 		//if (!usage[shrtidx])
 		if (!IsUsed(shrtidx, usage))
 		{
-			const ListComponent::tConnections cons = mCandidates[shrtidx].GetCConnections();
+			const ListComponent::tConnections& cons = mCandidates[shrtidx].GetCConnections();
 			if (!symbols2.RefersSameNode(cons[0], cons[1]))
 			{
-				usableshorts.push_back(shrtidx);
+				mUsableShortcut[shrtidx] = true;
+				usable = true;
 			}
 		}
 	}
 
-	if (usableshorts.empty()) return false;
-
-#ifdef DEBUG_OUT
-	OUTSTREAM << "USABLE SHORTCUTS" << endl; 
-	DumpIndicesList(shortcuts, mCandidates);
-#endif
+	if (!usable) return false;
 
-	tVisit toVisit;
-	// make the algorithm start at "startnode"
-	toVisit.push_back(insertsymbol);
+	// make the algorithm start at "startnode", no shortcut touches it if it isn't in the graph
+	const int startnode = mShortcutGraph.NodeIndex(insertsymbol);
+	mVisit.clear();
+	if (startnode >= 0) mVisit.push_back(startnode);
 
 	bool rv = false;
-	tTree tree;
-	string lastnode;
+	size_t lastnode = 0;
 
 #ifdef DEBUG_OUT
 	OUTSTREAM << "Tracing shortcuts: " << endl;
 #endif
-	while(!toVisit.empty() && !rv)
+	for(size_t head = 0; head < mVisit.size() && !rv; head++)
 	{
-		lastnode = toVisit.front();
-		if (symbols2.ContainsSymbol(endnode, lastnode)) rv = true;
+		lastnode = mVisit[head];
+		if (symbols2.ContainsSymbol(endnode, mShortcutGraph.Node(lastnode))) rv = true;
 
-		SearchShortcutVisit(toVisit.front(), toVisit, usableshorts, tree);
-		toVisit.pop_front();
+		SearchShortcutVisit(lastnode);
 	}
 
 #ifdef DEBUG_OUT
 	OUTSTREAM << endl;
 #endif
 
-	tSymbols symbolscopy;
+	tCompIndices out; // just a index array
 	if (rv)
 	{
-		symbolscopy = symbols2; // don't copy until we really need it copied
 #ifdef DEBUG_OUT
 		OUTSTREAM << "FOUND A BRIDGE!!" << endl;
 #endif
-		tCompIndices out; // just a index array
-		//out.reserve(mShortcuts.size()); // might be possible to count tree depth
-		SearchShortcutBacktrace(tree, lastnode, insertsymbol, out);
+		SearchShortcutBacktrace(lastnode, insertsymbol, out);
+	}
+
+	// leave the marks and the tree clean for the next search, every node with a tree entry was queued
+	for(size_t i=0, size = mShortcuts.size(); i < size; i++) mUsableShortcut[mShortcuts[i]] = false;
+	for(size_t i=0, size = mVisit.size(); i < size; i++) mTree[mVisit[i]] = 0;
+
+	if (rv)
+	{
+		const SymbolTable::tCheckpoint checkpoint = symbols2.Checkpoint();
 
 #ifdef DEBUG_OUT
 		OUTSTREAM << "Dump Bridge" << endl;
@@ -809,75 +1022,54 @@ bool CircuitSolver3::SearchShortcuts(tSymbols& symbols2, const tUsage& usage, co
 			const ListComponent& comp = mCandidates[*it];
 			solution.push_back(*it);
 			
-			if (!symbolscopy.Insert(endnode, comp.GetCConnections()[0])) return false;
-			if (!symbolscopy.Insert(endnode, comp.GetCConnections()[1])) return false;
+			if (!symbols2.Insert(endnode, comp.GetCConnections()[0]) || !symbols2.Insert(endnode, comp.GetCConnections()[1]))
+			{
+				symbols2.Rollback(checkpoint);
+				return false;
+			}
 		}
 
-		symbols2 = symbolscopy;
 		return true;
 	}
 
 	return false;
 }
 
-bool CircuitSolver3::SearchShortcutVisit(const string& current, tVisit& tovisit, tShorts& edges, tTree& tree) const
+void CircuitSolver3::SearchShortcutVisit(size_t current)
 {
-	// find any shortcut leading from current
-	// if we find a bridge, return
+	// follow every usable shortcut leading from current, each is only followed once
 
+	const InternString& name = mShortcutGraph.Node(current);
 #ifdef DEBUG_OUT
-	OUTSTREAM << "Shortcut Visit: " << current << endl;
+	OUTSTREAM << "Shortcut Visit: " << name << endl;
 #endif
-	tShorts::iterator it = edges.begin();
-	while(it != edges.end())
+	for(const size_t* it = mShortcutGraph.RowBegin(current), *end = mShortcutGraph.RowEnd(current); it != end; ++it)
 	{
-		bool next = true;
-		const ListComponent::tConnections cons = mCandidates[*it].GetCConnections();
+		const size_t shrtidx = *it;
+		if (!mUsableShortcut[shrtidx]) continue;
+		mUsableShortcut[shrtidx] = false;
 
-		if (cons[0] == current)
+		const ListComponent::tConnections& cons = mCandidates[shrtidx].GetCConnections();
+		const size_t other = mShortcutGraph.NodeIndex(cons[0] == name ? cons[1] : cons[0]);
+		if (!mTree[other])
 		{
-			if (!tree[cons[1]])
-			{
-				tree[cons[1]] = *it;
-				tovisit.push_back(cons[1]);
-			}
-			
-			next = false;
-		}
-		else if (cons[1] == current)
-		{
-			if (!tree[cons[0]])
-			{
-				tree[cons[0]] = *it;
-				tovisit.push_back(cons[0]);
-			}
-			next = false;
-		}
-
-		if (next) ++it;
-		else
-		{
-			it = edges.erase(it);
+			mTree[other] = shrtidx;
+			mVisit.push_back(other);
 		}
 	}
-
-	return true;
 }
 
-bool CircuitSolver3::SearchShortcutBacktrace(const tTree& tree, const string& lastnode, const string& startnode, tCompIndices& out) const
+bool CircuitSolver3::SearchShortcutBacktrace(size_t lastnode, const InternString& startnode, tCompIndices& out) const
 {
 	// backtrace the found shortcut bridge
 
-	string current = lastnode;
+	InternString current = mShortcutGraph.Node(lastnode);
 	bool done = false;
 
 	while(!done)
 	{
-		tTree::const_iterator finder = tree.find(current);
-		OUT(if (finder == tree.end()) OUTSTREAM << "Undefined node found in shortcut backtrace.." << endl);
-
-		const size_t c_idx = finder->second; //.front();
-		const ListComponent::tConnections cons = mCandidates[c_idx].GetCConnections();
+		const size_t c_idx = mTree[mShortcutGraph.NodeIndex(current)];
+		const ListComponent::tConnections& cons = mCandidates[c_idx].GetCConnections();
 		
 		if (cons[0] == current)
 		{
@@ -904,7 +1096,7 @@ bool CircuitSolver3::SearchShortcutBacktrace(const tTree& tree, const string& la
 // utility functions
 void CircuitSolver3::SetSymbol(const string& node, const string& symbol)
 {
-	mSymbols.Insert(node,symbol);
+	mSymbols.Insert(InternString(node), InternString(symbol));
 }
 
 /*void CircuitSolver3::Add(ListComponent& comp)
@@ -919,18 +1111,18 @@ CircuitSolver3::tCircuit CircuitSolver3::GetSolution() const
 
 bool CircuitSolver3::IsConnected(const string& node) const
 {
-	return mSolutionSymbols.IsUsed(node);
+	return mSolutionSymbols.IsUsed(InternString(node));
 }
 
-string CircuitSolver3::GetFirstSymbol(const string& sym)
+string CircuitSolver3::GetFirstSymbol(const InternString& sym)
 {
 	return mSolutionSymbols.GetFirstNodeOrSpare(sym);
 }
 
-void CircuitSolver3::InsertIProbe(ListComponent& component, int turn, const std::string& name)
+void CircuitSolver3::InsertIProbe(ListComponent& component, int turn, const InternString& name)
 {
-	component.SetType(NamedNodes::DmmIProbe);
-	component.SetSpecial(turn ? "1" : "0");
+	component.SetType(sIProbe);
+	component.SetSpecial(turn ? sIProbeTurned : sIProbeNotTurned);
 	component.SetName(name);
 }
 
@@ -939,6 +1131,27 @@ void CircuitSolver3::EnableLogging()
 	InitLogging();
 }
 
+void CircuitSolver3::SetCancelFlag(volatile int* pCancel)
+{
+	mpCancel = pCancel;
+}
+
+void CircuitSolver3::SetHeuristics(int heuristics)
+{
+	mHeuristics = heuristics;
+}
+
+void CircuitSolver3::SetBudget(size_t maxNodes, double maxSeconds)
+{
+	mMaxNodes = maxNodes;
+	mMaxSeconds = maxSeconds;
+}
+
+void CircuitSolver3::SetSharedBudget(SolverBudget* pBudget)
+{
+	mpSharedBudget = pBudget;
+}
+
 
 void CircuitSolver3::AddInstrumentNodes(tCircuit& list)
 {
@@ -947,7 +1160,7 @@ void CircuitSolver3::AddInstrumentNodes(tCircuit& list)
 		OUT(OUTSTREAM << "Adding instrument node for: " << it->GetType() << " " << it->GetName() << endl);
 
 		// The DMM has 2 connections that needs to be matched
-		if (it->GetType() == "DMM")
+		if (it->GetTypeId() == sDmm)
 		{
 			const string sym1 = GetFirstSymbol(it->GetCConnections()[0]);
 			const string sym2 = GetFirstSymbol(it->GetCConnections()[1]);
@@ -35,6 +35,8 @@
 
 //#include "listcomponent.h"
 #include "circuitsymbols2.h"
+#include "componentgraph.h"
+#include "solverbudget.h"
 
 class LogModule;
 class ListComponent;
@@ -44,11 +46,10 @@ class CircuitSolver3
 private:
 	typedef SymbolTable					tSymbols;
 	typedef std::vector<ListComponent>	tCircuit;
-	typedef std::deque<std::string>		tVisit;
+	typedef std::vector<size_t>			tVisit;		///< node indices of a ComponentGraph
 	typedef std::vector<size_t>			tOrderedIndices;
 	typedef std::vector<bool>			tUsedIndices;
-	typedef std::vector<std::string>	tUsedInstrumentSymbols;
-	typedef std::vector<size_t>			tShorts;
+	typedef std::vector<InternString>	tUsedInstrumentSymbols;
 public:
 	typedef std::deque<ListComponent>	tCandidates;
 	typedef std::vector<size_t>			tUsage;
@@ -56,8 +57,23 @@ public:
 	typedef std::deque<size_t>			tCompIndices;
 	typedef std::vector<ListComponent>	tVectorCircuit;
 
+	/// Search heuristics, flags for SetHeuristics.
+	/// They change the order components are solved in and cut branches that can't succeed,
+	/// so a different (but valid) solution may be found than without them.
+	enum Heuristics
+	{
+		eMostConstrainedFirst	= 1,	///< solve the component with the fewest usable candidates next
+		eForwardCheck			= 2,	///< skip candidates whose nodes are bound to other symbols
+		eNogoods				= 4,	///< remember partial states that failed and don't search them again
+		eAllHeuristics			= 7
+	};
+
 	bool Solve(const tCircuit& circuit, const tCandidates& candidates);
 
+	/// The circuit components the search has to place, each needs a candidate of its own.
+	/// Those are the ones tier one reaches, without the wires and instruments
+	void GetPlacedComponents(const tCircuit& circuit, tCircuit& placed);
+
 	//void Add(ListComponent& comp);
 	void SetSymbol(const std::string& node, const std::string& symbol);
 	
@@ -65,14 +81,29 @@ public:
 
 	void		EnableLogging();
 
+	/// Abort the search as soon as *pCancel becomes non-zero, the flag is polled from the solving thread
+	void		SetCancelFlag(volatile int* pCancel);
+
+	/// Combination of Heuristics flags, 0 searches in connection and maxlist order. Default is eAllHeuristics
+	void		SetHeuristics(int heuristics);
+
+	/// Limit each Solve call, 0 means no limit. An exhausted budget makes Solve fail with GetStats().aborted set
+	void		SetBudget(size_t maxNodes, double maxSeconds);
+
+	/// Also count the nodes against a budget shared with other solvers, NULL to stop sharing
+	void		SetSharedBudget(SolverBudget* pBudget);
+
+	/// What the last Solve call did
+	const SolverStats&	GetStats() const { return mStats; }
+
 	/// Check if a node is used in the solution
 	bool		IsConnected(const std::string& node) const;
 
 	CircuitSolver3();
 	virtual ~CircuitSolver3();
 private:
-	//typedef std::map<std::string, tCompIndices > tTree;
-	typedef std::map<std::string, size_t > tTree;
+	// the shortcut reaching each node of the shortcut graph, 0 if none
+	typedef std::vector<size_t>	tTree;
 
 	typedef std::vector< tUsage >	tCandCache;
 	tCandCache		mCandCache;
@@ -85,6 +116,14 @@ private:
 	tVectorCircuit	mCandidates;
 	tCompIndices	mShortcuts;
 
+	// graph walks index these by node and reuse them between walks
+	ComponentGraph	mCircuitGraph;		///< the circuit, for tier one
+	ComponentGraph	mShortcutGraph;		///< the shortcut candidates, for the bridge search
+	tVisit			mVisit;
+	std::vector<bool>	mVisited;
+	std::vector<bool>	mUsableShortcut;	///< by candidate index, set during a bridge search
+	tTree			mTree;
+
 	// These needs to be cleaned up..
 	//tCircuit	mInstruments;
 	tCircuit	mMeasInstrument;
@@ -92,10 +131,33 @@ private:
 	tCircuit	mSolution;
 	tSymbols	mSolutionSymbols;
 
+	volatile int*	mpCancel;
+	int				mHeuristics;
+
+	size_t			mMaxNodes;
+	double			mMaxSeconds;
+	SolverBudget	mBudget;
+	SolverBudget*	mpSharedBudget;
+	SolverStats		mStats;
+
+	// circuit indices in the order they are solved, the ones before the current depth are placed
+	tOrderedIndices	mOrder;
+	tUsedIndices	mPlaced;
+
+	// two independent hashes of a failed search state, a collision would skip a branch that can be solved
+	typedef std::pair<size_t, size_t>	tStateKey;
+	typedef std::set<tStateKey>			tNogoods;
+	tNogoods			mNogoods;
+	std::vector<int>	mStateBuffer;
+
+	bool	SolveCircuit(const tCircuit& circuit, const tCandidates& candidates);
+	bool	IsStopped();
+
 	bool	InsertIfValid(const ListComponent& circomp, size_t netcomp, int turn, const tUsage& usage, tSymbols& symbolcopy, tUsage& solution, bool shortcut);
 
 	//		Tier one, search for used components and instruments in the circuit
-	bool	TierOne(const tCandidates& cand, tUsedIndices& used, tOrderedIndices& ordered, tUsedInstrumentSymbols& instrSymbols) const;
+	bool	TierOne(const tCandidates& cand, tUsedIndices& used, tOrderedIndices& ordered, tUsedInstrumentSymbols& instrSymbols);
+	void	VisitOnce(int node);
 
 	//		Tier two, replace wires with symbols
 	//		also figure out which measurement instruments are connected and clear them from the candidates
@@ -103,19 +165,23 @@ private:
 
 	//		Tier three, the actual solver
 	bool	TierThree(const tCandidates& circuit, const tCandidates& candidates, tSymbols& symbols);
-	bool	TierThreeSolveRecursive(size_t circuitidx, tUsage& usage, tSymbols& symbols);
-	bool	TryCandidateList(const ListComponent& current, const tUsage& matched, size_t circuitidx, tUsage& usage, const tSymbols& symbols, bool withShortcuts);
+	bool	TierThreeSolveRecursive(size_t depth, tUsage& usage, tSymbols& symbols);
+	bool	SelectNext(size_t depth, const tUsage& usage, const tSymbols& symbols);
+	bool	CanInsert(const ListComponent& circomp, size_t netcomp, int turn, const tSymbols& symbols, bool freeShortcut, bool shortcut) const;
+	bool	HasFreeShortcut(const tUsage& usage) const;
+	tStateKey	StateKey(const tUsage& usage, const tSymbols& symbols);
+	bool	TryCandidateList(const ListComponent& current, const tUsage& matched, size_t depth, tUsage& usage, tSymbols& symbols, bool withShortcuts);
 	bool	TierThreeMatchAndInsert();
 
 	bool	BuildCandidateCache();
 
 	bool	SpecialCompare(const ListComponent& c1, const ListComponent& c2) const;
 
-	bool	SearchShortcuts(tSymbols& symbols, const tUsage& usage, const std::string& endnode, const std::string& insertsymbol, tUsage& solution);
-	bool	SearchShortcutVisit(const std::string& current, tVisit& tovisit, tShorts& edges, tTree& tree) const;
-	bool	SearchShortcutBacktrace(const tTree& tree, const std::string& lastnode, const std::string& startnode, tCompIndices& out) const;
+	bool	SearchShortcuts(tSymbols& symbols, const tUsage& usage, const InternString& endnode, const InternString& insertsymbol, tUsage& solution);
+	void	SearchShortcutVisit(size_t current);
+	bool	SearchShortcutBacktrace(size_t lastnode, const InternString& startnode, tCompIndices& out) const;
 
-	void	InsertIProbe(ListComponent& component, int turn, const std::string& name);
+	void	InsertIProbe(ListComponent& component, int turn, const InternString& name);
 
 	void	InstrumentFixup(tCandidates& cand);
 	void	CircuitFixup(tCandidates& cand);
@@ -127,7 +193,7 @@ private:
 	inline void UpdateUsageMap(tUsage& usage, const tUsage& update, size_t state);
 
 	/// Get first symbol from node
-	std::string		GetFirstSymbol(const std::string& node);
+	std::string		GetFirstSymbol(const InternString& node);
 
 	//void	DumpCandidateList(tCandidates& list);
 	//friend void	DumpCandidateList(tCandidates& list);
@@ -47,8 +47,35 @@ SymbolTable::SymbolTable()
 	mSymbolCounter = 0;
 }
 
+void SymbolTable::Rollback(tCheckpoint checkpoint)
+{
+	while (mUndoLog.size() > checkpoint)
+	{
+		const tUndo& undo = mUndoLog.back();
+		if (undo.slot >= 0) mSymbolToNodeIdx[undo.slot] = undo.value;
+		else mNodeToIdx[-1 - undo.slot] = undo.value;
+		mUndoLog.pop_back();
+	}
+}
+
+void SymbolTable::SetSlot(size_t slot, int idx)
+{
+	if (mSymbolToNodeIdx[slot] == idx) return;
+	tUndo undo = { (int)slot, mSymbolToNodeIdx[slot] };
+	mUndoLog.push_back(undo);
+	mSymbolToNodeIdx[slot] = idx;
+}
+
+void SymbolTable::SetNode(size_t nodeid, int idx)
+{
+	if (mNodeToIdx[nodeid] == idx) return;
+	tUndo undo = { -1 - (int)nodeid, mNodeToIdx[nodeid] };
+	mUndoLog.push_back(undo);
+	mNodeToIdx[nodeid] = idx;
+}
+
 /// add a reference between sym1 and sym2
-bool SymbolTable::Ref(const std::string& sym1, const std::string& sym2)
+bool SymbolTable::Ref(const InternString& sym1, const InternString& sym2)
 {
 	// get both symbols
 	// if both exist, merge and update index
@@ -72,17 +99,17 @@ bool SymbolTable::Ref(const std::string& sym1, const std::string& sym2)
 	}
 	else if (idx1 >= 0)
 	{
-		GetSymbolRef(sym2) = idx1;
+		SetSymbolIdx(sym2, idx1);
 	}
 	else if (idx2 >= 0)
 	{
-		GetSymbolRef(sym1) = idx2;
+		SetSymbolIdx(sym1, idx2);
 	}
 	else
 	{
 		size_t newindex = CreateNode();
-		GetSymbolRef(sym1) = newindex;
-		GetSymbolRef(sym2) = newindex;
+		SetSymbolIdx(sym1, newindex);
+		SetSymbolIdx(sym2, newindex);
 	}
 
 	return true;
@@ -91,7 +118,7 @@ bool SymbolTable::Ref(const std::string& sym1, const std::string& sym2)
 /// finds the symbol and adds the node to it
 /// if the node exists elsewhere, it will return false
 /// Notice: Can't just return false if the node is defined elsewhere as the function is used with or without verification
-bool SymbolTable::Insert(const std::string& sym, const std::string& node)
+bool SymbolTable::Insert(const InternString& sym, const InternString& node)
 {
 	ValidateNodeName(node);
 	
@@ -99,42 +126,42 @@ bool SymbolTable::Insert(const std::string& sym, const std::string& node)
 	const int idx = GetIndexOf(sym);
 	if (idx < 0)
 	{
-		int newindex = CreateNode(node[0]);
+		int newindex = CreateNode(node.str()[0]);
 		if (newindex < 0) return false;
-		GetSymbolRef(sym) = newindex;
+		SetSymbolIdx(sym, newindex);
 	}
 	else
 	{
-		return (AddNodeToIdx(idx, node[0]) >= 0);
+		return (AddNodeToIdx(idx, node.str()[0]) >= 0);
 	}
 	return rv;
 }
 
-void SymbolTable::Remove(const std::string& sym)
+void SymbolTable::Remove(const InternString& sym)
 {
 	EraseNodeForSymbol(sym);
 	EraseSymbol(sym);
 }
 
-bool SymbolTable::ContainsSymbolOrEmpty(const std::string& sym, const std::string& node) const
+bool SymbolTable::ContainsSymbolOrEmpty(const InternString& sym, const InternString& node) const
 {
 	ValidateNodeName(node);
 	
 	const int idx = GetIndexOf(sym);
 	if (idx < 0) return true;
 	if (NodesUsedForIdx(idx) == 0) return true;
-	return IdxUsesNode(idx, node[0]);
+	return IdxUsesNode(idx, node.str()[0]);
 }
 
-bool SymbolTable::ContainsSymbol(const std::string& sym, const std::string& node) const
+bool SymbolTable::ContainsSymbol(const InternString& sym, const InternString& node) const
 {
 	ValidateNodeName(node);
 	const int idx = GetIndexOf(sym);
 	if (idx < 0) return false;
-	return IdxUsesNode(idx, node[0]);
+	return IdxUsesNode(idx, node.str()[0]);
 }
 
-bool SymbolTable::IsUsed(const std::string& sym) const
+bool SymbolTable::IsUsed(const InternString& sym) const
 {
 	const int idx = GetIndexOf(sym);
 	if (idx >= 0)
@@ -144,7 +171,7 @@ bool SymbolTable::IsUsed(const std::string& sym) const
 	return false;
 }
 
-bool SymbolTable::RefersSameSymbol(const std::string& sym1, const std::string& sym2) const
+bool SymbolTable::RefersSameSymbol(const InternString& sym1, const InternString& sym2) const
 {
 	const int idx1 = GetIndexOf(sym1);
 	const int idx2 = GetIndexOf(sym2);
@@ -152,18 +179,59 @@ bool SymbolTable::RefersSameSymbol(const std::string& sym1, const std::string& s
 	return false;
 }
 
-bool SymbolTable::RefersSameNode(const std::string& node1, const std::string& node2) const
+bool SymbolTable::RefersSameNode(const InternString& node1, const InternString& node2) const
 {
 	ValidateNodeName(node1);
 	ValidateNodeName(node2);
 
-	const int idx1 = FindNodeIdx(node1[0]);
-	const int idx2 = FindNodeIdx(node2[0]);
+	const int idx1 = FindNodeIdx(node1.str()[0]);
+	const int idx2 = FindNodeIdx(node2.str()[0]);
 	if ( (idx1 >= 0) && (idx2 >= 0) && (idx1 == idx2)) return true;
 	return false;
 }
 
-std::string	SymbolTable::GetFirstNodeOrSpare(const std::string& sym)
+bool SymbolTable::CanInsert(const InternString& sym, const InternString& node, bool bridge) const
+{
+	ValidateNodeName(node);
+
+	const int idx = GetIndexOf(sym);
+	const int nodeidx = FindNodeIdx(node.str()[0]);
+	if (nodeidx >= 0) return (nodeidx == idx);
+	if (idx < 0 || bridge) return true;
+	return (NodesUsedForIdx(idx) == 0);
+}
+
+static int StateLabel(std::vector<int>& seen, int idx)
+{
+	for(size_t i = 0; i < seen.size(); ++i)
+	{
+		if (seen[i] == idx) return (int)i;
+	}
+	seen.push_back(idx);
+	return (int)seen.size() - 1;
+}
+
+void SymbolTable::AppendState(std::vector<int>& out) const
+{
+	// the indices depend on the order things were merged, number them in the order they are first seen instead
+	std::vector<int> seen;
+	for(size_t slot = 0, size = mSymbolToNodeIdx.size(); slot < size; ++slot)
+	{
+		const int idx = mSymbolToNodeIdx[slot];
+		if (idx < 0) continue;
+		// symbols outside the vocabulary have no id, their text hash stands in and can't be taken for one
+		const InternString& symbol = mSymbols[slot];
+		out.push_back(symbol.IsInterned() ? (int)symbol.Id() : (int)(symbol.Hash() | 0x80000000u));
+		out.push_back(StateLabel(seen, idx));
+	}
+
+	for(size_t i = 0; i < NodeToIdxSize; ++i)
+	{
+		out.push_back(mNodeToIdx[i] < 0 ? -1 : StateLabel(seen, mNodeToIdx[i]));
+	}
+}
+
+std::string	SymbolTable::GetFirstNodeOrSpare(const InternString& sym)
 {
 	tNodeName out = tNodeName();
 	const int idx = GetIndexOf(sym);
@@ -196,11 +264,11 @@ std::string	SymbolTable::GetFirstNodeOrSpare(const std::string& sym)
 	if (diff.empty()) return "NOSPARE";
 	out = *diff.begin();
 	std::string strout(1, out);
-	Insert(sym, strout);
+	Insert(sym, InternString(strout));
 	return strout;
 }
 
-void SymbolTable::Mark(tMarked& markdata, const std::string& sym)
+void SymbolTable::Mark(tMarked& markdata, const InternString& sym)
 {
 	// should this create the node if it doesn't exist?
 	const int idx = GetIndexOf(sym);
@@ -212,11 +280,11 @@ void SymbolTable::Mark(tMarked& markdata, const std::string& sym)
 	{
 		size_t newindex = CreateNode();
 		markdata.insert(newindex);
-		GetSymbolRef(sym) = newindex;
+		SetSymbolIdx(sym, newindex);
 	}
 }
 
-bool SymbolTable::IsMarked(const tMarked& markdata, const std::string& sym) const
+bool SymbolTable::IsMarked(const tMarked& markdata, const InternString& sym) const
 {
 	const int idx = GetIndexOf(sym);
 	if (idx >= 0)
@@ -234,7 +302,7 @@ void SymbolTable::Dump() const
 #endif
 }
 
-void SymbolTable::DumpSymbol(const std::string& sym)
+void SymbolTable::DumpSymbol(const InternString& sym)
 {
 #ifdef DEBUG_OUT
 	int idx = GetIndexOf(sym);
@@ -244,30 +312,56 @@ void SymbolTable::DumpSymbol(const std::string& sym)
 
 ///////////////////////////////////////////////
 
-SymbolTable::tSymbolLookup SymbolTable::sSymbolLookup;
+static inline size_t HashSymbol(const InternString& symbol)
+{
+	return symbol.Hash() * 2654435761u;
+}
 
-void SymbolTable::ToSymbolName(const std::string& symbol, tSymbolName& out)
-//SymbolTable::tSymbolName SymbolTable::ToSymbolName(const std::string& symbol)
+int SymbolTable::LookupSymbol(const InternString& symbol) const
 {
-	if (symbol.size() >= 16) {
-		//std::cerr << "Symbol name longer than 15 chars";
-		const char* invalid = "<INVALID>";
-		strcpy(out._name, invalid);
-	} else {
-		strcpy(out._name, symbol.c_str());
+	if (mSymbolHash.empty()) return -1;
+
+	const size_t mask = mSymbolHash.size() - 1;
+	for(size_t pos = HashSymbol(symbol) & mask; ; pos = (pos + 1) & mask)
+	{
+		const int slot = mSymbolHash[pos];
+		if (slot < 0) return -1;
+		if (mSymbols[slot] == symbol) return slot;
 	}
 }
 
-int SymbolTable::LookupSymbol(const std::string& symbol) const
+int SymbolTable::AddSymbol(const InternString& symbol)
 {
-	for(size_t i = 0, size = sSymbolLookup.size(); i < size; ++i)
+	// keep the load factor below one half
+	if ((mSymbols.size() + 1) * 2 > mSymbolHash.size())
 	{
-		if (symbol == sSymbolLookup[i]._name) return i;
+		Rehash(mSymbolHash.empty() ? 32 : mSymbolHash.size() * 2);
 	}
-	return -1;
+
+	const int slot = (int)mSymbols.size();
+	mSymbols.push_back(symbol);
+	mSymbolToNodeIdx.push_back(-1);
+
+	const size_t mask = mSymbolHash.size() - 1;
+	size_t pos = HashSymbol(symbol) & mask;
+	while (mSymbolHash[pos] >= 0) pos = (pos + 1) & mask;
+	mSymbolHash[pos] = slot;
+	return slot;
 }
 
-/*int SymbolTable::GetSymbolIdx(const std::string& symbol) const
+void SymbolTable::Rehash(size_t size)
+{
+	mSymbolHash.assign(size, -1);
+	const size_t mask = size - 1;
+	for(size_t slot = 0; slot < mSymbols.size(); ++slot)
+	{
+		size_t pos = HashSymbol(mSymbols[slot]) & mask;
+		while (mSymbolHash[pos] >= 0) pos = (pos + 1) & mask;
+		mSymbolHash[pos] = (int)slot;
+	}
+}
+
+/*int SymbolTable::GetSymbolIdx(const InternString& symbol) const
 {
 #ifdef NEW_SYMBOLS
 	int idx = LookupSymbol(symbol);
@@ -278,33 +372,18 @@ int SymbolTable::LookupSymbol(const std::string& symbol) const
 #endif
 }*/
 
-int& SymbolTable::GetSymbolRef(const std::string& symbol)
+void SymbolTable::SetSymbolIdx(const InternString& symbol, int idx)
 {
-#ifdef NEW_SYMBOLS
-	int idx = LookupSymbol(symbol);
-	if (idx >= 0) return mSymbolToNodeIdx[idx];
-
-	tSymbolName symname;
-	ToSymbolName(symbol, symname);
-	
-	size_t newidx = sSymbolLookup.size();
-	sSymbolLookup.push_back(symname);
-	if (mSymbolToNodeIdx.size() <= newidx) {
-		mSymbolToNodeIdx.resize((newidx+1)*2);
+	int slot = LookupSymbol(symbol);
+	if (slot < 0)
+	{
+		if (idx < 0) return; // erasing a symbol that was never added
+		slot = AddSymbol(symbol);
 	}
-	mSymbolToNodeIdx[newidx] = -1;
-	return mSymbolToNodeIdx[newidx];
-#else
-	return mMap[symbol];
-#endif
-}
-
-void SymbolTable::ResetLookup()
-{
-	sSymbolLookup = tSymbolLookup();
+	SetSlot(slot, idx);
 }
 
-int SymbolTable::GetIndexOf(const std::string& sym) const
+int SymbolTable::GetIndexOf(const InternString& sym) const
 {
 #ifdef NEW_SYMBOLS
 	int idx = LookupSymbol(sym);
@@ -324,9 +403,9 @@ void SymbolTable::UpdateRef(int ref, int newref)
 	assert(newref != -1 && "newref can't be -1");
 	
 #ifdef NEW_SYMBOLS
-	for(tSymbolToNodeIdx::iterator it = mSymbolToNodeIdx.begin(), end = mSymbolToNodeIdx.end(); it != end; ++it)
+	for(size_t slot = 0, size = mSymbolToNodeIdx.size(); slot < size; ++slot)
 	{
-		if (*it == ref) *it = newref;
+		if (mSymbolToNodeIdx[slot] == ref) SetSlot(slot, newref);
 	}
 #else
 	for(tMap::iterator it = mMap.begin(); it != mMap.end(); it++)
@@ -339,10 +418,10 @@ void SymbolTable::UpdateRef(int ref, int newref)
 #endif
 }
 
-void SymbolTable::EraseSymbol(const std::string& symbol)
+void SymbolTable::EraseSymbol(const InternString& symbol)
 {
 #ifdef NEW_SYMBOLS
-	GetSymbolRef(symbol) = -1;
+	SetSymbolIdx(symbol, -1);
 #else
 	mMap.erase(symbol);
 #endif
@@ -352,9 +431,9 @@ std::string SymbolTable::DumpSymbols() const
 {
 	std::stringstream outbuffer;
 #ifdef NEW_SYMBOLS
-	for(size_t i = 0; i< sSymbolLookup.size(); ++i)
+	for(size_t i = 0; i< mSymbols.size(); ++i)
 	{
-		outbuffer << "(" << std::string(sSymbolLookup[i]._name) << "-" << mSymbolToNodeIdx[i] << ") ";
+		outbuffer << "(" << mSymbols[i] << "-" << mSymbolToNodeIdx[i] << ") ";
 	}
 #else
 	for(tMap::const_iterator map_it = mMap.begin(); map_it != mMap.end(); ++map_it)
@@ -367,9 +446,9 @@ std::string SymbolTable::DumpSymbols() const
 
 ///////////////////////////////////////////////
 
-void SymbolTable::ValidateNodeName(const std::string& node) const
+void SymbolTable::ValidateNodeName(const InternString& node) const
 {
-	if (node.size() > 1) {
+	if (node.str().size() > 1) {
 		throw BasicException("Invalid node name found in symboltable");
 	}
 }
@@ -390,13 +469,13 @@ int SymbolTable::FindNodeIdx(tNodeName node) const
 }
 
 // XXX: Might be possible to remove srcsym parameter
-bool SymbolTable::MergeNodes(int dst, int src, const std::string& srcsym)
+bool SymbolTable::MergeNodes(int dst, int src, const InternString& srcsym)
 {
 #ifdef NEW_NODES
 	for(size_t i=0;i<NodeToIdxSize; ++i)
 	{
 		if (mNodeToIdx[i] == src) {
-			mNodeToIdx[i] = dst;
+			SetNode(i, dst);
 		}
 	}
 #else
@@ -404,7 +483,7 @@ bool SymbolTable::MergeNodes(int dst, int src, const std::string& srcsym)
 	mVec[src] = SymNode(); // Remove old Node
 #endif
 
-	GetSymbolRef(srcsym) = dst;
+	SetSymbolIdx(srcsym, dst);
 	UpdateRef(src, dst);
 	if (NodesUsedForIdx(dst) > 1) return false;
 	return true;
@@ -427,7 +506,7 @@ int	SymbolTable::CreateNode(tNodeName node)
 	size_t nodeid = LookupNode(node);
 	if (mNodeToIdx[nodeid] >= 0) return -1; // used elsewhere
 	int newSym = mSymbolCounter++;
-	mNodeToIdx[nodeid] = newSym;
+	SetNode(nodeid, newSym);
 	return newSym;
 #else
 	
@@ -454,7 +533,7 @@ int SymbolTable::AddNodeToIdx(int idx, tNodeName node)
 	if (idx == mNodeToIdx[nodeid]) return idx; // we're already using the node, ok
 	if (mNodeToIdx[nodeid] != -1) return -1; // someone else is using this node
 	
-	mNodeToIdx[nodeid] = idx;
+	SetNode(nodeid, idx);
 	return idx;
 #else
 	// verify that no other SymNode has the same node first before inserting
@@ -508,7 +587,7 @@ size_t SymbolTable::LookupNode(tNodeName node) const
 	return 0; // never reached
 }
 
-void SymbolTable::EraseNodeForSymbol(const std::string& sym)
+void SymbolTable::EraseNodeForSymbol(const InternString& sym)
 {
 #ifdef NEW_NODES
 	int idx = GetIndexOf(sym);
@@ -516,7 +595,7 @@ void SymbolTable::EraseNodeForSymbol(const std::string& sym)
 	{
 		for(size_t i=0;i<NodeToIdxSize; ++i)
 		{
-			if (mNodeToIdx[i] == idx) mNodeToIdx[i] = -1;
+			if (mNodeToIdx[i] == idx) SetNode(i, -1);
 		}
 	}
 #else
@@ -29,6 +29,8 @@
 #define __CIRCUIT_SYMBOLS2_H__
 
 //#include <algorithm>
+#include "internstring.h"
+
 #include <string>
 #include <map>
 //#include <list>
@@ -63,53 +65,70 @@ private:
 };
  */
 
+/// Maps circuit symbols to maxlist nodes.
+/// Every change is recorded in an undo log, a search can take a checkpoint and roll back
+/// to it when a branch fails instead of copying the whole table.
 class SymbolTable
 {
 public:
+	typedef size_t tCheckpoint;
+
 	SymbolTable();
+
+	///		Mark the current state, changes after this can be undone with Rollback
+	tCheckpoint	Checkpoint() const { return mUndoLog.size(); }
+
+	///		Undo all changes made after the checkpoint was taken
+	void	Rollback(tCheckpoint checkpoint);
 	
 	///		Add a reference between sym1 and sym2
 	///		Returns false if more than one node is defined in the resulting symbol
-	bool	Ref(const std::string& sym1, const std::string& sym2);
+	bool	Ref(const InternString& sym1, const InternString& sym2);
 
 	///		Finds the symbol and adds the node to it
 	///		If the node exists elsewhere, it will return false and no node is added
-	bool	Insert(const std::string& sym, const std::string& node);
+	bool	Insert(const InternString& sym, const InternString& node);
 
-	void	Remove(const std::string& sym);
+	void	Remove(const InternString& sym);
 
-	bool	ContainsSymbolOrEmpty(const std::string& sym, const std::string& node) const;
-	bool	ContainsSymbol(const std::string& sym, const std::string& node) const;
+	bool	ContainsSymbolOrEmpty(const InternString& sym, const InternString& node) const;
+	bool	ContainsSymbol(const InternString& sym, const InternString& node) const;
 	
-	bool	IsUsed(const std::string& sym) const;
-	bool	RefersSameSymbol(const std::string& sym1, const std::string& sym2) const;
-	bool	RefersSameNode(const std::string& sym1, const std::string& sym2) const;
+	bool	IsUsed(const InternString& sym) const;
+	bool	RefersSameSymbol(const InternString& sym1, const InternString& sym2) const;
+	bool	RefersSameNode(const InternString& sym1, const InternString& sym2) const;
+
+	///		Check if node can end up in sym. A node used by another symbol never can,
+	///		a symbol that already has other nodes only if a shortcut can bridge them
+	bool	CanInsert(const InternString& sym, const InternString& node, bool bridge) const;
+
+	///		Append a description of the symbol to node mapping that doesn't depend on the internal numbering,
+	///		tables mapping the symbols the same way append the same values
+	void	AppendState(std::vector<int>& out) const;
 
 	///		Utility function used by instruments to get the first used node name
 	///		or a spare node if none is defined
 	///		returns "NOSPARE" if no spares are available
-	std::string	GetFirstNodeOrSpare(const std::string& sym);
+	std::string	GetFirstNodeOrSpare(const InternString& sym);
 
 	typedef std::set<int>	tMarked;
-	void	Mark(tMarked& markdata, const std::string& sym);
-	bool	IsMarked(const tMarked& markdata, const std::string& sym) const;
+	void	Mark(tMarked& markdata, const InternString& sym);
+	bool	IsMarked(const tMarked& markdata, const InternString& sym) const;
 
 	void	Dump() const;
-	void	DumpSymbol(const std::string& sym);
-	
-	static void	ResetLookup();
+	void	DumpSymbol(const InternString& sym);
 private:
 	typedef char tNodeName;
 
 	// returns the index of the symbol if it exist
-	int GetIndexOf(const std::string& sym) const;
+	int GetIndexOf(const InternString& sym) const;
 
 	// Throws if invalid node name is found
-	void	ValidateNodeName(const std::string& node) const;
+	void	ValidateNodeName(const InternString& node) const;
 	
 	/// look if perticular node is used somewhere and return the index
 	int		FindNodeIdx(tNodeName node) const;
-	bool	MergeNodes(int dst, int src, const std::string& srcsym);
+	bool	MergeNodes(int dst, int src, const InternString& srcsym);
 	int		CreateNode();
 	int		CreateNode(tNodeName node);
 	int		AddNodeToIdx(int idx, tNodeName node);
@@ -119,27 +138,40 @@ private:
 	
 	void UpdateRef(int ref, int newref);
 	
-	int		LookupSymbol(const std::string& symbol) const;
-	int&	GetSymbolRef(const std::string& symbol);
-	
-	void	EraseSymbol(const std::string& symbol);
+	int		LookupSymbol(const InternString& symbol) const;
+	int		AddSymbol(const InternString& symbol);
+	void	Rehash(size_t size);
 
-	struct tSymbolName
-	{
-		char	_name[16];
-	};
+	void	SetSymbolIdx(const InternString& symbol, int idx);
+
+	// all writes to mSymbolToNodeIdx and mNodeToIdx go through these to be logged
+	void	SetSlot(size_t slot, int idx);
+	void	SetNode(size_t nodeid, int idx);
 	
-	void ToSymbolName(const std::string& symbol, tSymbolName& out);
+	void	EraseSymbol(const InternString& symbol);
+
+	// symbols are never removed, a symbol mapped to -1 is the same as a missing one
+	typedef std::vector<InternString>	tSymbols;
+	tSymbols	mSymbols;
 
-	typedef std::vector<tSymbolName>	tSymbolLookup;
-	static tSymbolLookup sSymbolLookup;
+	// open addressing on the intern id, holds indices into mSymbols or -1
+	typedef std::vector<int>	tSymbolHash;
+	tSymbolHash	mSymbolHash;
 	
 	typedef std::vector<int>	tSymbolToNodeIdx;
 	tSymbolToNodeIdx mSymbolToNodeIdx;
+
+	struct tUndo
+	{
+		int		slot;	// index in mSymbolToNodeIdx, or -1 - node id for mNodeToIdx
+		int		value;	// the value before the change
+	};
+	typedef std::vector<tUndo>	tUndoLog;
+	tUndoLog	mUndoLog;
 	
 	size_t		LookupNode(tNodeName node) const;
 	tNodeName	ReverseLookupNode(size_t i) const;
-	void		EraseNodeForSymbol(const std::string& sym);
+	void		EraseNodeForSymbol(const InternString& sym);
 	size_t		NodesUsedForIdx(int idx) const;
 	bool		IdxUsesNode(int idx, tNodeName node) const;
 	tNodeName	GetFirstNodeForIdx(int idx) const;
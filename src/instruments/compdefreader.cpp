@@ -30,8 +30,7 @@
 #include <instruments/netlist2.h>
 #include <instruments/listparser.h>
 
-#include <fstream>
-#include <stringop.h>
+#include <cctype>
 
 #define WHITESPACE " \t"
 
@@ -45,16 +44,16 @@ ComponentDefinitionReader::~ComponentDefinitionReader()
 
 bool ComponentDefinitionReader::ReadFile(const std::string& filename)
 {
-	std::fstream file(filename.c_str()); //abrimos el archivo
-	if (!file.is_open()) // ¿Es posible abrir el archivo?
+	std::string contents; // leemos el archivo entero y lo recorremos sin copiar las lineas
+	if (!ReadWholeFile(filename, contents)) // ¿Es posible abrir el archivo?
 	{
 		return false; // No, retornamos false
 	}
 
-	while(!file.eof()) // Mientras no lleguemos al final del archivo
+	LineCursor lines(contents);
+	StringView line;
+	while(lines.Next(line)) // Mientras no lleguemos al final del archivo
 	{
-		std::string line; // linea es de tipo string
-		getline(file, line); //leemos linea
 
 		if (IsComment(line)) continue; // es una linea de comentario?
 		else // si no es una linea de comentarios parseamos la linea
@@ -67,10 +66,10 @@ bool ComponentDefinitionReader::ReadFile(const std::string& filename)
 }
 
 // miramos si la linea es una linea de comentario
-bool ComponentDefinitionReader::IsComment(const std::string& line)
+bool ComponentDefinitionReader::IsComment(StringView line)
 {
 	size_t pos = line.find_first_not_of(WHITESPACE); // buscamos la posicion del primer caracter que no es espacio en blanco
-	if (pos != std::string::npos) // si la linea no esta entera en blanco, es decir lo anterior no retorno no existe posicion (npos)
+	if (pos != StringView::npos) // si la linea no esta entera en blanco, es decir lo anterior no retorno no existe posicion (npos)
 	{
 		if ((line[pos] == '#') || (line[pos] == '*')) return true; //si el primer caracter de la linea es # o * es una linea de comentario
 	}
@@ -79,15 +78,10 @@ bool ComponentDefinitionReader::IsComment(const std::string& line)
 	return false; // no es una linea de comentario
 }
 
-bool ComponentDefinitionReader::ParseLine(const std::string& inLine)
+bool ComponentDefinitionReader::ParseLine(StringView line)
 {
-	std::string line; // declaramos line de tipo string
-	size_t pos = inLine.find_first_of("#*"); // buscamos la posicion de la primera # o * , ¡¡ojo no se si funcionara o buscara # seguido de *
-	if (pos != std::string::npos) line = std::string(inLine, 0, pos); // si ha encontrado alguna es que en la linea hay comentarios, eliminamos esa parte de la linea
-	else line = inLine; // no hay comentarios en la linea, la guardamos sin recortar nada
-
-	typedef std::vector<std::string> tTokens; 
-	tTokens tokens; // creamos un vector para contener los token (palabras) que contiene la linea
+	size_t pos = line.find_first_of("#*"); // buscamos la posicion de la primera # o * , ¡¡ojo no se si funcionara o buscara # seguido de *
+	if (pos != StringView::npos) line = line.substr(0, pos); // si ha encontrado alguna es que en la linea hay comentarios, eliminamos esa parte de la linea
 
 	std::string type = "";
 	int numCons = 0;
@@ -95,20 +89,22 @@ bool ComponentDefinitionReader::ParseLine(const std::string& inLine)
 	bool ignoreValue = false;
 	bool canTurn = false;
 
-	Tokenize(line, tokens, WHITESPACE, true); //obtenermos los tokens(palabras) de la linea
-	for(size_t i=0;i<tokens.size(); i++) // recorremos el vector con los token obtenidos
+	TokenCursor tokens(line, WHITESPACE); //recorremos los tokens(palabras) de la linea
+	StringView token;
+	for(size_t i=0;tokens.Next(token); i++)
 	{
 		switch(i)
 		{
 		case 0:
-			type = ToUpper(tokens[0]); //convertimos a mayusculas y lo almacenamos en type
+			type = token.str(); //convertimos a mayusculas y lo almacenamos en type
+			for(size_t j=0;j<type.size(); j++) type[j] = (char)toupper((unsigned char)type[j]);
 			break;
 		case 1:
-			numCons = ToInt(tokens[1]); //convertimos a entero y lo guardamos como el numero de pines o conexiones
+			numCons = token.ToInt(); //convertimos a entero y lo guardamos como el numero de pines o conexiones
 			break;
 		case 2: // ahora leemos los flags
 			{
-				std::string flags = tokens[2];
+				StringView flags = token;
 				for(size_t j=0;j<flags.size(); j++)
 				{
 					switch(flags[j])
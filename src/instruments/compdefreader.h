@@ -29,6 +29,7 @@
 #define __COMPONENT_DEFINITION_READER_H__
 
 #include <instruments/listparser.h>
+#include <stringview.h>
 #include <string>
 
 class ComponentDefinitionReader
@@ -41,8 +42,8 @@ public:
 	ComponentDefinitionReader();
 	virtual ~ComponentDefinitionReader();
 private:
-	bool	IsComment(const std::string& line);
-	bool	ParseLine(const std::string& line);
+	bool	IsComment(StringView line);
+	bool	ParseLine(StringView line);
 
 	ListParser::tComponentDefinitions	mCompDefs;
 };
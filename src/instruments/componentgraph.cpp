@@ -0,0 +1,109 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "componentgraph.h"
+
+// a component connected twice to the same node is listed once for it
+static bool SeenBefore(const ListComponent::tConnections& cons, size_t i)
+{
+	for(size_t j = 0; j < i; j++)
+	{
+		if (cons[j] == cons[i]) return true;
+	}
+	return false;
+}
+
+size_t ComponentGraph::FindSlot(const InternString& node) const
+{
+	const size_t mask = mSlots.size() - 1;
+	size_t slot = node.Hash() & mask;
+	while (mSlots[slot] >= 0 && mNodes[mSlots[slot]] != node) slot = (slot + 1) & mask;
+	return slot;
+}
+
+void ComponentGraph::Rehash(size_t size)
+{
+	mSlots.assign(size, -1);
+	for(size_t i = 0, count = mNodes.size(); i < count; i++) mSlots[FindSlot(mNodes[i])] = (int)i;
+}
+
+void ComponentGraph::Reset()
+{
+	// the slots keep their size between builds
+	mSlots.assign(mSlots.size(), -1);
+
+	mNodes.clear();
+	mRows.clear();
+	mAdjacency.clear();
+}
+
+void ComponentGraph::Count(const ListComponent& component)
+{
+	const ListComponent::tConnections& cons = component.GetCConnections();
+	for(size_t i = 0, size = cons.size(); i < size; i++)
+	{
+		if (SeenBefore(cons, i)) continue;
+
+		// at most half full, the size stays a power of two
+		if ((mNodes.size() + 1) * 2 > mSlots.size()) Rehash(mSlots.empty() ? 64 : mSlots.size() * 2);
+
+		const InternString& node = cons[i];
+		int& index = mSlots[FindSlot(node)];
+		if (index < 0)
+		{
+			index = (int)mNodes.size();
+			mNodes.push_back(node);
+			mRows.push_back(0);
+		}
+		mRows[index]++;
+	}
+}
+
+void ComponentGraph::Layout()
+{
+	// counts to offsets
+	size_t offset = 0;
+	for(size_t i = 0, size = mRows.size(); i < size; i++)
+	{
+		const size_t count = mRows[i];
+		mRows[i] = offset;
+		offset += count;
+	}
+	mRows.push_back(offset);
+
+	mAdjacency.resize(offset);
+	mFill.assign(mRows.begin(), mRows.end() - 1);
+}
+
+void ComponentGraph::Place(size_t index, const ListComponent& component)
+{
+	const ListComponent::tConnections& cons = component.GetCConnections();
+	for(size_t i = 0, size = cons.size(); i < size; i++)
+	{
+		if (SeenBefore(cons, i)) continue;
+		mAdjacency[mFill[mSlots[FindSlot(cons[i])]]++] = index;
+	}
+}
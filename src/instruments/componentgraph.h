@@ -0,0 +1,95 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __COMPONENT_GRAPH_H__
+#define __COMPONENT_GRAPH_H__
+
+#include "listcomponent.h"
+
+#include <vector>
+
+/// Node to component adjacency of a component list, in compressed rows.
+/// Nodes are numbered densely in the order they are first seen so graph walks can use
+/// plain arrays indexed by node, building again reuses the memory of the last build.
+class ComponentGraph
+{
+public:
+	///		All components of the list
+	template<typename T>
+	void	Build(const T& components);
+
+	///		Only the listed components, the indices still refer to the whole list
+	template<typename T, typename I>
+	void	Build(const T& components, const I& subset);
+
+	size_t	NumNodes() const	{ return mNodes.size(); }
+
+	///		Dense index of the node, -1 if no component in the graph connects to it
+	int		NodeIndex(const InternString& node) const
+	{
+		return mSlots.empty() ? -1 : mSlots[FindSlot(node)];
+	}
+
+	const InternString&	Node(size_t node) const	{ return mNodes[node]; }
+
+	///		Components connected to the node, in list order and each once
+	const size_t*	RowBegin(size_t node) const	{ return &mAdjacency[0] + mRows[node]; }
+	const size_t*	RowEnd(size_t node) const	{ return &mAdjacency[0] + mRows[node + 1]; }
+private:
+	void	Reset();
+	void	Count(const ListComponent& component);
+	void	Layout();
+	void	Place(size_t index, const ListComponent& component);
+
+	size_t	FindSlot(const InternString& node) const;
+	void	Rehash(size_t size);
+
+	std::vector<InternString>	mNodes;
+	std::vector<int>			mSlots;		// open addressing from node name to node, -1 for free slots
+	std::vector<size_t>			mRows;		// first adjacency entry of each node, one extra at the end
+	std::vector<size_t>			mAdjacency;
+	std::vector<size_t>			mFill;
+};
+
+template<typename T>
+void ComponentGraph::Build(const T& components)
+{
+	Reset();
+	for(size_t i = 0, size = components.size(); i < size; i++) Count(components[i]);
+	Layout();
+	for(size_t i = 0, size = components.size(); i < size; i++) Place(i, components[i]);
+}
+
+template<typename T, typename I>
+void ComponentGraph::Build(const T& components, const I& subset)
+{
+	Reset();
+	for(size_t i = 0, size = subset.size(); i < size; i++) Count(components[subset[i]]);
+	Layout();
+	for(size_t i = 0, size = subset.size(); i < size; i++) Place(subset[i], components[subset[i]]);
+}
+
+#endif
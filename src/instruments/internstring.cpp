@@ -0,0 +1,148 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "internstring.h"
+
+#include <basic_exception.h>
+#include <util/atomic.h>
+
+#include <ostream>
+
+const InternTable::tId InternTable::eNotInterned;
+
+InternTable& InternTable::Instance()
+{
+	// created on first use, the first strings are interned during static initialization
+	static InternTable sTable;
+	return sTable;
+}
+
+InternTable::InternTable()
+{
+	for(size_t i = 0; i < eMaxChunks; i++) mChunks[i] = NULL;
+	mSize = 0;
+	mpIndex = NULL;
+	Grow();
+	Intern(""); // id 0 is the empty string, the same as a default constructed InternString
+}
+
+InternTable::~InternTable()
+{
+	for(size_t i = 0; i < eMaxChunks; i++) delete [] mChunks[i];
+	for(std::list<Index*>::iterator it = mIndices.begin(); it != mIndices.end(); it++)
+	{
+		delete [] (*it)->slots;
+		delete *it;
+	}
+}
+
+size_t InternTable::HashText(const std::string& str)
+{
+	// FNV-1a
+	size_t hash = 2166136261u;
+	for(size_t i = 0; i < str.size(); i++)
+	{
+		hash ^= (unsigned char)str[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+InternTable::tId InternTable::Find(const std::string& str) const
+{
+	// entries are stored before the slot pointing at them is published, see Intern
+	Index* pIndex = AtomicLoadPtr(const_cast<Index* volatile*>(&mpIndex));
+	size_t hash = HashText(str);
+	for(size_t slot = hash & pIndex->mask; ; slot = (slot + 1) & pIndex->mask)
+	{
+		int value = AtomicLoad(&pIndex->slots[slot]);
+		if (value == 0) return eNotInterned;
+		const Entry& entry = Get((tId)(value - 1));
+		if (entry.hash == hash && entry.text == str) return (tId)(value - 1);
+	}
+}
+
+InternTable::tId InternTable::Intern(const std::string& str)
+{
+	tId found = Find(str);
+	if (found != eNotInterned) return found;
+
+	ScopedLock lock(mMutex);
+
+	found = Find(str);
+	if (found != eNotInterned) return found;
+
+	size_t chunk = mSize >> eChunkBits;
+	if (chunk >= eMaxChunks) throw BasicException("String intern table is full");
+	if (!mChunks[chunk]) mChunks[chunk] = new Entry[eChunkSize];
+
+	tId id = (tId)mSize;
+	Entry& entry = mChunks[chunk][id & (eChunkSize - 1)];
+	entry.text = str;
+	entry.hash = HashText(str);
+	mSize++;
+
+	// keep the index at most half full
+	if (mSize * 2 > mpIndex->mask + 1) Grow();
+
+	Index* pIndex = mpIndex;
+	size_t slot = entry.hash & pIndex->mask;
+	while (pIndex->slots[slot] != 0) slot = (slot + 1) & pIndex->mask;
+	AtomicStore(&pIndex->slots[slot], (int)id + 1);
+	return id;
+}
+
+void InternTable::Grow()
+{
+	size_t size = mpIndex ? (mpIndex->mask + 1) * 2 : 256;
+	Index* pIndex = new Index;
+	pIndex->mask = size - 1;
+	pIndex->slots = new int[size];
+	for(size_t i = 0; i < size; i++) pIndex->slots[i] = 0;
+
+	// the entry being added is not in the old index and is placed by the caller
+	for(size_t id = 0; mpIndex && id + 1 < mSize; id++)
+	{
+		size_t slot = Get((tId)id).hash & pIndex->mask;
+		while (pIndex->slots[slot] != 0) slot = (slot + 1) & pIndex->mask;
+		pIndex->slots[slot] = (int)id + 1;
+	}
+
+	mIndices.push_back(pIndex);
+	AtomicStorePtr(&mpIndex, pIndex);
+}
+
+size_t InternTable::Size() const
+{
+	ScopedLock lock(mMutex);
+	return mSize;
+}
+
+std::ostream& operator<<(std::ostream& os, const InternString& str)
+{
+	return os << str.str();
+}
@@ -0,0 +1,150 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __INTERN_STRING_H__
+#define __INTERN_STRING_H__
+
+#include <util/thread.h>
+
+#include <iosfwd>
+#include <list>
+#include <string>
+
+/// Process wide table giving the strings of the vocabulary a small integer id.
+/// The vocabulary is what the configuration can name: the maxlists, the component
+/// definitions and the names used by the code, so the table stays bounded.
+/// Strings are never removed. Finding a string never locks, adding one does.
+class InternTable
+{
+public:
+	typedef unsigned int tId;
+
+	/// Id of strings that are not in the table
+	static const tId	eNotInterned = 0xffffffffu;
+
+	static InternTable&	Instance();
+
+	///					Returns the id of the string, adding it if needed. Only for the vocabulary
+	tId					Intern(const std::string& str);
+
+	///					Returns the id of the string or eNotInterned, never adds
+	tId					Find(const std::string& str) const;
+
+	///					The returned reference stays valid for the lifetime of the process
+	const std::string&	Lookup(tId id) const	{ return Get(id).text; }
+	size_t				Hash(tId id) const		{ return Get(id).hash; }
+
+	size_t				Size() const;
+
+	static size_t		HashText(const std::string& str);
+private:
+	InternTable();
+	~InternTable();
+	InternTable(const InternTable&);
+	InternTable& operator=(const InternTable&);
+
+	enum
+	{
+		eChunkBits	= 10,
+		eChunkSize	= 1 << eChunkBits,
+		eMaxChunks	= 4096
+	};
+
+	struct Entry
+	{
+		std::string	text;
+		size_t		hash;
+	};
+
+	/// Open addressing from string hash to id + 1, 0 is a free slot.
+	/// Replaced as a whole when it grows, readers may still be in an old one
+	struct Index
+	{
+		size_t			mask;
+		volatile int*	slots;
+	};
+
+	const Entry&	Get(tId id) const { return mChunks[id >> eChunkBits][id & (eChunkSize - 1)]; }
+	void			Grow();
+
+	// strings are stored in fixed chunks so lookups never see a reallocation
+	Entry*			mChunks[eMaxChunks];
+	size_t			mSize;
+
+	Index* volatile	mpIndex;
+	std::list<Index*>	mIndices;	// all indices ever published, freed with the table
+	mutable Mutex	mMutex;			// taken by Intern only
+};
+
+/// Interned string, comparing two of them is an integer compare and copying never allocates.
+/// Strings outside the vocabulary, like the names and values of a client circuit, are kept
+/// as plain text instead, they compare by text and copying them may allocate.
+/// The ordering is by id with the text strings after all interned ones, it is not alphabetical.
+/// The vocabulary should be added before the strings that are compared to it are made,
+/// a text string only compares equal to an interned one with the same text.
+class InternString
+{
+public:
+	InternString() : mId(0) {}
+	explicit InternString(const std::string& str) : mId(InternTable::Instance().Find(str))	{ if (mId == InternTable::eNotInterned) mText = str; }
+	explicit InternString(const char* str) : mId(InternTable::Instance().Find(str))		{ if (mId == InternTable::eNotInterned) mText = str; }
+
+	/// Adds the string to the vocabulary, for lists read from the configuration and constants
+	static InternString	Vocabulary(const std::string& str)	{ return InternString(InternTable::Instance().Intern(str)); }
+
+	const std::string&	str() const	{ return IsInterned() ? InternTable::Instance().Lookup(mId) : mText; }
+	operator const std::string&() const { return str(); }
+
+	bool				IsInterned() const	{ return mId != InternTable::eNotInterned; }
+	/// eNotInterned for text strings
+	InternTable::tId	Id() const			{ return mId; }
+	bool				empty() const		{ return mId == 0; }
+
+	/// Hash of the text, the same for an interned and a text string of the same text
+	size_t				Hash() const	{ return IsInterned() ? InternTable::Instance().Hash(mId) : InternTable::HashText(mText); }
+
+	bool operator==(const InternString& other) const
+	{
+		if (IsInterned() && other.IsInterned()) return mId == other.mId;
+		return str() == other.str();
+	}
+	bool operator!=(const InternString& other) const	{ return !(*this == other); }
+	bool operator<(const InternString& other) const
+	{
+		if (mId != other.mId) return mId < other.mId;
+		return !IsInterned() && mText < other.mText;
+	}
+private:
+	explicit InternString(InternTable::tId id) : mId(id) {}
+
+	InternTable::tId	mId;
+	std::string			mText;
+};
+
+std::ostream& operator<<(std::ostream& os, const InternString& str);
+
+#endif
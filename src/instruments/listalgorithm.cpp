@@ -144,9 +144,10 @@ void ListAlgorithm::Replace(const ListComponent& comp, const tComponentList& lis
 
 void ListAlgorithm::ReplaceNamed(const std::string& name, tComponentList& list, const ListComponent& comp)
 {
+	const InternString nameId(name);
 	for(tComponentList::iterator it = list.begin(); it != list.end(); it++)
 	{
-		if (name == it->GetName())
+		if (nameId == it->GetNameId())
 		{
 			*it = comp;
 		}
@@ -155,10 +156,11 @@ void ListAlgorithm::ReplaceNamed(const std::string& name, tComponentList& list,
 
 void ListAlgorithm::ReplaceTypeWithList(const std::string& name, tComponentList& list, const tComponentList& replace)
 {
+	const InternString type(name);
 	tComponentList out;
 	for(tComponentList::const_iterator it = list.begin(); it != list.end(); it++)
 	{
-		if (it->GetType() == name)
+		if (it->GetTypeId() == type)
 		{
 			for(tComponentList::const_iterator repit = replace.begin(); repit != replace.end(); repit++)
 			{
@@ -176,20 +178,23 @@ void ListAlgorithm::ReplaceTypeWithList(const std::string& name, tComponentList&
 
 void ListAlgorithm::ReplaceType(const std::string& type, tComponentList& list, std::string newtype)
 {
+	const InternString typeId(type);
+	const InternString newTypeId(newtype);
 	for(tComponentList::iterator it = list.begin(); it != list.end(); it++)
 	{
-		if (type == it->GetType())
+		if (typeId == it->GetTypeId())
 		{			
-			it->SetType(newtype);
+			it->SetType(newTypeId);
 		}
 	}
 }
 
 void ListAlgorithm::PushNodesOfType(const std::string& type, const tComponentList& list, tComponentList& out)
 {
+	const InternString typeId(type);
 	for(tComponentList::const_iterator it = list.begin(); it != list.end(); it++)
 	{
-		if (type == it->GetType())
+		if (typeId == it->GetTypeId())
 		{
 			out.push_back(*it);
 		}
@@ -198,10 +203,11 @@ void ListAlgorithm::PushNodesOfType(const std::string& type, const tComponentLis
 
 void ListAlgorithm::RemoveOfType(const std::string& type, tComponentList& out)
 {
+	const InternString typeId(type);
 	tComponentList temp;
 	for(tComponentList::const_iterator it = out.begin(); it != out.end(); it++)
 	{
-		if (type != it->GetType()) temp.push_back(*it);
+		if (typeId != it->GetTypeId()) temp.push_back(*it);
 	}
 
 	out = temp;
@@ -27,34 +27,62 @@
 
 #include "listcomponent.h"
 
-ListComponent::ListComponent() {}
+#include <basic_exception.h>
+
+#include <algorithm>
+
+void ConnectionList::push_back(const InternString& con)
+{
+	if (mSize >= eMaxConnections) throw BasicException("Too many connections on component");
+	mConnections[mSize++] = con;
+}
+
+bool ConnectionList::operator==(const ConnectionList& other) const
+{
+	if (mSize != other.mSize) return false;
+	for(size_t i = 0; i < mSize; i++)
+	{
+		if (mConnections[i] != other.mConnections[i]) return false;
+	}
+	return true;
+}
+
+/// Alphabetical order, InternString compares by id
+static bool ConnectionNameLess(const InternString& c1, const InternString& c2)
+{
+	return c1.str() < c2.str();
+}
+
+ListComponent::ListComponent()
+{
+	mGroupID = 0;
+}
+
 ListComponent::~ListComponent() {}
 
 ListComponent::ListComponent(std::string type, std::string name)
 {
-	mType	= type;
-	mName	= name;
+	mType	= InternString(type);
+	mName	= InternString(name);
 	mGroupID = 0;
 }
 
 
 ListComponent::ListComponent(std::string type, std::string name, std::string con1)
 {
-	mType	= type;
-	mName	= name;
-	mGroupID = 0;
-	mConnections.push_back(con1);
+	mType	= InternString(type);
+	mName	= InternString(name);
 	mGroupID = 0;
+	mConnections.push_back(InternString(con1));
 }
 
 ListComponent::ListComponent(std::string type, std::string name, std::string con1, std::string con2)
 {
-	mType	= type;
-	mName	= name;
-	mGroupID = 0;
-	mConnections.push_back(con1);
-	mConnections.push_back(con2);
+	mType	= InternString(type);
+	mName	= InternString(name);
 	mGroupID = 0;
+	mConnections.push_back(InternString(con1));
+	mConnections.push_back(InternString(con2));
 }
 
 bool ListComponent::Equals(const ListComponent& other) const
@@ -81,35 +109,42 @@ bool ListComponent::operator==(const ListComponent& other) const
 bool ListComponent::operator<(const ListComponent& other) const
 {
 	// sorting is done by combining the type and name of component..
-	std::string c1 = mType + mName + mValue;
-	std::string c2 = other.mType + other.mName + other.mValue;
+	std::string c1 = mType.str() + mName.str() + mValue.str();
+	std::string c2 = other.mType.str() + other.mName.str() + other.mValue.str();
 	if (c1 < c2) return true;
 	else if (c2 < c1) return false;
 
 	// else both are the same.. compare connections
-	return mConnections < other.mConnections;
+	return std::lexicographical_compare(mConnections.begin(), mConnections.end(), other.mConnections.begin(), other.mConnections.end(), ConnectionNameLess);
 }
 
+static const InternString sTurnableTypes[] = {
+	InternString::Vocabulary("R"),
+	InternString::Vocabulary("L"),
+	InternString::Vocabulary("C"),
+	InternString::Vocabulary("SHORTCUT"),
+	InternString::Vocabulary("XSWITCHOPEN"),
+	InternString::Vocabulary("XSWITCHCLOSE"),
+	InternString::Vocabulary("IPROBE")
+};
+
 // XXX: this info should come from the definition and not be hard coded
 bool ListComponent::CanTurn() const
 {
-	if (	mType == "R" 
-		||	mType == "L"
-		||	mType == "C"
-		||	mType == "SHORTCUT"
-		||	mType == "XSWITCHOPEN"
-		||	mType == "XSWITCHCLOSE"
-		||	mType == "IPROBE") return true;
+	for(size_t i = 0; i < sizeof(sTurnableTypes) / sizeof(sTurnableTypes[0]); i++)
+	{
+		if (mType == sTurnableTypes[i]) return true;
+	}
 	return false;
 }
 
 std::string ListComponent::Dump() const
 {
 	std::string out = "Component: ";
-	out += "'" + mType + "' '" + mName + "' '" + mValue + "'";
+	out += "'" + mType.str() + "' '" + mName.str() + "' '" + mValue.str() + "'";
 	for(tConnections::const_iterator it = mConnections.begin(); it != mConnections.end(); ++it)
 	{
-		out += " " + *it;
+		out += " " + it->str();
 	}
 
 	return out;
@@ -117,14 +152,15 @@ std::string ListComponent::Dump() const
 
 std::string ListComponent::GetSpecialToken(const std::string& name) const
 {
-	size_t start = mSpecial.find(name);
-	if (start == std::string::npos || (start + name.length()) >= mSpecial.length() ) return "";
-    size_t end = mSpecial.find_first_of(" ", start);
+	const std::string& special = mSpecial.str();
+	size_t start = special.find(name);
+	if (start == std::string::npos || (start + name.length()) >= special.length() ) return "";
+    size_t end = special.find_first_of(" ", start);
 	size_t len = 0;
 	if (end == std::string::npos)
-		len = mSpecial.length() - start - name.length();
+		len = special.length() - start - name.length();
 	else
 		len = end - start - name.length();
 	if (len <= 0) return "";
-	return std::string(mSpecial, start + name.length(), len);
+	return std::string(special, start + name.length(), len);
 }
\ No newline at end of file
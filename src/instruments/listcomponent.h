@@ -28,16 +28,49 @@
 #ifndef __LIST_COMPONENT_H__
 #define __LIST_COMPONENT_H__
 
+#include "internstring.h"
+
 #include <vector>
 #include <string>
 
+/// Connection names of a component, stored inline
+class ConnectionList
+{
+public:
+	/// the op-amp has the most connections
+	enum { eMaxConnections = 8 };
+
+	typedef InternString			value_type;
+	typedef const InternString*		const_iterator;
+
+	size_t			size() const	{ return mSize; }
+	bool			empty() const	{ return mSize == 0; }
+
+	const InternString&	operator[](size_t i) const	{ return mConnections[i]; }
+	const InternString&	front() const				{ return mConnections[0]; }
+	const_iterator	begin() const	{ return mConnections; }
+	const_iterator	end() const		{ return mConnections + mSize; }
+
+	///				Throws if the list is full
+	void			push_back(const InternString& con);
+
+	bool			operator==(const ConnectionList& other) const;
+	bool			operator!=(const ConnectionList& other) const { return !(*this == other); }
+
+	ConnectionList() : mSize(0) {}
+private:
+	InternString	mConnections[eMaxConnections];
+	size_t			mSize;
+};
+
 /// General list component/entry/node.
+/// The strings are InternStrings, components of the vocabulary compare ids and copy without allocating.
 class ListComponent
 {	
 public:
 	/// utility definition for vectors of components
 	typedef std::vector<ListComponent>	tComponentList;
-	typedef std::vector<std::string>	tConnections;
+	typedef ConnectionList				tConnections;
 
 	ListComponent();
 	~ListComponent();
@@ -59,16 +92,26 @@ public:
 	bool CanTurn() const;
 
 	inline const tConnections&	GetCConnections() const		{ return mConnections; }
-	inline const std::string&	GetName() const				{ return mName; }
-	inline const std::string&	GetType() const				{ return mType; }
-	inline const std::string&	GetValue() const			{ return mValue; }
-	inline const std::string&	GetSpecial() const			{ return mSpecial; }
-
-	void	AddConnection(std::string con)	{ mConnections.push_back(con);	}
-	void	SetValue(std::string value)		{ mValue = value;		}
-	void	SetType(std::string newtype)	{ mType = newtype;		}
-	void	SetSpecial(std::string special)	{ mSpecial = special;	}
-	void	SetName(std::string name)		{ mName = name;	}
+	inline const std::string&	GetName() const				{ return mName.str(); }
+	inline const std::string&	GetType() const				{ return mType.str(); }
+	inline const std::string&	GetValue() const			{ return mValue.str(); }
+	inline const std::string&	GetSpecial() const			{ return mSpecial.str(); }
+
+	inline const InternString&	GetNameId() const			{ return mName; }
+	inline const InternString&	GetTypeId() const			{ return mType; }
+	inline const InternString&	GetValueId() const			{ return mValue; }
+	inline const InternString&	GetSpecialId() const		{ return mSpecial; }
+
+	void	AddConnection(const std::string& con)	{ mConnections.push_back(InternString(con));	}
+	void	AddConnection(const InternString& con)	{ mConnections.push_back(con);	}
+	void	SetValue(const std::string& value)		{ mValue = InternString(value);		}
+	void	SetValue(const InternString& value)		{ mValue = value;		}
+	void	SetType(const std::string& newtype)		{ mType = InternString(newtype);	}
+	void	SetType(const InternString& newtype)	{ mType = newtype;		}
+	void	SetSpecial(const std::string& special)	{ mSpecial = InternString(special);	}
+	void	SetSpecial(const InternString& special)	{ mSpecial = special;	}
+	void	SetName(const std::string& name)		{ mName = InternString(name);	}
+	void	SetName(const InternString& name)		{ mName = name;	}
 	
 	bool	IsInGroup() const { return mGroupID != 0; }
 	size_t	GetGroup() const { return mGroupID; }
@@ -78,10 +121,10 @@ public:
 	std::string GetSpecialToken(const std::string& name) const;
 
 private:
-	std::string		mType;
-	std::string		mName;
-	std::string		mValue;
-	std::string		mSpecial;
+	InternString	mType;
+	InternString	mName;
+	InternString	mValue;
+	InternString	mSpecial;
 	tConnections	mConnections;
 	size_t			mGroupID;
 };
@@ -28,52 +28,53 @@
 #include "listparser.h"
 #include <basic_exception.h>
 
-#include <stringop.h>
-#include <fstream>
+#include <cctype>
 
 #define WHITESPACE " \t"
 
-ListParser::ListParser(const tComponentDefinitions& definitions)
+ListParser::ListParser(const tComponentDefinitions& definitions, bool vocabulary)
 {
+	mVocabulary = vocabulary;
 	for(tComponentDefinitions::const_iterator it = definitions.begin(); it != definitions.end(); it++)
 	{
 		mCompDefMap[it->Type()] = *it;
+		InternString::Vocabulary(it->Type());
 	}
 }
 
-bool ListParser::IsComment(const std::string& instring)
+bool ListParser::IsComment(StringView line)
 {
-	if (instring.empty())		return true;
+	if (line.empty())		return true;
 
-	size_t pos = instring.find_first_not_of(WHITESPACE);
-	if (pos != std::string::npos)
+	size_t pos = line.find_first_not_of(WHITESPACE);
+	if (pos != StringView::npos)
 	{
-		if ((instring[pos] == '#') || (instring[pos] == '*')) return true;
+		if ((line[pos] == '#') || (line[pos] == '*')) return true;
 	}
 	else return true; // only whitespace on line
 
 	return false;
 }
 
-bool ListParser::Parse(std::string aList)
+bool ListParser::Parse(const std::string& aList)
 {
 	//mComponentList se define en el .h como ListComponent::tComponentList
 	mComponentList.clear(); // nuke all old nodes
 
-	std::string line; // declaramos line como tipo string
-	while(GetLine(aList, line)) // cogemos una linea y la almacenamos en line
+	LineCursor lines(aList);
+	StringView line;
+	while(lines.Next(line)) // cogemos una linea sin copiarla
 	{
 		size_t pos = line.find_first_of("*#"); //buscamos la posicion de * o #
-		if (pos != std::string::npos) line = std::string(line, 0, pos); // hay comentarios, los eliminamos
+		if (pos != StringView::npos) line = line.substr(0, pos); // hay comentarios, los eliminamos
 
-		//line = Token(line,0,"*");	// remove everything after the first '*', which is the comment separator		
-		//line = CleanWhitespaces(line);		
-		//line = ToUpper(line);		// make uppercase.. easier parsing..
-		
 		if (IsComment(line)) continue; // si es una linea de comentario, continuamos con la siguiente
-		line = ToUpper(line); // Convertimos a mayusculas la linea
 
-		ListComponent* pComp = CreateComponent(line); //
+		// Convertimos a mayusculas la linea, en un buffer que se reutiliza
+		mLine.assign(line.data(), line.size());
+		for(size_t i = 0; i < mLine.size(); i++) mLine[i] = (char)toupper((unsigned char)mLine[i]);
+
+		ListComponent* pComp = CreateComponent(mLine);
 		if (!pComp)
 		{
 			delete pComp;
@@ -88,44 +89,56 @@ bool ListParser::Parse(std::string aList)
 	return true;
 }
 
-ListComponent* ListParser::CreateComponent(const std::string& instring)
+ListComponent* ListParser::CreateComponent(StringView line)
 {
-	std::string type_name = Token(instring, 0); // obtenermos la primera palabra de la linea que es el tipo_nombre
-	std::string restofstring = RemoveToken(instring, 0); //le eliminamos la primera palabra y guardamos el resultado en restofstring
+	TokenCursor tokens(line, WHITESPACE);
+
+	StringView type_name; // obtenermos la primera palabra de la linea que es el tipo_nombre
+	tokens.Next(type_name);
+	if (line.find_first_of(WHITESPACE) == 0) type_name = StringView(); // a line starting with whitespace has no type
+
+	StringView type = type_name.substr(0, type_name.find('_')); // buscamos el tipo, hasta el primer _
+
+	// el nombre es lo que queda despues del primer grupo de _
+	StringView name;
+	TokenCursor nameTokens(type_name, "_");
+	StringView typePart;
+	if (nameTokens.Next(typePart)) name = nameTokens.Rest();
 
-	std::string type = Token(type_name, 0, "\t _"); // buscamos el tipo, separando por \t o _ el primero que encuentre
-	std::string name = RemoveToken(type_name, 0, "_"); // eliminamos la primera parte y nos quedamos el resto en name
-	
 	size_t groupID = 0;
-	size_t atPos = name.find_first_of("@"); //buscamos la @ en el nombre
-	if (atPos != std::string::npos) { //¿existe posicion con @ en el nombre? si existe entra
-		groupID = atoi(std::string(name, atPos+1).c_str()); //atoid convierte a entero 
-		name = std::string(name, 0, atPos);
+	size_t atPos = name.find('@'); //buscamos la @ en el nombre
+	if (atPos != StringView::npos) { //¿existe posicion con @ en el nombre? si existe entra
+		groupID = name.substr(atPos+1).ToInt(); //convierte a entero como atoi
+		name = name.substr(0, atPos);
 		if (groupID > 20) throw BasicException("unexpected group id in maxlist"); //lanzamos una exception para la que hemos personalizado el what
 	}
 
-	const ComponentTypeDefinition* pType = GetTypeDefinition(type); 
+	const ComponentTypeDefinition* pType = GetTypeDefinition(Scratch(type));
 	if (!pType)
 		return NULL;
 
-	ListComponent* pComponent = new ListComponent(type, name);
+	ListComponent* pComponent = new ListComponent();
+	pComponent->SetType(InternString::Vocabulary(pType->Type()));
+	pComponent->SetName(Intern(name));
 	// read connections
 	for(int i=0;i<pType->NumConnections();i++)
 	{
-		std::string con = Token(restofstring, 0);
-		if (con == "")
+		StringView con;
+		if (!tokens.Next(con))
+		{
+			delete pComponent;
 			return NULL; // fail
-		restofstring = RemoveToken(restofstring, 0); // cut away the parsed bit
-		pComponent->AddConnection(con);
+		}
+		pComponent->AddConnection(Intern(con));
 	}
 
 	if (!pType->IgnoreValue()) {
-		std::string value = Token(restofstring, 0);
-		pComponent->SetValue(value);
-		restofstring = RemoveToken(restofstring, 0);
+		StringView value;
+		tokens.Next(value);
+		pComponent->SetValue(Intern(value));
 	}
 
-	if (pType->HasSpecialValue()) pComponent->SetSpecial(restofstring);
+	if (pType->HasSpecialValue()) pComponent->SetSpecial(Intern(tokens.Rest()));
 	pComponent->SetGroup(groupID);
 
 	return pComponent;
@@ -138,22 +151,25 @@ const ListComponent::tComponentList& ListParser::GetList() const
 
 bool ListParser::ParseFile(const std::string& filename) //parseamos archivo
 {
-	std::fstream file(filename.c_str()); //abrimos el archivo
-	if (!file.is_open()) //¿ha podido abrir el archivo?
+	std::string buffer; // leemos el archivo entero de una vez, Parse separa las lineas
+	if (!ReadWholeFile(filename, buffer)) //¿ha podido abrir el archivo?
 	{
 		return false; //no, retornamos false
 	}
 
-	std::string buffer; // buffer declarado como string
+	return Parse(buffer); //retonamos buffer parseado
+}
 
-	while(!file.eof()) // leemos el archivo linea a linea hasta el final
-	{
-		std::string str; 
-		getline(file, str); // leemos linea y la almacenamos en str
-		buffer += str + "\n"; // la alamcenamos en buffer con un retorno de linea al final
-	}
+InternString ListParser::Intern(StringView text)
+{
+	const std::string& str = Scratch(text);
+	return mVocabulary ? InternString::Vocabulary(str) : InternString(str);
+}
 
-	return Parse(buffer); //retonamos buffer parseado
+const std::string& ListParser::Scratch(StringView text)
+{
+	mScratch.assign(text.data(), text.size());
+	return mScratch;
 }
 
 const ComponentTypeDefinition* ListParser::GetTypeDefinition(const std::string& type) const
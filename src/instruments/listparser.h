@@ -29,6 +29,7 @@
 #define __LIST_PARSER_H__
 
 #include "listcomponent.h"
+#include <stringview.h>
 
 #include <string>
 #include <list>
@@ -53,6 +54,7 @@ public:
 	}
 	const std::string& Type() const		{ return mType; }
 	const int	NumConnections() const	{ return mNumCons; }
+	const bool	CanTurn() const			{ return mCanTurn; }
 	const bool	IgnoreValue() const		{ return mIgnoreValue; }
 	const bool	HasSpecialValue() const	{ return mHasSpecialValue; }
 private:
@@ -71,18 +73,31 @@ public:
 	
 	/// Parses a netlist and stores it in a nodelist.
 	/// returns false if Parser fails.
-	bool	Parse(std::string aList);
+	/// The text is walked in place, the only allocations are the components themselves.
+	bool	Parse(const std::string& aList);
 	bool	ParseFile(const std::string& filename);
 	const ListComponent::tComponentList&	GetList() const;
 
-	ListParser(const tComponentDefinitions& definitions);
+	/// The component types are always interned. With vocabulary set the names, connections
+	/// and values are interned too, only for lists from the configuration like the maxlists.
+	/// Lists sent by clients keep theirs as text so they can't fill the intern table.
+	ListParser(const tComponentDefinitions& definitions, bool vocabulary = false);
 private:
 	/// Create a component from a given list line
-	ListComponent*	CreateComponent(const std::string& instring);
-	bool			IsComment(const std::string& instring);
+	ListComponent*	CreateComponent(StringView line);
+	bool			IsComment(StringView line);
+
+	/// Copies the view into the reused scratch string
+	const std::string&	Scratch(StringView text);
+	/// The view as a string of the list, see the constructor
+	InternString		Intern(StringView text);
 
 	ListComponent::tComponentList	mComponentList;
 
+	std::string			mLine;		///< current line in upper case, reused between lines
+	std::string			mScratch;
+	bool				mVocabulary;
+
 	typedef std::map<std::string,ComponentTypeDefinition> tCompDefMap;
 	tCompDefMap			mCompDefMap;
 
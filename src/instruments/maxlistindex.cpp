@@ -0,0 +1,83 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "maxlistindex.h"
+#include "netlist2.h"
+
+#include <set>
+
+static const InternString sShortcut = InternString::Vocabulary(NamedNodes::Shortcut);
+static const InternString sIProbe = InternString::Vocabulary(NamedNodes::DmmIProbe);
+
+MaxListIndex::MaxListIndex()
+{
+	mShortcuts = 0;
+}
+
+void MaxListIndex::Build(const ListComponent::tComponentList& maxlist)
+{
+	mCapacity.clear();
+	mShortcuts = 0;
+
+	// only one component of a group can be used
+	std::set< std::pair<tKey, size_t> > groups;
+
+	for(ListComponent::tComponentList::const_iterator it = maxlist.begin(); it != maxlist.end(); ++it)
+	{
+		const tKey key(it->GetTypeId(), it->GetValueId());
+		if (it->IsInGroup() && !groups.insert(std::make_pair(key, it->GetGroup())).second) continue;
+
+		mCapacity[key]++;
+		if (key.first == sShortcut) mShortcuts++;
+	}
+}
+
+void MaxListIndex::Count(const std::vector<ListComponent>& components, tCounts& out)
+{
+	out.clear();
+	for(std::vector<ListComponent>::const_iterator it = components.begin(); it != components.end(); ++it)
+	{
+		out[tKey(it->GetTypeId(), it->GetValueId())]++;
+	}
+}
+
+bool MaxListIndex::CanContain(const tCounts& needed) const
+{
+	for(tCounts::const_iterator it = needed.begin(); it != needed.end(); ++it)
+	{
+		size_t capacity = Capacity(it->first);
+		if (it->first.first == sIProbe) capacity += mShortcuts;
+		if (it->second > capacity) return false;
+	}
+	return true;
+}
+
+size_t MaxListIndex::Capacity(const tKey& key) const
+{
+	tCounts::const_iterator finder = mCapacity.find(key);
+	return finder == mCapacity.end() ? 0 : finder->second;
+}
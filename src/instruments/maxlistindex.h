@@ -0,0 +1,63 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __MAXLIST_INDEX_H__
+#define __MAXLIST_INDEX_H__
+
+#include "listcomponent.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+/// How many components of each type and value a maxlist has, built when the list is read.
+/// Every component the solver places takes a candidate of its own, so a circuit that
+/// needs more of some component than a list has can't be solved on that list.
+class MaxListIndex
+{
+public:
+	typedef std::pair<InternString, InternString>	tKey;	///< type and value
+	typedef std::map<tKey, size_t>					tCounts;
+
+	void	Build(const ListComponent::tComponentList& maxlist);
+
+	///		Count components by type and value, see CircuitSolver3::GetPlacedComponents
+	static void	Count(const std::vector<ListComponent>& components, tCounts& out);
+
+	///		False if the list has too few candidates for some of the counted components
+	bool	CanContain(const tCounts& needed) const;
+
+	///		Candidates for a type and value, a group counts once
+	size_t	Capacity(const tKey& key) const;
+
+	MaxListIndex();
+private:
+	tCounts	mCapacity;
+	size_t	mShortcuts;		// current probes can be placed on any shortcut
+};
+
+#endif
@@ -0,0 +1,71 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "solverbudget.h"
+
+#include <util/atomic.h>
+
+void SolverStats::Add(const SolverStats& other)
+{
+	nodes				+= other.nodes;
+	backtracks			+= other.backtracks;
+	shortcutSearches	+= other.shortcutSearches;
+	seconds				+= other.seconds;
+	if (other.aborted) aborted = true;
+}
+
+SolverBudget::SolverBudget(size_t maxNodes, double maxSeconds)
+{
+	Reset(maxNodes, maxSeconds);
+}
+
+void SolverBudget::Reset(size_t maxNodes, double maxSeconds)
+{
+	mMaxChunks	= (maxNodes + cChunk - 1) / cChunk;
+	mMaxSeconds	= maxSeconds;
+	mChunks		= 0;
+	mExhausted	= 0;
+	mTimer.restart();
+}
+
+bool SolverBudget::Spend()
+{
+	if (AtomicLoad(&mExhausted)) return false;
+
+	const size_t chunks = (size_t)AtomicIncrement(&mChunks);
+	if ((mMaxChunks > 0 && chunks > mMaxChunks) || (mMaxSeconds > 0 && mTimer.elapsed() > mMaxSeconds))
+	{
+		AtomicStore(&mExhausted, 1);
+		return false;
+	}
+	return true;
+}
+
+bool SolverBudget::IsExhausted() const
+{
+	return AtomicLoad(const_cast<volatile int*>(&mExhausted)) != 0;
+}
@@ -0,0 +1,76 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __SOLVER_BUDGET_H__
+#define __SOLVER_BUDGET_H__
+
+#include <util/timer.h>
+
+#include <stddef.h>
+
+/// What a circuit search did, filled in by the solver
+struct SolverStats
+{
+	size_t	nodes;				///< steps into the recursive search
+	size_t	backtracks;			///< inserted candidates that had to be undone
+	size_t	shortcutSearches;
+	double	seconds;
+	bool	aborted;			///< stopped because the budget ran out
+
+	SolverStats() : nodes(0), backtracks(0), shortcutSearches(0), seconds(0), aborted(false) {}
+	void	Add(const SolverStats& other);
+};
+
+/// Work limit for circuit searches, counted in explored nodes and wall time.
+/// Solvers report their nodes in chunks, so one budget can be shared by the
+/// solvers searching different maxlists for the same circuit.
+class SolverBudget
+{
+public:
+	/// Nodes reported per Spend call, the node limit is rounded up to whole chunks
+	static const size_t cChunk = 256;
+
+	///		Start over with new limits, 0 means no limit
+	void	Reset(size_t maxNodes, double maxSeconds);
+
+	///		Report another cChunk explored nodes, returns false once either limit is reached
+	bool	Spend();
+	bool	IsExhausted() const;
+
+	SolverBudget(size_t maxNodes = 0, double maxSeconds = 0);
+private:
+	SolverBudget(const SolverBudget&);
+	SolverBudget& operator=(const SolverBudget&);
+
+	size_t			mMaxChunks;
+	double			mMaxSeconds;
+	timer			mTimer;
+	volatile int	mChunks;
+	volatile int	mExhausted;
+};
+
+#endif
@@ -80,7 +80,7 @@ int	IVIModule::Init()
 	}
 
 	std::string CompConfig = "conf/" + mpServices->GetConfig()->GetString("CompConfig", "components.list");		
-	mpListParser = new ListParser(*mpServices->GetComponentDefinitions());
+	mpListParser = new ListParser(*mpServices->GetComponentDefinitions(), true);
 	if (!mpListParser->ParseFile(CompConfig))
 	{
 		return 0;
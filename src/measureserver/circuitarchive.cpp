@@ -0,0 +1,500 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "circuitarchive.h"
+
+#include <contrib/md5.h>
+
+#include <util/byteorder.h>
+#include <util/syslog.h>
+
+#include <algorithm>
+#include <string.h>
+
+static const char	sMagic[4] = { 'V', 'C', 'A', 'R' };
+static const size_t	cMd5Size = 16;
+static const size_t	cRecordHeaderSize = sizeof(sMagic) + 4 + 4 + cMd5Size;
+static const size_t	cIndexEntrySize = 4 + 4 + 4 + cMd5Size;
+
+/// Circuits waiting for the writer, more are dropped if the disk can't keep up
+static const size_t	cMaxQueued = 10000;
+
+/// The editor on the client limits what a circuit can be, anything larger is damage
+static const size_t	cMaxCircuitSize = 1024 * 1024;
+
+void CircuitArchive::Writer::Run()
+{
+	mpArchive->WriterLoop();
+}
+
+CircuitArchive::CircuitArchive()
+{
+	mpWriter		= NULL;
+	mStopping		= false;
+	mSegments		= 0;
+	mSegmentSize	= 64 * 1024 * 1024;
+	mpSegment		= NULL;
+	mSegmentOffset	= 0;
+	mpIndexFile		= NULL;
+	mpReadFile		= NULL;
+	mReadSegment	= 0;
+}
+
+CircuitArchive::~CircuitArchive()
+{
+	Close();
+}
+
+std::string CircuitArchive::Md5(const std::string& circuit)
+{
+	unsigned char md5sum[cMd5Size];
+	md5((unsigned char*)circuit.c_str(), (int)circuit.size(), md5sum);
+	return std::string((const char*)md5sum, sizeof(md5sum));
+}
+
+std::string CircuitArchive::ToHex(const std::string& md5)
+{
+	static const char sDigits[] = "0123456789abcdef";
+	std::string out;
+	for(size_t i = 0; i < md5.size(); i++)
+	{
+		out += sDigits[(md5[i] >> 4) & 0xf];
+		out += sDigits[md5[i] & 0xf];
+	}
+	return out;
+}
+
+std::string CircuitArchive::SegmentName(unsigned int segment) const
+{
+	char name[32];
+	sprintf(name, "segment-%06u.dat", segment);
+	return mDir + name;
+}
+
+std::string CircuitArchive::IndexName() const
+{
+	return mDir + "index.dat";
+}
+
+bool CircuitArchive::SetDir(const std::string& dir)
+{
+	Close();
+	if (dir.empty()) return false;
+
+	mDir = dir;
+	const char last = mDir[mDir.size() - 1];
+	if (last != '/' && last != '\\') mDir += "/";
+	return true;
+}
+
+bool CircuitArchive::Open(const std::string& dir)
+{
+	if (!SetDir(dir)) return false;
+
+	ScopedLock lock(mMutex);
+	ReadIndex();
+	return true;
+}
+
+bool CircuitArchive::OpenForAppend(const std::string& dir)
+{
+	if (!SetDir(dir)) return false;
+
+	ScopedLock lock(mMutex);
+
+	// a damaged or incomplete index is written again, appending to it would misplace the new entries
+	if (!ReadIndex() && !WriteIndex())
+	{
+		syserr << "Failed to repair the circuit archive index: " << IndexName() << std::endl;
+		mDir.clear();
+		return false;
+	}
+
+	mpIndexFile = fopen(IndexName().c_str(), "ab");
+	if (!mpIndexFile)
+	{
+		syserr << "Failed to open the circuit archive index: " << IndexName() << std::endl;
+		mDir.clear();
+		return false;
+	}
+
+	mpWriter = new Writer(this);
+	if (!mpWriter->Start())
+	{
+		syserr << "Failed to start the circuit archive writer" << std::endl;
+		delete mpWriter;
+		mpWriter = NULL;
+		fclose(mpIndexFile);
+		mpIndexFile = NULL;
+		mDir.clear();
+		return false;
+	}
+	return true;
+}
+
+void CircuitArchive::Close()
+{
+	if (mpWriter)
+	{
+		{
+			ScopedLock lock(mMutex);
+			mStopping = true;
+			mQueued.Broadcast();
+		}
+		mpWriter->Join();
+		delete mpWriter;
+		mpWriter = NULL;
+	}
+
+	ScopedLock lock(mMutex);
+	if (mpSegment) fclose(mpSegment);
+	if (mpIndexFile) fclose(mpIndexFile);
+	if (mpReadFile) fclose(mpReadFile);
+	mpSegment		= NULL;
+	mpIndexFile		= NULL;
+	mpReadFile		= NULL;
+	mStopping		= false;
+	mSegments		= 0;
+	mSegmentOffset	= 0;
+	mLocations.clear();
+	mIndex.clear();
+	mQueuedKeys.clear();
+	mQueue.clear();
+	mDir.clear();
+}
+
+void CircuitArchive::Flush()
+{
+	// the keys are only dropped once their record is written, the queue empties before that
+	ScopedLock lock(mMutex);
+	while(!mQueuedKeys.empty() && mpWriter) mWritten.Wait(mMutex);
+}
+
+bool CircuitArchive::ReadIndex()
+{
+	mLocations.clear();
+	mIndex.clear();
+	if (mpReadFile) fclose(mpReadFile);
+	mpReadFile = NULL;
+
+	mSegments = 0;
+	for(;;)
+	{
+		FILE* segment = fopen(SegmentName(mSegments).c_str(), "rb");
+		if (!segment) break;
+		fclose(segment);
+		mSegments++;
+	}
+
+	bool complete = true;
+	std::vector<unsigned int> indexed(mSegments, 0);
+	FILE* file = fopen(IndexName().c_str(), "rb");
+	if (file)
+	{
+		char entry[cIndexEntrySize];
+		size_t got;
+		while((got = fread(entry, 1, sizeof(entry), file)) == sizeof(entry))
+		{
+			Location location;
+			location.segment	= GetU32(entry);
+			location.offset		= GetU32(entry + 4);
+			location.length		= GetU32(entry + 8);
+			location.md5.assign(entry + 12, cMd5Size);
+			if (location.segment >= mSegments)
+			{
+				complete = false;
+				continue;
+			}
+
+			AddLocation(location);
+			indexed[location.segment] = std::max(indexed[location.segment], (unsigned int)(location.offset + cRecordHeaderSize + location.length));
+		}
+		if (got != 0) complete = false;	// torn entry at the end
+		fclose(file);
+	}
+	else if (mSegments > 0) complete = false;
+
+	// the server may have stopped between writing a record and its index entry
+	for(unsigned int segment = 0; segment < mSegments; segment++)
+	{
+		if (ScanSegment(segment, indexed[segment]) > 0) complete = false;
+	}
+	return complete;
+}
+
+size_t CircuitArchive::ScanSegment(unsigned int segment, unsigned int offset)
+{
+	FILE* file = fopen(SegmentName(segment).c_str(), "rb");
+	if (!file) return 0;
+
+	size_t found = 0;
+	std::string circuit;
+	while(fseek(file, offset, SEEK_SET) == 0)
+	{
+		char header[cRecordHeaderSize];
+		if (fread(header, sizeof(header), 1, file) != 1 || memcmp(header, sMagic, sizeof(sMagic)) != 0) break;
+
+		Location location;
+		location.segment	= segment;
+		location.offset		= offset;
+		location.length		= GetU32(header + 4);
+		location.md5.assign(header + 12, cMd5Size);
+		if (location.length > cMaxCircuitSize) break;
+
+		// a record cut short by a crash doesn't match its checksum
+		circuit.resize(location.length);
+		if (location.length > 0 && fread(&circuit[0], location.length, 1, file) != 1) break;
+		if (Md5(circuit) != location.md5) break;
+
+		AddLocation(location);
+		offset += (unsigned int)(cRecordHeaderSize + location.length);
+		found++;
+	}
+
+	fclose(file);
+	return found;
+}
+
+void CircuitArchive::AddLocation(const Location& location)
+{
+	if (mIndex.find(location.md5) != mIndex.end()) return;
+
+	mIndex[location.md5] = mLocations.size();
+	mLocations.push_back(location);
+}
+
+bool CircuitArchive::WriteIndex()
+{
+	std::string data;
+	for(std::vector<Location>::const_iterator it = mLocations.begin(); it != mLocations.end(); ++it)
+	{
+		PutU32(data, it->segment);
+		PutU32(data, it->offset);
+		PutU32(data, it->length);
+		data += it->md5;
+	}
+
+	std::string tmpname = IndexName() + ".tmp";
+	FILE* file = fopen(tmpname.c_str(), "wb");
+	if (!file) return false;
+
+	bool ok = data.empty() || fwrite(data.data(), data.size(), 1, file) == 1;
+	if (fclose(file) != 0) ok = false;
+	if (!ok)
+	{
+		remove(tmpname.c_str());
+		return false;
+	}
+
+#ifdef _WIN32
+	remove(IndexName().c_str());
+#endif
+	return rename(tmpname.c_str(), IndexName().c_str()) == 0;
+}
+
+bool CircuitArchive::Add(const std::string& circuit, unsigned int time)
+{
+	if (circuit.size() > cMaxCircuitSize) return false;
+
+	Pending pending;
+	pending.md5		= Md5(circuit);
+	pending.time	= time;
+
+	ScopedLock lock(mMutex);
+	if (!mpWriter || mStopping) return false;
+	if (mIndex.find(pending.md5) != mIndex.end() || mQueuedKeys.find(pending.md5) != mQueuedKeys.end()) return false;
+	if (mQueue.size() >= cMaxQueued)
+	{
+		LogLevel(syserr, 3) << "Circuit archive writer is behind, circuit not saved" << std::endl;
+		return false;
+	}
+
+	pending.circuit = circuit;
+	mQueuedKeys.insert(pending.md5);
+	mQueue.push_back(pending);
+	mQueued.Signal();
+	return true;
+}
+
+void CircuitArchive::WriterLoop()
+{
+	ScopedLock lock(mMutex);
+	for(;;)
+	{
+		while(mQueue.empty() && !mStopping) mQueued.Wait(mMutex);
+		if (mQueue.empty()) return;	// stopping, everything is written
+
+		Pending pending = mQueue.front();
+		mQueue.pop_front();
+
+		Location location;
+		mMutex.Unlock();
+		bool written = Write(pending, location);
+		mMutex.Lock();
+
+		if (written) AddLocation(location);
+		mQueuedKeys.erase(pending.md5);
+		if (mQueuedKeys.empty()) mWritten.Broadcast();
+	}
+}
+
+bool CircuitArchive::StartSegment()
+{
+	if (mpSegment) fclose(mpSegment);
+
+	// the segment count is only changed here and read under the mutex
+	ScopedLock lock(mMutex);
+	mpSegment = fopen(SegmentName(mSegments).c_str(), "wb");
+	if (!mpSegment) return false;
+
+	mSegments++;
+	mSegmentOffset = 0;
+	return true;
+}
+
+bool CircuitArchive::Write(const Pending& pending, Location& location)
+{
+	const size_t size = cRecordHeaderSize + pending.circuit.size();
+	if (!mpSegment || (mSegmentOffset > 0 && mSegmentOffset + size > mSegmentSize))
+	{
+		if (!StartSegment())
+		{
+			syserr << "Failed to start a circuit archive segment in: " << mDir << std::endl;
+			return false;
+		}
+	}
+
+	std::string record(sMagic, sizeof(sMagic));
+	PutU32(record, (unsigned int)pending.circuit.size());
+	PutU32(record, pending.time);
+	record += pending.md5;
+	record += pending.circuit;
+
+	location.segment	= mSegments - 1;
+	location.offset		= mSegmentOffset;
+	location.length		= (unsigned int)pending.circuit.size();
+	location.md5		= pending.md5;
+
+	if (fwrite(record.data(), record.size(), 1, mpSegment) != 1 || fflush(mpSegment) != 0)
+	{
+		// the rest of the segment can't be trusted, later records go to a new one
+		syserr << "Failed to write to the circuit archive: " << SegmentName(location.segment) << std::endl;
+		fclose(mpSegment);
+		mpSegment = NULL;
+		return false;
+	}
+	mSegmentOffset += (unsigned int)record.size();
+
+	std::string entry;
+	PutU32(entry, location.segment);
+	PutU32(entry, location.offset);
+	PutU32(entry, location.length);
+	entry += location.md5;
+	if (fwrite(entry.data(), entry.size(), 1, mpIndexFile) != 1 || fflush(mpIndexFile) != 0)
+	{
+		// found again by scanning the segment the next time the archive is opened
+		syserr << "Failed to write to the circuit archive index: " << IndexName() << std::endl;
+	}
+	return true;
+}
+
+size_t CircuitArchive::Size() const
+{
+	ScopedLock lock(mMutex);
+	return mLocations.size();
+}
+
+bool CircuitArchive::Read(size_t index, Record& record) const
+{
+	ScopedLock lock(mMutex);
+	if (index >= mLocations.size()) return false;
+	return ReadRecord(mLocations[index], record);
+}
+
+bool CircuitArchive::Find(const std::string& md5, Record& record) const
+{
+	// hex as shown to people, or the binary sum
+	std::string key = md5;
+	if (md5.size() == cMd5Size * 2)
+	{
+		key.clear();
+		for(size_t i = 0; i < md5.size(); i += 2)
+		{
+			unsigned int byte;
+			if (sscanf(md5.substr(i, 2).c_str(), "%2x", &byte) != 1) return false;
+			key += (char)byte;
+		}
+	}
+
+	ScopedLock lock(mMutex);
+	std::map<std::string, size_t>::const_iterator it = mIndex.find(key);
+	if (it == mIndex.end()) return false;
+	return ReadRecord(mLocations[it->second], record);
+}
+
+bool CircuitArchive::ReadRecord(const Location& location, Record& record) const
+{
+	if (!mpReadFile || mReadSegment != location.segment)
+	{
+		if (mpReadFile) fclose(mpReadFile);
+		mpReadFile = fopen(SegmentName(location.segment).c_str(), "rb");
+		mReadSegment = location.segment;
+		if (!mpReadFile) return false;
+	}
+
+	char header[cRecordHeaderSize];
+	if (fseek(mpReadFile, location.offset, SEEK_SET) != 0 || fread(header, sizeof(header), 1, mpReadFile) != 1) return false;
+	if (memcmp(header, sMagic, sizeof(sMagic)) != 0 || GetU32(header + 4) != location.length) return false;
+
+	record.circuit.resize(location.length);
+	if (location.length > 0 && fread(&record.circuit[0], location.length, 1, mpReadFile) != 1) return false;
+
+	record.md5	= ToHex(location.md5);
+	record.time	= GetU32(header + 8);
+	return true;
+}
+
+bool CircuitArchive::Compact(const std::string& fromDir, const std::string& toDir, unsigned int minTime)
+{
+	CircuitArchive from;
+	CircuitArchive to;
+	if (!from.Open(fromDir) || !to.OpenForAppend(toDir)) return false;
+
+	Record record;
+	for(size_t i = 0; i < from.Size(); i++)
+	{
+		// damaged records are left behind
+		if (!from.Read(i, record)) continue;
+		if (record.time < minTime) continue;
+		to.Add(record.circuit, record.time);
+
+		// keep the writer queue short, Add drops circuits when it is full
+		if ((i % 1000) == 999) to.Flush();
+	}
+
+	to.Close();
+	return true;
+}
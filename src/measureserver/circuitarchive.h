@@ -0,0 +1,154 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __CIRCUIT_ARCHIVE_H__
+#define __CIRCUIT_ARCHIVE_H__
+
+#include <util/thread.h>
+
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/// Append only store of the circuits sent to the server, each distinct circuit is kept once.
+/// Records are appended to numbered segment files and listed in an index file. Opening the archive
+/// for appending starts a new segment, and a writer thread does the file io so Add never blocks on disk.
+/// Records the index missed, when the server stopped between writing a record and its index entry,
+/// are found again by scanning the segments past the last indexed record.
+///
+/// Files in the archive directory, all numbers little endian:
+///   segment-NNNNNN.dat	records of "VCAR", u32 length, u32 unix time, 16 byte md5 of the circuit, circuit text
+///   index.dat				u32 segment, u32 record offset, u32 length and the md5 for each record
+class CircuitArchive
+{
+public:
+	struct Record
+	{
+		std::string		md5;	///< hex, the name the circuit was saved under before the archive
+		unsigned int	time;	///< when it was first seen, seconds since 1970
+		std::string		circuit;
+	};
+
+	///				Reads the index, the directory must exist. Closes an already open archive
+	bool			Open(const std::string& dir);
+	///				Opens the archive and starts the writer on a new segment
+	bool			OpenForAppend(const std::string& dir);
+	///				Writes what is queued and stops the writer
+	void			Close();
+	///				Waits until what is queued has been written
+	void			Flush();
+
+	bool			IsOpen() const	{ return !mDir.empty(); }
+
+	///				Queues a circuit that isn't in the archive yet, returns false if it is known or the archive is read only
+	bool			Add(const std::string& circuit, unsigned int time);
+
+	///				Records in the order they were added, circuits still queued for writing aren't counted
+	size_t			Size() const;
+	bool			Read(size_t index, Record& record) const;
+	bool			Find(const std::string& md5, Record& record) const;
+
+	///				Copies the readable records to a new archive in one segment per size limit, oldest first.
+	///				Records older than minTime are dropped
+	static bool		Compact(const std::string& fromDir, const std::string& toDir, unsigned int minTime = 0);
+
+	static std::string	Md5(const std::string& circuit);
+	static std::string	ToHex(const std::string& md5);
+
+	///				A new segment is started when the current one grows past this many bytes
+	void			SetSegmentSize(size_t bytes)	{ mSegmentSize = bytes; }
+
+	CircuitArchive();
+	virtual ~CircuitArchive();
+private:
+	class Writer : public Thread
+	{
+	public:
+		Writer(CircuitArchive* pArchive) : mpArchive(pArchive) {}
+		virtual void Run();
+	private:
+		CircuitArchive* mpArchive;
+	};
+
+	struct Location
+	{
+		unsigned int	segment;
+		unsigned int	offset;		///< of the record header
+		unsigned int	length;		///< of the circuit text
+		std::string		md5;		///< binary
+	};
+
+	struct Pending
+	{
+		std::string		md5;
+		unsigned int	time;
+		std::string		circuit;
+	};
+
+	std::string		SegmentName(unsigned int segment) const;
+	std::string		IndexName() const;
+
+	bool			SetDir(const std::string& dir);
+
+	// mutex must be held
+	bool			ReadIndex();
+	size_t			ScanSegment(unsigned int segment, unsigned int offset);
+	void			AddLocation(const Location& location);
+	bool			WriteIndex();
+	bool			ReadRecord(const Location& location, Record& record) const;
+
+	// writer thread
+	void			WriterLoop();
+	bool			Write(const Pending& pending, Location& location);
+	bool			StartSegment();
+
+	mutable Mutex	mMutex;
+	Condition		mQueued;
+	Condition		mWritten;
+	std::string		mDir;
+
+	std::vector<Location>				mLocations;
+	std::map<std::string, size_t>		mIndex;		// binary md5 to position in mLocations
+	std::set<std::string>				mQueuedKeys;	// added but not written yet
+
+	std::deque<Pending>	mQueue;
+	Writer*			mpWriter;
+	bool			mStopping;
+
+	unsigned int	mSegments;		// segment files that exist
+	size_t			mSegmentSize;
+	FILE*			mpSegment;		// being appended to, owned by the writer
+	unsigned int	mSegmentOffset;
+	FILE*			mpIndexFile;
+
+	mutable FILE*	mpReadFile;		// last segment read from
+	mutable unsigned int mReadSegment;
+};
+
+#endif
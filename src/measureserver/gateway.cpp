@@ -0,0 +1,292 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "gateway.h"
+#include "client.h"
+#include "clientmanager.h"
+#include "protocolservice.h"
+#include "requestqueue.h"
+#include "session.h"
+#include "transactionrequest.h"
+
+#include <instruments/instrumentblock.h>
+
+#include <syslog.h>
+
+using namespace std;
+
+/// Scheduler side of a connection, owns the client.
+/// Finished transactions are passed on to the reactor together with a copy of the
+/// instruments of the session, the response is serialized there.
+class ClientChannel : public protocol::TransactionIssuer, public IClientEventListener
+{
+public:
+	void Submit(protocol::Transaction* pTransaction);
+	void Close();
+
+	virtual bool TransactionComplete(protocol::Transaction* pTransaction);
+	virtual void TransactionError(protocol::Transaction* pTransaction, const char* msg, protocol::TransactionErrorType type);
+
+	virtual void SessionDestroyed();
+
+	ClientChannel(Reactor* pReactor, unsigned int channel, int flags, Client* pClient, ServerProtocolService* pSrvProtSrvc, ClientManager* pClientMgr);
+	virtual ~ClientChannel();
+private:
+	void Post(GatewayMessage::Type type, std::string* pData = NULL);
+
+	Reactor*				mpReactor;
+	unsigned int			mChannel;
+	int						mFlags;
+	Client*					mpClient;
+	ServerProtocolService*	mpSrvProtSrvc;
+	ClientManager*			mpClientMgr;
+	TransactionRequest*		mpCurrentRequest;
+};
+
+ClientChannel::ClientChannel(Reactor* pReactor, unsigned int channel, int flags, Client* pClient, ServerProtocolService* pSrvProtSrvc, ClientManager* pClientMgr)
+{
+	mpReactor		= pReactor;
+	mChannel		= channel;
+	mFlags			= flags;
+	mpClient		= pClient;
+	mpSrvProtSrvc	= pSrvProtSrvc;
+	mpClientMgr		= pClientMgr;
+	mpCurrentRequest = NULL;
+
+	mpClient->AddListener(this);
+}
+
+ClientChannel::~ClientChannel()
+{
+}
+
+void ClientChannel::Post(GatewayMessage::Type type, std::string* pData)
+{
+	GatewayMessage msg = { type, mChannel, 0, NULL, pData, NULL };
+	mpReactor->Post(msg);
+}
+
+void ClientChannel::Submit(protocol::Transaction* pTransaction)
+{
+	if ((mFlags & Reactor::eOneTransaction) && mpCurrentRequest != NULL)
+	{
+		Post(GatewayMessage::eError, new std::string("Transaction already in progress"));
+		delete pTransaction;
+		return;
+	}
+
+	pTransaction->SetIssuer(this);
+	pTransaction->SetOwner(mpClient);
+
+	// hand over ownership to the handler
+	mpCurrentRequest = mpSrvProtSrvc->ProcessTransaction(pTransaction, mpClient);
+}
+
+void ClientChannel::Close()
+{
+	if (mpCurrentRequest)
+	{
+		syserr << "A transaction was canceled mid flight" << endl;
+		mpCurrentRequest->ClientGone();
+		mpCurrentRequest = NULL;
+	}
+
+	mpClient->RemoveListener(this);
+
+	mpSrvProtSrvc->GetRequestQueue()->RemoveRequestsFrom(mpClient);
+	mpClient->ConnectionClosed();
+	mpClientMgr->RemoveClient(mpClient);
+	delete mpClient;
+	mpClient = NULL;
+}
+
+static bool HasMeasurement(protocol::Transaction* pTransaction)
+{
+	typedef protocol::Transaction::tRequests tRequests;
+	const tRequests& requests = pTransaction->GetRequests();
+	for(tRequests::const_iterator it = requests.begin(); it != requests.end(); it++)
+	{
+		if ((*it)->GetType() == protocol::RequestType::Measurement) return true;
+	}
+	return false;
+}
+
+bool ClientChannel::TransactionComplete(protocol::Transaction* pTransaction)
+{
+	mpCurrentRequest = NULL;
+
+	Session* pSession = mpClient->GetSession();
+
+	if (mFlags & Reactor::eRequireSession)
+	{
+		if (!pSession)
+		{
+			Post(GatewayMessage::eError, new std::string("Unable to get session when generating xml response"));
+			return false;
+		}
+
+		sysout << "request from session: " << pSession->GetKey() << endl;
+	}
+
+	// the session may run its next transaction before the reactor gets to this one
+	InstrumentBlock* pSnapshot = NULL;
+	if (pSession && HasMeasurement(pTransaction))
+	{
+		pSnapshot = new InstrumentBlock();
+		pSnapshot->CopyFrom(*pSession->GetBlock());
+	}
+
+	pTransaction->SetPrepared(NULL); // only used for performing
+	GatewayMessage msg = { GatewayMessage::eCompleted, mChannel, 0, pTransaction, NULL, pSnapshot };
+	mpReactor->Post(msg);
+	return true;
+}
+
+void ClientChannel::TransactionError(protocol::Transaction* pTransaction, const char* msg, protocol::TransactionErrorType type)
+{
+	mpCurrentRequest = NULL;
+	Post(GatewayMessage::eError, new std::string(msg));
+}
+
+void ClientChannel::SessionDestroyed()
+{
+	syserr << "Session is destroyed while client is connected!" << endl;
+
+	if (mpCurrentRequest)
+	{
+		// Cancel the request by pretending that the client has disconnected
+		mpCurrentRequest->ClientGone();
+		mpCurrentRequest = NULL;
+	}
+
+	Post(GatewayMessage::eSessionGone);
+}
+
+///////////////////
+
+ProtocolGateway::ProtocolGateway(ServerProtocolService* pSrvProtSrvc, ClientManager* pClientMgr)
+	: mWakeup(this)
+{
+	mpMultiplexer	= NULL;
+	mpSrvProtSrvc	= pSrvProtSrvc;
+	mpClientMgr		= pClientMgr;
+}
+
+ProtocolGateway::~ProtocolGateway()
+{
+	CloseAll();
+	if (mpMultiplexer) mpMultiplexer->RemoveHandler(&mWakeup);
+}
+
+bool ProtocolGateway::Init(Net::Multiplexer* pMultiplexer)
+{
+	mpMultiplexer = pMultiplexer;
+	if (!mWakeup.Init()) return false;
+	mpMultiplexer->AddHandler(&mWakeup);
+	return true;
+}
+
+void ProtocolGateway::AddReactor(Reactor* pReactor)
+{
+	mReactors.push_back(pReactor);
+}
+
+void ProtocolGateway::Signal()
+{
+	mWakeup.Signal();
+}
+
+void ProtocolGateway::WokenUp()
+{
+	ProcessMessages();
+}
+
+void ProtocolGateway::ProcessMessages()
+{
+	for(tReactors::iterator it = mReactors.begin(); it != mReactors.end(); it++)
+	{
+		GatewayMessage msg;
+		while((*it)->Receive(msg)) HandleMessage(*it, msg);
+	}
+}
+
+void ProtocolGateway::CloseAll()
+{
+	for(tChannels::iterator it = mChannels.begin(); it != mChannels.end(); it++)
+	{
+		it->second->Close();
+		delete it->second;
+	}
+	mChannels.clear();
+}
+
+void ProtocolGateway::HandleMessage(Reactor* pReactor, GatewayMessage& msg)
+{
+	tChannelKey key(pReactor, msg.channel);
+
+	switch(msg.type)
+	{
+	case GatewayMessage::eOpen:
+		{
+			Client* pClient = mpClientMgr->AddClient(NULL);
+			if (!pClient)
+			{
+				GatewayMessage reply = { GatewayMessage::eRejected, msg.channel, 0, NULL, new std::string("Unable to create client, server overloaded"), NULL };
+				pReactor->Post(reply);
+				return;
+			}
+
+			mChannels[key] = new ClientChannel(pReactor, msg.channel, msg.flags, pClient, mpSrvProtSrvc, mpClientMgr);
+		}
+		break;
+	case GatewayMessage::eTransaction:
+		{
+			tChannels::iterator it = mChannels.find(key);
+			if (it == mChannels.end())
+			{
+				// rejected or already closed
+				delete msg.pTransaction;
+				return;
+			}
+
+			it->second->Submit(msg.pTransaction);
+		}
+		break;
+	case GatewayMessage::eClose:
+		{
+			tChannels::iterator it = mChannels.find(key);
+			if (it == mChannels.end()) return;
+
+			it->second->Close();
+			delete it->second;
+			mChannels.erase(it);
+		}
+		break;
+	default:
+		break;
+	}
+}
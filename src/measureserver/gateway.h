@@ -0,0 +1,82 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __GATEWAY_H__
+#define __GATEWAY_H__
+
+#include "reactor.h"
+
+#include <network/wakeup.h>
+
+#include <map>
+#include <vector>
+
+class ClientChannel;
+class ClientManager;
+class ServerProtocolService;
+
+/// Scheduler side of the I/O reactors.
+/// Drains the reactor queues in the scheduler thread, keeps a client per connection
+/// and hands the transactions to the request queue.
+class ProtocolGateway : public Net::WakeupListener
+{
+public:
+	bool			Init(Net::Multiplexer* pMultiplexer);
+	void			AddReactor(Reactor* pReactor);
+
+	///				Thread safe, makes the scheduler thread process the reactor queues
+	void			Signal();
+
+	///				Handle the pending messages of all reactors
+	void			ProcessMessages();
+
+	///				Close the channels that are still open, used on shutdown
+	void			CloseAll();
+
+	size_t			NumChannels() const { return mChannels.size(); }
+
+	virtual void	WokenUp();
+
+	ProtocolGateway(ServerProtocolService* pSrvProtSrvc, ClientManager* pClientMgr);
+	virtual ~ProtocolGateway();
+private:
+	void			HandleMessage(Reactor* pReactor, GatewayMessage& msg);
+
+	typedef std::pair<Reactor*, unsigned int> tChannelKey;
+	typedef std::map<tChannelKey, ClientChannel*> tChannels;
+	typedef std::vector<Reactor*> tReactors;
+
+	Net::Multiplexer*		mpMultiplexer;
+	Net::Wakeup				mWakeup;
+	ServerProtocolService*	mpSrvProtSrvc;
+	ClientManager*			mpClientMgr;
+
+	tReactors				mReactors;
+	tChannels				mChannels;
+};
+
+#endif
@@ -0,0 +1,197 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "listorder.h"
+
+#include <syslog.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+// floor for the cost of a search, keeps the score finite for lists that fail instantly
+static const double cMinSeconds = 0.000001;
+
+namespace
+{
+	struct ByScore
+	{
+		const std::vector<double>& scores;
+		ByScore(const std::vector<double>& s) : scores(s) {}
+		bool operator()(size_t a, size_t b) const
+		{
+			if (scores[a] != scores[b]) return scores[a] > scores[b];
+			return a < b;
+		}
+	};
+}
+
+ListOrder::ListOrder()
+{
+}
+
+ListOrder::~ListOrder()
+{
+}
+
+void ListOrder::SetLists(const std::vector<std::string>& names)
+{
+	std::map<std::string, Entry> known;
+	for(tEntries::const_iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+	{
+		known[it->name] = *it;
+	}
+
+	mEntries.clear();
+	for(std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it)
+	{
+		std::map<std::string, Entry>::const_iterator found = known.find(*it);
+		if (found != known.end()) mEntries.push_back(found->second);
+		else
+		{
+			mEntries.push_back(Entry());
+			mEntries.back().name = *it;
+		}
+	}
+
+	Update();
+}
+
+void ListOrder::Add(size_t index, bool matched, double seconds)
+{
+	if (index >= mEntries.size()) return;
+
+	Entry& entry = mEntries[index];
+	entry.attempts++;
+	if (matched)
+	{
+		entry.matches++;
+		entry.matchSeconds += seconds;
+	}
+	else entry.failSeconds += seconds;
+}
+
+double ListOrder::Score(const Entry& entry, double defaultCost) const
+{
+	// laplace smoothed, a list that hasn't been tried yet is as likely to match as not
+	const double p = (entry.matches + 1.0) / (entry.attempts + 2.0);
+
+	const size_t failures = entry.attempts - entry.matches;
+	double failCost = defaultCost;
+	double matchCost = defaultCost;
+	if (failures > 0) failCost = entry.failSeconds / failures;
+	if (entry.matches > 0) matchCost = entry.matchSeconds / entry.matches;
+	if (failures == 0) failCost = matchCost;
+	if (entry.matches == 0) matchCost = failCost;
+
+	const double cost = std::max(p * matchCost + (1.0 - p) * failCost, cMinSeconds);
+	return p / cost;
+}
+
+void ListOrder::Update()
+{
+	// lists nothing is known about are assumed to cost as much as the average one
+	double seconds = 0;
+	size_t attempts = 0;
+	for(tEntries::const_iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+	{
+		seconds += it->matchSeconds + it->failSeconds;
+		attempts += it->attempts;
+	}
+	const double defaultCost = (attempts > 0) ? seconds / attempts : cMinSeconds;
+
+	std::vector<double> scores;
+	scores.reserve(mEntries.size());
+	for(tEntries::const_iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+	{
+		scores.push_back(Score(*it, defaultCost));
+	}
+
+	mOrder.resize(mEntries.size());
+	for(size_t i = 0; i < mOrder.size(); i++) mOrder[i] = i;
+	std::sort(mOrder.begin(), mOrder.end(), ByScore(scores));
+}
+
+bool ListOrder::Load(const std::string& filename)
+{
+	std::ifstream file(filename.c_str());
+	if (!file.is_open()) return false;
+
+	std::map<std::string, size_t> indices;
+	for(size_t i = 0; i < mEntries.size(); i++) indices[mEntries[i].name] = i;
+
+	std::string line;
+	while(getline(file, line))
+	{
+		if (line.empty() || line[0] == '#') continue;
+		if (line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+
+		// the name may contain spaces, the fields are tab separated
+		std::string::size_type tab = line.find('\t');
+		if (tab == std::string::npos) continue;
+
+		std::map<std::string, size_t>::const_iterator found = indices.find(line.substr(0, tab));
+		if (found == indices.end()) continue;
+
+		Entry entry;
+		entry.name = found->first;
+		std::istringstream fields(line.substr(tab + 1));
+		if (!(fields >> entry.attempts >> entry.matches >> entry.matchSeconds >> entry.failSeconds) || entry.matches > entry.attempts)
+		{
+			syserr << "Invalid maxlist statistics for: " << entry.name << std::endl;
+			continue;
+		}
+		mEntries[found->second] = entry;
+	}
+
+	Update();
+	return true;
+}
+
+bool ListOrder::Save(const std::string& filename) const
+{
+	// written next to the old file and renamed over it, a crash doesn't leave half a file
+	std::string tmpname = filename + ".tmp";
+	{
+		std::ofstream file(tmpname.c_str());
+		if (!file.is_open()) return false;
+
+		file << "# maxlist\tattempts\tmatches\tmatch seconds\tfail seconds, most promising first" << std::endl;
+		for(tOrder::const_iterator it = mOrder.begin(); it != mOrder.end(); ++it)
+		{
+			const Entry& entry = mEntries[*it];
+			file << entry.name << '\t' << (unsigned int)entry.attempts << '\t' << (unsigned int)entry.matches << '\t' << entry.matchSeconds << '\t' << entry.failSeconds << std::endl;
+		}
+		if (!file.good()) return false;
+	}
+
+#ifdef _WIN32
+	remove(filename.c_str());
+#endif
+	return rename(tmpname.c_str(), filename.c_str()) == 0;
+}
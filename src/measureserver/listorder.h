@@ -0,0 +1,77 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __LIST_ORDER_H__
+#define __LIST_ORDER_H__
+
+#include <string>
+#include <vector>
+
+/// Learns in which order the maxlists are worth trying from how earlier searches went.
+/// Lists are ranked by match rate over expected search cost, so a cheap list that often matches goes first.
+/// The statistics are kept by list name so they survive rereading the config and can be saved to a file.
+class ListOrder
+{
+public:
+	typedef std::vector<size_t>	tOrder;
+
+	struct Entry
+	{
+		std::string	name;
+		size_t		attempts;
+		size_t		matches;
+		double		matchSeconds;	///< time spent on searches that matched
+		double		failSeconds;	///< time spent on searches that didn't
+
+		Entry() : attempts(0), matches(0), matchSeconds(0), failSeconds(0) {}
+	};
+	typedef std::vector<Entry>	tEntries;
+
+	///				One entry per maxlist in config order, lists with a known name keep what was learned
+	void			SetLists(const std::vector<std::string>& names);
+
+	///				Record one search, call Update to rank the lists again
+	void			Add(size_t index, bool matched, double seconds);
+	void			Update();
+
+	///				List indices, most promising first. Lists nothing is known about keep their config order
+	const tOrder&	GetOrder() const	{ return mOrder; }
+	const tEntries&	GetEntries() const	{ return mEntries; }
+
+	///				Entries in the file for lists that aren't loaded are ignored
+	bool			Load(const std::string& filename);
+	bool			Save(const std::string& filename) const;
+
+	ListOrder();
+	virtual ~ListOrder();
+private:
+	double			Score(const Entry& entry, double defaultCost) const;
+
+	tEntries		mEntries;	// config order
+	tOrder			mOrder;
+};
+
+#endif
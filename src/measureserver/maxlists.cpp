@@ -29,7 +29,7 @@
 #include "maxlists.h"
 #include <instruments/instrumentblock.h>
 #include <instruments/nodeinterpreter.h>
-#include <instruments/circuitlist.h>
+#include <instruments/circuitsolver3.h>
 #include <instruments/listparser.h>
 
 #include <contrib/md5.h>
@@ -37,29 +37,53 @@
 #include <syslog.h>
 #include <basic_exception.h>
 #include <stringop.h>
+#include <stringview.h>
 #include <timer.h>
 
-#include <fstream>
 #include <math.h>
+#include <time.h>
 #include <sstream>
 
 MaxLists::MaxLists()
 {
-	mSaveCircuits = false;
-	mSaveLocation = "";
+	mCircuitNodes = 0;
+	mCircuitSeconds = 0;
+	mStatsInterval = 0;
+	mCircuits = 0;
+	mOrderMode = eConfigOrder;
 }
 
 MaxLists::~MaxLists()
 {
+	SaveListOrder();
 }
 
-bool MaxLists::Init(const std::string& confBase, const std::string& maxListConfig, const std::string& saveLocation, const ListParser::tComponentDefinitions& compdefs)
+bool MaxLists::Init(const std::string& confBase, const std::string& maxListConfig, const std::string& saveLocation, const ListParser::tComponentDefinitions& compdefs, size_t cacheSize, int solverThreads)
 {
 	mCompDefs = compdefs; // copy the component definitions
-	mSaveLocation = saveLocation;
-	if (mSaveLocation != "") mSaveCircuits = true;
+
+	// losing the saved circuits is no reason to stop serving
+	if (saveLocation != "")
+	{
+		if (mArchive.OpenForAppend(saveLocation)) sysout << "[+] Saving circuits to archive: " << saveLocation << ", " << (unsigned int)mArchive.Size() << " circuits" << std::endl;
+		else syserr << "Can't open the circuit archive, circuits are not saved: " << saveLocation << std::endl;
+	}
+
+	mCache.SetCapacity(cacheSize);
+
+	if (!mSolverPool.Start(solverThreads))
+	{
+		syserr << "Failed to start the maxlist solver threads" << std::endl;
+		return false;
+	}
 
 	if (!ReadConfig(confBase, maxListConfig)) return false;
+
+	if (!mOrderFile.empty())
+	{
+		if (mListOrder.Load(mOrderFile)) sysout << "[+] Loaded maxlist statistics: " << mOrderFile << std::endl;
+		else sysout << "[+] No maxlist statistics, starting from config order: " << mOrderFile << std::endl;
+	}
 	return true;
 }
 
@@ -67,18 +91,26 @@ bool MaxLists::ReadConfig(std::string basedir, std::string filename)
 {
 	sysout << "[+] Reading maxlist config" << std::endl;
 	mBaseDir = basedir;
-	std::fstream file((mBaseDir + filename).c_str());
-	if (!file.is_open())
+
+	// cached solutions refer to the old lists by index
+	mMaxLists.clear();
+	mListNames.clear();
+	mIndices.clear();
+	mCache.Clear();
+	mStats.clear();
+
+	std::string contents;
+	if (!ReadWholeFile(mBaseDir + filename, contents))
 	{
 		syserr << "Can't find maxlist: " << filename << std::endl;
 		return false;
 	}
 
-	while(!file.eof())
+	LineCursor lines(contents);
+	StringView line;
+	while(lines.Next(line))
 	{
-		std::string str;
-		getline(file,str);
-
+		std::string str = line.str();
 		if (!ReadMaxList(str))
 		{
 			syserr << "failed on : " << str << std::endl;
@@ -86,6 +118,10 @@ bool MaxLists::ReadConfig(std::string basedir, std::string filename)
 		}
 	}
 
+	// what was learned about lists that are still there is kept
+	mListOrder.SetLists(std::vector<std::string>(mListNames.begin(), mListNames.end()));
+
+	OpenSolutionStore();
 	return true;
 }
 
@@ -99,7 +135,7 @@ bool MaxLists::ReadMaxList(std::string filename)
 	NetList2 aNetList;
 	try
 	{
-		ListParser parser(mCompDefs);
+		ListParser parser(mCompDefs, true);
 		if (!parser.ParseFile(mBaseDir + filename))
 		{
 			syserr << "Failed to parse maxlist: " << filename << std::endl;
@@ -117,6 +153,13 @@ bool MaxLists::ReadMaxList(std::string filename)
 
 	mMaxLists.push_back(aNetList);
 	mListNames.push_back(filename); // XXX: Store in a pair instead
+
+	mIndices.push_back(MaxListIndex());
+	mIndices.back().Build(aNetList.GetNodeList());
+
+	ListStats stats;
+	stats.name = filename;
+	mStats.push_back(stats);
 	return true;
 }
 
@@ -150,8 +193,12 @@ bool MaxLists::CheckMaxValues(InstrumentBlock* pBlock, const NetList2& maxlist)
 	return true;
 }
 
-bool MaxLists::CircuitToNetlist(InstrumentBlock* block)
+bool MaxLists::CircuitToNetlist(InstrumentBlock* block, CacheOutcome* pOutcome)
 {
+	CacheOutcome outcome;
+	if (!pOutcome) pOutcome = &outcome;
+	*pOutcome = eNotCached;
+
 	if (block->GetNodeInterpreter()->GetCircuitList().empty())
 	{
 		// don't bother.. just reset the "solved" netlist
@@ -174,53 +221,305 @@ bool MaxLists::CircuitToNetlist(InstrumentBlock* block)
 		return false;
 	}
 
-	if (mSaveCircuits) SaveCircuits(block->GetNodeInterpreter()->GetCircuitList());
+	// written by the archive's own thread
+	if (mArchive.IsOpen()) mArchive.Add(block->GetNodeInterpreter()->GetCircuitList(), (unsigned int)time(NULL));
 
 	timer circuittimer;
 
-	tListNames::const_iterator nameit = mListNames.begin();
-
+	// this requires the fgen and tripledc to be set up properly..
+	// may be that they are not yet validated.. can that be a problem?
+	std::vector<bool> allowed;
+	allowed.reserve(mMaxLists.size());
 	for(tMaxLists::const_iterator it = mMaxLists.begin(); it != mMaxLists.end(); ++it)
 	{
-		// this requires the fgen and tripledc to be set up properly..
-		// may be that they are not yet validated.. can that be a problem?
-		if (!CheckMaxValues(block, *it))
+		allowed.push_back(CheckMaxValues(block, *it));
+	}
+
+	// students resend the same circuit over and over, skip the search if we have seen it
+	std::string key;
+	if (mCache.GetCapacity() > 0 || mStore.IsOpen())
+	{
+		key = CacheKey(circuitparser.GetList(), allowed);
+		const SolutionCache::Entry* pEntry = mCache.Find(key);
+		if (pEntry)
+		{
+			LogLevel(sysout, 4) << "Solution cache hit, maxlist: " << pEntry->maxlist << " (" << (unsigned int)mCache.NumHits() << " hits, " << (unsigned int)mCache.NumMisses() << " misses)" << std::endl;
+			*pOutcome = eCacheHit;
+			if (!pEntry->solved) return false;
+
+			block->GetNodeInterpreter()->SetNetList(pEntry->netlist);
+			return true;
+		}
+
+		SolutionCache::Entry stored;
+		if (mStore.Find(key, stored))
+		{
+			LogLevel(sysout, 4) << "Solution store hit, maxlist: " << stored.maxlist << std::endl;
+			mCache.Insert(key, stored);
+			*pOutcome = eCacheHit;
+			if (!stored.solved) return false;
+
+			block->GetNodeInterpreter()->SetNetList(stored.netlist);
+			return true;
+		}
+	}
+
+	// a list that has fewer of some component than the circuit places can't solve it
+	MaxListIndex::tCounts needed;
+	{
+		CircuitSolver3 solver;
+		SolverPool::tCircuit placed;
+		solver.GetPlacedComponents(circuitparser.GetList(), placed);
+		MaxListIndex::Count(placed, needed);
+	}
+
+	SolverPool::tMaxLists candidates;
+	candidates.reserve(mMaxLists.size());
+	tListNames::const_iterator nameit = mListNames.begin();
+	int index = 0;
+	for(tMaxLists::const_iterator it = mMaxLists.begin(); it != mMaxLists.end(); ++it, ++nameit, ++index)
+	{
+		if (!allowed[index])
 		{
 			syslog << "Limits exceeded, skipping: " << *nameit << std::endl;
+			candidates.push_back(NULL);
 		}
-		else
+		else if (!mIndices[index].CanContain(needed))
 		{
-			CircuitList aList;
-			if (aList.Solve(circuitparser.GetList(), it->GetNodeList()))
-			{
-				NetList2 solvednetlist;
-				solvednetlist.SetNodeList(aList.GetSolution());
-
-				// ugly fix.. this should be done inside the solver
-				// the problem is that instrument nodes can be introduces that is not allowed
-				if (!solvednetlist.IsSubsetOf(*it))
-				{
-					LogLevel(sysout, 4) << "solved but not a subset of: " << *nameit << std::endl;
-					continue;
-				}
-
-				LogLevel(sysout, 4) << "Matching maxlist: " << *nameit << std::endl;
-				LogLevel(sysout, 4) << "Solved list is:" << std::endl << solvednetlist.GetNetListAsString() << std::endl;
-
-				block->GetNodeInterpreter()->SetNetList(solvednetlist);
-				LogLevel(timerlog, 4) << timestamp << "MaxLists::CircuitToNetlist solved after: " << circuittimer.elapsed() << std::endl;
-				return true;
-			}
+			LogLevel(sysout, 4) << "Components missing, skipping: " << *nameit << std::endl;
+			mStats[index].skipped++;
+			candidates.push_back(NULL);
 		}
+		else candidates.push_back(&(*it));
+	}
 
-		++nameit;
+	// the lists are searched in parallel, but the first matching one in config order is picked unless told otherwise
+	SolverBudget budget(mCircuitNodes, mCircuitSeconds);
+	NetList2 solvednetlist;
+	SolverPool::tResults results;
+	SolverPool::tStats stats;
+	const ListOrder::tOrder& order = mListOrder.GetOrder();
+	int solved = -1;
+	if (mOrderMode == eLearnedOrder)
+	{
+		// the first match in the learned order wins, the lists are permuted and the outcome mapped back
+		SolverPool::tMaxLists ordered;
+		ordered.reserve(candidates.size());
+		for(size_t i = 0; i < order.size(); ++i) ordered.push_back(candidates[order[i]]);
+
+		SolverPool::tResults orderedResults;
+		SolverPool::tStats orderedStats;
+		int first = mSolverPool.SolveFirst(circuitparser.GetList(), ordered, solvednetlist, orderedResults, orderedStats, &budget);
+
+		results.resize(orderedResults.size());
+		stats.resize(orderedStats.size());
+		for(size_t i = 0; i < order.size(); ++i)
+		{
+			results[order[i]] = orderedResults[i];
+			stats[order[i]] = orderedStats[i];
+		}
+		if (first >= 0) solved = (int)order[first];
+	}
+	else
+	{
+		solved = mSolverPool.SolveFirst(circuitparser.GetList(), candidates, solvednetlist, results, stats, &budget,
+			(mOrderMode == eConfirmedOrder) ? &order : NULL);
+	}
+
+	AddSolverStats(results, stats);
+
+	bool tooComplex = false;
+	nameit = mListNames.begin();
+	for(size_t i = 0; i < results.size(); ++i, ++nameit)
+	{
+		if (results[i] == SolverPool::eTooComplex)
+		{
+			syslog << "Solver ran out of budget on: " << *nameit << " after " << (unsigned int)stats[i].nodes << " nodes" << std::endl;
+			tooComplex = true;
+		}
+		else if (results[i] == SolverPool::eNotSubset) LogLevel(sysout, 4) << "solved but not a subset of: " << *nameit << std::endl;
+		else if (results[i] == SolverPool::eSolved && (int)i == solved)
+		{
+			LogLevel(sysout, 4) << "Matching maxlist: " << *nameit << std::endl;
+			LogLevel(sysout, 4) << "Solved list is:" << std::endl << solvednetlist.GetNetListAsString() << std::endl;
+		}
+	}
+
+	if (solved >= 0)
+	{
+		// an earlier list may have solved it with more budget, so it isn't the answer to remember
+		if (!key.empty() && !tooComplex)
+		{
+			SolutionCache::Entry entry;
+			entry.solved	= true;
+			entry.maxlist	= solved;
+			entry.netlist	= solvednetlist;
+			mCache.Insert(key, entry);
+			*pOutcome = eCached;
+		}
+		else if (tooComplex) *pOutcome = eTooComplex;
+
+		block->GetNodeInterpreter()->SetNetList(solvednetlist);
+		LogLevel(timerlog, 4) << timestamp << "MaxLists::CircuitToNetlist solved after: " << circuittimer.elapsed() << std::endl;
+		return true;
 	}
 
 	syslog << "MaxLists::CircuitToNetlist failed to solve after: " << circuittimer.elapsed() << std::endl;
 
+	// not cached, the outcome depends on the budget and the load
+	if (tooComplex)
+	{
+		*pOutcome = eTooComplex;
+		throw ValidationException("The circuit is too complex to solve. Try to simplify it.");
+	}
+
+	if (!key.empty())
+	{
+		SolutionCache::Entry entry;
+		entry.solved	= false;
+		entry.maxlist	= -1;
+		mCache.Insert(key, entry);
+		*pOutcome = eCached;
+	}
+
 	return false;
 }
 
+void MaxLists::SetSolverBudget(size_t solveNodes, double solveSeconds, size_t circuitNodes, double circuitSeconds)
+{
+	mSolverPool.SetBudget(solveNodes, solveSeconds);
+	mCircuitNodes = circuitNodes;
+	mCircuitSeconds = circuitSeconds;
+}
+
+void MaxLists::AddSolverStats(const SolverPool::tResults& results, const SolverPool::tStats& stats)
+{
+	for(size_t i = 0; i < results.size() && i < mStats.size(); ++i)
+	{
+		if (stats[i].nodes == 0 && results[i] == SolverPool::eNotTried) continue;
+
+		ListStats& list = mStats[i];
+		list.searches++;
+		if (results[i] == SolverPool::eSolved) list.solved++;
+		if (results[i] == SolverPool::eTooComplex) list.tooComplex++;
+		list.work.Add(stats[i]);
+
+		if (results[i] != SolverPool::eNotTried) mListOrder.Add(i, results[i] == SolverPool::eSolved, stats[i].seconds);
+	}
+	mListOrder.Update();
+
+	mCircuits++;
+	if (mStatsInterval > 0 && (mCircuits % mStatsInterval) == 0)
+	{
+		LogSolverStats();
+		SaveListOrder();
+	}
+}
+
+void MaxLists::SaveListOrder() const
+{
+	if (mOrderFile.empty()) return;
+	if (!mListOrder.Save(mOrderFile)) syserr << "Failed to save maxlist statistics: " << mOrderFile << std::endl;
+}
+
+void MaxLists::LogSolverStats() const
+{
+	syslog << "Solver stats after " << (unsigned int)mCircuits << " searched circuits" << std::endl;
+	for(tListStats::const_iterator it = mStats.begin(); it != mStats.end(); ++it)
+	{
+		syslog << "  " << it->name << ": "
+			<< (unsigned int)it->searches << " searches, "
+			<< (unsigned int)it->solved << " solved, "
+			<< (unsigned int)it->tooComplex << " too complex, "
+			<< (unsigned int)it->skipped << " skipped, "
+			<< (unsigned int)it->work.nodes << " nodes, "
+			<< (unsigned int)it->work.backtracks << " backtracks, "
+			<< (unsigned int)it->work.shortcutSearches << " shortcut searches, "
+			<< it->work.seconds << "s" << std::endl;
+	}
+
+	if (mOrderMode == eConfigOrder) return;
+	std::string names;
+	const ListOrder::tOrder& order = mListOrder.GetOrder();
+	for(ListOrder::tOrder::const_iterator it = order.begin(); it != order.end(); ++it)
+	{
+		names += " " + mListOrder.GetEntries()[*it].name;
+	}
+	syslog << "Maxlist order:" << names << std::endl;
+}
+
+void MaxLists::Normalize(const ListComponent::tComponentList& components, std::ostream& out)
+{
+	// the parsed list is the normalized form, whitespace and formatting of the text doesn't matter
+	for(ListComponent::tComponentList::const_iterator it = components.begin(); it != components.end(); ++it)
+	{
+		out << it->GetType() << '\x1f' << it->GetName() << '\x1f' << it->GetValue() << '\x1f' << it->GetSpecial() << '\x1f' << (unsigned int)it->GetGroup();
+		const ListComponent::tConnections& connections = it->GetCConnections();
+		for(ListComponent::tConnections::const_iterator conit = connections.begin(); conit != connections.end(); ++conit)
+		{
+			out << '\x1f' << *conit;
+		}
+		out << '\n';
+	}
+}
+
+std::string MaxLists::CacheKey(const ListComponent::tComponentList& circuit, const std::vector<bool>& allowed) const
+{
+	std::stringstream normalized;
+	Normalize(circuit, normalized);
+
+	std::string text = normalized.str();
+	unsigned char md5sum[16];
+	md5((unsigned char*)text.c_str(), (int)text.size(), md5sum);
+
+	std::string key((const char*)md5sum, sizeof(md5sum));
+	for(std::vector<bool>::const_iterator it = allowed.begin(); it != allowed.end(); ++it)
+	{
+		key += (*it) ? '1' : '0';
+	}
+
+	// the other modes give the config order answer, in learned order it depends on the order used
+	if (mOrderMode == eLearnedOrder)
+	{
+		key += 'L';
+		const ListOrder::tOrder& order = mListOrder.GetOrder();
+		for(ListOrder::tOrder::const_iterator it = order.begin(); it != order.end(); ++it)
+		{
+			key += ToString((unsigned int)*it) + ",";
+		}
+	}
+	return key;
+}
+
+std::string MaxLists::Fingerprint() const
+{
+	// the list names don't matter, a renamed list solves the same circuits
+	std::stringstream normalized;
+	for(ListParser::tComponentDefinitions::const_iterator it = mCompDefs.begin(); it != mCompDefs.end(); ++it)
+	{
+		normalized << it->Type() << '\x1f' << it->NumConnections() << '\x1f' << it->CanTurn() << '\x1f' << it->IgnoreValue() << '\x1f' << it->HasSpecialValue() << '\n';
+	}
+	for(tMaxLists::const_iterator it = mMaxLists.begin(); it != mMaxLists.end(); ++it)
+	{
+		normalized << '\x1e' << '\n';
+		Normalize(it->GetNodeList(), normalized);
+	}
+
+	std::string text = normalized.str();
+	unsigned char md5sum[16];
+	md5((unsigned char*)text.c_str(), (int)text.size(), md5sum);
+	return std::string((const char*)md5sum, sizeof(md5sum));
+}
+
+void MaxLists::OpenSolutionStore()
+{
+	mStore.Close();
+	if (mStoreFile.empty()) return;
+
+	if (mStore.Open(mStoreFile, Fingerprint())) sysout << "[+] Mapped solution store: " << mStoreFile << ", " << (unsigned int)mStore.Size() << " circuits" << std::endl;
+	else syserr << "Solution store missing, damaged or built for other maxlists, not used: " << mStoreFile << std::endl;
+}
+
 bool MaxLists::IsSubsetsOfComponentlist(const NetList2& componentlist)
 {
 	bool rv = true;
@@ -243,39 +542,3 @@ bool MaxLists::IsSubsetsOfComponentlist(const NetList2& componentlist)
 
 	return rv;
 }
-
-void MaxLists::SaveCircuits(const std::string& circuit)
-{
-	unsigned char md5sum[16];
-	md5((unsigned char*)circuit.c_str(), circuit.size(), md5sum);
-
-	char output[33];
-	for( int i = 0; i < 16; ++i )
-	{
-		sprintf(&output[i*2] , "%02x", md5sum[i]);
-	}
-	output[32] = '\0';
-
-	LogLevel(sysout, 3) << "Circuit checksum: " << output << std::endl;
-
-	std::string filename = mSaveLocation + output + ".circuit";
-	FILE* testfile = fopen(filename.c_str(), "r");
-	if (testfile != NULL)
-	{
-		fclose(testfile);
-		return; // file does already exist, we don't have to write the data
-	}
-
-	LogLevel(sysout, 3) << "Saving to file: " << filename << std::endl;
-
-	FILE* savefile = fopen(filename.c_str(), "w");
-	if (!savefile)
-	{
-		syserr << "Failed to write circuit to file" << std::endl;
-		return;
-	}
-
-	fwrite(circuit.c_str(), circuit.size(), 1, savefile);
-
-	fclose(savefile);
-}
\ No newline at end of file
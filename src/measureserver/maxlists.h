@@ -29,11 +29,19 @@
 #ifndef __SERVICE_MAXLISTS_H__
 #define __SERVICE_MAXLISTS_H__
 
+#include "circuitarchive.h"
+#include "listorder.h"
+#include "solutioncache.h"
+#include "solutionstore.h"
+#include "solverpool.h"
+
+#include <instruments/maxlistindex.h>
 #include <instruments/netlist2.h>
 #include <instruments/listparser.h>
 
 #include <list>
 #include <string>
+#include <vector>
 
 class InstrumentBlock;
 class Service;
@@ -45,15 +53,76 @@ public:
 		const std::string& confBase,
 		const std::string& maxListConfig,
 		const std::string& saveLocation,
-		const ListParser::tComponentDefinitions& compdefs
+		const ListParser::tComponentDefinitions& compdefs,
+		size_t cacheSize = 0,
+		int solverThreads = 0
 		);
 
+	/// Read (or reread) the maxlists, the solution cache is invalidated
 	bool ReadConfig(std::string basedir, std::string filename);
+
+	enum ListOrderMode
+	{
+		eConfigOrder,		///< try the maxlists in config order
+		eConfirmedOrder,	///< try them in learned order, a match is confirmed against the earlier lists in the config
+		eLearnedOrder		///< try them in learned order, the first match wins. Opt in, the answer depends on
+							///< the history and the order file, cached answers are only reused with the same order
+	};
+
+	/// How the maxlists are tried and where the learned order is kept between restarts, empty to not keep it.
+	/// Set it before Init
+	void SetListOrder(int mode, const std::string& statsFile) { mOrderMode = mode; mOrderFile = statsFile; }
+	const ListOrder&	GetListOrder() const { return mListOrder; }
+
+	/// Search heuristics used by the solver, see CircuitSolver3::SetHeuristics
+	void SetSolverHeuristics(int heuristics) { mSolverPool.SetHeuristics(heuristics); }
 	bool CheckAndValidate(InstrumentBlock* block);
-	bool CircuitToNetlist(InstrumentBlock* block);
+
+	/// Where the answer of CircuitToNetlist came from
+	enum CacheOutcome
+	{
+		eNotCached,		///< unparsable circuit or no cache
+		eCacheHit,		///< found in the solution cache or the store
+		eCached,		///< searched, the answer is now in the cache
+		eTooComplex		///< a list ran out of budget, the answer isn't cached
+	};
+	bool CircuitToNetlist(InstrumentBlock* block, CacheOutcome* pOutcome = NULL);
 
 	bool	IsSubsetsOfComponentlist(const NetList2& componentlist);
 
+	const SolutionCache&	GetSolutionCache() const { return mCache; }
+
+	/// Prebuilt solutions looked up when the cache misses, empty to not use one. Set it before Init
+	void	SetSolutionStore(const std::string& filename) { mStoreFile = filename; }
+	const SolutionStore&	GetSolutionStore() const { return mStore; }
+
+	/// Hash of the component types and the maxlists, solutions are only valid for the same fingerprint
+	std::string	Fingerprint() const;
+
+	/// Work limits for each maxlist search and for all searches on one circuit, 0 means no limit.
+	/// A circuit that runs out of budget is rejected as too complex
+	void	SetSolverBudget(size_t solveNodes, double solveSeconds, size_t circuitNodes, double circuitSeconds);
+
+	/// Totals of the searches done on one maxlist since it was read
+	struct ListStats
+	{
+		std::string	name;
+		size_t		searches;
+		size_t		solved;
+		size_t		tooComplex;
+		size_t		skipped;	///< searches avoided because the list lacks some component
+		SolverStats	work;
+
+		ListStats() : searches(0), solved(0), tooComplex(0), skipped(0) {}
+	};
+	typedef std::vector<ListStats>	tListStats;
+
+	const tListStats&	GetSolverStats() const { return mStats; }
+
+	/// Log the solver totals every interval circuits, 0 turns it off
+	void	SetStatsInterval(size_t interval) { mStatsInterval = interval; }
+	void	LogSolverStats() const;
+
 	MaxLists();
 	virtual ~MaxLists();
 private:
@@ -62,19 +131,45 @@ private:
 	bool ReadMaxList(std::string filename);
 	bool CheckMaxValues(InstrumentBlock* block, const NetList2& maxlist);
 
+	/// Hash of the parsed circuit and the maxlists the instrument limits allow
+	std::string CacheKey(const ListComponent::tComponentList& circuit, const std::vector<bool>& allowed) const;
+	static void	Normalize(const ListComponent::tComponentList& components, std::ostream& out);
+
+	void	OpenSolutionStore();
+
+	void	AddSolverStats(const SolverPool::tResults& results, const SolverPool::tStats& stats);
+	void	SaveListOrder() const;
+
 	typedef std::list<NetList2>	tMaxLists;
 	tMaxLists mMaxLists;
 
 	typedef std::list<std::string>	tListNames;
 	tListNames mListNames;
 
+	typedef std::vector<MaxListIndex>	tIndices;
+	tIndices	mIndices;		// one per maxlist
+
 	std::string mBaseDir;
 
-	bool		mSaveCircuits;
-	std::string	mSaveLocation;
-	void		SaveCircuits(const std::string& circuit);
+	CircuitArchive	mArchive;
 	
 	ListParser::tComponentDefinitions mCompDefs;
+
+	SolutionCache	mCache;
+	SolutionStore	mStore;
+	std::string		mStoreFile;
+	SolverPool		mSolverPool;
+
+	size_t			mCircuitNodes;
+	double			mCircuitSeconds;
+
+	tListStats		mStats;		// one per maxlist
+	size_t			mStatsInterval;
+	size_t			mCircuits;
+
+	ListOrder		mListOrder;
+	int				mOrderMode;
+	std::string		mOrderFile;
 };
 
 #endif
@@ -99,10 +99,18 @@ TransactionRequest* ServerProtocolService::ProcessTransaction(protocol::Transact
 		else LogLevel(timerlog,4) << timestamp << "ServerProtocolService::ProcessTransaction: clientid=" << pClient->ClientID() << std::endl;
 		if (!pRequest->BuildRequest())
 		{
+			pTransaction->GetIssuer()->TransactionError(pTransaction, "Unable to prepare the transaction", protocol::Fatal);
 			delete pRequest;
 			return NULL;
 		}
 	}
+	catch(ValidationException e)
+	{
+		// rejected before it had to wait in the queue
+		pTransaction->GetIssuer()->TransactionError(pTransaction, e.what(), protocol::Notification);
+		delete pRequest;
+		return NULL;
+	}
 	catch(BasicException e)
 	{
 		pTransaction->GetIssuer()->TransactionError(pTransaction, e.what(), protocol::Fatal);
@@ -110,9 +118,21 @@ TransactionRequest* ServerProtocolService::ProcessTransaction(protocol::Transact
 		return NULL;
 	}
 
-	if (pSession) pSession->SetActiveTransaction(pTransaction);
+	// logins and heartbeats shouldn't wait behind the measurements, or time out while doing so
+	if (!pHandler->NeedsEquipment())
+	{
+		if (pSession) pSession->SetActiveTransaction(pTransaction);
+		return mpRequestQueue->PerformNow(pRequest) ? pRequest : NULL;
+	}
 
-	mpRequestQueue->AddRequest(pRequest);
+	if (!mpRequestQueue->AddRequest(pRequest))
+	{
+		pTransaction->GetIssuer()->TransactionError(pTransaction, "Too many requests waiting for this session", protocol::Notification);
+		delete pRequest;
+		return NULL;
+	}
+
+	if (pSession) pSession->SetActiveTransaction(pTransaction);
 	return pRequest;
 }
 
@@ -0,0 +1,201 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "reactor.h"
+#include "gateway.h"
+
+#include <protocol/protocol.h>
+#include <xmlprotocol/producer.h>
+#include <instruments/instrumentblock.h>
+#include <util/atomic.h>
+#include <syslog.h>
+
+#include <sstream>
+
+Reactor::Reactor(ProtocolGateway* pGateway, const std::string& crossDomainPolicy)
+	: mWakeup(this)
+{
+	mpGateway			= pGateway;
+	mpMultiplexer		= NULL;
+	mOwnsMultiplexer	= false;
+	mCrossDomainPolicy	= crossDomainPolicy;
+	mLastChannel		= 0;
+	mRunning			= 0;
+}
+
+Reactor::~Reactor()
+{
+	Stop();
+
+	if (mpMultiplexer) mpMultiplexer->RemoveHandler(&mWakeup);
+
+	// messages nobody is going to read
+	GatewayMessage msg;
+	while(mToReactor.Pop(msg))
+	{
+		delete msg.pData;
+		delete msg.pTransaction;
+		delete msg.pBlock;
+	}
+	while(mToScheduler.Pop(msg)) delete msg.pTransaction;
+
+	if (mOwnsMultiplexer) delete mpMultiplexer;
+}
+
+bool Reactor::Init(Net::Multiplexer* pShared, Net::Multiplexer::BackendType type)
+{
+	if (pShared)
+	{
+		mpMultiplexer = pShared;
+		mOwnsMultiplexer = false;
+	}
+	else
+	{
+		mpMultiplexer = new Net::Multiplexer();
+		mOwnsMultiplexer = true;
+		if (!mpMultiplexer->Init(type)) return false;
+	}
+
+	if (!mWakeup.Init()) return false;
+	mpMultiplexer->AddHandler(&mWakeup);
+	return true;
+}
+
+bool Reactor::StartThread()
+{
+	AtomicStore(&mRunning, 1);
+	if (!Start())
+	{
+		AtomicStore(&mRunning, 0);
+		return false;
+	}
+	return true;
+}
+
+void Reactor::Stop()
+{
+	if (!IsStarted()) return;
+	AtomicStore(&mRunning, 0);
+	mWakeup.Signal();
+	Join();
+}
+
+void Reactor::Run()
+{
+	while(AtomicLoad(&mRunning))
+	{
+		if (!mpMultiplexer->WaitForEvent(1000))
+		{
+			syserr << timestamp << "Reactor multiplexer failed, no more connections are served by this thread" << std::endl;
+			break;
+		}
+
+		mpMultiplexer->HouseKeeping();
+	}
+}
+
+unsigned int Reactor::OpenChannel(ChannelEndpoint* pEndpoint, int flags)
+{
+	unsigned int channel = ++mLastChannel;
+	mEndpoints[channel] = pEndpoint;
+
+	GatewayMessage msg = { GatewayMessage::eOpen, channel, flags, NULL, NULL, NULL };
+	mToScheduler.Push(msg);
+	mpGateway->Signal();
+	return channel;
+}
+
+void Reactor::Submit(unsigned int channel, protocol::Transaction* pTransaction)
+{
+	GatewayMessage msg = { GatewayMessage::eTransaction, channel, 0, pTransaction, NULL, NULL };
+	mToScheduler.Push(msg);
+	mpGateway->Signal();
+}
+
+void Reactor::CloseChannel(unsigned int channel)
+{
+	mEndpoints.erase(channel);
+
+	GatewayMessage msg = { GatewayMessage::eClose, channel, 0, NULL, NULL, NULL };
+	mToScheduler.Push(msg);
+	mpGateway->Signal();
+}
+
+void Reactor::Post(const GatewayMessage& msg)
+{
+	mToReactor.Push(msg);
+	mWakeup.Signal();
+}
+
+bool Reactor::Receive(GatewayMessage& msg)
+{
+	return mToScheduler.Pop(msg);
+}
+
+void Reactor::WokenUp()
+{
+	GatewayMessage msg;
+	while(mToReactor.Pop(msg)) Dispatch(msg);
+}
+
+void Reactor::Dispatch(GatewayMessage& msg)
+{
+	// the connection may be gone already, then the message is dropped
+	tEndpoints::iterator it = mEndpoints.find(msg.channel);
+	if (it != mEndpoints.end())
+	{
+		ChannelEndpoint* pEndpoint = it->second;
+		switch(msg.type)
+		{
+		case GatewayMessage::eCompleted:	ProduceResponse(pEndpoint, msg);		break;
+		case GatewayMessage::eResponse:		pEndpoint->ChannelResponse(*msg.pData);	break;
+		case GatewayMessage::eError:		pEndpoint->ChannelError(*msg.pData);	break;
+		case GatewayMessage::eSessionGone:	pEndpoint->ChannelSessionGone();		break;
+		case GatewayMessage::eRejected:		pEndpoint->ChannelRejected(*msg.pData);	break;
+		default: break;
+		}
+	}
+
+	delete msg.pData;
+	delete msg.pTransaction;
+	delete msg.pBlock;
+}
+
+void Reactor::ProduceResponse(ChannelEndpoint* pEndpoint, GatewayMessage& msg)
+{
+	std::stringstream out;
+	xmlprotocol::XmlProducer::TransactionResponse(msg.pTransaction, msg.pBlock, out, this);
+
+	if (msg.pTransaction->GetErrorState() != protocol::NoError)
+	{
+		pEndpoint->ChannelError(msg.pTransaction->GetError());
+		return;
+	}
+
+	std::string response = out.str();
+	pEndpoint->ChannelResponse(response);
+}
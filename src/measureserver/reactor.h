@@ -0,0 +1,142 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __REACTOR_H__
+#define __REACTOR_H__
+
+#include <network/multiplexer.h>
+#include <network/wakeup.h>
+#include <protocol/protocol.h>
+#include <util/thread.h>
+#include <util/spscqueue.h>
+
+#include <map>
+#include <string>
+
+class InstrumentBlock;
+class ProtocolGateway;
+
+/// Message passed between an I/O reactor and the scheduler thread
+struct GatewayMessage
+{
+	enum Type
+	{
+		// reactor to scheduler
+		eOpen,			///< a connection was accepted, flags holds the channel flags
+		eTransaction,	///< a parsed transaction, ownership is passed along
+		eClose,			///< the connection is gone
+
+		// scheduler to reactor
+		eCompleted,		///< finished transaction, its response is produced from the instrument snapshot in pBlock
+		eResponse,		///< serialized response in pData
+		eError,			///< error message in pData
+		eSessionGone,	///< the session was destroyed, the connection should close
+		eRejected,		///< no client could be created, error message in pData
+	};
+
+	Type					type;
+	unsigned int			channel;
+	int						flags;
+	protocol::Transaction*	pTransaction;
+	std::string*			pData;
+	InstrumentBlock*		pBlock;
+};
+
+/// Connection side of a channel, always called in the reactor thread
+class ChannelEndpoint
+{
+public:
+	///				The response is taken over without copying
+	virtual void	ChannelResponse(std::string& response) = 0;
+	virtual void	ChannelError(const std::string& msg) = 0;
+	virtual void	ChannelSessionGone() = 0;
+	virtual void	ChannelRejected(const std::string& msg) = 0;
+
+	virtual ~ChannelEndpoint() {}
+};
+
+/// I/O reactor.
+/// Runs the protocol connections on its own multiplexer, parses the requests and produces the responses.
+/// Transactions are handed to the scheduler thread through lock free queues, so the equipment
+/// is still only touched by one thread. A reactor without a thread runs on the schedulers multiplexer.
+class Reactor : public Thread, public Net::WakeupListener, public protocol::IProtocolService
+{
+public:
+	enum ChannelFlags
+	{
+		eRequireSession		= 0x01,		///< responses are only produced for clients bound to a session
+		eOneTransaction		= 0x02,		///< reject transactions while one is in flight
+	};
+
+	///				pShared: run on this multiplexer in the calling thread instead of starting a thread
+	bool			Init(Net::Multiplexer* pShared, Net::Multiplexer::BackendType type);
+
+	///				Start the reactor thread, not used for shared reactors
+	bool			StartThread();
+
+	///				Stop and join the reactor thread
+	void			Stop();
+
+	Net::Multiplexer*	GetMultiplexer()	{ return mpMultiplexer; }
+	Net::TimerQueue*	GetTimerQueue()		{ return mpMultiplexer->GetTimerQueue(); }
+	virtual const char*	GetCrossDomainPolicy() { return mCrossDomainPolicy.c_str(); }
+
+	// reactor thread
+	unsigned int	OpenChannel(ChannelEndpoint* pEndpoint, int flags);
+	void			Submit(unsigned int channel, protocol::Transaction* pTransaction);
+	void			CloseChannel(unsigned int channel);
+
+	// scheduler thread
+	void			Post(const GatewayMessage& msg);
+	bool			Receive(GatewayMessage& msg);
+
+	virtual void	Run();
+	virtual void	WokenUp();
+
+	Reactor(ProtocolGateway* pGateway, const std::string& crossDomainPolicy);
+	virtual ~Reactor();
+private:
+	void			Dispatch(GatewayMessage& msg);
+	void			ProduceResponse(ChannelEndpoint* pEndpoint, GatewayMessage& msg);
+
+	typedef std::map<unsigned int, ChannelEndpoint*> tEndpoints;
+
+	ProtocolGateway*				mpGateway;
+	Net::Multiplexer*				mpMultiplexer;
+	bool							mOwnsMultiplexer;
+	Net::Wakeup						mWakeup;
+	std::string						mCrossDomainPolicy;
+
+	tEndpoints						mEndpoints;
+	unsigned int					mLastChannel;
+	volatile int					mRunning;
+
+	SPSCQueue<GatewayMessage>		mToScheduler;
+	SPSCQueue<GatewayMessage>		mToReactor;
+};
+
+#endif
@@ -28,6 +28,11 @@
 #ifndef __REQUEST_H__
 #define __REQUEST_H__
 
+#include <timer.h>
+
+#include <string>
+#include <vector>
+
 // forward decl.
 class Client;
 class RequestQueue;
@@ -51,11 +56,19 @@ public:
 	///						Get the owner, the client, who issued the request
 	Client*					GetOwner();
 
+	///						Sorted names of the equipment components the request switches in, NULL if not known
+	virtual const std::vector<std::string>*	GetSwitched() { return NULL; }
+
+	///						Seconds since the request arrived, queueing included
+	double					TimeSinceArrival() { return mArrival.elapsed(); }
+
 	Request(RequestQueue* pQueue, Client* pOwner);
 	virtual ~Request();
 protected:
 	Client*			mpOwner;
 	RequestQueue*	mpQueue;
+private:
+	timer			mArrival;
 };
 
 #endif
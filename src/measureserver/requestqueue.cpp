@@ -26,90 +26,210 @@
  */
 
 #include "requestqueue.h"
+#include "requestscheduler.h"
 #include "request.h"
+#include "client.h"
+#include "session.h"
 
 #include <basic_exception.h>
 #include <syslog.h>
 
-RequestQueue::RequestQueue()
+#include <algorithm>
+#include <vector>
+
+void RequestLatency::Add(double seconds)
 {
-	mWaiting = false;
+	count++;
+	total += seconds;
+	if (seconds > max) max = seconds;
+}
+
+RequestQueue::RequestQueue(Net::TimerQueue* pTimers, SchedulerType type, size_t maxPerSession, size_t relayWindow)
+{
+	mpTimers = pTimers;
+	switch(type)
+	{
+	case eFair:		mpScheduler = CreateFairScheduler();			break;
+	case eRelay:	mpScheduler = CreateRelayScheduler(relayWindow);	break;
+	default:		mpScheduler = CreateFifoScheduler();			break;
+	}
+	mpCurrent = NULL;
+	mMaxPerSession = maxPerSession;
 	mHandledRequests = 0;
+	mStatsInterval = 0;
 }
 
 RequestQueue::~RequestQueue()
 {
-	while(!mQueue.empty())
+	delete mpCurrent;
+
+	while(!mpScheduler->Empty())
+	{
+		delete mpScheduler->Pop();
+	}
+	delete mpScheduler;
+
+	while(!mImmediate.empty())
 	{
-		delete mQueue.front();
-		mQueue.pop_front();
+		delete mImmediate.front();
+		mImmediate.pop_front();
 	}
 }
 
-void RequestQueue::AddRequest(Request* request)
+bool RequestQueue::AddRequest(Request* request)
 {
-	mQueue.push_back(request);
+	Client* pOwner = request->GetOwner();
+	Session* pSession = pOwner ? pOwner->GetSession() : NULL;
+
+	Queued queued;
+	queued.owner	= pOwner;
+	queued.flow		= pSession ? (const void*) pSession : (const void*) pOwner;
+	queued.priority	= pSession ? pSession->GetPriority() : 0;
+
+	tDepths::iterator depth = mDepths.insert(std::make_pair(queued.flow, 0)).first;
+	if (mMaxPerSession > 0 && depth->second >= mMaxPerSession) return false;
+	depth->second++;
+
+	mQueued[request] = queued;
+	mByClient.insert(std::make_pair(pOwner, request));
+	mpScheduler->Push(request, queued.flow, queued.priority, request->GetSwitched());
+	return true;
 }
 
-void RequestQueue::RemoveRequestsFrom(Client* client)
+void RequestQueue::Forget(Request* request)
 {
-	if (mQueue.empty()) return;
+	tQueued::iterator it = mQueued.find(request);
+	if (it == mQueued.end()) return;
 
-	if (mQueue.front()->GetOwner() == client)
+	tDepths::iterator depth = mDepths.find(it->second.flow);
+	if (--depth->second == 0) mDepths.erase(depth);
+
+	std::pair<tByClient::iterator, tByClient::iterator> range = mByClient.equal_range(it->second.owner);
+	for(tByClient::iterator owned = range.first; owned != range.second; owned++)
 	{
-		mWaiting = false;
+		if (owned->second == request)
+		{
+			mByClient.erase(owned);
+			break;
+		}
 	}
 
-	tQueue::iterator i = mQueue.begin();
-	while(i != mQueue.end())
-	{		
-		if ((*i)->GetOwner() == client)
+	mQueued.erase(it);
+}
+
+bool RequestQueue::PerformNow(Request* request)
+{
+	mImmediate.push_back(request);
+	request->Send();
+
+	// a handler that finishes right away has removed it through RequestDone
+	return std::find(mImmediate.begin(), mImmediate.end(), request) != mImmediate.end();
+}
+
+bool RequestQueue::RemoveImmediate(Request* request)
+{
+	tQueue::iterator it = std::find(mImmediate.begin(), mImmediate.end(), request);
+	if (it == mImmediate.end()) return false;
+
+	mImmediate.erase(it);
+	return true;
+}
+
+void RequestQueue::RemoveRequestsFrom(Client* client)
+{
+	tQueue::iterator im = mImmediate.begin();
+	while(im != mImmediate.end())
+	{
+		if ((*im)->GetOwner() == client)
 		{
-			Request* temp = *i;
-			i = mQueue.erase(i);
+			Request* temp = *im;
+			im = mImmediate.erase(im);
 
 			temp->Cancel();
 			delete temp;
 		}
-		else i++;
+		else im++;
+	}
+
+	if (mpCurrent && mpCurrent->GetOwner() == client)
+	{
+		Request* temp = mpCurrent;
+		mpCurrent = NULL;
+
+		temp->Cancel();
+		delete temp;
+	}
+
+	std::pair<tByClient::iterator, tByClient::iterator> range = mByClient.equal_range(client);
+	std::vector<Request*> owned;
+	for(tByClient::iterator it = range.first; it != range.second; it++)
+	{
+		owned.push_back(it->second);
+	}
+
+	for(size_t i = 0; i < owned.size(); i++)
+	{
+		Request* temp = owned[i];
+		mpScheduler->Remove(temp);
+		Forget(temp);
+
+		temp->Cancel();
+		delete temp;
 	}
 }
 
 void RequestQueue::RemoveRequest(Request* pRequest)
 {
-	if (pRequest == mQueue.front())
+	if (RemoveImmediate(pRequest))
+	{
+		delete pRequest;
+		return;
+	}
+
+	if (pRequest == mpCurrent)
 	{
 		syserr << "Forcefully removing the currently handled request." << std::endl;
-		mWaiting = false; // xxx
+		mpCurrent = NULL;
+	}
+	else if (mpScheduler->Remove(pRequest))
+	{
+		Forget(pRequest);
 	}
-	mQueue.remove(pRequest);
 	delete pRequest;
 }
 
 bool RequestQueue::ProcessQueue()
 {
-	if (mWaiting)
-	{
-		mQueue.front()->HasTimedOut();
-		return true;
-	}
+	// the request being handled has a deadline in the timer queue
+	if (mpCurrent) return true;
+
+	Request* request = mpScheduler->Pop();
+	if (!request) return true;
 
-	if (mQueue.empty()) return true;
+	mWait[mQueued[request].priority].Add(request->TimeSinceArrival());
+	Forget(request);
 
-	HandleRequest(mQueue.front());
+	HandleRequest(request);
 
 	return true;
 }
 
 void RequestQueue::HandleRequest(Request* request)
 {
-	mWaiting = true;
+	mpCurrent = request;
 	request->Send();
 }
 
 void RequestQueue::RequestDone(Request* request)
 {
-	if ( request != mQueue.front())
+	if (RemoveImmediate(request))
+	{
+		Handled(eImmediate, request);
+		delete request;
+		return;
+	}
+
+	if (request != mpCurrent)
 	{
 		syserr << "Calling RequestDone on request not on the stack. Probably because of a client that shut down during handling of a transaction." << std::endl;
 		RemoveRequest(request); // make sure to delete the request in any case
@@ -118,10 +238,55 @@ void RequestQueue::RequestDone(Request* request)
 	}
 
 	// allow next request to be processed
+	Handled(eEquipment, request);
+	mpCurrent = NULL;
+
+	delete request; // delete the request that was handled
+}
+
+const char* RequestQueue::GetSchedulerName() const
+{
+	return mpScheduler->GetName();
+}
+
+bool RequestQueue::ParseSchedulerType(const std::string& name, SchedulerType& type)
+{
+	if (name == "fifo")			type = eFifo;
+	else if (name == "fair")	type = eFair;
+	else if (name == "relay")	type = eRelay;
+	else return false;
+	return true;
+}
+
+void RequestQueue::Handled(RequestClass reqclass, Request* request)
+{
 	mHandledRequests++;
-	mWaiting = false;
+	mLatency[reqclass].Add(request->TimeSinceArrival());
 
-	mQueue.pop_front();
+	if (mStatsInterval > 0 && (mHandledRequests % mStatsInterval) == 0) LogRequestLatency();
+}
 
-	delete request; // delete the frontmost request
+void RequestQueue::LogRequestLatency()
+{
+	static const char* sNames[eNumClasses] = { "equipment", "immediate" };
+
+	for(int i = 0; i < eNumClasses; i++)
+	{
+		const RequestLatency& latency = mLatency[i];
+		sysout << "Request latency, " << sNames[i] << ": " << (unsigned int)latency.count << " requests, avg "
+			<< latency.Average() * 1000.0 << "ms, max " << latency.max * 1000.0 << "ms" << std::endl;
+	}
+
+	for(tWaitStats::const_iterator it = mWait.begin(); it != mWait.end(); it++)
+	{
+		const RequestLatency& wait = it->second;
+		sysout << "Queue wait, priority " << it->first << ": " << (unsigned int)wait.count << " requests, avg "
+			<< wait.Average() * 1000.0 << "ms, max " << wait.max * 1000.0 << "ms" << std::endl;
+	}
+}
+
+void RequestQueue::LogLatency()
+{
+	LogRequestLatency();
+	mpScheduler->LogStats();
 }
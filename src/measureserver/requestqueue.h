@@ -31,20 +31,59 @@
 //#include "request.h"
 
 #include <list>
+#include <map>
+#include <string>
 
 // forward decl.
 class Client;
 
+namespace Net { class TimerQueue; }
+
 class Request;
+class RequestScheduler;
+
+/// Time from arrival to completion for one class of requests
+struct RequestLatency
+{
+	size_t	count;
+	double	total;	// seconds
+	double	max;
+
+	void	Add(double seconds);
+	double	Average() const { return count ? total / count : 0.0; }
+
+	RequestLatency() : count(0), total(0.0), max(0.0) {}
+};
 
 /// Queues the request for future processing.
 /// When a client issues a measurement, the request is encoded and placed in the queue.
-/// When the server has time to process the request, the request is removed from the queue and sent to the server.
+/// When the server has time to process the request, the scheduler picks the next one and it is sent to the server.
 class RequestQueue
 {
 public:
-	///		Add a request for processing on the queue
-	void	AddRequest(Request* request);
+	enum RequestClass
+	{
+		eEquipment = 0,	///< serialized through the queue
+		eImmediate,		///< never touches the equipment, performed without queueing
+		eNumClasses
+	};
+
+	enum SchedulerType
+	{
+		eFifo,			///< arrival order
+		eFair,			///< session priority first, then the sessions take turns
+		eRelay,			///< fair, but similar circuits are run back to back to switch fewer relays
+	};
+
+	typedef std::map< int, RequestLatency > tWaitStats;
+
+	///		Add a request for processing on the queue.
+	///		Returns false, and keeps out of it, if the session already has the max number of requests waiting
+	bool	AddRequest(Request* request);
+
+	///		Perform a request that doesn't use the equipment right away, bypassing the queue.
+	///		Returns false if the request is already done, and deleted, when this returns
+	bool	PerformNow(Request* request);
 
 	///		Remove all request from a specific client
 	void	RemoveRequestsFrom(Client* client);
@@ -60,16 +99,59 @@ public:
 
 	inline size_t	NumHandledRequests() { return mHandledRequests; }
 
-			RequestQueue();
+	const RequestLatency&	GetLatency(RequestClass reqclass) const { return mLatency[reqclass]; }
+
+	///		Time spent waiting in the queue, by session priority
+	const tWaitStats&		GetQueueWait() const { return mWait; }
+	void					LogLatency();
+
+	///		Log the request latencies and queue waits every this many handled requests while running, 0 turns it off
+	void	SetStatsInterval(size_t interval) { mStatsInterval = interval; }
+
+	const char*		GetSchedulerName() const;
+
+	///		Translate a config value ("fifo"/"fair"/"relay") to a scheduler type
+	static bool		ParseSchedulerType(const std::string& name, SchedulerType& type);
+
+	///		Timers for request deadlines
+	inline Net::TimerQueue*	GetTimerQueue() { return mpTimers; }
+
+	///		maxPerSession is the number of requests a session may have waiting, 0 for no limit.
+	///		relayWindow is how many requests the relay scheduler looks at, and how many times one may be passed over
+			RequestQueue(Net::TimerQueue* pTimers, SchedulerType type = eFifo, size_t maxPerSession = 0, size_t relayWindow = 8);
 	virtual ~RequestQueue();
 private:
+	/// Where a waiting request belongs, taken when it is queued since the session may go away before it
+	struct Queued
+	{
+		Client*		owner;
+		const void*	flow;		// the session, or the client without one
+		int			priority;
+	};
 
 	void		HandleRequest(Request* request);
+	bool		RemoveImmediate(Request* request);
+	void		Forget(Request* request);
+	void		Handled(RequestClass reqclass, Request* request);
+	void		LogRequestLatency();
 
 	typedef		std::list< Request* > tQueue;
-	tQueue		mQueue;
-	bool		mWaiting;
+	typedef		std::map< Request*, Queued > tQueued;
+	typedef		std::multimap< Client*, Request* > tByClient;
+	typedef		std::map< const void*, size_t > tDepths;
+
+	RequestScheduler*	mpScheduler;
+	Request*	mpCurrent;	// sent and waiting for the equipment
+	tQueued		mQueued;
+	tByClient	mByClient;
+	tDepths		mDepths;
+	size_t		mMaxPerSession;
+	tQueue		mImmediate;	// performed right away, waiting for their handlers to finish
+	RequestLatency	mLatency[eNumClasses];
+	tWaitStats	mWait;
 	size_t		mHandledRequests;
+	size_t		mStatsInterval;
+	Net::TimerQueue*	mpTimers;
 };
 
 #endif
@@ -0,0 +1,289 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "requestscheduler.h"
+
+#include <syslog.h>
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <set>
+
+namespace {
+
+class FifoScheduler : public RequestScheduler
+{
+public:
+	virtual void		Push(Request* request, const void* flow, int priority, const tSwitched* pSwitched) { mQueue.push_back(request); }
+	virtual Request*	Pop();
+	virtual bool		Remove(Request* request);
+
+	virtual bool		Empty() const { return mQueue.empty(); }
+
+	virtual const char*	GetName() const { return "fifo"; }
+private:
+	typedef std::list< Request* > tQueue;
+	tQueue		mQueue;
+};
+
+/// Start time fair queuing within each priority class.
+/// Every request costs the same, a request is tagged with the virtual time its flow is done with it:
+/// the later of the class clock and the end of the previous request of the flow, plus one.
+/// The lowest tag is handled first, so a flow with many requests queued gets every other turn at most.
+/// With a window the first requests of the class are searched for the one closest to the previous
+/// circuit, relay settle time is what a measurement mostly waits for.
+class FairScheduler : public RequestScheduler
+{
+public:
+	virtual void		Push(Request* request, const void* flow, int priority, const tSwitched* pSwitched);
+	virtual Request*	Pop();
+	virtual bool		Remove(Request* request);
+
+	virtual bool		Empty() const { return mEntries.empty(); }
+
+	virtual const char*	GetName() const { return (mWindow > 0) ? "relay" : "fair"; }
+
+	virtual void		LogStats() const;
+
+	FairScheduler(size_t window) : mSequence(0), mWindow(window), mHasPrevious(false), mRelayChanges(0), mRelayChangesAvoided(0) {}
+private:
+	typedef std::pair< int, const void* > tFlowKey;
+
+	struct Entry
+	{
+		int			priority;
+		double		tag;
+		size_t		sequence;	// breaks ties in arrival order
+		Request*	request;
+		const void*	flow;
+		const tSwitched*	pSwitched;
+		mutable size_t		passed;	// times a later request was picked before this one
+
+		bool operator<(const Entry& other) const
+		{
+			if (priority != other.priority) return priority > other.priority;
+			if (tag != other.tag) return tag < other.tag;
+			return sequence < other.sequence;
+		}
+	};
+
+	struct Flow
+	{
+		double		finish;
+		size_t		queued;
+	};
+
+	typedef std::set< Entry >							tEntries;
+	typedef std::map< Request*, tEntries::iterator >	tIndex;
+	typedef std::map< tFlowKey, Flow >					tFlows;
+	typedef std::map< int, double >						tClocks;
+
+	void		Take(tEntries::iterator it);
+	tEntries::iterator	PickSimilar();
+
+	tEntries	mEntries;
+	tIndex		mIndex;
+	tFlows		mFlows;		// forgotten when the queue runs empty, bounded by the sessions
+	tClocks		mClocks;	// virtual time per priority class
+	size_t		mSequence;
+
+	size_t		mWindow;
+	tSwitched	mPrevious;	// switched in by the last request handed out
+	bool		mHasPrevious;
+	size_t		mRelayChanges;
+	size_t		mRelayChangesAvoided;
+};
+
+/// Relays that change going from one sorted component list to the other
+size_t CountChanges(const RequestScheduler::tSwitched& from, const RequestScheduler::tSwitched& to)
+{
+	size_t changes = 0;
+	size_t i = 0, j = 0;
+	while(i < from.size() && j < to.size())
+	{
+		if (from[i] < to[j])		{ changes++; i++; }
+		else if (to[j] < from[i])	{ changes++; j++; }
+		else { i++; j++; }
+	}
+	return changes + (from.size() - i) + (to.size() - j);
+}
+
+} // end of anonymous namespace
+
+Request* FifoScheduler::Pop()
+{
+	if (mQueue.empty()) return NULL;
+
+	Request* request = mQueue.front();
+	mQueue.pop_front();
+	return request;
+}
+
+bool FifoScheduler::Remove(Request* request)
+{
+	tQueue::iterator it = std::find(mQueue.begin(), mQueue.end(), request);
+	if (it == mQueue.end()) return false;
+
+	mQueue.erase(it);
+	return true;
+}
+
+void FairScheduler::Push(Request* request, const void* flow, int priority, const tSwitched* pSwitched)
+{
+	Flow& rFlow = mFlows.insert(std::make_pair(tFlowKey(priority, flow), Flow())).first->second;
+	double& clock = mClocks[priority];
+
+	Entry entry;
+	entry.priority	= priority;
+	entry.tag		= std::max(clock, rFlow.finish) + 1.0;
+	entry.sequence	= mSequence++;
+	entry.request	= request;
+	entry.flow		= flow;
+	entry.pSwitched	= pSwitched;
+	entry.passed	= 0;
+
+	rFlow.finish = entry.tag;
+	rFlow.queued++;
+
+	mIndex[request] = mEntries.insert(entry).first;
+}
+
+void FairScheduler::Take(tEntries::iterator it)
+{
+	mFlows[tFlowKey(it->priority, it->flow)].queued--;
+	mIndex.erase(it->request);
+	mEntries.erase(it);
+
+	// nothing waits, so nobody is owed a turn
+	if (mEntries.empty())
+	{
+		mFlows.clear();
+		mClocks.clear();
+	}
+}
+
+FairScheduler::tEntries::iterator FairScheduler::PickSimilar()
+{
+	tEntries::iterator head = mEntries.begin();
+	if (!mHasPrevious || !head->pSwitched) return head;
+
+	const size_t headChanges = CountChanges(mPrevious, *head->pSwitched);
+	size_t bestChanges = headChanges;
+	tEntries::iterator best = head;
+
+	// the tags of a flow grow, so its first entry seen is its oldest and the only one it may run now
+	std::set< const void* > seen;
+	size_t searched = 0;
+	for(tEntries::iterator it = head; it != mEntries.end() && searched < mWindow; it++, searched++)
+	{
+		if (it->priority != head->priority) break;
+		if (!seen.insert(it->flow).second) continue;
+
+		// passed over enough, it goes now
+		if (it->passed >= mWindow)
+		{
+			best = it;
+			break;
+		}
+
+		if (!it->pSwitched) continue;
+
+		size_t changes = CountChanges(mPrevious, *it->pSwitched);
+		if (changes < bestChanges)
+		{
+			bestChanges = changes;
+			best = it;
+		}
+	}
+
+	for(tEntries::iterator it = head; it != best; it++)
+	{
+		it->passed++;
+	}
+
+	if (best->pSwitched)
+	{
+		bestChanges = CountChanges(mPrevious, *best->pSwitched);
+		if (bestChanges < headChanges) mRelayChangesAvoided += headChanges - bestChanges;
+	}
+	return best;
+}
+
+Request* FairScheduler::Pop()
+{
+	if (mEntries.empty()) return NULL;
+
+	// the class clock follows the head even when a later request is picked, the others keep their turns
+	tEntries::iterator head = mEntries.begin();
+	mClocks[head->priority] = head->tag - 1.0; // the start of the request being handled
+
+	tEntries::iterator it = (mWindow > 0) ? PickSimilar() : head;
+	Request* request = it->request;
+
+	if (it->pSwitched)
+	{
+		if (mHasPrevious) mRelayChanges += CountChanges(mPrevious, *it->pSwitched);
+		mPrevious = *it->pSwitched;
+		mHasPrevious = true;
+	}
+	else mHasPrevious = false;
+
+	Take(it);
+	return request;
+}
+
+void FairScheduler::LogStats() const
+{
+	if (mWindow == 0) return;
+
+	sysout << "Relay changes between measurements: " << (unsigned int)mRelayChanges
+		<< ", avoided by reordering: " << (unsigned int)mRelayChangesAvoided << std::endl;
+}
+
+bool FairScheduler::Remove(Request* request)
+{
+	tIndex::iterator it = mIndex.find(request);
+	if (it == mIndex.end()) return false;
+
+	Take(it->second);
+	return true;
+}
+
+RequestScheduler* CreateFifoScheduler()
+{
+	return new FifoScheduler();
+}
+
+RequestScheduler* CreateFairScheduler()
+{
+	return new FairScheduler(0);
+}
+
+RequestScheduler* CreateRelayScheduler(size_t window)
+{
+	return new FairScheduler(window);
+}
@@ -0,0 +1,73 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __REQUEST_SCHEDULER_H__
+#define __REQUEST_SCHEDULER_H__
+
+#include <string>
+#include <vector>
+
+class Request;
+
+/// Picks the order the queued requests are handled in.
+/// Only the RequestQueue should use this, requests are queued through it.
+class RequestScheduler
+{
+public:
+	typedef std::vector<std::string> tSwitched;
+
+	/// Queue a request. Requests with the same flow (a session) are handled in the order they were pushed.
+	/// pSwitched is the sorted components the request switches in, NULL if not known. It must stay valid while queued
+	virtual void		Push(Request* request, const void* flow, int priority, const tSwitched* pSwitched) = 0;
+
+	/// Take out the request to handle next, NULL if nothing is queued
+	virtual Request*	Pop() = 0;
+
+	/// Take out a queued request that won't be handled, returns false if it isn't queued
+	virtual bool		Remove(Request* request) = 0;
+
+	virtual bool		Empty() const = 0;
+
+	virtual const char*	GetName() const = 0;
+
+	virtual void		LogStats() const {}
+
+	virtual ~RequestScheduler() {}
+};
+
+/// Handles the requests in arrival order
+RequestScheduler* CreateFifoScheduler();
+
+/// Strict priority between the priority classes, higher first.
+/// Within a class the flows take turns, so a session firing requests back to back can't starve the others
+RequestScheduler* CreateFairScheduler();
+
+/// Fair, but the next request is picked among the first window ones of the class to switch as few relays
+/// as possible from the previous measurement. Only the oldest request of a flow is picked, so the flows
+/// keep their order. A request is passed over at most window times
+RequestScheduler* CreateRelayScheduler(size_t window);
+
+#endif
@@ -12,6 +12,8 @@
 #include "systemtransactions.h"
 
 #include "protocolservice.h"
+#include "gateway.h"
+#include "reactor.h"
 
 #include <network/socket.h>
 #include <network/multiplexer.h>
@@ -23,6 +25,8 @@
 #include <xmlserver/xmlserver.h>
 #include <scgiserver/scgiserver.h>
 
+#include <algorithm>
+
 using namespace std;
 
 #define SAFE_DELETE(x) {delete x; x = NULL;}
@@ -41,21 +45,14 @@ ServerMain::ServerMain()
 	mpRequestQueue = NULL;
 	mpServerProtocolService = NULL;
 	mpModuleRegistry = NULL;
-
-	mpHTTPServer = NULL;
-	mpXMLServer = NULL;
-	mpXMLPolicyServer = NULL;
-	mpSCGIServer = NULL;
+	mpGateway = NULL;
 
 	mState = eInit;
 }
 
 ServerMain::~ServerMain()
 {
-	SAFE_DELETE(mpHTTPServer)
-	SAFE_DELETE(mpXMLServer)
-	SAFE_DELETE(mpXMLPolicyServer)
-	SAFE_DELETE(mpSCGIServer)
+	StopServers();
 
 	SAFE_DELETE(mpModuleRegistry)
 	SAFE_DELETE(mpService)
@@ -112,18 +109,34 @@ int ServerMain::StartUp(int argc, char** argv)
 
 	sysout << timestamp << "*** Starting server, version " << VersionString() << " " << BUILDTYPE " ***" << endl; // Indicamos hora y que se inializo server y la version
 
+	mpMultiplexer = new Net::Multiplexer(); // Clase que multiplexa la conexion socket para permitir multiples clientes, esto, en nuestro caso lo hace directamente flask
+
+	// epoll where available, select is kept as fallback and for comparison
+	Net::Multiplexer::BackendType backendType = Net::Multiplexer::eEpoll;
+	string backendName = mpConfig->GetString("Multiplexer", "epoll");
+	if (!Net::Multiplexer::ParseBackendType(backendName, backendType))
+	{
+		syserr << "*** Unknown multiplexer backend: " << backendName << endl;
+		return 0;
+	}
+
+	if (!mpMultiplexer->Init(backendType))
+	{
+		syserr << "*** Failed to initialize network multiplexer" << endl;
+		return 0;
+	}
+	sysout << "[+] Using " << mpMultiplexer->GetBackendName() << " network multiplexer" << endl;
+
 	size_t maxSessions = mpConfig->GetInt("MaxSessions", 50); // del dict de conf leemos el maximo de sesiones, si no se carga valor por defecto 50
 	double sessionTimeout = mpConfig->GetInt("SessionTimeout", 60*10); // Leemos el tiempo de tiemout del dict de conf si novalor defecto 600
 
-	mpSessionRegistry = new SessionRegistry(maxSessions, sessionTimeout); // creamos un objeto de registro de sesiones, esta clase esta en sesion.h
+	mpSessionRegistry = new SessionRegistry(mpMultiplexer->GetTimerQueue(), maxSessions, sessionTimeout); // creamos un objeto de registro de sesiones, esta clase esta en sesion.h
 	mpTransactionControl = new TransactionControl();
 
 	int allowKeepAlive = mpConfig->GetInt("AllowKeepAlive", 1); // leemos la configuracion de permitir mantener se vivo, por defecto a 1, es necesario http en especial
 	int bypassAuth = mpConfig->GetInt("BypassAuth", 0); // leemos la conf si hacemos by pass a la autentificacion, por defecto 0
 	mpAuthentication = new Authentication(mpSessionRegistry, allowKeepAlive != 0, bypassAuth != 0); // creamos objeto autentificacion, le pasamos el objeto de registro de sesion true si permitimos keepalive y true si autentificacion
 
-	mpMultiplexer = new Net::Multiplexer(); // Clase que multiplexa la conexion socket para permitir multiples clientes, esto, en nuestro caso lo hace directamente flask
-
 	mpService = new Service(mpConfig);
 
 	// init information service
@@ -134,7 +147,20 @@ int ServerMain::StartUp(int argc, char** argv)
 		return 0;
 	}
 	
-	mpRequestQueue = new RequestQueue(); // creamos la clase que gestiona la cola de respuestas, igual flask ya despone de esto
+	// higher priority sessions first, the sessions of the same priority take turns
+	RequestQueue::SchedulerType schedulerType = RequestQueue::eFair;
+	string schedulerName = mpConfig->GetString("QueueScheduler", "fair");
+	if (!RequestQueue::ParseSchedulerType(schedulerName, schedulerType))
+	{
+		syserr << "*** Unknown queue scheduler: " << schedulerName << endl;
+		return 0;
+	}
+
+	size_t maxQueuedPerSession = mpConfig->GetInt("MaxQueuedPerSession", 1);
+	size_t relayWindow = mpConfig->GetInt("QueueRelayWindow", 8);
+	mpRequestQueue = new RequestQueue(mpMultiplexer->GetTimerQueue(), schedulerType, maxQueuedPerSession, relayWindow); // creamos la clase que gestiona la cola de respuestas, igual flask ya despone de esto
+	sysout << "[+] Using " << mpRequestQueue->GetSchedulerName() << " request scheduling" << endl;
+	mpRequestQueue->SetStatsInterval((size_t)std::max(mpConfig->GetInt("RequestStatsInterval", 100), 0));
 
 	int maxClients = mpConfig->GetInt("MaxClients", 16); 
 	mpClientManager = new ClientManager(maxClients);
@@ -183,71 +209,157 @@ int ServerMain::StartServers()
 {
 	sysout << "[+] Initialization complete, staring to listen for incoming connections" << endl;
 
-	mpHTTPServer = new HTTPServer(mpMultiplexer, mpServerProtocolService, mpClientManager);
-	int httpport = mpConfig->GetInt("HTTPPort", 0);
-	if (httpport != 0)
+	// the connections are served by the I/O threads, the equipment is only driven from this thread
+	int numThreads = mpConfig->GetInt("IOThreads", 2);
+	if (numThreads < 0) numThreads = 0;
+	if (numThreads > 1 && !Net::Socket::SupportsSharedPort())
 	{
-		if (!mpHTTPServer->Init(httpport, mpConfig))
-		{
-			syserr << "HTTP Server failed to start" << endl;
-			return 0;
-		}
-		else
-		{
-			sysout << "[+] Started HTTP server on port " << httpport << endl;
-		}
+		sysout << "[+] Listening ports can't be shared on this platform, using one I/O thread" << endl;
+		numThreads = 1;
+	}
+	bool shared = (numThreads > 1);
+
+	Net::Multiplexer::BackendType backendType = Net::Multiplexer::eEpoll;
+	Net::Multiplexer::ParseBackendType(mpConfig->GetString("Multiplexer", "epoll"), backendType);
+
+	mpGateway = new ProtocolGateway(mpServerProtocolService, mpClientManager);
+	if (!mpGateway->Init(mpMultiplexer))
+	{
+		syserr << "*** Failed to initialize protocol gateway" << endl;
+		return 0;
 	}
 
+	int httpport = mpConfig->GetInt("HTTPPort", 0);
 	int port = mpConfig->GetInt("Port", 0);
-	mpXMLServer = new XMLServer(mpMultiplexer, mpServerProtocolService, mpClientManager);
-	if (port != 0)
+	int scgiport = mpConfig->GetInt("SCGIPort", 0);
+	int noPolicyServer = mpConfig->GetInt("NoPolicyServer", 0);
+
+	// without threads a single reactor runs on our own multiplexer
+	int numReactors = (numThreads > 0) ? numThreads : 1;
+	for(int i = 0; i < numReactors; i++)
 	{
-		if (!mpXMLServer->Init(port, mpConfig))
+		ReactorServers servers = { NULL, NULL, NULL, NULL, NULL };
+		servers.pReactor = new Reactor(mpGateway, mpServerProtocolService->GetCrossDomainPolicy());
+		mReactors.push_back(servers);
+
+		Reactor* pReactor = servers.pReactor;
+		if (!pReactor->Init((numThreads > 0) ? NULL : mpMultiplexer, backendType))
 		{
-			syserr << "XML Server failed to start" << endl;
+			syserr << "*** Failed to initialize I/O reactor" << endl;
 			return 0;
 		}
-		else
+		mpGateway->AddReactor(pReactor);
+
+		// only the first reactor reports, the others listen on the same ports
+		bool first = (i == 0);
+
+		mReactors.back().pHTTPServer = new HTTPServer(pReactor);
+		if (httpport != 0)
 		{
-			sysout << "[+] Started XML server on port " << port << endl;
+			if (!mReactors.back().pHTTPServer->Init(httpport, mpConfig, shared))
+			{
+				syserr << "HTTP Server failed to start" << endl;
+				return 0;
+			}
+			else if (first)
+			{
+				sysout << "[+] Started HTTP server on port " << httpport << endl;
+			}
 		}
-	}
 
-	int scgiport = mpConfig->GetInt("SCGIPort", 0);
-	if (scgiport != 0)
-	{
-		mpSCGIServer = new SCGIServer(mpMultiplexer, mpServerProtocolService, mpClientManager);
-		if (!mpSCGIServer->Init(scgiport, mpConfig))
+		mReactors.back().pXMLServer = new XMLServer(pReactor);
+		if (port != 0)
 		{
-			syserr << "SCGI Server failed to start" << endl;
-			return 0;
+			if (!mReactors.back().pXMLServer->Init(port, mpConfig, shared))
+			{
+				syserr << "XML Server failed to start" << endl;
+				return 0;
+			}
+			else if (first)
+			{
+				sysout << "[+] Started XML server on port " << port << endl;
+			}
 		}
-		else
+
+		if (scgiport != 0)
 		{
-			sysout << "[+] Started SCGI server on port " << scgiport << endl;
+			mReactors.back().pSCGIServer = new SCGIServer(pReactor);
+			if (!mReactors.back().pSCGIServer->Init(scgiport, mpConfig, shared))
+			{
+				syserr << "SCGI Server failed to start" << endl;
+				return 0;
+			}
+			else if (first)
+			{
+				sysout << "[+] Started SCGI server on port " << scgiport << endl;
+			}
 		}
-	}
 
-	int noPolicyServer = mpConfig->GetInt("NoPolicyServer", 0);
-	
-	if (!noPolicyServer)
-	{
-		// just reuse the xml server for the policy file handling..
-		mpXMLPolicyServer = new XMLServer(mpMultiplexer, mpServerProtocolService, mpClientManager);
-		if (!mpXMLPolicyServer->Init(843, mpConfig))
+		// policy requests are rare, one listener is enough
+		if (!noPolicyServer && first)
 		{
-			syserr << "XML Policy Server failed to start" << endl;
-			return 0;
+			// just reuse the xml server for the policy file handling..
+			mReactors.back().pXMLPolicyServer = new XMLServer(pReactor);
+			if (!mReactors.back().pXMLPolicyServer->Init(843, mpConfig))
+			{
+				syserr << "XML Policy Server failed to start" << endl;
+				return 0;
+			}
+			else
+			{
+				sysout << "[+] Started XML policy server on port " << 843 << endl;
+			}
 		}
-		else
+	}
+
+	if (numThreads > 0)
+	{
+		for(tReactors::iterator it = mReactors.begin(); it != mReactors.end(); it++)
 		{
-			sysout << "[+] Started XML policy server on port " << 843 << endl;
+			if (!it->pReactor->StartThread())
+			{
+				syserr << "*** Failed to start I/O thread" << endl;
+				return 0;
+			}
 		}
+		sysout << "[+] Serving connections from " << numThreads << " I/O threads" << endl;
 	}
 
 	return 1;
 }
 
+void ServerMain::StopServers()
+{
+	// no thread may touch the connections while they are deleted
+	for(tReactors::iterator it = mReactors.begin(); it != mReactors.end(); it++)
+	{
+		it->pReactor->Stop();
+	}
+
+	for(tReactors::iterator it = mReactors.begin(); it != mReactors.end(); it++)
+	{
+		SAFE_DELETE(it->pHTTPServer)
+		SAFE_DELETE(it->pXMLServer)
+		SAFE_DELETE(it->pXMLPolicyServer)
+		SAFE_DELETE(it->pSCGIServer)
+	}
+
+	// drop the clients of the closed connections
+	if (mpGateway)
+	{
+		mpGateway->ProcessMessages();
+		mpGateway->CloseAll();
+	}
+
+	for(tReactors::iterator it = mReactors.begin(); it != mReactors.end(); it++)
+	{
+		SAFE_DELETE(it->pReactor)
+	}
+	mReactors.clear();
+
+	SAFE_DELETE(mpGateway)
+}
+
 int ServerMain::Tick(int timeout)
 {
 	switch(mState)
@@ -283,13 +395,12 @@ int ServerMain::Tick(int timeout)
 				return 0;
 			}
 
-			mpRequestQueue->ProcessQueue();
-
-			// housekeeping
+			// housekeeping, runs connection, session and request timers that are due
 			mpMultiplexer->HouseKeeping();
 
+			mpRequestQueue->ProcessQueue();
+
 			mpAuthentication->Tick();
-			mpSessionRegistry->Tick();
 		}
 		break;
 	}
@@ -300,9 +411,9 @@ int ServerMain::Tick(int timeout)
 int ServerMain::Shutdown()
 {
 	// shutdown the network services
-	SAFE_DELETE(mpHTTPServer)
-	SAFE_DELETE(mpXMLServer)
-	SAFE_DELETE(mpXMLPolicyServer)
+	StopServers();
+
+	if (mpRequestQueue) mpRequestQueue->LogLatency();
 
 	if (mpModuleRegistry) mpModuleRegistry->UnloadModules();
 	if (mpTransactionControl) mpTransactionControl->UnregisterHandler(mpSystemTransactionHandler);
@@ -15,11 +15,15 @@ class ModuleRegistry;
 class HTTPServer;
 class XMLServer;
 class SCGIServer;
+class Reactor;
+class ProtocolGateway;
 
 namespace Net {
 	class Multiplexer;
 }
 
+#include <vector>
+
 class ServerMain
 {
 public:
@@ -44,6 +48,7 @@ private:
 	bool InitLog();
 
 	int StartServers();
+	void StopServers();
 
 	Config* mpConfig;
 	SessionRegistry* mpSessionRegistry;
@@ -56,10 +61,20 @@ private:
 	RequestQueue* mpRequestQueue;
 	ServerProtocolService* mpServerProtocolService;
 	ModuleRegistry* mpModuleRegistry;
-	HTTPServer* mpHTTPServer;
-	XMLServer* mpXMLServer;
-	XMLServer* mpXMLPolicyServer;
-	SCGIServer* mpSCGIServer;
+	ProtocolGateway* mpGateway;
+
+	/// I/O reactor and the protocol servers listening in it
+	struct ReactorServers
+	{
+		Reactor* pReactor;
+		HTTPServer* pHTTPServer;
+		XMLServer* pXMLServer;
+		XMLServer* pXMLPolicyServer;
+		SCGIServer* pSCGIServer;
+	};
+
+	typedef std::vector<ReactorServers> tReactors;
+	tReactors mReactors;
 };
 
 #endif
@@ -29,12 +29,15 @@
 
 #include <instruments/validate.h>
 #include <instruments/compdefreader.h>
+#include <instruments/circuitsolver3.h>
 
 #include <config.h>
 #include <basic_exception.h>
 
 #include <syslog.h>
 
+#include <algorithm>
+
 static const char* sDefaultPolicy =
 "<?xml version=\"1.0\"?>"
 "<!DOCTYPE cross-domain-policy SYSTEM \"http://www.macromedia.com/xml/dtds/cross-domain-policy.dtd\">"
@@ -61,6 +64,17 @@ bool Service::Init()
 	std::string compTypeConfig	= mpConfig->GetString("CompTypes", "component.types");
 	std::string maxListConfig	= mpConfig->GetString("MaxListConfig", "maxlists.conf");
 	std::string saveCircuits	= mpConfig->GetString("SaveCircuits", "");
+	int solutionCacheSize		= mpConfig->GetInt("SolutionCacheSize", 256);
+	int solverThreads			= mpConfig->GetInt("SolverThreads", 2);
+	int solverHeuristics		= mpConfig->GetInt("SolverHeuristics", CircuitSolver3::eAllHeuristics);
+	int solverMaxNodes			= mpConfig->GetInt("SolverMaxNodes", 0);
+	int solverMaxTime			= mpConfig->GetInt("SolverMaxTime", 0);
+	int circuitMaxNodes			= mpConfig->GetInt("CircuitMaxNodes", 0);
+	int circuitMaxTime			= mpConfig->GetInt("CircuitMaxTime", 2000);
+	int solverStatsInterval		= mpConfig->GetInt("SolverStatsInterval", 100);
+	int maxListOrder			= mpConfig->GetInt("MaxListOrder", MaxLists::eConfirmedOrder);
+	std::string maxListStats	= mpConfig->GetString("MaxListStats", "");
+	std::string solutionStore	= mpConfig->GetString("SolutionStore", "");
 
 	if (!mCompInfo->ReadFile(confBaseDir + compTypeConfig))
 	{
@@ -68,7 +82,16 @@ bool Service::Init()
 		return false;
 	}
 
-	if (!mpMaxLists->Init(confBaseDir, maxListConfig, saveCircuits, mCompInfo->GetDefinitions())) return false;
+	if (solutionCacheSize < 0) solutionCacheSize = 0;
+	if (solverThreads < 0) solverThreads = 0;
+	mpMaxLists->SetSolverHeuristics(solverHeuristics);
+	mpMaxLists->SetSolverBudget(
+		(size_t)std::max(solverMaxNodes, 0), std::max(solverMaxTime, 0) / 1000.0,
+		(size_t)std::max(circuitMaxNodes, 0), std::max(circuitMaxTime, 0) / 1000.0);
+	mpMaxLists->SetStatsInterval((size_t)std::max(solverStatsInterval, 0));
+	mpMaxLists->SetListOrder(maxListOrder, maxListStats);
+	mpMaxLists->SetSolutionStore(solutionStore);
+	if (!mpMaxLists->Init(confBaseDir, maxListConfig, saveCircuits, mCompInfo->GetDefinitions(), solutionCacheSize, solverThreads)) return false;
 
 	std::string policyFile		= mpConfig->GetString("PolicyFile", "");
 	if (policyFile == "")
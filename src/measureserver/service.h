@@ -52,6 +52,9 @@ public:
 
 	const ListParser::tComponentDefinitions& GetComponentDefinitions() const;
 
+	const SolutionCache&	GetSolutionCache() const { return mpMaxLists->GetSolutionCache(); }
+	const MaxLists::tListStats&	GetSolverStats() const { return mpMaxLists->GetSolverStats(); }
+
 
 			Service(Config* pConfig);
 	virtual ~Service();
@@ -76,6 +76,11 @@ void Session::Touch()
 	mLastActive = time(0);
 }
 
+void Session::TimerExpired()
+{
+	mpSessionReg->CheckTimeout(this);
+}
+
 bool Session::Lock(Client* pClient)
 {
 	if (mpLock && (pClient != mpLock)) return false;
@@ -115,8 +120,9 @@ bool Session::HasActiveTransaction()
 
 ///////////
 
-SessionRegistry::SessionRegistry(size_t maxSessions, double sessionTimeout) // le pasa el maximo de sesiones y el timeout de sesion
+SessionRegistry::SessionRegistry(Net::TimerQueue* pTimers, size_t maxSessions, double sessionTimeout) // le pasa el maximo de sesiones y el timeout de sesion
 {
+	mpTimers		= pTimers;
 	mMaxSessions	= maxSessions; // almacena el maximo num de sesiones 
 	mSessionTimeout	= sessionTimeout; // almacena el timeout de sesion
 }
@@ -142,6 +148,9 @@ Session* SessionRegistry::CreateSession(std::string cookie, bool keepalive, IAut
 	std::string sessionkey = GenerateName();
 	Session* pNewSession = new Session(this, sessionkey, cookie, keepalive, prio);
 	mSessions[sessionkey] = pNewSession;
+
+	// time_t has second resolution, give the deadline a second of slack
+	mpTimers->Schedule(pNewSession, mSessionTimeout + 1.0);
 	return pNewSession;
 }
 
@@ -185,31 +194,23 @@ Session* SessionRegistry::GetSessionFromCookie(const std::string& cookie) const
 	return NULL;
 }
 
-bool SessionRegistry::Tick()
+void SessionRegistry::CheckTimeout(Session* pSession)
 {
-	double timeout = mSessionTimeout;
-	time_t now = time(0);
+	double idle = difftime(time(0), pSession->LastActive());
 
-	tSessions::iterator it = mSessions.begin();
-	while(it != mSessions.end())
+	// touched since the timer was set, wait for the new deadline
+	if (idle <= mSessionTimeout)
 	{
-		// check for timeout
-		if (it->second->LastActive() < (now - timeout))
-		{
-			tSessions::iterator deleteit = it;
-			it++;
-
-			sysout << timestamp << "Session timed out: " << deleteit->second->GetNumber() << std::endl;
-			DestroySession(deleteit->second);
-			
-			mSessions.erase(deleteit);
-		}
-		else
-		{
-			it++;
-		}
+		mpTimers->Schedule(pSession, mSessionTimeout - idle + 1.0);
+		return;
 	}
-	return true;
+
+	tSessions::iterator finder = mSessions.find(pSession->GetKey());
+	if (finder == mSessions.end() || finder->second != pSession) return;
+
+	sysout << timestamp << "Session timed out: " << pSession->GetNumber() << std::endl;
+	DestroySession(pSession);
+	mSessions.erase(finder);
 }
 
 std::string	SessionRegistry::GenerateName() const
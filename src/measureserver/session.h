@@ -28,6 +28,8 @@
 #ifndef __SESSION_H__
 #define __SESSION_H__
 
+#include <network/timerqueue.h>
+
 #include <string>
 #include <map>
 
@@ -38,7 +40,7 @@ class SessionRegistry;
 
 namespace protocol { class Transaction; }
 
-class Session
+class Session : public Net::TimerHandler
 {
 public:
 	inline	size_t				GetNumber()		{ return mNumber; }
@@ -62,6 +64,8 @@ public:
 
 	void	Close();
 
+	virtual void	TimerExpired();
+
 	Session(SessionRegistry* pSessionReg, std::string key, std::string cookie, bool keepalive, int prio);
 	virtual ~Session();
 
@@ -100,9 +104,10 @@ public:
 
 	size_t		NumActiveSessions() const;
 
-	bool		Tick();
+	/// Called when a session deadline passes, destroys the session if it has been idle too long
+	void		CheckTimeout(Session* pSession);
 
-	SessionRegistry(size_t maxSessions, double sessionTimeout);
+	SessionRegistry(Net::TimerQueue* pTimers, size_t maxSessions, double sessionTimeout);
 	~SessionRegistry();
 private:
 	std::string	GenerateName() const;
@@ -115,6 +120,7 @@ private:
 	tSessions	mSessions;
 	size_t		mMaxSessions;
 	double		mSessionTimeout;
+	Net::TimerQueue*	mpTimers;
 };
 
 #endif
@@ -0,0 +1,99 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "solutioncache.h"
+
+SolutionCache::SolutionCache()
+{
+	mCapacity	= 0;
+	mHits		= 0;
+	mMisses		= 0;
+}
+
+SolutionCache::~SolutionCache()
+{
+}
+
+const SolutionCache::Entry* SolutionCache::Find(const std::string& key)
+{
+	tIndex::iterator it = mIndex.find(key);
+	if (it == mIndex.end())
+	{
+		mMisses++;
+		return NULL;
+	}
+
+	mHits++;
+	mEntries.splice(mEntries.begin(), mEntries, it->second);
+	return &it->second->second;
+}
+
+void SolutionCache::Insert(const std::string& key, const Entry& entry)
+{
+	if (mCapacity == 0) return;
+
+	tIndex::iterator it = mIndex.find(key);
+	if (it != mIndex.end())
+	{
+		it->second->second = entry;
+		mEntries.splice(mEntries.begin(), mEntries, it->second);
+		return;
+	}
+
+	mEntries.push_front(std::make_pair(key, entry));
+	mIndex[key] = mEntries.begin();
+	Trim();
+}
+
+void SolutionCache::Clear()
+{
+	mEntries.clear();
+	mIndex.clear();
+}
+
+void SolutionCache::GetEntries(tEntryMap& entries) const
+{
+	for(tEntries::const_iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+	{
+		entries[it->first] = it->second;
+	}
+}
+
+void SolutionCache::SetCapacity(size_t capacity)
+{
+	mCapacity = capacity;
+	Trim();
+}
+
+void SolutionCache::Trim()
+{
+	while(mIndex.size() > mCapacity)
+	{
+		mIndex.erase(mEntries.back().first);
+		mEntries.pop_back();
+	}
+}
@@ -0,0 +1,82 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __SOLUTION_CACHE_H__
+#define __SOLUTION_CACHE_H__
+
+#include <instruments/netlist2.h>
+
+#include <list>
+#include <map>
+#include <string>
+
+/// Bounded LRU cache of solved circuits.
+/// Circuits that can't be solved are kept as well, they cost as much to search again.
+class SolutionCache
+{
+public:
+	struct Entry
+	{
+		bool		solved;
+		int			maxlist;	///< index of the matching maxlist, -1 if not solved
+		NetList2	netlist;
+	};
+
+	///				Returns NULL if the key is unknown, a found entry becomes the most recently used
+	const Entry*	Find(const std::string& key);
+	void			Insert(const std::string& key, const Entry& entry);
+	void			Clear();
+
+	typedef std::map<std::string, Entry> tEntryMap;
+
+	///				Copies all entries, by key
+	void			GetEntries(tEntryMap& entries) const;
+
+	///				A capacity of 0 disables the cache
+	void			SetCapacity(size_t capacity);
+	size_t			GetCapacity() const	{ return mCapacity; }
+	size_t			Size() const		{ return mIndex.size(); }
+
+	size_t			NumHits() const		{ return mHits; }
+	size_t			NumMisses() const	{ return mMisses; }
+
+	SolutionCache();
+	virtual ~SolutionCache();
+private:
+	void			Trim();
+
+	typedef std::list< std::pair<std::string, Entry> > tEntries;
+	typedef std::map<std::string, tEntries::iterator> tIndex;
+
+	tEntries		mEntries;	// most recently used first
+	tIndex			mIndex;
+	size_t			mCapacity;
+	size_t			mHits;
+	size_t			mMisses;
+};
+
+#endif
@@ -0,0 +1,270 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "solutionstore.h"
+
+#include <util/byteorder.h>
+
+#include <cstdio>
+#include <string.h>
+
+static const char	sMagic[4] = { 'V', 'S', 'O', 'L' };
+static const size_t	cFingerprintSize = 16;
+static const size_t	cHeaderSize = sizeof(sMagic) + 4 + cFingerprintSize + 4 + 4;
+
+namespace
+{
+	void PutString(std::string& out, const std::string& val)
+	{
+		PutU16(out, (unsigned int)val.size());
+		out += val;
+	}
+
+	/// Bounds checked reads from the mapped file, a damaged store fails instead of reading past the end
+	class Reader
+	{
+	public:
+		Reader(const char* pData, size_t size, size_t pos) : mpData((const unsigned char*)pData), mSize(size), mPos(pos) {}
+
+		bool U8(unsigned int& val)
+		{
+			if (mPos + 1 > mSize) return false;
+			val = mpData[mPos++];
+			return true;
+		}
+
+		bool U16(unsigned int& val)
+		{
+			if (mPos + 2 > mSize) return false;
+			val = GetU16(mpData + mPos);
+			mPos += 2;
+			return true;
+		}
+
+		bool U32(unsigned int& val)
+		{
+			if (mPos + 4 > mSize) return false;
+			val = GetU32(mpData + mPos);
+			mPos += 4;
+			return true;
+		}
+
+		bool String(std::string& val)
+		{
+			unsigned int length;
+			if (!U16(length) || mPos + length > mSize) return false;
+			val.assign((const char*)mpData + mPos, length);
+			mPos += length;
+			return true;
+		}
+	private:
+		const unsigned char*	mpData;
+		size_t					mSize;
+		size_t					mPos;
+	};
+}
+
+SolutionStore::SolutionStore()
+{
+	mCount		= 0;
+	mKeySize	= 0;
+	mpIndex		= NULL;
+}
+
+SolutionStore::~SolutionStore()
+{
+}
+
+bool SolutionStore::Open(const std::string& filename, const std::string& fingerprint)
+{
+	Close();
+	if (fingerprint.size() != cFingerprintSize || !mFile.Open(filename)) return false;
+
+	const char* pData = mFile.Data();
+	unsigned int version, count, keySize;
+	Reader header(pData, mFile.Size(), sizeof(sMagic));
+	if (mFile.Size() < cHeaderSize
+		|| memcmp(pData, sMagic, sizeof(sMagic)) != 0
+		|| !header.U32(version) || version != eVersion
+		|| memcmp(pData + sizeof(sMagic) + 4, fingerprint.data(), cFingerprintSize) != 0)
+	{
+		Close();
+		return false;
+	}
+
+	Reader sizes(pData, mFile.Size(), sizeof(sMagic) + 4 + cFingerprintSize);
+	sizes.U32(count);
+	sizes.U32(keySize);
+	if (keySize == 0 || (mFile.Size() - cHeaderSize) / (keySize + 4) < count)
+	{
+		Close();
+		return false;
+	}
+
+	mCount		= count;
+	mKeySize	= keySize;
+	mpIndex		= pData + cHeaderSize;
+	return true;
+}
+
+void SolutionStore::Close()
+{
+	mFile.Close();
+	mCount		= 0;
+	mKeySize	= 0;
+	mpIndex		= NULL;
+}
+
+bool SolutionStore::Find(const std::string& key, SolutionCache::Entry& entry) const
+{
+	if (!IsOpen() || key.size() != mKeySize) return false;
+
+	// binary search straight on the mapped index
+	const size_t recordSize = mKeySize + 4;
+	size_t low = 0;
+	size_t high = mCount;
+	while (low < high)
+	{
+		const size_t mid = low + (high - low) / 2;
+		const char* pRecord = mpIndex + mid * recordSize;
+		const int cmp = memcmp(pRecord, key.data(), mKeySize);
+		if (cmp == 0)
+		{
+			unsigned int offset;
+			Reader record(mFile.Data(), mFile.Size(), (pRecord - mFile.Data()) + mKeySize);
+			return record.U32(offset) && Decode(offset, entry);
+		}
+
+		if (cmp < 0) low = mid + 1;
+		else high = mid;
+	}
+	return false;
+}
+
+bool SolutionStore::Decode(size_t offset, SolutionCache::Entry& entry) const
+{
+	Reader in(mFile.Data(), mFile.Size(), offset);
+
+	unsigned int solved, maxlist, count;
+	if (!in.U8(solved) || !in.U32(maxlist) || !in.U32(count)) return false;
+
+	ListComponent::tComponentList components;
+	for(unsigned int i = 0; i < count; i++)
+	{
+		std::string type, name, value, special;
+		unsigned int group, connections;
+		if (!in.String(type) || !in.String(name) || !in.String(value) || !in.String(special)) return false;
+		if (!in.U32(group) || !in.U8(connections) || connections > ConnectionList::eMaxConnections) return false;
+
+		ListComponent component;
+		component.SetType(type);
+		component.SetName(name);
+		component.SetValue(value);
+		component.SetSpecial(special);
+		component.SetGroup(group);
+		for(unsigned int c = 0; c < connections; c++)
+		{
+			std::string connection;
+			if (!in.String(connection)) return false;
+			component.AddConnection(connection);
+		}
+		components.push_back(component);
+	}
+
+	entry.solved	= (solved != 0);
+	entry.maxlist	= (int)maxlist;
+	entry.netlist	= NetList2();
+	if (entry.solved) entry.netlist.SetNodeList(components);
+	return true;
+}
+
+bool SolutionStore::Write(const std::string& filename, const std::string& fingerprint, const SolutionCache::tEntryMap& entries)
+{
+	if (fingerprint.size() != cFingerprintSize) return false;
+
+	// all keys of one maxlist set have the same size, the map is already sorted by key
+	const size_t keySize = entries.empty() ? 1 : entries.begin()->first.size();
+	const size_t recordSize = keySize + 4;
+
+	std::string data;
+	std::string index;
+	const size_t dataStart = cHeaderSize + entries.size() * recordSize;
+	for(SolutionCache::tEntryMap::const_iterator it = entries.begin(); it != entries.end(); ++it)
+	{
+		if (it->first.size() != keySize || dataStart + data.size() > 0xffffffffUL) return false;
+
+		index += it->first;
+		PutU32(index, (unsigned int)(dataStart + data.size()));
+
+		const SolutionCache::Entry& entry = it->second;
+		const ListComponent::tComponentList& components = entry.netlist.GetNodeList();
+		PutU8(data, entry.solved ? 1 : 0);
+		PutU32(data, (unsigned int)entry.maxlist);
+		PutU32(data, entry.solved ? (unsigned int)components.size() : 0);
+		if (!entry.solved) continue;
+
+		for(ListComponent::tComponentList::const_iterator comp = components.begin(); comp != components.end(); ++comp)
+		{
+			PutString(data, comp->GetType());
+			PutString(data, comp->GetName());
+			PutString(data, comp->GetValue());
+			PutString(data, comp->GetSpecial());
+			PutU32(data, (unsigned int)comp->GetGroup());
+			const ListComponent::tConnections& connections = comp->GetCConnections();
+			PutU8(data, (unsigned int)connections.size());
+			for(ListComponent::tConnections::const_iterator con = connections.begin(); con != connections.end(); ++con)
+			{
+				PutString(data, con->str());
+			}
+		}
+	}
+
+	std::string header(sMagic, sizeof(sMagic));
+	PutU32(header, eVersion);
+	header += fingerprint;
+	PutU32(header, (unsigned int)entries.size());
+	PutU32(header, (unsigned int)keySize);
+
+	// written next to the old store and renamed over it, a running server keeps its mapping of the old one
+	std::string tmpname = filename + ".tmp";
+	FILE* file = fopen(tmpname.c_str(), "wb");
+	if (!file) return false;
+
+	bool ok = fwrite(header.data(), header.size(), 1, file) == 1;
+	if (ok && !index.empty()) ok = fwrite(index.data(), index.size(), 1, file) == 1;
+	if (ok && !data.empty()) ok = fwrite(data.data(), data.size(), 1, file) == 1;
+	if (fclose(file) != 0) ok = false;
+	if (!ok)
+	{
+		remove(tmpname.c_str());
+		return false;
+	}
+
+#ifdef _WIN32
+	remove(filename.c_str());
+#endif
+	return rename(tmpname.c_str(), filename.c_str()) == 0;
+}
@@ -0,0 +1,74 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __SOLUTION_STORE_H__
+#define __SOLUTION_STORE_H__
+
+#include "solutioncache.h"
+
+#include <util/mappedfile.h>
+
+#include <string>
+
+/// Read only file of solved circuits, built offline and mapped by the server to warm up the solution cache.
+/// The keys are solution cache keys. The file carries a fingerprint of the component types and maxlists
+/// it was solved against, a store built for other lists is rejected when it is opened.
+///
+/// Layout, all numbers little endian:
+///   header	"VSOL", u32 version, 16 byte fingerprint, u32 entry count, u32 key size
+///   index	entry count records of key bytes and the u32 file offset of the entry, sorted by key
+///   entries	u8 solved, i32 maxlist, u32 component count, then per component the type, name, value
+///				and special strings, u32 group, u8 connection count and the connection strings.
+///				Strings are a u16 length and the bytes
+class SolutionStore
+{
+public:
+	enum { eVersion = 1 };
+
+	///				Returns false if the file can't be read, is damaged or doesn't match the fingerprint
+	bool			Open(const std::string& filename, const std::string& fingerprint);
+	void			Close();
+
+	bool			IsOpen() const	{ return mFile.IsOpen(); }
+	size_t			Size() const	{ return mCount; }
+
+	///				Decodes the entry of the key, false if there is none
+	bool			Find(const std::string& key, SolutionCache::Entry& entry) const;
+
+	static bool		Write(const std::string& filename, const std::string& fingerprint, const SolutionCache::tEntryMap& entries);
+
+	SolutionStore();
+	virtual ~SolutionStore();
+private:
+	bool			Decode(size_t offset, SolutionCache::Entry& entry) const;
+
+	MappedFile		mFile;
+	size_t			mCount;
+	size_t			mKeySize;
+	const char*		mpIndex;
+};
+
+#endif
@@ -0,0 +1,204 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "solverpool.h"
+
+#include <instruments/circuitlist.h>
+#include <instruments/circuitsolver3.h>
+#include <util/atomic.h>
+
+void SolverPool::Worker::Run()
+{
+	mpPool->WorkerLoop();
+}
+
+SolverPool::SolverPool()
+{
+	mStopping	= false;
+	mHeuristics	= CircuitSolver3::eAllHeuristics;
+	mMaxNodes	= 0;
+	mMaxSeconds	= 0;
+	mpBudget	= NULL;
+	mpCircuit	= NULL;
+	mpMaxLists	= NULL;
+	mNext		= 0;
+	mBest		= 0;
+	mActive		= 0;
+}
+
+SolverPool::~SolverPool()
+{
+	Stop();
+}
+
+bool SolverPool::Start(int numThreads)
+{
+	for(int i = 0; i < numThreads; i++)
+	{
+		Worker* pWorker = new Worker(this);
+		if (!pWorker->Start())
+		{
+			delete pWorker;
+			return false;
+		}
+		mWorkers.push_back(pWorker);
+	}
+	return true;
+}
+
+void SolverPool::Stop()
+{
+	{
+		ScopedLock lock(mMutex);
+		mStopping = true;
+		mWork.Broadcast();
+	}
+
+	for(tWorkers::iterator it = mWorkers.begin(); it != mWorkers.end(); ++it)
+	{
+		(*it)->Join();
+		delete *it;
+	}
+	mWorkers.clear();
+	mStopping = false;
+}
+
+int SolverPool::SolveFirst(const tCircuit& circuit, const tMaxLists& maxlists, NetList2& solution, tResults& results, tStats& stats, SolverBudget* pBudget, const tOrder* pOrder)
+{
+	ScopedLock lock(mMutex);
+
+	if (pOrder && pOrder->size() == maxlists.size()) mOrder = *pOrder;
+	else
+	{
+		mOrder.resize(maxlists.size());
+		for(size_t i = 0; i < mOrder.size(); i++) mOrder[i] = i;
+	}
+
+	mpCircuit	= &circuit;
+	mpMaxLists	= &maxlists;
+	mNext		= 0;
+	mBest		= maxlists.size();
+	mActive		= 0;
+	mResults.assign(maxlists.size(), eNotTried);
+	mStats.assign(maxlists.size(), SolverStats());
+	mpBudget	= pBudget;
+	mCancel.assign(maxlists.size(), 0);
+
+	mWork.Broadcast();
+
+	// help out until all lists are handed out, then wait for the workers to finish theirs
+	while (HasWork()) SolveNext();
+	while (mActive > 0) mDone.Wait(mMutex);
+
+	int rv = -1;
+	if (mBest < maxlists.size())
+	{
+		rv = (int)mBest;
+		solution = mSolution;
+	}
+	results.swap(mResults);
+	stats.swap(mStats);
+
+	mpBudget	= NULL;
+	mpCircuit	= NULL;
+	mpMaxLists	= NULL;
+	mSolution	= NetList2();
+	return rv;
+}
+
+void SolverPool::WorkerLoop()
+{
+	ScopedLock lock(mMutex);
+	while (!mStopping)
+	{
+		if (HasWork()) SolveNext();
+		else mWork.Wait(mMutex);
+	}
+}
+
+bool SolverPool::HasWork() const
+{
+	// there is no point in starting on lists after one that has already solved, or when the budget is spent
+	if (!mpMaxLists || (mpBudget && mpBudget->IsExhausted())) return false;
+	for(size_t i = mNext; i < mOrder.size(); i++)
+	{
+		if (mOrder[i] < mBest) return true;
+	}
+	return false;
+}
+
+void SolverPool::SolveNext()
+{
+	while (mOrder[mNext] >= mBest) mNext++;
+	size_t index = mOrder[mNext++];
+	mActive++;
+
+	NetList2 solved;
+	SolverStats stats;
+	mMutex.Unlock();
+	Result result = SolveOne(index, solved, stats);
+	mMutex.Lock();
+
+	mActive--;
+	mResults[index] = result;
+	mStats[index] = stats;
+	if (result == eSolved && index < mBest)
+	{
+		mBest = index;
+		mSolution = solved;
+		for(size_t i = index + 1; i < mCancel.size(); i++) AtomicStore(&mCancel[i], 1);
+	}
+
+	if (mActive == 0) mDone.Broadcast();
+}
+
+SolverPool::Result SolverPool::SolveOne(size_t index, NetList2& solution, SolverStats& stats)
+{
+	const NetList2* pMaxList = (*mpMaxLists)[index];
+	if (!pMaxList) return eNotTried;
+
+	CircuitList aList;
+	aList.SetCancelFlag(&mCancel[index]);
+	aList.SetHeuristics(mHeuristics);
+	aList.SetBudget(mMaxNodes, mMaxSeconds);
+	aList.SetSharedBudget(mpBudget);
+	const bool solved = aList.Solve(*mpCircuit, pMaxList->GetNodeList());
+	stats = aList.GetStats();
+
+	if (!solved)
+	{
+		if (AtomicLoad(&mCancel[index])) return eNotTried;
+		return stats.aborted ? eTooComplex : eFailed;
+	}
+
+	solution.SetNodeList(aList.GetSolution());
+
+	// ugly fix.. this should be done inside the solver
+	// the problem is that instrument nodes can be introduces that is not allowed
+	if (!solution.IsSubsetOf(*pMaxList)) return eNotSubset;
+	return eSolved;
+}
@@ -0,0 +1,123 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __SOLVER_POOL_H__
+#define __SOLVER_POOL_H__
+
+#include <instruments/netlist2.h>
+#include <instruments/solverbudget.h>
+#include <util/thread.h>
+
+#include <vector>
+
+/// Solves a circuit against several maxlists at once.
+/// The result is the same as trying the lists in order, the lowest index that solves wins
+/// and searches on higher indices are cancelled as soon as it is found.
+/// The lists can be handed out in another order, a list that solves is then confirmed by
+/// searching the lower indices that haven't been tried.
+class SolverPool
+{
+public:
+	enum Result
+	{
+		eNotTried,		///< skipped or cancelled
+		eSolved,
+		eNotSubset,		///< solved, but the solution uses nodes the maxlist doesn't have
+		eFailed,
+		eTooComplex		///< the search ran out of budget
+	};
+
+	typedef std::vector<ListComponent>		tCircuit;
+	typedef std::vector<const NetList2*>	tMaxLists;
+	typedef std::vector<Result>				tResults;
+	typedef std::vector<SolverStats>		tStats;
+	typedef std::vector<size_t>				tOrder;
+
+	///		Start the worker threads, with no workers everything is solved by the calling thread
+	bool	Start(int numThreads);
+	void	Stop();
+	size_t	NumThreads() const { return mWorkers.size(); }
+
+	///		Search heuristics passed to the solvers, see CircuitSolver3::SetHeuristics. Set it before solving
+	void	SetHeuristics(int heuristics) { mHeuristics = heuristics; }
+
+	///		Work limit for each maxlist search, see CircuitSolver3::SetBudget. Set it before solving
+	void	SetBudget(size_t maxNodes, double maxSeconds) { mMaxNodes = maxNodes; mMaxSeconds = maxSeconds; }
+
+	///		NULL entries in maxlists are skipped.
+	///		Returns the index of the first maxlist that solved, or -1, results holds the outcome per list.
+	///		The calling thread takes part in the search, only one solve can run at a time.
+	///		stats holds what each search did, all searches also spend from pBudget if it is set.
+	///		pOrder lists the maxlist indices in the order to start them in, by default it is index order.
+	int		SolveFirst(const tCircuit& circuit, const tMaxLists& maxlists, NetList2& solution, tResults& results, tStats& stats, SolverBudget* pBudget = NULL, const tOrder* pOrder = NULL);
+
+	SolverPool();
+	virtual ~SolverPool();
+private:
+	class Worker : public Thread
+	{
+	public:
+		Worker(SolverPool* pPool) : mpPool(pPool) {}
+		virtual void Run();
+	private:
+		SolverPool* mpPool;
+	};
+
+	void	WorkerLoop();
+
+	// mutex must be held
+	bool	HasWork() const;
+	void	SolveNext();
+
+	Result	SolveOne(size_t index, NetList2& solution, SolverStats& stats);
+
+	typedef std::vector<Worker*>	tWorkers;
+	tWorkers		mWorkers;
+
+	Mutex			mMutex;
+	Condition		mWork;
+	Condition		mDone;
+	bool			mStopping;
+	int				mHeuristics;
+	size_t			mMaxNodes;
+	double			mMaxSeconds;
+
+	// the current job, protected by mMutex
+	const tCircuit*		mpCircuit;
+	const tMaxLists*	mpMaxLists;
+	tOrder				mOrder;		// indices to start in order, mNext is the position in it
+	size_t				mNext;
+	size_t				mBest;
+	size_t				mActive;
+	NetList2			mSolution;
+	tResults			mResults;
+	tStats				mStats;
+	SolverBudget*		mpBudget;
+	std::vector<int>	mCancel;	// one flag per maxlist, polled by the solvers
+};
+
+#endif
@@ -36,6 +36,7 @@ class SystemTransactionHandler : public protocol::TransactionHandler
 {
 public:
 	virtual bool	CanHandle(protocol::Transaction* pTransaction);
+	virtual bool	NeedsEquipment()	{ return false; }
 	virtual bool	Perform(protocol::Transaction* pTransaction, protocol::TransactionCallback* pCallback);
 	virtual bool	Cancel(protocol::Transaction* pTransaction, protocol::TransactionCallback* pCallback);
 
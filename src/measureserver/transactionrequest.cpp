@@ -77,6 +77,9 @@ void TransactionRequest::Send()
 
 	mHasBeenSent = true;
 
+	// scheduled before performing, the transaction may finish (and delete us) right away
+	mpQueue->GetTimerQueue()->Schedule(this, mTimeout);
+
 	if (mpOwner)
 	{
 		try
@@ -103,7 +106,19 @@ void TransactionRequest::Send()
 
 bool TransactionRequest::BuildRequest()
 {
-	return true;
+	// validating, solving and serializing happens now, the queue head only has to send.
+	// Throws when the transaction can't be carried out, it is then never queued
+	timer preparetimer;
+	const bool prepared = mpHandler->Prepare(mpTransaction, this);
+	LogLevel(timerlog,4) << timestamp << "TransactionRequest::BuildRequest prepared in " << preparetimer.elapsed() << std::endl;
+	return prepared;
+}
+
+const std::vector<std::string>* TransactionRequest::GetSwitched()
+{
+	protocol::PreparedData* pPrepared = mpTransaction ? mpTransaction->GetPrepared() : NULL;
+	if (!pPrepared) return NULL;
+	return &pPrepared->switched;
 }
 
 // This should NOT delete the instance..
@@ -130,6 +145,13 @@ bool TransactionRequest::HasTimedOut()
 	return false;	
 }
 
+void TransactionRequest::TimerExpired()
+{
+	if (HasTimedOut()) return; // we are gone
+
+	mpQueue->GetTimerQueue()->Schedule(this, mTimeout - mTimer.elapsed());
+}
+
 InstrumentBlock* TransactionRequest::GetInstrumentBlock()
 {
 	if (!mpOwner) return NULL;
@@ -174,7 +196,7 @@ void TransactionRequest::TransactionDone()
 	{
 		Session* pSession = mpOwner->GetSession();
 		if (pSession) pSession->SetActiveTransaction(NULL); // no active transaction
-		mpTransaction->GetIssuer()->TransactionComplete(mpTransaction);
+		if (mpTransaction->GetIssuer()->TransactionComplete(mpTransaction)) mpTransaction = NULL;
 	}
 	RequestDone(); // this will delete us
 }
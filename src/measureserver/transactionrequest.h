@@ -32,6 +32,7 @@
 #include "request.h"
 
 #include <protocol/protocol.h>
+#include <network/timerqueue.h>
 #include <timer.h>
 
 class Session;
@@ -39,13 +40,16 @@ class TransactionControl;
 
 /// Represents a request to the measurement server
 // xxx: merge this with request, no other request types will ever be needed..
-class TransactionRequest : public Request , public protocol::TransactionCallback
+class TransactionRequest : public Request , public protocol::TransactionCallback, public Net::TimerHandler
 {
 public:
 	virtual void	Send();
 	virtual bool	BuildRequest();
 	virtual bool	HasTimedOut();
 	virtual void	Cancel();
+	virtual const std::vector<std::string>*	GetSwitched();
+
+	virtual void	TimerExpired();
 
 	virtual void	RequestDone();
 
@@ -0,0 +1,106 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "bufferpool.h"
+#include <util/thread.h>
+
+using namespace Net;
+
+// 4k covers the usual http and xml request, 128k is MAX_REQUEST_SIZE of the connections
+static const size_t sClassSize[] = { 4*1024, 16*1024, 64*1024, 128*1024 };
+static const size_t sMaxFree[] = { 64, 32, 8, 4 };
+
+BufferPool& BufferPool::Instance()
+{
+	// one pool per thread so the reactor threads never contend,
+	// never destroyed, buffers may be released during static destruction
+	static THREAD_LOCAL BufferPool* spPool = NULL;
+	if (!spPool) spPool = new BufferPool();
+	return *spPool;
+}
+
+BufferPool::BufferPool()
+{
+}
+
+BufferPool::~BufferPool()
+{
+	for(int i = 0; i < eNumClasses; i++)
+	{
+		for(tChunks::iterator it = mFree[i].begin(); it != mFree[i].end(); it++)
+		{
+			delete [] *it;
+		}
+	}
+}
+
+int BufferPool::SizeClass(size_t size) const
+{
+	for(int i = 0; i < eNumClasses; i++)
+	{
+		if (size <= sClassSize[i]) return i;
+	}
+	return -1;
+}
+
+char* BufferPool::Allocate(size_t minsize, size_t& size)
+{
+	int sc = SizeClass(minsize);
+	if (sc < 0)
+	{
+		size = minsize;
+		return new char[size];
+	}
+
+	size = sClassSize[sc];
+	if (mFree[sc].empty()) return new char[size];
+
+	char* pChunk = mFree[sc].back();
+	mFree[sc].pop_back();
+	return pChunk;
+}
+
+void BufferPool::Release(char* pChunk, size_t size)
+{
+	if (!pChunk) return;
+
+	int sc = SizeClass(size);
+	if (sc < 0 || sClassSize[sc] != size || mFree[sc].size() >= sMaxFree[sc])
+	{
+		delete [] pChunk;
+		return;
+	}
+
+	mFree[sc].push_back(pChunk);
+}
+
+size_t BufferPool::NumFree() const
+{
+	size_t num = 0;
+	for(int i = 0; i < eNumClasses; i++) num += mFree[i].size();
+	return num;
+}
@@ -0,0 +1,65 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __NETWORK_BUFFERPOOL_H__
+#define __NETWORK_BUFFERPOOL_H__
+
+#include <vector>
+#include <stddef.h>
+
+namespace Net
+{
+
+/// Size classed free lists of I/O buffer chunks, shared by all connections of a thread.
+/// Idle connections hand their chunks back, so memory follows the number of active reads.
+/// Chunks larger than the biggest class are allocated and freed directly.
+class BufferPool
+{
+public:
+	static BufferPool&	Instance();
+
+	///			Get a chunk of at least minsize bytes, the actual chunk size is returned in size
+	char*		Allocate(size_t minsize, size_t& size);
+	void		Release(char* pChunk, size_t size);
+
+	///			Number of chunks kept in the free lists
+	size_t		NumFree() const;
+
+	BufferPool();
+	virtual ~BufferPool();
+private:
+	enum { eNumClasses = 4 };
+
+	int			SizeClass(size_t size) const;
+
+	typedef std::vector< char* > tChunks;
+	tChunks		mFree[eNumClasses];
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,298 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "multiplexerbackend.h"
+
+#ifdef __linux__
+
+#include "sockethandler.h"
+#include "socket.h"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <syslog.h>
+
+#include <map>
+#include <list>
+#include <vector>
+
+using namespace Net;
+
+namespace {
+
+class EpollBackend;
+
+/// Bookkeeping for one registered handler.
+/// The pointer is stored in the epoll event, so dispatching needs no lookups.
+struct Registration : public SelectMaskListener
+{
+	virtual void SelectMaskChanged(Socket* pSocket);
+
+	EpollBackend*	mpBackend;
+	SocketHandler*	mpHandler;
+	Socket*			mpSocket;
+	opaque_socket	mFd;		// descriptor registered in the kernel, -1 if none
+	int				mMask;		// mask registered in the kernel
+	bool			mRemoved;
+};
+
+/// Registers interest once and only updates it when a socket changes its select mask.
+/// Wait cost scales with the number of active sockets instead of the total.
+class EpollBackend : public MultiplexerBackend
+{
+public:
+	virtual bool	Init();
+
+	virtual void	AddHandler(SocketHandler* handler);
+	virtual void	RemoveHandler(SocketHandler* handler);
+
+	virtual bool	WaitForEvent(int timeout_ms);
+
+	virtual const char*	GetName() const { return "epoll"; }
+
+	void	Update(Registration* pReg);
+
+			EpollBackend();
+	virtual ~EpollBackend();
+private:
+	static unsigned int	ToEvents(int mask);
+	static int			ToFlags(unsigned int events, int mask);
+
+	typedef std::map< Socket*, Registration* > tRegistrations;
+	typedef std::list< Registration* > tGraveyard;
+	typedef std::vector< epoll_event > tEvents;
+
+	int					mEpollFd;
+	tRegistrations		mRegistrations;
+	tGraveyard			mGraveyard;		// removed while dispatching, freed after the round
+	tEvents				mEvents;
+	bool				mDispatching;
+};
+
+} // end of anonymous namespace
+
+void Registration::SelectMaskChanged(Socket* pSocket)
+{
+	mpBackend->Update(this);
+}
+
+EpollBackend::EpollBackend()
+{
+	mEpollFd = -1;
+	mDispatching = false;
+	mEvents.resize(64);
+}
+
+EpollBackend::~EpollBackend()
+{
+	for(tRegistrations::iterator it = mRegistrations.begin(); it != mRegistrations.end(); it++)
+	{
+		it->first->SetSelectMaskListener(NULL);
+		delete it->second;
+	}
+
+	while(!mGraveyard.empty())
+	{
+		delete mGraveyard.front();
+		mGraveyard.pop_front();
+	}
+
+	if (mEpollFd != -1) close(mEpollFd);
+}
+
+bool EpollBackend::Init()
+{
+	mEpollFd = epoll_create(256); // size is only a hint
+	if (mEpollFd == -1)
+	{
+		syserr << timestamp << "epoll_create failed (" << errno << ")" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+unsigned int EpollBackend::ToEvents(int mask)
+{
+	unsigned int events = 0;
+	if (mask & NET_READ_FLAG)		events |= EPOLLIN;
+	if (mask & NET_WRITE_FLAG)		events |= EPOLLOUT;
+	if (mask & NET_EXCEPTION_FLAG)	events |= EPOLLPRI;
+	return events;
+}
+
+int EpollBackend::ToFlags(unsigned int events, int mask)
+{
+	int flags = 0;
+	if (events & EPOLLIN)	flags |= NET_READ_FLAG;
+	if (events & EPOLLOUT)	flags |= NET_WRITE_FLAG;
+	if (events & EPOLLPRI)	flags |= NET_EXCEPTION_FLAG;
+
+	// select reports broken sockets as readable/writable, let the handler find out on recv/send
+	if (events & (EPOLLERR | EPOLLHUP))
+	{
+		int rw = mask & (NET_READ_FLAG | NET_WRITE_FLAG);
+		flags |= rw ? rw : NET_EXCEPTION_FLAG;
+	}
+
+	return flags & (mask | NET_EXCEPTION_FLAG);
+}
+
+void EpollBackend::Update(Registration* pReg)
+{
+	opaque_socket fd = pReg->mpSocket->GetHandle();
+	int mask = pReg->mpSocket->GetSelectMask();
+
+	if (fd == pReg->mFd && mask == pReg->mMask) return;
+
+	epoll_event ev;
+	ev.events = ToEvents(mask);
+	ev.data.ptr = pReg;
+
+	if (fd != pReg->mFd)
+	{
+		// the old descriptor is closed, and closing removes it from the epoll set
+		pReg->mFd = fd;
+		if (fd == -1) return;
+
+		if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &ev) == -1)
+		{
+			if (errno != EEXIST || epoll_ctl(mEpollFd, EPOLL_CTL_MOD, fd, &ev) == -1)
+			{
+				syserr << timestamp << "epoll_ctl add failed (" << errno << ")" << std::endl;
+			}
+		}
+	}
+	else if (epoll_ctl(mEpollFd, EPOLL_CTL_MOD, fd, &ev) == -1)
+	{
+		syserr << timestamp << "epoll_ctl mod failed (" << errno << ")" << std::endl;
+	}
+
+	pReg->mMask = mask;
+}
+
+void EpollBackend::AddHandler(SocketHandler* handler)
+{
+	Socket* pSocket = handler->GetSocket();
+
+	Registration* pReg = new Registration();
+	pReg->mpBackend	= this;
+	pReg->mpHandler	= handler;
+	pReg->mpSocket	= pSocket;
+	pReg->mFd		= -1;
+	pReg->mMask		= 0;
+	pReg->mRemoved	= false;
+
+	tRegistrations::iterator finder = mRegistrations.find(pSocket);
+	if (finder != mRegistrations.end())
+	{
+		// replaces the old handler, like the select backend does
+		finder->second->mRemoved = true;
+		mGraveyard.push_back(finder->second);
+		finder->second = pReg;
+	}
+	else
+	{
+		mRegistrations[pSocket] = pReg;
+	}
+
+	pSocket->SetSelectMaskListener(pReg);
+	Update(pReg);
+}
+
+void EpollBackend::RemoveHandler(SocketHandler* handler)
+{
+	Socket* pSocket = handler->GetSocket();
+
+	tRegistrations::iterator finder = mRegistrations.find(pSocket);
+	if (finder == mRegistrations.end()) return;
+
+	Registration* pReg = finder->second;
+	mRegistrations.erase(finder);
+
+	// only remove if the descriptor still belongs to the socket
+	if (pReg->mFd != -1 && pSocket->GetHandle() == pReg->mFd)
+	{
+		epoll_event ev; // non-null pointer needed by older kernels
+		epoll_ctl(mEpollFd, EPOLL_CTL_DEL, pReg->mFd, &ev);
+	}
+
+	pSocket->SetSelectMaskListener(NULL);
+	pReg->mRemoved = true;
+
+	// events for this handler may still be pending in the current round
+	if (mDispatching) mGraveyard.push_back(pReg);
+	else delete pReg;
+}
+
+bool EpollBackend::WaitForEvent(int timeout_ms)
+{
+	int n = epoll_wait(mEpollFd, &mEvents[0], (int)mEvents.size(), timeout_ms);
+	if (n < 0)
+	{
+		if (errno == EINTR) return true;
+		syserr << timestamp << "epoll_wait failed (" << errno << ")" << std::endl;
+		return false;
+	}
+
+	mDispatching = true;
+	for(int i=0; i<n; i++)
+	{
+		Registration* pReg = (Registration*) mEvents[i].data.ptr;
+		if (pReg->mRemoved) continue;
+
+		int flags = ToFlags(mEvents[i].events, pReg->mMask);
+		if (flags) pReg->mpHandler->HandleEvent(flags);
+	}
+	mDispatching = false;
+
+	while(!mGraveyard.empty())
+	{
+		delete mGraveyard.front();
+		mGraveyard.pop_front();
+	}
+
+	// a full event list means there might be more pending, take more next time
+	if (n == (int)mEvents.size()) mEvents.resize(mEvents.size() * 2);
+
+	return true;
+}
+
+MultiplexerBackend* Net::CreateEpollBackend()
+{
+	return new EpollBackend();
+}
+
+#else
+
+Net::MultiplexerBackend* Net::CreateEpollBackend()
+{
+	return 0;
+}
+
+#endif
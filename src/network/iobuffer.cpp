@@ -27,20 +27,37 @@
 
 #include "iobuffer.h"
 #include "connection.h"
+#include "bufferpool.h"
 
 #include <iostream>
 #include <syslog.h>
 
-#include <vector>
+#include <deque>
+#include <string.h>
 
 using namespace Net;
 
+/// A part of the send buffer, either owned (mData) or borrowed (mpBorrowed)
+struct SendSegment
+{
+	std::string	mData;
+	const char*	mpBorrowed;
+	size_t		mSize;
+	bool		mFilled;	// copied by Fill, small fills may be appended
+
+	const char* Data() const { return mpBorrowed ? mpBorrowed : mData.data(); }
+};
+
 struct Net::IOBuffer_internal
 {
-	typedef std::vector<char> tByteBuffer;
-	tByteBuffer mBuffer;
+	// a deque keeps the segments in place when more are added
+	typedef std::deque<SendSegment> tSegments;
+	tSegments mSegments;
 };
 
+// fills up to this size are merged into the previous copied segment
+#define MERGE_FILL_SIZE 1024
+
 SendBuffer::SendBuffer()
 {
 	mWrap = new IOBuffer_internal();
@@ -52,83 +69,201 @@ SendBuffer::~SendBuffer()
 	delete mWrap;
 }
 
-bool SendBuffer::Fill(void* pData, size_t size)
+bool SendBuffer::Fill(const void* pData, size_t size)
+{
+	if (size == 0) return true;
+
+	IOBuffer_internal::tSegments& segments = mWrap->mSegments;
+	if (!segments.empty() && segments.back().mFilled && size <= MERGE_FILL_SIZE)
+	{
+		SendSegment& last = segments.back();
+		last.mData.append((const char*)pData, size);
+		last.mSize = last.mData.size();
+		return true;
+	}
+
+	segments.push_back(SendSegment());
+	SendSegment& segment = segments.back();
+	segment.mData.assign((const char*)pData, size);
+	segment.mpBorrowed	= NULL;
+	segment.mSize		= size;
+	segment.mFilled		= true;
+	return true;
+}
+
+bool SendBuffer::Take(std::string& data)
+{
+	if (data.empty()) return true;
+
+	mWrap->mSegments.push_back(SendSegment());
+	SendSegment& segment = mWrap->mSegments.back();
+	segment.mData.swap(data);
+	segment.mpBorrowed	= NULL;
+	segment.mSize		= segment.mData.size();
+	segment.mFilled		= false;
+	return true;
+}
+
+bool SendBuffer::Borrow(const void* pData, size_t size)
 {
-	mWrap->mBuffer.insert(mWrap->mBuffer.end(), (char*)pData, (char*)pData + size);
+	if (size == 0) return true;
+
+	mWrap->mSegments.push_back(SendSegment());
+	SendSegment& segment = mWrap->mSegments.back();
+	segment.mpBorrowed	= (const char*)pData;
+	segment.mSize		= size;
+	segment.mFilled		= false;
 	return true;
 }
 
 bool SendBuffer::Clear()
 {
 	mOffset = 0;
-	mWrap->mBuffer.clear();
+	mWrap->mSegments.clear();
 	return true;
 }
 
 bool SendBuffer::Empty()
 {
-	return mWrap->mBuffer.empty();
+	return mWrap->mSegments.empty();
 }
 
 int SendBuffer::Send(Connection* pConnection)
 {
-	size_t len = mWrap->mBuffer.size() - mOffset;
-	int rv = pConnection->Send(&mWrap->mBuffer[0], len);
+	IOBuffer_internal::tSegments& segments = mWrap->mSegments;
+	if (segments.empty()) return 1;
+
+	IOSegment iov[NET_MAX_SEGMENTS];
+	size_t count = 0;
+	for(IOBuffer_internal::tSegments::iterator it = segments.begin(); it != segments.end() && count < NET_MAX_SEGMENTS; it++)
+	{
+		size_t skip = (count == 0) ? mOffset : 0;
+		iov[count].pData	= it->Data() + skip;
+		iov[count].length	= it->mSize - skip;
+		count++;
+	}
+
+	int rv = (count == 1) ? pConnection->Send(iov[0].pData, iov[0].length) : pConnection->SendV(iov, count);
 	if (rv <= 0) return -1;
 
-	mOffset += rv;
-	if (mWrap->mBuffer.size() == mOffset) return 1;
-	return 0;
-}
+	// drop the segments that went out completely
+	size_t sent = rv;
+	while(!segments.empty())
+	{
+		size_t left = segments.front().mSize - mOffset;
+		if (sent < left)
+		{
+			mOffset += sent;
+			break;
+		}
+
+		sent -= left;
+		mOffset = 0;
+		segments.pop_front();
+	}
 
+	return segments.empty() ? 1 : 0;
+}
 
 ReceiveBuffer::ReceiveBuffer()
 {
-	mWrap = new IOBuffer_internal();
+	mpData		= NULL;
+	mCapacity	= 0;
+	mStart		= 0;
+	mEnd		= 0;
 }
 
 ReceiveBuffer::~ReceiveBuffer()
 {
-	delete mWrap;
+	Release();
 }
 
 int ReceiveBuffer::Receive(Connection* pConnection, size_t length)
 {
-	size_t remaining = length - mWrap->mBuffer.size();
-	if (remaining == 0) return 1;
+	size_t size = mEnd - mStart;
+	if (size >= length) return 1;
+	size_t remaining = length - size;
 
-	std::vector<char> tmpbuffer(remaining);
-	
-	int rv = pConnection->Receive(&tmpbuffer[0], remaining);
-	if (rv <= 0) return -1;
-	else
+	if (mCapacity - mEnd < remaining)
+	{
+		// wrap around, move the unconsumed bytes to the front of the chunk
+		if (mStart > 0)
+		{
+			memmove(mpData, mpData + mStart, size);
+			mStart	= 0;
+			mEnd	= size;
+		}
+
+		// full, step up to the next chunk size
+		if (mEnd == mCapacity)
+		{
+			size_t wanted = (mCapacity > 0) ? mCapacity * 2 : 1;
+			if (wanted > length) wanted = length;
+			Reserve(wanted);
+		}
+	}
+
+	size_t space = mCapacity - mEnd;
+	if (space > remaining) space = remaining;
+
+	int rv = pConnection->Receive(mpData + mEnd, space);
+	if (rv <= 0)
 	{
-		mWrap->mBuffer.insert(mWrap->mBuffer.end(), &tmpbuffer[0], &tmpbuffer[0] + rv);
+		if (mStart == mEnd) Release();
+		return -1;
 	}
 
-	return (mWrap->mBuffer.size() == length) ? 1 : 0;
+	mEnd += rv;
+	return (mEnd - mStart == length) ? 1 : 0;
+}
+
+void ReceiveBuffer::Reserve(size_t size)
+{
+	size_t used = mEnd - mStart;
+	if (size < used) size = used;
+
+	size_t capacity = 0;
+	char* pData = BufferPool::Instance().Allocate(size, capacity);
+	if (used > 0) memcpy(pData, mpData + mStart, used);
+
+	Release();
+	mpData		= pData;
+	mCapacity	= capacity;
+	mEnd		= used;
+}
+
+void ReceiveBuffer::Release()
+{
+	BufferPool::Instance().Release(mpData, mCapacity);
+	mpData		= NULL;
+	mCapacity	= 0;
+	mStart		= 0;
+	mEnd		= 0;
 }
 
 void* ReceiveBuffer::GetBuffer() const
 {
-	return &mWrap->mBuffer[0];
+	return mpData + mStart;
 }
 
 size_t ReceiveBuffer::GetSize() const
 {
-	return mWrap->mBuffer.size();
+	return mEnd - mStart;
 }
 
 void ReceiveBuffer::Clear()
 {
-	mWrap->mBuffer.clear();
+	Release();
 }
 
 void ReceiveBuffer::EraseFront(size_t length)
 {
-	//std::vector<char>& test = mWrap->mBuffer;
-	//size_t before = test.size();
-	mWrap->mBuffer.erase(mWrap->mBuffer.begin(), mWrap->mBuffer.begin() + length);
+	if (length >= mEnd - mStart)
+	{
+		// idle buffers don't keep their chunk
+		Release();
+		return;
+	}
 
-	//size_t after = test.size();
-}
\ No newline at end of file
+	mStart += length;
+}
@@ -33,6 +33,8 @@
 #include <unistd.h>
 #endif
 
+#include <string>
+
 namespace Net
 {
 
@@ -40,30 +42,48 @@ class Connection;
 
 struct IOBuffer_internal;
 
+/// Scatter/gather send buffer.
+/// Holds a list of segments that are flushed with a single gathered send.
+/// Segments are either copied (Fill), taken over without copying (Take) or borrowed from the caller (Borrow).
 class SendBuffer
 {
 public:
-	bool Fill(void* pData, size_t size);
+	/// Copy data into the buffer, small fills are merged into the last copied segment
+	bool Fill(const void* pData, size_t size);
+
+	/// Take over the contents of data without copying, data is left empty
+	bool Take(std::string& data);
+
+	/// Queue data owned by the caller, it must stay valid until it is sent or the buffer is cleared
+	bool Borrow(const void* pData, size_t size);
+
 	bool Clear();
 
 	bool Empty();
 
+	/// Returns 1 when everything is sent, 0 if there is more to send and -1 on error
 	int Send(Connection* pConnection);
 
 	SendBuffer();
 	virtual ~SendBuffer();
 private:
 	IOBuffer_internal* mWrap;
-	size_t	mOffset;
+	size_t	mOffset;	// bytes of the first segment already sent
 };
 
 /////////////////
 
+/// Contiguous receive buffer.
+/// Data is read straight into the free space after the buffered bytes and consumed by moving the start index.
+/// The received bytes are always contiguous, so GetBuffer can be parsed in place.
+/// Storage comes from the BufferPool and is handed back when the buffer runs empty.
 class ReceiveBuffer
 {
 public:
+	/// Read until length bytes are buffered, returns 1 when complete, 0 if more is needed and -1 on error
 	int Receive(Connection* pConnection, size_t length);
 
+	/// Start of the unconsumed data, valid until the next Receive, Clear or EraseFront
 	void* GetBuffer() const;
 	size_t GetSize() const;
 
@@ -73,7 +93,13 @@ public:
 	ReceiveBuffer();
 	virtual ~ReceiveBuffer();
 private:
-	IOBuffer_internal* mWrap;
+	void	Reserve(size_t size);
+	void	Release();
+
+	char*	mpData;
+	size_t	mCapacity;
+	size_t	mStart;
+	size_t	mEnd;
 };
 
 } // end namespace
@@ -26,6 +26,7 @@
  */
 
 #include "multiplexer.h"
+#include "multiplexerbackend.h"
 #include "server.h"
 #include <syslog.h>
 
@@ -33,70 +34,89 @@ using namespace Net;
 
 Multiplexer::Multiplexer()
 {
+	mpBackend = NULL;
 }
 
 Multiplexer::~Multiplexer()
 {
+	delete mpBackend;
 }
 
-
-bool Multiplexer::WaitForEvent(int timeout_ms)
+bool Multiplexer::Init(BackendType type)
 {
-	tSockets out;
-	
-	if (mSockets.empty()) return true; // this will lead to a spin...
-
-	if (Net::Socket::Select(mSockets,out,timeout_ms) < 0)
-	{
-		syserr << timestamp << "Select failed (" << (unsigned int)mSockets.size() << ")" << std::endl;
-		return false;
-	}
+	delete mpBackend;
+	mpBackend = NULL;
 
-	// this doesn't guard against handlers going away in the event handling
-	for(tSockets::const_iterator i=out.begin(); i!= out.end(); i++)
+	if (type == eEpoll)
 	{
-		// check if socket is still alive before calling handle event
-		tHandlers::const_iterator finder = mHandlers.find(*i);
-		if (finder != mHandlers.end())
+		mpBackend = CreateEpollBackend();
+		if (mpBackend && !mpBackend->Init())
 		{
-			mHandlers[*i]->HandleEvent((*i)->GetSelectFlags());
+			delete mpBackend;
+			mpBackend = NULL;
 		}
-		else
+
+		if (!mpBackend)
 		{
-			syserr << timestamp << "Trying to handle event on dead eventhandler" << std::endl;
+			syserr << timestamp << "epoll multiplexer not available, falling back to select" << std::endl;
 		}
 	}
+
+	if (!mpBackend)
+	{
+		mpBackend = CreateSelectBackend();
+		if (!mpBackend->Init()) return false;
+	}
+
+	// pick up handlers added before init
+	for(tHandlers::iterator it = mHandlers.begin(); it != mHandlers.end(); it++)
+	{
+		mpBackend->AddHandler(*it);
+	}
+
 	return true;
 }
 
-bool Multiplexer::HouseKeeping()
+bool Multiplexer::ParseBackendType(const std::string& name, BackendType& type)
 {
-	// handlers can disapear, so we make a copy for conveniance sake
-	tHandlers aCopy = mHandlers;
-	for(tHandlers::iterator it = aCopy.begin(); it != aCopy.end(); it++)
-	{
-		if(!it->second->IsAlive())
-		{
-			syserr << timestamp << "Dead handler: kicking" << std::endl;
-			it->second->Shutdown();
-		}
-	}
+	if (name == "select")		type = eSelect;
+	else if (name == "epoll")	type = eEpoll;
+	else return false;
+	return true;
+}
+
+const char* Multiplexer::GetBackendName() const
+{
+	if (!mpBackend) return "none";
+	return mpBackend->GetName();
+}
 
+bool Multiplexer::WaitForEvent(int timeout_ms)
+{
+	if (!mpBackend && !Init()) return false;
+	return mpBackend->WaitForEvent(mTimers.NextTimeout(timeout_ms));
+}
+
+bool Multiplexer::HouseKeeping()
+{
+	// handlers with deadlines register a timer, only the expired ones are visited
+	mTimers.RunExpired();
 	return true;
 }
 
 void Multiplexer::AddHandler(Net::SocketHandler* handler)
 {
-	mSockets.push_back(handler->GetSocket());
-	if (mHandlers.find(handler->GetSocket()) != mHandlers.end())
+	if (!mHandlers.insert(handler).second)
 	{
 		std::cerr << "Handler is already in map!" << std::endl;
+		return;
 	}
-	mHandlers[handler->GetSocket()] = handler;
+
+	if (mpBackend) mpBackend->AddHandler(handler);
 }
 
 void Multiplexer::RemoveHandler(Net::SocketHandler* handler)
 {
-	mSockets.remove(handler->GetSocket());
-	mHandlers.erase(handler->GetSocket());
+	if (mHandlers.erase(handler) == 0) return;
+	if (mpBackend) mpBackend->RemoveHandler(handler);
 }
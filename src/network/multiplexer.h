@@ -29,35 +29,57 @@
 #define __NETWORK_MULTIPLEXER_H__
 
 #include "sockethandler.h"
+#include "timerqueue.h"
 
-#include <map>
-#include <list>
+#include <set>
+#include <string>
 
 namespace Net {
 
+class MultiplexerBackend;
+
 /// Network multiplexer / server utility.
-/// Manages sockethandlers for processing (mapping to select).
-/// Notice: you must keep the list of selectable sockets intact in all cases..
-/// No closed or broken sockets should be in the list..
+/// Manages sockethandlers for processing (mapping to select or epoll).
+/// Closed sockets may stay registered until their handler is removed, they are skipped.
+/// Deadlines are kept in a timer queue, waits never pass the nearest deadline.
 
 class Multiplexer
 {
 public:
+	enum BackendType
+	{
+		eSelect,
+		eEpoll,
+	};
+
+	/// Create the backend, falls back to select if the requested one isn't available.
+	bool	Init(BackendType type = eSelect);
+
+	/// Wait for socket events, returns early if a timer is due before timeout_ms
 	bool	WaitForEvent(int timeout_ms);
 
+	/// Run expired timers
 	bool	HouseKeeping();
 
 	void	AddHandler(Net::SocketHandler* handler);
 	void	RemoveHandler(Net::SocketHandler* handler);
 
+	/// Name of the active backend, "select" or "epoll"
+	const char*	GetBackendName() const;
+
+	/// Translate a config value ("select"/"epoll") to a backend type
+	static bool	ParseBackendType(const std::string& name, BackendType& type);
+
+	TimerQueue*	GetTimerQueue() { return &mTimers; }
+
 			Multiplexer();
 	virtual ~Multiplexer();
 private:
-	typedef std::map< Net::Socket*, Net::SocketHandler* > tHandlers;
-	typedef std::list< Net::Socket* > tSockets;
+	typedef std::set< Net::SocketHandler* > tHandlers;
 
-	tHandlers		mHandlers;
-	tSockets		mSockets;
+	tHandlers				mHandlers;
+	MultiplexerBackend*		mpBackend;
+	TimerQueue				mTimers;
 };
 
 }
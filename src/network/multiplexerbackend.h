@@ -0,0 +1,62 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __NETWORK_MULTIPLEXER_BACKEND_H__
+#define __NETWORK_MULTIPLEXER_BACKEND_H__
+
+namespace Net {
+
+class SocketHandler;
+
+/// Event notification mechanism used by the Multiplexer.
+/// Only the multiplexer should use this, handlers are added through Multiplexer.
+class MultiplexerBackend
+{
+public:
+	virtual bool	Init() = 0;
+
+	virtual void	AddHandler(SocketHandler* handler) = 0;
+	virtual void	RemoveHandler(SocketHandler* handler) = 0;
+
+	/// Wait for network activity and dispatch it to the handlers.
+	/// Returns false if the wait failed.
+	virtual bool	WaitForEvent(int timeout_ms) = 0;
+
+	virtual const char*	GetName() const = 0;
+
+	virtual ~MultiplexerBackend() {}
+};
+
+/// Classic select based backend, available on all platforms.
+MultiplexerBackend* CreateSelectBackend();
+
+/// epoll based backend, returns NULL if not supported on this platform.
+MultiplexerBackend* CreateEpollBackend();
+
+} // end of namespace
+
+#endif
@@ -0,0 +1,108 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "multiplexerbackend.h"
+#include "sockethandler.h"
+#include "socket.h"
+
+#include <syslog.h>
+
+#include <map>
+#include <list>
+
+using namespace Net;
+
+namespace {
+
+/// Rebuilds the select sets from the socket list on every wait.
+/// Limited to FD_SETSIZE sockets, but works everywhere.
+class SelectBackend : public MultiplexerBackend
+{
+public:
+	virtual bool	Init() { return true; }
+
+	virtual void	AddHandler(SocketHandler* handler);
+	virtual void	RemoveHandler(SocketHandler* handler);
+
+	virtual bool	WaitForEvent(int timeout_ms);
+
+	virtual const char*	GetName() const { return "select"; }
+private:
+	typedef std::map< Socket*, SocketHandler* > tHandlers;
+	typedef std::list< Socket* > tSockets;
+
+	tHandlers		mHandlers;
+	tSockets		mSockets;
+};
+
+} // end of anonymous namespace
+
+bool SelectBackend::WaitForEvent(int timeout_ms)
+{
+	tSockets out;
+	
+	if (mSockets.empty()) return true; // this will lead to a spin...
+
+	if (Socket::Select(mSockets,out,timeout_ms) < 0)
+	{
+		syserr << timestamp << "Select failed (" << (unsigned int)mSockets.size() << ")" << std::endl;
+		return false;
+	}
+
+	// this doesn't guard against handlers going away in the event handling
+	for(tSockets::const_iterator i=out.begin(); i!= out.end(); i++)
+	{
+		// check if socket is still alive before calling handle event
+		tHandlers::const_iterator finder = mHandlers.find(*i);
+		if (finder != mHandlers.end())
+		{
+			finder->second->HandleEvent((*i)->GetSelectFlags());
+		}
+		else
+		{
+			syserr << timestamp << "Trying to handle event on dead eventhandler" << std::endl;
+		}
+	}
+	return true;
+}
+
+void SelectBackend::AddHandler(SocketHandler* handler)
+{
+	mSockets.push_back(handler->GetSocket());
+	mHandlers[handler->GetSocket()] = handler;
+}
+
+void SelectBackend::RemoveHandler(SocketHandler* handler)
+{
+	mSockets.remove(handler->GetSocket());
+	mHandlers.erase(handler->GetSocket());
+}
+
+MultiplexerBackend* Net::CreateSelectBackend()
+{
+	return new SelectBackend();
+}
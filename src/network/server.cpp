@@ -38,9 +38,9 @@ Server::~Server()
 {
 }
 
-int Server::StartServer(int port, int backlog)
+int Server::StartServer(int port, int backlog, bool shared)
 {
-	return Socket::StartServer(port, backlog);
+	return Socket::StartServer(port, backlog, shared);
 }
 
 Connection *Server::CheckIncomming()
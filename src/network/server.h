@@ -42,7 +42,7 @@ class Server : public Socket
 public:
 	Connection *CheckIncomming();
 
-	int StartServer(int port,int backlog);
+	int StartServer(int port,int backlog, bool shared = false);
 	Server();
 	virtual ~Server();
 };
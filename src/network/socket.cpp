@@ -48,6 +48,7 @@ Socket::Socket(BlockingMode mode)
 {
 	mMode			= mode;
 	mSelectMask		= NET_ALL_FLAGS;
+	mpMaskListener	= NULL;
 
 	mSocket			= new realsocket();
 	mSocket->socket	= UNINITIALIZED_SOCKET;
@@ -59,6 +60,7 @@ Socket::Socket(realsocket* pSocket)
 	
 	mMode			= Blocking;			// set blocking as default
 	mSelectMask		= NET_ALL_FLAGS;	// select on all
+	mpMaskListener	= NULL;
 	mSocket			= pSocket;	
 }
 
@@ -84,8 +86,15 @@ bool Socket::Init()
 	return true;
 }
 
-bool Socket::StartServer(int port, int backlog)
+bool Socket::SupportsSharedPort()
 {
+	// SO_REUSEADDR on windows does not balance connections
+	return false;
+}
+
+bool Socket::StartServer(int port, int backlog, bool shared)
+{
+	if (shared) return false;
 	if (!CreateTCPSocket()) return false;
 	mSocket->flags = SERVER_SOCKET;
 
@@ -281,6 +290,75 @@ signed int Socket::Send(const void* buffer,	size_t len)
 	return send(mSocket->socket, (const char*) buffer, (int)len,0);
 }
 
+signed int Socket::SendV(const IOSegment* segments, size_t count)
+{
+	if (count > NET_MAX_SEGMENTS) count = NET_MAX_SEGMENTS;
+
+	WSABUF buffers[NET_MAX_SEGMENTS];
+	for(size_t i = 0; i < count; i++)
+	{
+		buffers[i].buf	= (char*) segments[i].pData;
+		buffers[i].len	= (ULONG) segments[i].length;
+	}
+
+	DWORD sent = 0;
+	if (WSASend(mSocket->socket, buffers, (DWORD) count, &sent, 0, NULL, NULL) == SOCKET_ERROR) return -1;
+	return (signed int) sent;
+}
+
+bool Socket::CreatePair(Socket*& pFirst, Socket*& pSecond)
+{
+	// no socketpair in winsock, connect two sockets over the loopback interface
+	SOCKET listener = socket(AF_INET, SOCK_STREAM, 0);
+	if (listener == INVALID_SOCKET)
+	{
+		HandleError();
+		return false;
+	}
+
+	struct sockaddr_in addr;
+	int addrlen = sizeof(addr);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family			= AF_INET;
+	addr.sin_port			= 0;
+	addr.sin_addr.s_addr	= htonl(INADDR_LOOPBACK);
+
+	SOCKET first	= INVALID_SOCKET;
+	SOCKET second	= INVALID_SOCKET;
+
+	if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != SOCKET_ERROR
+		&& getsockname(listener, (struct sockaddr *)&addr, &addrlen) != SOCKET_ERROR
+		&& listen(listener, 1) != SOCKET_ERROR)
+	{
+		first = socket(AF_INET, SOCK_STREAM, 0);
+		if (first != INVALID_SOCKET && connect(first, (struct sockaddr *)&addr, sizeof(addr)) != SOCKET_ERROR)
+		{
+			second = accept(listener, NULL, NULL);
+		}
+	}
+
+	closesocket(listener);
+
+	if (second == INVALID_SOCKET)
+	{
+		HandleError();
+		if (first != INVALID_SOCKET) closesocket(first);
+		return false;
+	}
+
+	realsocket* pFirstSocket = new realsocket();
+	pFirstSocket->socket	= first;
+	pFirstSocket->flags		= CLIENT_SOCKET;
+
+	realsocket* pSecondSocket = new realsocket();
+	pSecondSocket->socket	= second;
+	pSecondSocket->flags	= CLIENT_SOCKET;
+
+	pFirst	= new Socket(pFirstSocket);
+	pSecond	= new Socket(pSecondSocket);
+	return true;
+}
+
 bool Socket::SetNonBlocking()
 {
 	if (!CreateTCPSocket()) return false;
@@ -347,7 +425,7 @@ int Socket::Select(const tSockets& in, tSockets& out, int timeout_ms)
 {
 	struct timeval time;	
 	fd_set readfds, writefds, exceptfds;
-	time.tv_sec = timeout_ms / 1000; time.tv_usec = timeout_ms % 1000;
+	time.tv_sec = timeout_ms / 1000; time.tv_usec = (timeout_ms % 1000) * 1000;
 
 	FD_ZERO(&readfds);
 	FD_ZERO(&writefds);
@@ -404,9 +482,27 @@ int Socket::GetSelectFlags() const
 	return mSelectFlags;
 }
 
+int Socket::GetSelectMask() const
+{
+	return mSelectMask;
+}
+
 void Socket::SetSelectMask(int flags)
 {
+	if (mSelectMask == flags) return;
+
 	mSelectMask = flags;
+	if (mpMaskListener) mpMaskListener->SelectMaskChanged(this);
+}
+
+void Socket::SetSelectMaskListener(SelectMaskListener* pListener)
+{
+	mpMaskListener = pListener;
+}
+
+opaque_socket Socket::GetHandle() const
+{
+	return mSocket;
 }
 
 std::string Socket::GetPeerIPAsString() const
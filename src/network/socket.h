@@ -40,6 +40,9 @@ namespace Net
 
 #define NET_ALL_FLAGS		0x07
 
+// maximum number of buffers passed to one gathered send
+#define NET_MAX_SEGMENTS	64
+
 #if _WIN32
 // wrapper for windows sockets.. no need to expose junk..
 typedef struct realsocket* opaque_socket;
@@ -47,6 +50,24 @@ typedef struct realsocket* opaque_socket;
 typedef int opaque_socket;
 #endif
 
+class Socket;
+
+/// One buffer of a gathered send
+struct IOSegment
+{
+	const void*	pData;
+	size_t		length;
+};
+
+/// Gets notified when a socket changes the events it wants to be selected on.
+/// Used by multiplexer backends that register interest once (epoll) instead of every wait.
+class SelectMaskListener
+{
+public:
+	virtual void	SelectMaskChanged(Socket* pSocket) = 0;
+	virtual ~SelectMaskListener() {}
+};
+
 /// Handles all lowlevel socket functions
 class Socket
 {
@@ -63,7 +84,10 @@ public:
 	static bool	Init();
 
 	// server methods, use only in servermode
-	bool		StartServer(int port, int backlog);
+	///			A shared server lets several sockets listen on the same port, the kernel spreads the incoming connections
+	bool		StartServer(int port, int backlog, bool shared = false);
+	///			Can servers share a port (SO_REUSEPORT)
+	static bool	SupportsSharedPort();
 	bool		HasConnecting();
 	opaque_socket	AcceptConnecting();
 
@@ -78,11 +102,24 @@ public:
 	signed int	Receive(void* buffer,		size_t len);
 	signed int	Send(const void* buffer,	size_t len);
 
+	///			Send several buffers with one call (sendmsg/WSASend), at most NET_MAX_SEGMENTS are used
+	signed int	SendV(const IOSegment* segments, size_t count);
+
 	int			GetSelectFlags() const;
+	int			GetSelectMask() const;
 	void		SetSelectMask(int flags);
 
+	///			Set the listener that is notified when the select mask changes
+	void		SetSelectMaskListener(SelectMaskListener* pListener);
+
+	///			Native socket handle, only meant for the multiplexer backends
+	opaque_socket	GetHandle() const;
+
 	bool		SetNonBlocking();
 
+	///			Create a pair of connected sockets, used to wake up a multiplexer from another thread
+	static bool	CreatePair(Socket*& pFirst, Socket*& pSecond);
+
 	///			Select on many sockets
 	///			\param in list of sockets to check of network activity
 	///			\param out reference to a list which will receive sockets where something has happened
@@ -108,6 +145,7 @@ private:
 	BlockingMode	mMode;
 	int				mSelectFlags;
 	int				mSelectMask;
+	SelectMaskListener*	mpMaskListener;
 };
 
 } // end of namespace
@@ -30,11 +30,13 @@
 #include <arpa/inet.h>
 #include <sys/select.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/types.h>
 #include <fcntl.h>
 #include <netdb.h>
 #include <unistd.h>
 #include <errno.h>
+#include <string.h>
 
 #include <syslog.h>
 
@@ -54,6 +56,7 @@ Socket::Socket(BlockingMode mode)
 {
 	mMode			= mode;
 	mSelectMask		= NET_ALL_FLAGS;
+	mpMaskListener	= NULL;
 	mSocket			= -1;
 }
 
@@ -61,6 +64,7 @@ Socket::Socket(opaque_socket pSocket)
 {
 	mMode			= Blocking;			// set blocking as default
 	mSelectMask		= NET_ALL_FLAGS;	// select on all
+	mpMaskListener	= NULL;
 	mSocket			= pSocket;	
 }
 
@@ -79,7 +83,16 @@ bool Socket::Init()
 	return true;
 }
 
-bool Socket::StartServer(int port, int backlog)
+bool Socket::SupportsSharedPort()
+{
+#ifdef SO_REUSEPORT
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool Socket::StartServer(int port, int backlog, bool shared)
 {
 	struct addrinfo hints, *res;
 	
@@ -95,6 +108,23 @@ bool Socket::StartServer(int port, int backlog)
 	getaddrinfo(NULL, portstr, &hints, &res);
 	
 	mSocket = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+
+	if (shared)
+	{
+#ifdef SO_REUSEPORT
+		int on = 1;
+		if (setsockopt(mSocket, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == SOCKET_ERROR)
+		{
+			HandleError();
+			freeaddrinfo(res);
+			return false;
+		}
+#else
+		freeaddrinfo(res);
+		return false;
+#endif
+	}
+
 	if (bind(mSocket, res->ai_addr, res->ai_addrlen) == -1) {
 		freeaddrinfo(res);
 		return false;
@@ -347,6 +377,39 @@ signed int Socket::Send(const void* buffer,	size_t len)
 	return send(mSocket, (const char*) buffer, (int)len,0);
 }
 
+signed int Socket::SendV(const IOSegment* segments, size_t count)
+{
+	if (count > NET_MAX_SEGMENTS) count = NET_MAX_SEGMENTS;
+
+	struct iovec iov[NET_MAX_SEGMENTS];
+	for(size_t i = 0; i < count; i++)
+	{
+		iov[i].iov_base	= (void*) segments[i].pData;
+		iov[i].iov_len	= segments[i].length;
+	}
+
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov		= iov;
+	msg.msg_iovlen	= count;
+
+	return sendmsg(mSocket, &msg, 0);
+}
+
+bool Socket::CreatePair(Socket*& pFirst, Socket*& pSecond)
+{
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == SOCKET_ERROR)
+	{
+		HandleError();
+		return false;
+	}
+
+	pFirst	= new Socket(fds[0]);
+	pSecond	= new Socket(fds[1]);
+	return true;
+}
+
 bool Socket::SetNonBlocking()
 {
 	if (!CreateTCPSocket()) return false;
@@ -412,7 +475,7 @@ int Socket::Select(const tSockets& in, tSockets& out, int timeout_ms)
 {
 	struct timeval time;	
 	fd_set readfds, writefds, exceptfds;
-	time.tv_sec = timeout_ms / 1000; time.tv_usec = timeout_ms % 1000;
+	time.tv_sec = timeout_ms / 1000; time.tv_usec = (timeout_ms % 1000) * 1000;
 
 	FD_ZERO(&readfds);
 	FD_ZERO(&writefds);
@@ -422,12 +485,8 @@ int Socket::Select(const tSockets& in, tSockets& out, int timeout_ms)
 
 	for(tSockets::const_iterator i=in.begin(); i != in.end(); i++)
 	{
-		//Socket* s = *i;
-		// sanity check
-		if (!(*i)->CheckSocket())
-		{
-			return -1;
-		}
+		// closed sockets stay in the list until their handler is removed, skip them
+		if (!(*i)->CheckSocket()) continue;
 				
 		if ((*i)->mSocket > nfds) nfds = (*i)->mSocket;
 
@@ -463,6 +522,8 @@ int Socket::Select(const tSockets& in, tSockets& out, int timeout_ms)
 	for(tSockets::const_iterator i=in.begin(); i != in.end(); i++)
 	{
 		Socket* pSocket = *i;
+		if (!pSocket->CheckSocket()) continue;
+
 		int flags = 0;
 		if (FD_ISSET(pSocket->mSocket,&readfds))	flags |= NET_READ_FLAG;
 		if (FD_ISSET(pSocket->mSocket,&writefds))	flags |= NET_WRITE_FLAG;
@@ -486,9 +547,27 @@ int Socket::GetSelectFlags() const
 	return mSelectFlags;
 }
 
+int Socket::GetSelectMask() const
+{
+	return mSelectMask;
+}
+
 void Socket::SetSelectMask(int flags)
 {
+	if (mSelectMask == flags) return;
+
 	mSelectMask = flags;
+	if (mpMaskListener) mpMaskListener->SelectMaskChanged(this);
+}
+
+void Socket::SetSelectMaskListener(SelectMaskListener* pListener)
+{
+	mpMaskListener = pListener;
+}
+
+opaque_socket Socket::GetHandle() const
+{
+	return mSocket;
 }
 
 std::string Socket::GetPeerIPAsString() const
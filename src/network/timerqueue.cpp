@@ -0,0 +1,178 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "timerqueue.h"
+
+#include <math.h>
+
+using namespace Net;
+
+TimerHandler::TimerHandler()
+{
+	mpTimerQueue	= 0;
+	mTimerIndex		= 0;
+	mDeadline		= 0;
+}
+
+TimerHandler::~TimerHandler()
+{
+	if (mpTimerQueue) mpTimerQueue->Cancel(this);
+}
+
+///////////////////
+
+TimerQueue::TimerQueue()
+{
+}
+
+TimerQueue::~TimerQueue()
+{
+	for(tHeap::iterator it = mHeap.begin(); it != mHeap.end(); it++)
+	{
+		(*it)->mpTimerQueue = 0;
+	}
+}
+
+double TimerQueue::Now()
+{
+	return mClock.elapsed();
+}
+
+void TimerQueue::Schedule(TimerHandler* pHandler, double timeout)
+{
+	if (pHandler->mpTimerQueue && pHandler->mpTimerQueue != this)
+	{
+		pHandler->mpTimerQueue->Cancel(pHandler);
+	}
+
+	if (timeout < 0) timeout = 0;
+	double deadline = Now() + timeout;
+
+	if (pHandler->mpTimerQueue == this)
+	{
+		// move the existing entry
+		bool earlier = deadline < pHandler->mDeadline;
+		pHandler->mDeadline = deadline;
+		if (earlier) SiftUp(pHandler->mTimerIndex);
+		else SiftDown(pHandler->mTimerIndex);
+		return;
+	}
+
+	pHandler->mpTimerQueue	= this;
+	pHandler->mDeadline		= deadline;
+	mHeap.push_back(pHandler);
+	pHandler->mTimerIndex	= mHeap.size() - 1;
+	SiftUp(pHandler->mTimerIndex);
+}
+
+void TimerQueue::Cancel(TimerHandler* pHandler)
+{
+	if (pHandler->mpTimerQueue != this) return;
+	RemoveAt(pHandler->mTimerIndex);
+}
+
+int TimerQueue::NextTimeout(int maxwait_ms)
+{
+	if (mHeap.empty()) return maxwait_ms;
+
+	double left = mHeap.front()->mDeadline - Now();
+	if (left <= 0) return 0;
+
+	// round up, waking up early would only lead to another wait
+	double ms = ceil(left * 1000.0);
+	if (ms >= maxwait_ms) return maxwait_ms;
+	return (int) ms;
+}
+
+size_t TimerQueue::RunExpired()
+{
+	double now = Now();
+
+	// handlers rescheduled with a zero timeout would keep us here forever, bound the round
+	size_t maxFire = mHeap.size();
+	size_t fired = 0;
+
+	while(!mHeap.empty() && fired < maxFire && mHeap.front()->mDeadline <= now)
+	{
+		TimerHandler* pHandler = mHeap.front();
+		RemoveAt(0);
+
+		fired++;
+		pHandler->TimerExpired(); // may reschedule or delete the handler
+	}
+
+	return fired;
+}
+
+void TimerQueue::Place(TimerHandler* pHandler, size_t index)
+{
+	mHeap[index] = pHandler;
+	pHandler->mTimerIndex = index;
+}
+
+void TimerQueue::SiftUp(size_t index)
+{
+	TimerHandler* pHandler = mHeap[index];
+	while(index > 0)
+	{
+		size_t parent = (index - 1) / 2;
+		if (mHeap[parent]->mDeadline <= pHandler->mDeadline) break;
+		Place(mHeap[parent], index);
+		index = parent;
+	}
+	Place(pHandler, index);
+}
+
+void TimerQueue::SiftDown(size_t index)
+{
+	TimerHandler* pHandler = mHeap[index];
+	size_t size = mHeap.size();
+	for(;;)
+	{
+		size_t child = index * 2 + 1;
+		if (child >= size) break;
+		if (child + 1 < size && mHeap[child + 1]->mDeadline < mHeap[child]->mDeadline) child++;
+		if (pHandler->mDeadline <= mHeap[child]->mDeadline) break;
+		Place(mHeap[child], index);
+		index = child;
+	}
+	Place(pHandler, index);
+}
+
+void TimerQueue::RemoveAt(size_t index)
+{
+	TimerHandler* pHandler = mHeap[index];
+	pHandler->mpTimerQueue = 0;
+
+	TimerHandler* pLast = mHeap.back();
+	mHeap.pop_back();
+	if (pLast == pHandler) return;
+
+	Place(pLast, index);
+	if (index > 0 && pLast->mDeadline < mHeap[(index - 1) / 2]->mDeadline) SiftUp(index);
+	else SiftDown(index);
+}
@@ -0,0 +1,94 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __NETWORK_TIMERQUEUE_H__
+#define __NETWORK_TIMERQUEUE_H__
+
+#include <util/timer.h>
+
+#include <vector>
+#include <stddef.h>
+
+namespace Net {
+
+class TimerQueue;
+
+/// Something that wants to be called back at a deadline.
+/// A handler has at most one pending deadline, scheduling it again moves the deadline.
+/// Pending timers are canceled when the handler is destroyed.
+class TimerHandler
+{
+public:
+	virtual void	TimerExpired() = 0;
+
+	bool			IsTimerScheduled() const { return mpTimerQueue != 0; }
+
+			TimerHandler();
+	virtual ~TimerHandler();
+private:
+	friend class TimerQueue;
+
+	TimerQueue*		mpTimerQueue;
+	size_t			mTimerIndex;	// position in the heap
+	double			mDeadline;
+};
+
+/// Deadlines kept in a binary min-heap.
+/// Waking up costs O(log n) per expiring timer, independent of how many timers are pending.
+class TimerQueue
+{
+public:
+	///			Schedule the handler timeout seconds from now
+	void		Schedule(TimerHandler* pHandler, double timeout);
+	void		Cancel(TimerHandler* pHandler);
+
+	///			Milliseconds until the nearest deadline, never more than maxwait_ms
+	int			NextTimeout(int maxwait_ms);
+
+	///			Call all handlers with expired deadlines, returns how many were called
+	size_t		RunExpired();
+
+	size_t		NumTimers() const { return mHeap.size(); }
+
+	TimerQueue();
+	virtual ~TimerQueue();
+private:
+	double		Now();
+
+	void		Place(TimerHandler* pHandler, size_t index);
+	void		SiftUp(size_t index);
+	void		SiftDown(size_t index);
+	void		RemoveAt(size_t index);
+
+	typedef std::vector< TimerHandler* > tHeap;
+	tHeap		mHeap;
+	timer		mClock;
+};
+
+} // end of namespace
+
+#endif
@@ -0,0 +1,88 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "wakeup.h"
+#include "socket.h"
+
+#include <util/atomic.h>
+#include <syslog.h>
+
+#include <stddef.h>
+
+using namespace Net;
+
+Wakeup::Wakeup(WakeupListener* pListener)
+{
+	mpListener	= pListener;
+	mpReceiver	= NULL;
+	mpSender	= NULL;
+	mPending	= 0;
+}
+
+Wakeup::~Wakeup()
+{
+	delete mpReceiver;
+	delete mpSender;
+}
+
+bool Wakeup::Init()
+{
+	if (!Socket::CreatePair(mpReceiver, mpSender))
+	{
+		syserr << timestamp << "Unable to create wakeup socket pair" << std::endl;
+		return false;
+	}
+
+	mpReceiver->SetNonBlocking();
+	mpReceiver->SetSelectMask(NET_READ_FLAG | NET_EXCEPTION_FLAG);
+	return true;
+}
+
+void Wakeup::Signal()
+{
+	// only the first signal since the last wakeup writes
+	if (AtomicExchange(&mPending, 1) != 0) return;
+
+	char byte = 0;
+	mpSender->Send(&byte, 1);
+}
+
+void Wakeup::HandleEvent(int flags)
+{
+	// reset before draining, a signal arriving after this writes a new byte
+	AtomicExchange(&mPending, 0);
+
+	char buffer[64];
+	mpReceiver->Receive(buffer, sizeof(buffer));
+
+	mpListener->WokenUp();
+}
+
+Socket* Wakeup::GetSocket()
+{
+	return mpReceiver;
+}
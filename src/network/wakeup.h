@@ -0,0 +1,70 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __NETWORK_WAKEUP_H__
+#define __NETWORK_WAKEUP_H__
+
+#include "sockethandler.h"
+
+namespace Net
+{
+
+/// Gets called in the multiplexer thread after a Signal
+class WakeupListener
+{
+public:
+	virtual void	WokenUp() = 0;
+	virtual ~WakeupListener() {}
+};
+
+/// Wakes a thread blocked in Multiplexer::WaitForEvent from another thread.
+/// Signals are coalesced, at most one byte is in flight until the listener has run.
+class Wakeup : public SocketHandler
+{
+public:
+	bool			Init();
+
+	///				Thread safe, may be called from any thread
+	void			Signal();
+
+	virtual void	HandleEvent(int flags);
+	virtual Socket*	GetSocket();
+	virtual bool	IsAlive()	{ return true; }
+	virtual bool	Shutdown()	{ return true; }
+
+	Wakeup(WakeupListener* pListener);
+	virtual ~Wakeup();
+private:
+	WakeupListener*	mpListener;
+	Socket*			mpReceiver;
+	Socket*			mpSender;
+	volatile int	mPending;
+};
+
+} // end of namespace
+
+#endif
@@ -34,6 +34,7 @@ Transaction::Transaction()
 {
 	mpOwner = NULL;
 	mpIssuer = NULL;
+	mpPrepared = NULL;
 	mErrorState = NoError;
 }
 
@@ -44,6 +45,8 @@ Transaction::~Transaction()
 		delete *it;
 	}
 	mRequests.clear();
+
+	delete mpPrepared;
 }
 
 void Transaction::AddRequest(Request* pRequest)
@@ -66,6 +69,12 @@ void Transaction::SetIssuer(TransactionIssuer* pIssuer)
 	mpIssuer = pIssuer;
 }
 
+void Transaction::SetPrepared(PreparedData* pPrepared)
+{
+	if (pPrepared != mpPrepared) delete mpPrepared;
+	mpPrepared = pPrepared;
+}
+
 void Transaction::Abort(std::string error, TransactionErrorType errortype)
 {
 	mError = error;
@@ -31,6 +31,7 @@
 
 #include <string>
 #include <list>
+#include <vector>
 
 // forward decl.
 class InstrumentBlock;
@@ -98,11 +99,25 @@ enum TransactionErrorType
 
 class Transaction;
 
+/// Whatever a handler works out for a transaction ahead of performing it, see TransactionHandler::Prepare
+class PreparedData
+{
+public:
+	typedef std::vector<std::string> tSwitched;
+
+	/// Sorted names of the equipment components switched in, empty if the handler doesn't tell.
+	/// The queue uses it to run measurements of similar circuits back to back
+	tSwitched	switched;
+
+	virtual ~PreparedData() {}
+};
+
 class TransactionIssuer
 {
 public:
-	/// Called after the transaction is handled successfully
-	virtual void TransactionComplete(Transaction* pTransaction) = 0;
+	/// Called after the transaction is handled successfully.
+	/// Returns true if the issuer takes over the transaction, it then has to delete it
+	virtual bool TransactionComplete(Transaction* pTransaction) = 0;
 	/// Called when a transaction fails
 	virtual void TransactionError(Transaction* pTransaction, const char* msg, TransactionErrorType type) = 0;
 
@@ -134,12 +149,17 @@ public:
 	void				SetIssuer(TransactionIssuer* pIssuer);
 	TransactionIssuer*	GetIssuer() { return mpIssuer; }
 
+	/// Takes ownership, a previously prepared state is deleted
+	void				SetPrepared(PreparedData* pPrepared);
+	PreparedData*		GetPrepared() { return mpPrepared; }
+
 	Transaction();
 	virtual ~Transaction();
 private:
 	TransactionIssuer*	mpIssuer;
 	tRequests			mRequests;
 	void*				mpOwner;
+	PreparedData*		mpPrepared;
 
 	std::string				mError;
 	TransactionErrorType	mErrorState;
@@ -162,6 +182,14 @@ public:
 	/// Check if the commander can handle this transaction
 	virtual bool	CanHandle(Transaction* pTransaction)	= 0;
 
+	/// Do the work that doesn't need the equipment, called when the transaction is queued.
+	/// Throws if the transaction can't be carried out, so it is rejected without waiting in the queue
+	virtual bool	Prepare(Transaction* pTransaction, TransactionCallback* pCallback)	{ return true; }
+
+	/// False for transactions that never touch the equipment, they are then performed right away
+	/// instead of waiting behind the measurements
+	virtual bool	NeedsEquipment()	{ return true; }
+
 	/// Carry out the transaction
 	virtual bool	Perform(Transaction* pTransaction, TransactionCallback* pCallback)		= 0;
 
@@ -33,21 +33,16 @@
 #include <syslog.h>
 #include <sstream>
 
-#include <measureserver/clientmanager.h>
-#include <measureserver/protocolservice.h>
-#include <measureserver/session.h>
-#include <measureserver/service.h>
-#include <measureserver/transactionrequest.h>
-#include <measureserver/requestqueue.h>
-
 #include <xmlprotocol/producer.h>
 #include <xmlprotocol/requestparser.h>
 
 #include <basic_exception.h>
+#include <util/atomic.h>
 
 using namespace std;
 
 #define MAX_REQUEST_SIZE (128*1024)
+#define IDLE_TIMEOUT 300.0
 
 const char* SCGIindexPage = "<html>"
 "<body>"
@@ -56,12 +51,13 @@ const char* SCGIindexPage = "<html>"
 "</body>"
 "</html>";
 
-SCGIConnection::SCGIConnection(Net::Connection* pConnection, SCGIServer* pServer, ServerProtocolService* pSrvProtSrvc, ClientManager* pClientMgr)
+SCGIConnection::SCGIConnection(Net::Connection* pConnection, SCGIServer* pServer, Reactor* pReactor)
 {
 	mpConnection = pConnection;
 	mpServer	= pServer;
-	mpSrvProtSrvc = pSrvProtSrvc;
-	mpClientMgr	= pClientMgr;
+	mpReactor	= pReactor;
+	mpTimers	= pReactor->GetTimerQueue();
+	mChannel	= 0;
 
 	mpRequest = new SCGIRequest();
 
@@ -73,32 +69,19 @@ SCGIConnection::SCGIConnection(Net::Connection* pConnection, SCGIServer* pServer
 	mState = eRequest;
 	mKeepAlive = false;
 
-	mpClient = NULL;
-
-	mpCurrentRequest = NULL;
+	// connections are created in several reactor threads
+	static volatile int sLastID = 0;
+	mRequestID = AtomicIncrement(&sLastID);
 
-	static int id = 1;
-	mRequestID = id++;
+	mpTimers->Schedule(this, IDLE_TIMEOUT);
 }
 
 SCGIConnection::~SCGIConnection()
 {
 	mpConnection->Destroy();
-	if (mpCurrentRequest)
-	{
-		mpCurrentRequest->ClientGone();
-	}
 
-	if (mpClient)
-	{
-		mpClient->RemoveListener(this);
-
-		mpSrvProtSrvc->GetRequestQueue()->RemoveRequestsFrom(mpClient);
-		mpClient->ConnectionClosed();
-		mpClientMgr->RemoveClient(mpClient);
-		delete mpClient;
-		mpClient = NULL;
-	}
+	// the scheduler cancels the transaction in flight and drops the client
+	if (mChannel) mpReactor->CloseChannel(mChannel);
 
 	delete mpRequest;
 	delete mpConnection;
@@ -106,15 +89,8 @@ SCGIConnection::~SCGIConnection()
 
 bool SCGIConnection::Init()
 {
-	mpClient = mpClientMgr->AddClient(mpConnection);
-	if (!mpClient)
-	{
-		SCGIError("Unable to create client, server overloaded");
-		mState = eClosing;
-		return false;
-	}
-	mpClient->AddListener(this);
-
+	// the client is created by the scheduler, a rejection arrives as ChannelRejected
+	mChannel = mpReactor->OpenChannel(this, Reactor::eRequireSession | Reactor::eOneTransaction);
 	return true;
 }
 
@@ -226,25 +202,25 @@ void SCGIConnection::HandleEvent(int flags)
 	}
 }
 
-void SCGIConnection::SendResponse(const char* buffer, size_t length)
+void SCGIConnection::SendResponse(std::string& data)
 {
-	scgilog.Log(5) << "SCGI XML response: " << endl << string(buffer, length) << endl;
-
-	//string response(buffer, length);
+	if (scgilog.GetLogLevel() >= 5) scgilog.Log(5) << "SCGI XML response: " << endl << data << endl;
 
 	std::stringstream out;
 	out << "Status: 200 OK\r\n";
 	out << "Server: Measurementserver\r\n";
-	out << "Content-Length: " << length << "\r\n";
+	out << "Content-Length: " << data.size() << "\r\n";
 	out << "Content-Type: text/xml\r\n";
 	out << "Cache-Control: no-cache\r\n";
 	out << "Access-Control-Allow-Origin: *\r\n";
 	if (mKeepAlive) out << "Connection: keep-alive\r\n";
 	else out << "Connection: close\r\n";
 	out << "\r\n";
-	mSendBuffer.Fill((void*)out.str().c_str(), out.str().size());
 
-	mSendBuffer.Fill((void *)buffer, length);
+	// headers and body go out in one gathered send
+	std::string header = out.str();
+	mSendBuffer.Take(header);
+	mSendBuffer.Take(data);
 	mpConnection->SetSelectMask(NET_WRITE_FLAG | NET_READ_FLAG | NET_EXCEPTION_FLAG);
 }
 
@@ -252,7 +228,8 @@ void SCGIConnection::SendError(std::string msg)
 {
 	std::stringstream out;
 	xmlprotocol::XmlProducer::ProduceError(out, msg);
-	SendResponse(out.str().c_str(), out.str().size());
+	std::string response = out.str();
+	SendResponse(response);
 }
 
 Net::Socket* SCGIConnection::GetSocket()
@@ -262,11 +239,24 @@ Net::Socket* SCGIConnection::GetSocket()
 
 bool SCGIConnection::IsAlive()
 {
-	double timeout = 300.0;
-	if (mLifeTimer.elapsed() > timeout) return false;
+	if (mLifeTimer.elapsed() > IDLE_TIMEOUT) return false;
 	return true;
 }
 
+void SCGIConnection::TimerExpired()
+{
+	// the life timer is restarted on every request, only check it when the deadline passes
+	double left = IDLE_TIMEOUT - mLifeTimer.elapsed();
+	if (left > 0)
+	{
+		mpTimers->Schedule(this, left);
+		return;
+	}
+
+	syserr << timestamp << "Dead handler: kicking" << endl;
+	Shutdown(); // this will delete us
+}
+
 bool SCGIConnection::Shutdown()
 {
 	if (mState != eClosing) {
@@ -276,7 +266,6 @@ bool SCGIConnection::Shutdown()
 	//cout << "Shutdown socket: " << mRequestID << endl;
 
 
-	if (mpClient) mpClient->ConnectionClosed();
 	mpConnection->Disconnect();
 	mpConnection->Destroy();
 	mpServer->RemoveConnection(this); // this will delete us
@@ -304,26 +293,25 @@ bool SCGIConnection::ParseSCGIRequest(void* buffer, size_t datalength)
 
 			if (mpRequest->Verb() == "POST" && mpRequest->URL() == "/measureserver")
 			{
-				string payload = mpRequest->GetPayload();
-				//cout << "payload" << endl << payload << endl;
-			
-				//mpClient->HandlePacket((char*)payload.c_str(), payload.size());
-				HandlePacket(payload.c_str(), payload.size());
+				// parsed in place, the receive buffer is consumed below
+				HandlePacket(mpRequest->GetPayload((char*)buffer), mpRequest->ContentLength());
 			}
 			else if (mpRequest->Verb() == "GET" && mpRequest->URL() == "/crossdomain.xml")
 			{
 				sysout << "SCGI Policy file request" << endl;
 
 				std::stringstream out;
-				out << mpSrvProtSrvc->GetCrossDomainPolicy();
-				SendResponse(out.str().c_str(), out.str().size());
+				out << mpReactor->GetCrossDomainPolicy();
+				std::string response = out.str();
+				SendResponse(response);
 			}
 			else if (mpRequest->URL() == "/test")
 			{
 				std::stringstream out;
 				//sysout << "Test request: " << mRequestID << endl;
 				out << "Test response: " << mRequestID << endl;
-				SendResponse(out.str().c_str(), out.str().size());
+				std::string response = out.str();
+				SendResponse(response);
 			}
 			else if (mpRequest->URL() == "/")
 			{
@@ -336,8 +324,9 @@ bool SCGIConnection::ParseSCGIRequest(void* buffer, size_t datalength)
 				out << "Content-Type: text/html\r\n";
 				out << "Connection: close\r\n";
 				out << "\r\n";
-				out << SCGIindexPage;
-				mSendBuffer.Fill((void*)out.str().c_str(), out.str().size());
+				std::string header = out.str();
+				mSendBuffer.Take(header);
+				mSendBuffer.Borrow(SCGIindexPage, strlen(SCGIindexPage)); // static page, no need to copy
 				mpConnection->SetSelectMask(NET_WRITE_FLAG | NET_READ_FLAG | NET_EXCEPTION_FLAG);
 			}
 			else
@@ -433,67 +422,28 @@ bool SCGIConnection::HandlePacket(const char* pData, size_t length)
 		return false;
 	}
 
-	pTransaction->SetIssuer(this);
-	pTransaction->SetOwner(mpClient);
-
-	// hand over ownership to the handler
-	if (mpCurrentRequest != NULL)
-	{
-		SendError("Transaction already in progress");
-	}
-	else
-	{
-		mpCurrentRequest = mpSrvProtSrvc->ProcessTransaction(pTransaction, mpClient);
-		if (mpCurrentRequest == NULL) return false;
-	}
-	
+	// hand over ownership to the scheduler thread
+	mpReactor->Submit(mChannel, pTransaction);
 	return true;
 }
 
-void SCGIConnection::TransactionComplete(protocol::Transaction* pTransaction)
+void SCGIConnection::ChannelResponse(std::string& response)
 {
-	mpCurrentRequest = NULL;
-
-	Session* pSession = NULL;
-	if (mpClient) pSession = mpClient->GetSession();
-	if (!pSession)
-	{
-		SendError("Unable to get session when generating xml response");
-		return;
-	}
-
-	sysout << "request from session: " << pSession->GetKey() << endl;
-
-	std::stringstream out;
-	xmlprotocol::XmlProducer::TransactionResponse(pTransaction, pSession->GetBlock(), out, mpSrvProtSrvc);
-
-	protocol::TransactionErrorType errtype = pTransaction->GetErrorState();
-	if (errtype != protocol::NoError)
-	{
-		SendError(pTransaction->GetError());
-		return;
-	}
-
-	SendResponse(out.str().c_str(), out.str().size());
+	SendResponse(response);
 }
 
-void SCGIConnection::TransactionError(protocol::Transaction* pTransaction, const char* msg, protocol::TransactionErrorType type)
+void SCGIConnection::ChannelError(const std::string& msg)
 {
-	mpCurrentRequest = NULL;
 	SendError(msg);
 }
 
-void SCGIConnection::SessionDestroyed()
+void SCGIConnection::ChannelSessionGone()
 {
-	syserr << "Session is destroyed while client is connected!" << endl;
-
-	if (mpCurrentRequest)
-	{
-		// Cancel the request by pretending that the client has disconnected
-		mpCurrentRequest->ClientGone();
-		mpCurrentRequest = NULL;
-	}
-
 	SendError("Your session has timed out during measurement");
 	mState = eClosing;
+}
+
+void SCGIConnection::ChannelRejected(const std::string& msg)
+{
+	SCGIError(msg);
 }
\ No newline at end of file
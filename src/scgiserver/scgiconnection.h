@@ -29,10 +29,11 @@
 #define __SCGI_CONNECTION_H__
 
 #include <network/sockethandler.h>
+#include <network/timerqueue.h>
 #include <network/iobuffer.h>
 #include <util/timer.h>
 
-#include <measureserver/client.h>
+#include <measureserver/reactor.h>
 
 #include <protocol/protocol.h>
 
@@ -40,13 +41,8 @@
 
 class SCGIServer;
 class SCGIRequest;
-class RequestQueue;
-class ClientManager;
 
-class ServerProtocolService;
-class TransactionRequest;
-
-class SCGIConnection : public Net::SocketHandler, public protocol::TransactionIssuer, public IClientEventListener
+class SCGIConnection : public Net::SocketHandler, public Net::TimerHandler, public ChannelEndpoint
 {
 public:
 	virtual void	HandleEvent(int flags);
@@ -54,17 +50,20 @@ public:
 	virtual bool	IsAlive();
 	virtual bool	Shutdown();
 
-	virtual void TransactionComplete(protocol::Transaction* pTransaction);
-	virtual void TransactionError(protocol::Transaction* pTransaction, const char* msg, protocol::TransactionErrorType type);
+	virtual void	TimerExpired();
 
-	virtual void SessionDestroyed();
+	virtual void	ChannelResponse(std::string& response);
+	virtual void	ChannelError(const std::string& msg);
+	virtual void	ChannelSessionGone();
+	virtual void	ChannelRejected(const std::string& msg);
 
 	bool Init();
 
-	SCGIConnection(Net::Connection* pConnection, SCGIServer* pServer, ServerProtocolService* pSrvProtSrvc, ClientManager* pClientMgr);
+	SCGIConnection(Net::Connection* pConnection, SCGIServer* pServer, Reactor* pReactor);
 	virtual ~SCGIConnection();
 private:
-	void SendResponse(const char* data, size_t length);
+	/// Queue a response, the data is taken over without copying
+	void SendResponse(std::string& data);
 	void SendError(std::string msg);
 
 	bool ParseSCGIRequest(void* buffer, size_t datalength);
@@ -74,10 +73,9 @@ private:
 
 	Net::Connection*	mpConnection;
 	SCGIServer*			mpServer;
-	Client*				mpClient;
-	ServerProtocolService* mpSrvProtSrvc;
-	ClientManager*		mpClientMgr;
-	TransactionRequest*		mpCurrentRequest;
+	Net::TimerQueue*	mpTimers;
+	Reactor*			mpReactor;
+	unsigned int		mChannel;
 
 	timer				mLifeTimer;
 
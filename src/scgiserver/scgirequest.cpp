@@ -48,6 +48,7 @@ void SCGIRequest::Reset()
 	mHeaderSize = 0;
 	mContentLength = 0;
 	mRequestSize = 0;
+	mContentOffset = 0;
 
 	//mKeepAlive = 0;
 	mConnectionType = eConnectionClose;
@@ -146,7 +147,7 @@ bool SCGIRequest::ParseToken(char* data, size_t length, int& error, bool& done)
 
 			mRequestSize = mCurrentOffset + mContentLength;
 
-			mContent = string(data + mCurrentOffset, data + mCurrentOffset + mContentLength);
+			mContentOffset = mCurrentOffset;
 			mState = eNetstringLine;
 			done = true;
 			return false;
@@ -167,7 +168,7 @@ size_t SCGIRequest::RequestSize()
 	return mRequestSize;
 }
 
-std::string SCGIRequest::GetPayload()
+const char* SCGIRequest::GetPayload(const char* data)
 {
-	return mContent;
+	return data + mContentOffset;
 }
\ No newline at end of file
@@ -47,7 +47,8 @@ public:
 
 	eConnectionType ConnectionType() { return mConnectionType; }
 
-	std::string		GetPayload();
+	/// Payload within the request data (not copied)
+	const char*		GetPayload(const char* data);
 	std::string		RemoteAddr() { return mRemoteAddr; }
 
 	size_t			RequestSize();
@@ -65,7 +66,7 @@ private:
 	size_t	mHeaderSize;
 	size_t	mContentLength;
 	size_t	mRequestSize;
-	std::string mContent;
+	size_t	mContentOffset;
 
 	eConnectionType	mConnectionType;
 
@@ -64,7 +64,7 @@ void InitSCGILog(Config* pConfig)
 class SCGIServerHandler : public Net::SocketHandler
 {
 public:
-	bool	ListenOn(int port);
+	bool	ListenOn(int port, bool shared);
 
 	virtual void			HandleEvent(int flags);
 
@@ -93,9 +93,9 @@ SCGIServerHandler::~SCGIServerHandler()
 	delete mpServerSocket;
 }
 
-bool SCGIServerHandler::ListenOn(int port)
+bool SCGIServerHandler::ListenOn(int port, bool shared)
 {
-	if (!mpServerSocket->StartServer(port, 100)) return false;
+	if (!mpServerSocket->StartServer(port, 100, shared)) return false;
 	return true;
 }
 
@@ -107,12 +107,11 @@ void SCGIServerHandler::HandleEvent(int flags)
 
 ///////////////////
 
-SCGIServer::SCGIServer(Net::Multiplexer* pServer, ServerProtocolService* pSrvProtSrvc, ClientManager* pClientMgr)
+SCGIServer::SCGIServer(Reactor* pReactor)
 {
 	mpServerHandler = new SCGIServerHandler(this);
-	mpServer	= pServer;
-	mpSrvProtSrvc = pSrvProtSrvc;
-	mpClientMgr = pClientMgr;
+	mpServer	= pReactor->GetMultiplexer();
+	mpReactor	= pReactor;
 }
 
 SCGIServer::~SCGIServer()
@@ -127,9 +126,9 @@ SCGIServer::~SCGIServer()
 	delete mpServerHandler;
 }
 
-bool SCGIServer::Init(int port, Config* pConfig)
+bool SCGIServer::Init(int port, Config* pConfig, bool shared)
 {
-	if (!mpServerHandler->ListenOn(port))
+	if (!mpServerHandler->ListenOn(port, shared))
 	{
 		return false;
 	}
@@ -148,7 +147,7 @@ void SCGIServer::AddConnection(Net::Connection* pConnection)
 	sysout << timestamp << "SCGI connection from: " << pConnection->GetPeerIPAsString() << endl;
 	scgilog.Log(1) << timestamp << "SCGI connection from: " << pConnection->GetPeerIPAsString() << endl;
 
-	SCGIConnection* pSCGICon = new SCGIConnection(pConnection, this, mpSrvProtSrvc, mpClientMgr);
+	SCGIConnection* pSCGICon = new SCGIConnection(pConnection, this, mpReactor);
 	pSCGICon->Init(); // even if we fail to init, we want the connection to send an error
 
 	mConnections.push_back(pSCGICon);
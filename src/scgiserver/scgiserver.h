@@ -41,18 +41,20 @@ namespace Net
 
 class SCGIServerHandler;
 class Config;
+class Reactor;
 
 extern LogModule	scgilog;
 
 class SCGIServer
 {
 public:
-	bool Init(int port, Config* pConfig);
+	///	shared: other reactors listen on the same port
+	bool Init(int port, Config* pConfig, bool shared = false);
 
 	void AddConnection(Net::Connection* pConnection);
 	void RemoveConnection(SCGIConnection* pSCGICon);
 
-	SCGIServer(Net::Multiplexer* pServer, ServerProtocolService* pSrvProtSrvc, ClientManager* pClientMgr);
+	SCGIServer(Reactor* pReactor);
 	virtual ~SCGIServer();
 private:
 	SCGIServerHandler* mpServerHandler;
@@ -60,8 +62,7 @@ private:
 	typedef std::list<SCGIConnection*> tConnections;
 	tConnections			mConnections;
 	Net::Multiplexer*		mpServer;
-	ServerProtocolService*	mpSrvProtSrvc;
-	ClientManager*			mpClientMgr;
+	Reactor*				mpReactor;
 };
 
 #endif
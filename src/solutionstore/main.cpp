@@ -0,0 +1,329 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+/*
+	Solution store builder
+
+	Solves the circuits the server saved (SaveCircuits) against the server's maxlists and writes the
+	solutions to a store file the server maps at startup (SolutionStore), so circuits it has seen
+	before don't have to be searched again after a restart. The circuits are spread over threads,
+	each with its own copy of the maxlists.
+
+		solutionstore -c conf/ -o conf/solutions.store -a savedcircuits
+
+	The store is only used with the same component types and maxlists, rebuild it when they change.
+	Circuits that are too complex for the budget aren't stored, the server searches them as usual.
+	Every circuit is keyed with all maxlists allowed (there are no instruments to set limits), so
+	circuits sent with instrument settings that rule out a maxlist never hit the store.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <glob.h>
+#endif
+
+#include <measureserver/circuitarchive.h>
+#include <measureserver/maxlists.h>
+#include <measureserver/solutionstore.h>
+#include <instruments/compdefreader.h>
+#include <instruments/instrumentblock.h>
+#include <instruments/nodeinterpreter.h>
+
+#include <util/basic_exception.h>
+#include <util/syslog.h>
+#include <util/thread.h>
+#include <util/timer.h>
+
+using namespace std;
+
+/// An unopened stream discards what is written to it
+static ofstream sNullStream;
+
+void usage(char* cmdname)
+{
+	cout << cmdname << " <flags> <circuit files>" << endl;
+	cout << " Flags:" << endl;
+	cout << "  -c <confdir>       directory with the server config, default conf/" << endl;
+	cout << "  -d <compdef>       component types in the config directory, default component.types" << endl;
+	cout << "  -m <maxlistconf>   maxlist config in the config directory, default maxlists.conf" << endl;
+	cout << "  -o <store>         store file to write" << endl;
+	cout << "  -a <archive>       solve the circuits in the server's circuit archive" << endl;
+	cout << "  -j <threads>       solve on this many threads, default 1" << endl;
+	cout << "  -b <ms>            solver budget per circuit in milliseconds, default 2000, 0 for no limit" << endl;
+	cout << "  -v                 show the solver log" << endl;
+	cout << " Circuit files may be given as well, the names may be wildcards" << endl;
+	cout << " Circuits that are too complex for the budget aren't stored. Every circuit is stored with all" << endl;
+	cout << " maxlists allowed, circuits whose instrument limits rule out a maxlist never hit the store" << endl;
+	exit(1);
+}
+
+void BuildFileList(const string& arg, vector<string>& fileList)
+{
+#ifdef _WIN32
+	string path;
+	size_t last = arg.find_last_of("\\/");
+	if (last != string::npos) path = arg.substr(0, last + 1);
+
+	WIN32_FIND_DATAA filedata;
+	HANDLE fh = FindFirstFileA(arg.c_str(), &filedata);
+	if (INVALID_HANDLE_VALUE == fh) return;
+
+	do
+	{
+		fileList.push_back(path + filedata.cFileName);
+	} while(FindNextFileA(fh, &filedata) != 0);
+
+	FindClose(fh);
+#else
+	glob_t globblob;
+	if (0 != glob(arg.c_str(), 0, NULL, &globblob)) return;
+
+	for(size_t i = 0; i < globblob.gl_pathc; i++)
+	{
+		fileList.push_back(globblob.gl_pathv[i]);
+	}
+
+	globfree(&globblob);
+#endif
+}
+
+bool ReadFile(const string& filename, string& contents)
+{
+	ifstream file(filename.c_str(), ios::in | ios::binary);
+	if (!file.is_open()) return false;
+
+	stringstream buffer;
+	buffer << file.rdbuf();
+	contents = buffer.str();
+	return true;
+}
+
+/// The circuits and what became of them, shared by the workers. The files are followed by the archived circuits
+struct Batch
+{
+	const vector<string>*	pFiles;
+	const CircuitArchive*	pArchive;
+	size_t		size;
+	Mutex		mutex;
+	size_t		next;
+	size_t		solved;
+	size_t		unsolvable;
+	size_t		tooComplex;
+	size_t		invalid;	// unreadable or unparsable
+};
+
+class StoreWorker : public Thread
+{
+public:
+	StoreWorker(Batch* pBatch) : mpBatch(pBatch) {}
+
+	virtual void Run()
+	{
+		for(;;)
+		{
+			mpBatch->mutex.Lock();
+			size_t index = mpBatch->next++;
+			mpBatch->mutex.Unlock();
+
+			if (index >= mpBatch->size) return;
+			Solve(index);
+		}
+	}
+
+	MaxLists	maxLists;
+private:
+	bool Read(size_t index, string& name, string& circuit)
+	{
+		if (index < mpBatch->pFiles->size())
+		{
+			name = (*mpBatch->pFiles)[index];
+			return ReadFile(name, circuit);
+		}
+
+		CircuitArchive::Record record;
+		stringstream archiveName;
+		archiveName << "archive record " << (index - mpBatch->pFiles->size());
+		name = archiveName.str();
+		if (!mpBatch->pArchive->Read(index - mpBatch->pFiles->size(), record)) return false;
+
+		name = record.md5;
+		circuit = record.circuit;
+		return true;
+	}
+
+	void Solve(size_t index)
+	{
+		string filename;
+		string circuit;
+		MaxLists::CacheOutcome outcome = MaxLists::eNotCached;
+		bool solved = false;
+		if (!Read(index, filename, circuit)) cerr << "Can't read: " << filename << endl;
+		else
+		{
+			// the block has no instruments, so every maxlist is allowed like for a circuit without limits
+			InstrumentBlock block;
+			block.GetNodeInterpreter()->SetCircuitList(circuit);
+			try
+			{
+				solved = maxLists.CircuitToNetlist(&block, &outcome);
+			}
+			catch(BasicException e)
+			{
+				cerr << filename << ": " << e.what() << endl;
+			}
+		}
+
+		// a repeated circuit is a cache hit, it is stored all the same
+		ScopedLock lock(mpBatch->mutex);
+		if (outcome == MaxLists::eTooComplex) mpBatch->tooComplex++;
+		else if (outcome == MaxLists::eNotCached) mpBatch->invalid++;
+		else if (solved) mpBatch->solved++;
+		else mpBatch->unsolvable++;
+	}
+
+	Batch*	mpBatch;
+};
+
+int main(int argc, char** argv)
+{
+	string confDir = "conf/";
+	string compDefFile = "component.types";
+	string maxListConf = "maxlists.conf";
+	string output;
+	int threads = 1;
+	int budget = 2000;
+	bool verbose = false;
+
+	string archiveDir;
+	int i = 1;
+	for(; i < argc && argv[i][0] == '-'; i++)
+	{
+		string option = argv[i];
+		if (option == "-v")
+		{
+			verbose = true;
+			continue;
+		}
+		if (i + 1 >= argc) usage(argv[0]);
+
+		string value = argv[++i];
+		if (option == "-c") confDir = value;
+		else if (option == "-d") compDefFile = value;
+		else if (option == "-m") maxListConf = value;
+		else if (option == "-o") output = value;
+		else if (option == "-a") archiveDir = value;
+		else if (option == "-j") threads = atoi(value.c_str());
+		else if (option == "-b") budget = atoi(value.c_str());
+		else usage(argv[0]);
+	}
+	if (output.empty() || threads < 1 || budget < 0) usage(argv[0]);
+	if (!confDir.empty() && confDir[confDir.size() - 1] != '/' && confDir[confDir.size() - 1] != '\\') confDir += "/";
+
+	vector<string> fileList;
+	for(; i < argc; i++) BuildFileList(argv[i], fileList);
+
+	CircuitArchive archive;
+	if (!archiveDir.empty() && !archive.Open(archiveDir))
+	{
+		cerr << "Can't open circuit archive: " << archiveDir << endl;
+		return 1;
+	}
+
+	const size_t circuits = fileList.size() + archive.Size();
+	if (circuits == 0)
+	{
+		cerr << "No input files" << endl;
+		usage(argv[0]);
+	}
+
+	if (!verbose) sysout.SetStreams(sNullStream);
+
+	ComponentDefinitionReader compdef;
+	if (!compdef.ReadFile(confDir + compDefFile))
+	{
+		cerr << "Can't find component definitions file: " << confDir + compDefFile << endl;
+		return 1;
+	}
+
+	Batch batch;
+	batch.pFiles		= &fileList;
+	batch.pArchive		= &archive;
+	batch.size			= circuits;
+	batch.next			= 0;
+	batch.solved		= 0;
+	batch.unsolvable	= 0;
+	batch.tooComplex	= 0;
+	batch.invalid		= 0;
+
+	// every worker remembers all its solutions, they are merged into the store at the end
+	vector<StoreWorker*> workers;
+	for(int t = 0; t < threads; t++)
+	{
+		StoreWorker* pWorker = new StoreWorker(&batch);
+		pWorker->maxLists.SetSolverBudget(0, 0, 0, budget / 1000.0);
+		if (!pWorker->maxLists.Init(confDir, maxListConf, "", compdef.GetDefinitions(), circuits, 0))
+		{
+			cerr << "Can't read the maxlists: " << confDir + maxListConf << endl;
+			return 1;
+		}
+		workers.push_back(pWorker);
+	}
+
+	timer total;
+	for(size_t t = 1; t < workers.size(); t++)
+	{
+		if (!workers[t]->Start()) cerr << "Failed to start worker thread" << endl;
+	}
+	workers[0]->Run();
+
+	SolutionCache::tEntryMap entries;
+	for(size_t t = 0; t < workers.size(); t++)
+	{
+		if (t > 0) workers[t]->Join();
+		workers[t]->maxLists.GetSolutionCache().GetEntries(entries);
+	}
+
+	if (!SolutionStore::Write(output, workers[0]->maxLists.Fingerprint(), entries))
+	{
+		cerr << "Failed to write the solution store: " << output << endl;
+		return 1;
+	}
+
+	cout << "Circuits: " << circuits << " solved: " << batch.solved << " unsolvable: " << batch.unsolvable
+		<< " too complex: " << batch.tooComplex << " invalid: " << batch.invalid << " in " << total.elapsed() << "s" << endl;
+	cout << "Wrote " << entries.size() << " distinct circuits to " << output << endl;
+
+	for(size_t t = 0; t < workers.size(); t++) delete workers[t];
+	return 0;
+}
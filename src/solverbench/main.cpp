@@ -0,0 +1,284 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+/*
+	Solver microbenchmark
+
+	Solves a corpus of saved circuits (see SaveCircuits in measureserver.conf, export them from
+	the archive with circuitarchive) against the maxlists and times the symbol table backtracking
+	step, copying the table as the solver used to against the checkpoint/rollback it uses now.
+
+	With -c every circuit is also solved without search heuristics and the outcomes are compared.
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+
+#include <instruments/circuitlist.h>
+#include <instruments/circuitsolver3.h>
+#include <instruments/circuitsymbols2.h>
+#include <instruments/compdefreader.h>
+#include <instruments/listparser.h>
+
+#include <util/timer.h>
+
+#include <fstream>
+
+using namespace std;
+
+typedef vector<ListComponent::tComponentList> tLists;
+
+void usage(char* cmdname)
+{
+	cout << cmdname << " <flags> <circuit files>" << endl;
+	cout << " Flags:" << endl;
+	cout << "  -d <compdef>       component definitions, default component.types" << endl;
+	cout << "  -m <maxlistconf>   maxlist config, the solve benchmark is skipped without it" << endl;
+	cout << "  -n <rounds>        times each circuit is solved, default 10" << endl;
+	cout << "  -H <heuristics>    solver heuristics flags, default 7 (all)" << endl;
+	cout << "  -c                 compare the results with a search without heuristics" << endl;
+	exit(1);
+}
+
+bool LoadMaxlists(const string& maxlistConf, tLists& maxLists, const ListParser::tComponentDefinitions& compdefs)
+{
+	string path;
+	size_t sep = maxlistConf.find_last_of("/\\");
+	if (sep != string::npos) path = string(maxlistConf, 0, sep + 1);
+
+	fstream file(maxlistConf.c_str());
+	if (!file.is_open())
+	{
+		cerr << "Can't find maxlist config: " << maxlistConf << endl;
+		return false;
+	}
+
+	string line;
+	while(getline(file, line))
+	{
+		if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+		if (line.empty() || line[0] == '#' || line[0] == '*') continue;
+
+		ListParser parser(compdefs, true);
+		if (!parser.ParseFile(path + line))
+		{
+			cerr << "failed to read maxlist: " << path + line << endl;
+			return false;
+		}
+		maxLists.push_back(parser.GetList());
+	}
+	return true;
+}
+
+/// Returns the index of the first maxlist that solves the circuit, or -1
+int SolveFirst(const ListComponent::tComponentList& circuit, const tLists& maxLists, int heuristics, ListComponent::tComponentList& solution, SolverStats& stats)
+{
+	for(size_t i = 0; i < maxLists.size(); i++)
+	{
+		CircuitList solver;
+		solver.SetHeuristics(heuristics);
+		const bool solved = solver.Solve(circuit, maxLists[i]);
+		stats.Add(solver.GetStats());
+		if (solved)
+		{
+			solution = solver.GetSolution();
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+/// Time both searches per circuit and report where they disagree
+void Compare(const tLists& circuits, const tLists& maxLists, int heuristics)
+{
+	int differentList = 0;
+	int differentSolution = 0;
+	double plainTime = 0;
+	double heuristicTime = 0;
+	double worstPlain = 0;
+	double worstHeuristic = 0;
+	SolverStats plainStats, heuristicStats;
+
+	for(size_t i = 0; i < circuits.size(); i++)
+	{
+		ListComponent::tComponentList plain, heuristic;
+
+		timer plaintimer;
+		int plainList = SolveFirst(circuits[i], maxLists, 0, plain, plainStats);
+		double elapsed = plaintimer.elapsed();
+		plainTime += elapsed;
+		worstPlain = max(worstPlain, elapsed);
+
+		timer heuristictimer;
+		int heuristicList = SolveFirst(circuits[i], maxLists, heuristics, heuristic, heuristicStats);
+		elapsed = heuristictimer.elapsed();
+		heuristicTime += elapsed;
+		worstHeuristic = max(worstHeuristic, elapsed);
+
+		if (plainList != heuristicList)
+		{
+			cout << "circuit " << i << ": solved by maxlist " << plainList << " without heuristics, " << heuristicList << " with" << endl;
+			differentList++;
+		}
+		else if (plain != heuristic) differentSolution++;
+	}
+
+	cout << "Compare: " << differentList << " solved by another maxlist, "
+		<< differentSolution << " other solutions from the same maxlist" << endl;
+	cout << "Without heuristics: " << std::fixed << (plainTime * 1000.0 / circuits.size()) << "ms per circuit, worst " << (worstPlain * 1000.0) << "ms, "
+		<< plainStats.nodes << " nodes, " << plainStats.backtracks << " backtracks" << endl;
+	cout << "With heuristics: " << (heuristicTime * 1000.0 / circuits.size()) << "ms per circuit, worst " << (worstHeuristic * 1000.0) << "ms, "
+		<< heuristicStats.nodes << " nodes, " << heuristicStats.backtracks << " backtracks" << endl;
+}
+
+/// Fill a table the way tier two does, every wire is a reference and every other connection is marked
+void BuildSymbols(const ListComponent::tComponentList& circuit, SymbolTable& symbols)
+{
+	const InternString wire = InternString::Vocabulary("W");
+	SymbolTable::tMarked marked;
+	for(ListComponent::tComponentList::const_iterator it = circuit.begin(); it != circuit.end(); ++it)
+	{
+		const ListComponent::tConnections& cons = it->GetCConnections();
+		if (it->GetTypeId() == wire && cons.size() == 2) symbols.Ref(cons[0], cons[1]);
+		else for(size_t i = 0; i < cons.size(); ++i) symbols.Mark(marked, cons[i]);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	string compDefFile = "component.types";
+	string maxListConf;
+	int rounds = 10;
+	int heuristics = CircuitSolver3::eAllHeuristics;
+	bool compare = false;
+
+	int i = 1;
+	for(; i < argc && argv[i][0] == '-'; i++)
+	{
+		string option = argv[i];
+		if (option == "-c")
+		{
+			compare = true;
+			continue;
+		}
+
+		if (i + 1 >= argc) usage(argv[0]);
+		if (option == "-d") compDefFile = argv[++i];
+		else if (option == "-m") maxListConf = argv[++i];
+		else if (option == "-n") rounds = atoi(argv[++i]);
+		else if (option == "-H") heuristics = atoi(argv[++i]);
+		else usage(argv[0]);
+	}
+	if (i >= argc || rounds <= 0) usage(argv[0]);
+
+	ComponentDefinitionReader compdef;
+	if (!compdef.ReadFile(compDefFile))
+	{
+		cerr << "Can't find component definitions file: " << compDefFile << endl;
+		return 1;
+	}
+
+	tLists circuits;
+	for(; i < argc; i++)
+	{
+		ListParser parser(compdef.GetDefinitions());
+		if (!parser.ParseFile(argv[i])) cerr << "Unable to parse: " << argv[i] << endl;
+		else circuits.push_back(parser.GetList());
+	}
+	if (circuits.empty())
+	{
+		cerr << "No input circuits" << endl;
+		return 1;
+	}
+
+	cout << "Circuits: " << circuits.size() << ", rounds: " << rounds << endl;
+
+	tLists maxLists;
+	if (!maxListConf.empty())
+	{
+		if (!LoadMaxlists(maxListConf, maxLists, compdef.GetDefinitions())) return 1;
+
+		int solved = 0;
+		timer solvetimer;
+		for(int round = 0; round < rounds; round++)
+		{
+			for(tLists::const_iterator it = circuits.begin(); it != circuits.end(); ++it)
+			{
+				ListComponent::tComponentList solution;
+				SolverStats stats;
+				if (SolveFirst(*it, maxLists, heuristics, solution, stats) >= 0 && round == 0) solved++;
+			}
+		}
+		double elapsed = solvetimer.elapsed();
+		cout << "Solve: " << solved << " of " << circuits.size() << " solved, "
+			<< std::fixed << (elapsed * 1000.0 / (rounds * circuits.size())) << "ms per circuit" << endl;
+
+		if (compare) Compare(circuits, maxLists, heuristics);
+	}
+
+	// the step repeated for every candidate in the backtracking search: try one insert and undo it
+	const InternString node = InternString::Vocabulary("A");
+	const int steps = rounds * 1000;
+	double copytime = 0;
+	double rollbacktime = 0;
+
+	for(tLists::const_iterator it = circuits.begin(); it != circuits.end(); ++it)
+	{
+		if (it->empty()) continue;
+
+		SymbolTable symbols;
+		BuildSymbols(*it, symbols);
+		const InternString& sym = it->front().GetCConnections().front();
+
+		timer copytimer;
+		for(int step = 0; step < steps; step++)
+		{
+			SymbolTable attempt = symbols;
+			attempt.Insert(sym, node);
+		}
+		copytime += copytimer.elapsed();
+
+		timer rollbacktimer;
+		for(int step = 0; step < steps; step++)
+		{
+			SymbolTable::tCheckpoint checkpoint = symbols.Checkpoint();
+			symbols.Insert(sym, node);
+			symbols.Rollback(checkpoint);
+		}
+		rollbacktime += rollbacktimer.elapsed();
+	}
+
+	double total = (double)steps * circuits.size();
+	cout << "Backtrack step, copy: " << std::fixed << (copytime * 1e9 / total) << "ns"
+		<< ", checkpoint/rollback: " << (rollbacktime * 1e9 / total) << "ns"
+		<< ", speedup: " << (rollbacktime > 0 ? copytime / rollbacktime : 0) << "x" << endl;
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __ATOMIC_H__
+#define __ATOMIC_H__
+
+/// Minimal set of atomic operations on ints and pointers.
+/// Loads have acquire and stores have release semantics, which is enough
+/// for handing data between two threads.
+
+#ifdef _WIN32
+#include <windows.h>
+#include <intrin.h>
+
+inline int AtomicLoad(volatile int* p)
+{
+	int value = *p;
+	_ReadWriteBarrier();
+	return value;
+}
+
+inline void AtomicStore(volatile int* p, int value)
+{
+	_ReadWriteBarrier();
+	*p = value;
+}
+
+inline int AtomicExchange(volatile int* p, int value)
+{
+	return (int)InterlockedExchange((volatile LONG*)p, (LONG)value);
+}
+
+/// Returns the new value
+inline int AtomicIncrement(volatile int* p)
+{
+	return (int)InterlockedIncrement((volatile LONG*)p);
+}
+
+template<class T>
+inline T* AtomicLoadPtr(T* volatile* p)
+{
+	T* value = *p;
+	_ReadWriteBarrier();
+	return value;
+}
+
+template<class T>
+inline void AtomicStorePtr(T* volatile* p, T* value)
+{
+	_ReadWriteBarrier();
+	*p = value;
+}
+
+#else
+
+inline int AtomicLoad(volatile int* p)
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+inline void AtomicStore(volatile int* p, int value)
+{
+	__atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+inline int AtomicExchange(volatile int* p, int value)
+{
+	return __atomic_exchange_n(p, value, __ATOMIC_ACQ_REL);
+}
+
+/// Returns the new value
+inline int AtomicIncrement(volatile int* p)
+{
+	return __atomic_add_fetch(p, 1, __ATOMIC_ACQ_REL);
+}
+
+template<class T>
+inline T* AtomicLoadPtr(T* volatile* p)
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+template<class T>
+inline void AtomicStorePtr(T* volatile* p, T* value)
+{
+	__atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,63 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __BYTEORDER_H__
+#define __BYTEORDER_H__
+
+#include <string>
+
+/// Little endian encoding of the numbers in the binary files, the same on every platform
+
+inline void PutU8(std::string& out, unsigned int val)
+{
+	out += (char)(val & 0xff);
+}
+
+inline void PutU16(std::string& out, unsigned int val)
+{
+	PutU8(out, val);
+	PutU8(out, val >> 8);
+}
+
+inline void PutU32(std::string& out, unsigned int val)
+{
+	PutU16(out, val);
+	PutU16(out, val >> 16);
+}
+
+inline unsigned int GetU16(const void* pData)
+{
+	const unsigned char* p = (const unsigned char*)pData;
+	return p[0] | (p[1] << 8);
+}
+
+inline unsigned int GetU32(const void* pData)
+{
+	const unsigned char* p = (const unsigned char*)pData;
+	return GetU16(p) | (GetU16(p + 2) << 16);
+}
+
+#endif
@@ -50,7 +50,21 @@ public:
 
 	const LogOutput& operator<<(std::ostream& (*_Pfn)(std::ostream&)) const
 	{
-		::operator<<(*this, _Pfn);
+		if (mStreams.empty()) return *this;
+
+		std::ostringstream& line = PendingLogLine(this, *mStreams.front());
+		line << _Pfn;
+
+		std::string text;
+		if (!TakeLogLine(line, *mStreams.front(), text)) return *this;
+
+		LockLog();
+		for(tOutStreams::const_iterator it = mStreams.begin(); it != mStreams.end(); it++)
+		{
+			**it << text;
+			(*it)->flush();
+		}
+		UnlockLog();
 		return *this;
 	}
 private:
@@ -61,12 +75,10 @@ private:
 template< class T >
 const LogOutput& operator<< (const LogOutput& logoutput, T out)
 {
-	LogOutput::tOutStreams streams = logoutput.GetStreams();
-	for(LogOutput::tOutStreams::const_iterator it = streams.begin(); it != streams.end(); it++)
-	{
-		**it << out;
-	}
+	const LogOutput::tOutStreams& streams = logoutput.GetStreams();
+	if (streams.empty()) return logoutput;
 
+	PendingLogLine(&logoutput, *streams.front()) << out;
 	return logoutput;
 }
 
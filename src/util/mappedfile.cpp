@@ -0,0 +1,145 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+
+struct MappedFile_internal
+{
+	HANDLE	file;
+	HANDLE	mapping;
+};
+
+bool MappedFile::Open(const std::string& filename)
+{
+	Close();
+
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		// an empty file can't be mapped
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	const void* pData = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (pData == NULL)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	mpWrap = new MappedFile_internal();
+	mpWrap->file	= file;
+	mpWrap->mapping	= mapping;
+	mpData	= (const char*)pData;
+	mSize	= (size_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (!mpWrap) return;
+
+	UnmapViewOfFile(mpData);
+	CloseHandle(mpWrap->mapping);
+	CloseHandle(mpWrap->file);
+	delete mpWrap;
+	mpWrap	= NULL;
+	mpData	= NULL;
+	mSize	= 0;
+}
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct MappedFile_internal
+{
+};
+
+bool MappedFile::Open(const std::string& filename)
+{
+	Close();
+
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		// an empty file can't be mapped
+		close(fd);
+		return false;
+	}
+
+	// the mapping stays valid after the descriptor is closed
+	void* pData = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (pData == MAP_FAILED) return false;
+
+	mpData	= (const char*)pData;
+	mSize	= (size_t)info.st_size;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (!mpData) return;
+
+	munmap((void*)mpData, mSize);
+	mpData	= NULL;
+	mSize	= 0;
+}
+
+#endif
+
+MappedFile::MappedFile()
+{
+	mpWrap	= NULL;
+	mpData	= NULL;
+	mSize	= 0;
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
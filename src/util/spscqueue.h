@@ -0,0 +1,115 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __SPSCQUEUE_H__
+#define __SPSCQUEUE_H__
+
+#include "atomic.h"
+#include <stddef.h>
+
+/// Unbounded lock free queue with exactly one producer and one consumer thread.
+/// Push never blocks, consumed nodes are recycled by the producer so a queue
+/// in steady state does not allocate.
+template<class T>
+class SPSCQueue
+{
+public:
+	SPSCQueue()
+	{
+		Node* pNode		= new Node();
+		pNode->pNext	= NULL;
+		mpTail			= pNode;
+		mpHead			= pNode;
+		mpFirst			= pNode;
+		mpTailCopy		= pNode;
+	}
+
+	~SPSCQueue()
+	{
+		Node* pNode = mpFirst;
+		while (pNode)
+		{
+			Node* pNext = pNode->pNext;
+			delete pNode;
+			pNode = pNext;
+		}
+	}
+
+	/// Producer side
+	void Push(const T& value)
+	{
+		Node* pNode		= AllocNode();
+		pNode->value	= value;
+		pNode->pNext	= NULL;
+		AtomicStorePtr(&mpHead->pNext, pNode);
+		mpHead = pNode;
+	}
+
+	/// Consumer side, returns false if the queue is empty
+	bool Pop(T& value)
+	{
+		Node* pNext = AtomicLoadPtr(&mpTail->pNext);
+		if (!pNext) return false;
+		value = pNext->value;
+		AtomicStorePtr(&mpTail, pNext);
+		return true;
+	}
+private:
+	struct Node
+	{
+		Node* volatile	pNext;
+		T				value;
+	};
+
+	Node* AllocNode()
+	{
+		// nodes before the consumers tail are free for reuse
+		if (mpFirst == mpTailCopy)
+		{
+			mpTailCopy = AtomicLoadPtr(&mpTail);
+			if (mpFirst == mpTailCopy) return new Node();
+		}
+
+		Node* pNode = mpFirst;
+		mpFirst = mpFirst->pNext;
+		return pNode;
+	}
+
+	SPSCQueue(const SPSCQueue&);
+	SPSCQueue& operator=(const SPSCQueue&);
+
+	// consumer
+	Node* volatile	mpTail;
+	char			mPadding[64];
+
+	// producer
+	Node*			mpHead;
+	Node*			mpFirst;
+	Node*			mpTailCopy;
+};
+
+#endif
@@ -0,0 +1,179 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __STRINGVIEW_H__
+#define __STRINGVIEW_H__
+
+#include <stddef.h>
+#include <string.h>
+#include <fstream>
+#include <string>
+
+/// Non owning view of a range of characters, a small std::string_view.
+/// The viewed text must outlive the view.
+class StringView
+{
+public:
+	static const size_t npos = std::string::npos;
+
+	StringView() : mpData(""), mSize(0) {}
+	StringView(const char* pData, size_t size) : mpData(pData), mSize(size) {}
+	StringView(const char* pText) : mpData(pText), mSize(strlen(pText)) {}
+	StringView(const std::string& text) : mpData(text.data()), mSize(text.size()) {}
+
+	const char*	data() const	{ return mpData; }
+	size_t		size() const	{ return mSize; }
+	bool		empty() const	{ return mSize == 0; }
+	char		operator[](size_t i) const { return mpData[i]; }
+
+	std::string	str() const		{ return std::string(mpData, mSize); }
+
+	/// Like std::string::substr, pos past the end gives an empty view
+	StringView	substr(size_t pos, size_t count = npos) const
+	{
+		if (pos > mSize) pos = mSize;
+		if (count > mSize - pos) count = mSize - pos;
+		return StringView(mpData + pos, count);
+	}
+
+	size_t find(char c, size_t pos = 0) const
+	{
+		for(; pos < mSize; pos++) if (mpData[pos] == c) return pos;
+		return npos;
+	}
+
+	size_t find_first_of(const char* chars, size_t pos = 0) const
+	{
+		for(; pos < mSize; pos++) if (strchr(chars, mpData[pos]) && mpData[pos]) return pos;
+		return npos;
+	}
+
+	size_t find_first_not_of(const char* chars, size_t pos = 0) const
+	{
+		for(; pos < mSize; pos++) if (!strchr(chars, mpData[pos]) || !mpData[pos]) return pos;
+		return npos;
+	}
+
+	bool operator==(const StringView& other) const { return mSize == other.mSize && memcmp(mpData, other.mpData, mSize) == 0; }
+	bool operator!=(const StringView& other) const { return !(*this == other); }
+
+	/// Like atoi, leading whitespace and a sign then the digits up to the first non digit
+	int ToInt() const
+	{
+		size_t pos = find_first_not_of(" \t\n\r\f\v");
+		if (pos == npos) return 0;
+
+		bool negative = false;
+		if (mpData[pos] == '-' || mpData[pos] == '+') negative = (mpData[pos++] == '-');
+
+		int value = 0;
+		for(; pos < mSize && mpData[pos] >= '0' && mpData[pos] <= '9'; pos++) value = value * 10 + (mpData[pos] - '0');
+		return negative ? -value : value;
+	}
+private:
+	const char*	mpData;
+	size_t		mSize;
+};
+
+/// Splits text into lines without copying it. Lines end at any run of \n and \r, so empty lines are skipped
+class LineCursor
+{
+public:
+	LineCursor(StringView text) : mText(text), mPos(0) {}
+
+	bool Next(StringView& line)
+	{
+		if (mPos >= mText.size()) return false;
+
+		size_t end = mText.find_first_of("\n\r", mPos);
+		if (end == StringView::npos) end = mText.size();
+		line = mText.substr(mPos, end - mPos);
+
+		mPos = mText.find_first_not_of("\n\r", end);
+		if (mPos == StringView::npos) mPos = mText.size();
+		return true;
+	}
+private:
+	StringView	mText;
+	size_t		mPos;
+};
+
+/// Walks the tokens of a line without copying it, tokens are separated by runs of the separator characters
+class TokenCursor
+{
+public:
+	TokenCursor(StringView text, const char* separators = " \t") : mText(text), mpSeparators(separators), mPos(0) {}
+
+	/// Separators before the token are skipped, returns false when there are no more tokens
+	bool Next(StringView& token)
+	{
+		size_t start = mText.find_first_not_of(mpSeparators, mPos);
+		if (start == StringView::npos)
+		{
+			mPos = mText.size();
+			return false;
+		}
+
+		size_t end = mText.find_first_of(mpSeparators, start);
+		if (end == StringView::npos) end = mText.size();
+		token = mText.substr(start, end - start);
+		mPos = end;
+		return true;
+	}
+
+	/// What is left of the text after the separators following the last token
+	StringView Rest() const
+	{
+		size_t start = mText.find_first_not_of(mpSeparators, mPos);
+		if (start == StringView::npos) return StringView();
+		return mText.substr(start);
+	}
+private:
+	StringView	mText;
+	const char*	mpSeparators;
+	size_t		mPos;
+};
+
+/// Reads a whole file in one go so it can be walked with the cursors above
+inline bool ReadWholeFile(const std::string& filename, std::string& contents)
+{
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	if (!file.is_open()) return false;
+
+	contents.clear();
+	file.seekg(0, std::ios::end);
+	std::streamoff size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	if (size > 0)
+	{
+		contents.resize((size_t)size);
+		file.read(&contents[0], size);
+		contents.resize((size_t)file.gcount());
+	}
+	return true;
+}
+
+#endif
@@ -26,7 +26,9 @@
  */
 
 #include "syslog.h"
+#include "thread.h"
 #include <string>
+#include <map>
 
 #if _WIN32
 #include <windows.h>
@@ -46,6 +48,51 @@ std::ostream	sNullOStream(0);
 
 static int sLogLevel = 0;
 
+static Mutex& LogMutex()
+{
+	static Mutex sLogMutex;
+	return sLogMutex;
+}
+
+void LockLog()
+{
+	LogMutex().Lock();
+}
+
+void UnlockLog()
+{
+	LogMutex().Unlock();
+}
+
+typedef std::map<const void*, std::ostringstream*> tLogLines;
+
+std::ostringstream& PendingLogLine(const void* pStream, const std::ostream& format)
+{
+	// never destroyed, a thread may log during static destruction
+	static THREAD_LOCAL tLogLines* spLines = NULL;
+	if (!spLines) spLines = new tLogLines();
+
+	std::ostringstream*& pLine = (*spLines)[pStream];
+	if (!pLine)
+	{
+		pLine = new std::ostringstream();
+		pLine->flags(format.flags());
+		pLine->precision(format.precision());
+	}
+	return *pLine;
+}
+
+bool TakeLogLine(std::ostringstream& line, const std::ostream& format, std::string& text)
+{
+	text = line.str();
+	if (text.empty() || text[text.size() - 1] != '\n') return false;
+
+	line.str("");
+	line.flags(format.flags());
+	line.precision(format.precision());
+	return true;
+}
+
 #if _WIN32
 #define DIRSEP "\\"
 #else
@@ -120,11 +167,11 @@ std::string GenerateTimestamp()
 		);
 #else
 	time_t now;
-	struct tm* timeinfo;
+	struct tm timeinfo;
 	char buffer[80];
 	time(&now);
-	timeinfo = localtime(&now);
-	strftime(buffer, 80, "%Y-%m-%d %H:%M:%S", timeinfo);
+	localtime_r(&now, &timeinfo);
+	strftime(buffer, 80, "%Y-%m-%d %H:%M:%S", &timeinfo);
 #endif
 
 	return buffer;
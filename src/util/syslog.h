@@ -32,11 +32,22 @@
 #include <time.h>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 
 #ifdef _WIN32 
 #pragma warning( disable : 4996 )
 #endif
 
+/// Serializes writes to the log streams, the server logs from several threads
+void LockLog();
+void UnlockLog();
+
+/// The line this thread is writing to a log stream, numbers are formatted like in format.
+/// Lines are written out whole, so the lines of different threads don't interleave
+std::ostringstream& PendingLogLine(const void* pStream, const std::ostream& format);
+/// Moves the pending line to text if it is ended, the next line starts empty
+bool TakeLogLine(std::ostringstream& line, const std::ostream& format, std::string& text);
+
 /// Multiplexing output stream, with many endpoints
 /// Used to redirect to both standard out and log
 class MultiOStream
@@ -60,8 +71,19 @@ public:
 
 	MultiOStream& operator<<(std::ostream& (*_Pfn)(std::ostream&))
 	{
-		if (Os1) *Os1 << _Pfn;
-		if (Os2) *Os2 << _Pfn;
+		if (!Os1 && !Os2) return *this;
+
+		const std::ostream& format = Os1 ? *Os1 : *Os2;
+		std::ostringstream& line = PendingLogLine(this, format);
+		line << _Pfn;
+
+		std::string text;
+		if (!TakeLogLine(line, format, text)) return *this;
+
+		LockLog();
+		if (Os1) { *Os1 << text; Os1->flush(); }
+		if (Os2) { *Os2 << text; Os2->flush(); }
+		UnlockLog();
 		return *this;
 	}
 public:
@@ -72,8 +94,8 @@ public:
 template< class T >
 MultiOStream& operator<< (MultiOStream& t,T thing)
 {
-	if (t.Os1) *t.Os1 << thing;
-	if (t.Os2) *t.Os2 << thing; 
+	if (!t.Os1 && !t.Os2) return t;
+	PendingLogLine(&t, t.Os1 ? *t.Os1 : *t.Os2) << thing;
 	return t;
 }
 
@@ -0,0 +1,247 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#include "thread.h"
+
+#include <stddef.h>
+
+#ifdef _WIN32
+#include <windows.h>
+
+struct Mutex_internal
+{
+	CRITICAL_SECTION section;
+};
+
+Mutex::Mutex()
+{
+	mpWrap = new Mutex_internal();
+	InitializeCriticalSection(&mpWrap->section);
+}
+
+Mutex::~Mutex()
+{
+	DeleteCriticalSection(&mpWrap->section);
+	delete mpWrap;
+}
+
+void Mutex::Lock()
+{
+	EnterCriticalSection(&mpWrap->section);
+}
+
+void Mutex::Unlock()
+{
+	LeaveCriticalSection(&mpWrap->section);
+}
+
+struct Condition_internal
+{
+	CONDITION_VARIABLE condition;
+};
+
+Condition::Condition()
+{
+	mpWrap = new Condition_internal();
+	InitializeConditionVariable(&mpWrap->condition);
+}
+
+Condition::~Condition()
+{
+	delete mpWrap;
+}
+
+void Condition::Wait(Mutex& mutex)
+{
+	SleepConditionVariableCS(&mpWrap->condition, &mutex.mpWrap->section, INFINITE);
+}
+
+void Condition::Signal()
+{
+	WakeConditionVariable(&mpWrap->condition);
+}
+
+void Condition::Broadcast()
+{
+	WakeAllConditionVariable(&mpWrap->condition);
+}
+
+struct Thread_internal
+{
+	HANDLE handle;
+};
+
+static DWORD WINAPI ThreadEntry(LPVOID pParam)
+{
+	static_cast<Thread*>(pParam)->Run();
+	return 0;
+}
+
+Thread::Thread()
+{
+	mpWrap = new Thread_internal();
+	mpWrap->handle = NULL;
+}
+
+Thread::~Thread()
+{
+	Join();
+	delete mpWrap;
+}
+
+bool Thread::Start()
+{
+	if (mpWrap->handle) return false;
+	mpWrap->handle = CreateThread(NULL, 0, ThreadEntry, this, 0, NULL);
+	return (mpWrap->handle != NULL);
+}
+
+void Thread::Join()
+{
+	if (!mpWrap->handle) return;
+	WaitForSingleObject(mpWrap->handle, INFINITE);
+	CloseHandle(mpWrap->handle);
+	mpWrap->handle = NULL;
+}
+
+bool Thread::IsStarted() const
+{
+	return (mpWrap->handle != NULL);
+}
+
+#else
+
+#include <pthread.h>
+
+struct Mutex_internal
+{
+	pthread_mutex_t mutex;
+};
+
+Mutex::Mutex()
+{
+	mpWrap = new Mutex_internal();
+
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&mpWrap->mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+Mutex::~Mutex()
+{
+	pthread_mutex_destroy(&mpWrap->mutex);
+	delete mpWrap;
+}
+
+void Mutex::Lock()
+{
+	pthread_mutex_lock(&mpWrap->mutex);
+}
+
+void Mutex::Unlock()
+{
+	pthread_mutex_unlock(&mpWrap->mutex);
+}
+
+struct Condition_internal
+{
+	pthread_cond_t condition;
+};
+
+Condition::Condition()
+{
+	mpWrap = new Condition_internal();
+	pthread_cond_init(&mpWrap->condition, NULL);
+}
+
+Condition::~Condition()
+{
+	pthread_cond_destroy(&mpWrap->condition);
+	delete mpWrap;
+}
+
+void Condition::Wait(Mutex& mutex)
+{
+	pthread_cond_wait(&mpWrap->condition, &mutex.mpWrap->mutex);
+}
+
+void Condition::Signal()
+{
+	pthread_cond_signal(&mpWrap->condition);
+}
+
+void Condition::Broadcast()
+{
+	pthread_cond_broadcast(&mpWrap->condition);
+}
+
+struct Thread_internal
+{
+	pthread_t	thread;
+	bool		started;
+};
+
+static void* ThreadEntry(void* pParam)
+{
+	static_cast<Thread*>(pParam)->Run();
+	return NULL;
+}
+
+Thread::Thread()
+{
+	mpWrap = new Thread_internal();
+	mpWrap->started = false;
+}
+
+Thread::~Thread()
+{
+	Join();
+	delete mpWrap;
+}
+
+bool Thread::Start()
+{
+	if (mpWrap->started) return false;
+	mpWrap->started = (pthread_create(&mpWrap->thread, NULL, ThreadEntry, this) == 0);
+	return mpWrap->started;
+}
+
+void Thread::Join()
+{
+	if (!mpWrap->started) return;
+	pthread_join(mpWrap->thread, NULL);
+	mpWrap->started = false;
+}
+
+bool Thread::IsStarted() const
+{
+	return mpWrap->started;
+}
+
+#endif
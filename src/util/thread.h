@@ -0,0 +1,112 @@
+/**** BEGIN LICENSE BLOCK ****
+ * This file is a part of the VISIR(TM) (Virtual Systems in Reality)
+ * Software package.
+ * 
+ * VISIR(TM) is used to open laboratories for remote operation and control
+ * as a supplement and a complement to local use.
+ * 
+ * VISIR(TM) is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. No liability
+ * can be imposed for any impact on any equipment by the software. See
+ * the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **** END LICENSE BLOCK ****/
+
+/*
+ * Copyright (c) 2011 Johan Zackrisson
+ * All Rights Reserved.
+ */
+
+#ifndef __THREAD_H__
+#define __THREAD_H__
+
+#ifdef _WIN32
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+struct Mutex_internal;
+struct Condition_internal;
+struct Thread_internal;
+
+/// Recursive mutex
+class Mutex
+{
+public:
+	void Lock();
+	void Unlock();
+
+	Mutex();
+	~Mutex();
+private:
+	Mutex(const Mutex&);
+	Mutex& operator=(const Mutex&);
+
+	friend class Condition;
+	Mutex_internal* mpWrap;
+};
+
+/// Condition variable, the mutex must be locked exactly once by the waiting thread
+class Condition
+{
+public:
+	/// Unlocks the mutex while waiting, spurious wakeups can happen
+	void Wait(Mutex& mutex);
+	void Signal();
+	void Broadcast();
+
+	Condition();
+	~Condition();
+private:
+	Condition(const Condition&);
+	Condition& operator=(const Condition&);
+
+	Condition_internal* mpWrap;
+};
+
+/// Holds a mutex for the lifetime of the object
+class ScopedLock
+{
+public:
+	ScopedLock(Mutex& mutex) : mMutex(mutex) { mMutex.Lock(); }
+	~ScopedLock() { mMutex.Unlock(); }
+private:
+	ScopedLock(const ScopedLock&);
+	ScopedLock& operator=(const ScopedLock&);
+
+	Mutex& mMutex;
+};
+
+/// Operating system thread, override Run
+class Thread
+{
+public:
+	/// Start running Run in a new thread
+	bool Start();
+
+	/// Wait for Run to return
+	void Join();
+
+	bool IsStarted() const;
+
+	virtual void Run() = 0;
+
+	Thread();
+	virtual ~Thread();
+private:
+	Thread(const Thread&);
+	Thread& operator=(const Thread&);
+
+	Thread_internal* mpWrap;
+};
+
+#endif
@@ -31,15 +31,10 @@
 #include <network/connection.h>
 #include <syslog.h>
 #include <sstream>
+#include <string.h>
 
 #include <basic_exception.h>
 
-#include <measureserver/clientmanager.h>
-#include <measureserver/protocolservice.h>
-#include <measureserver/session.h>
-#include <measureserver/transactionrequest.h>
-#include <measureserver/requestqueue.h>
-
 #include <xmlprotocol/producer.h>
 #include <xmlprotocol/requestparser.h>
 
@@ -49,13 +44,14 @@ using namespace std;
 
 
 
-XMLConnection::XMLConnection(Net::Connection* pConnection, XMLServer* pServer, ServerProtocolService* pSrvProtSrvc, ClientManager* pClientMgr, double shorttimeout, double timeout)
+XMLConnection::XMLConnection(Net::Connection* pConnection, XMLServer* pServer, Reactor* pReactor, double shorttimeout, double timeout)
 {
 	mpConnection = pConnection;
 
 	mpServer	= pServer;
-	mpSrvProtSrvc = pSrvProtSrvc;
-	mpClientMgr = pClientMgr;
+	mpReactor	= pReactor;
+	mpTimers	= pReactor->GetTimerQueue();
+	mChannel	= 0;
 
 	mpConnection->SetNonBlocking();
 	mpConnection->SetSelectMask(NET_READ_FLAG | NET_EXCEPTION_FLAG);
@@ -64,46 +60,25 @@ XMLConnection::XMLConnection(Net::Connection* pConnection, XMLServer* pServer, S
 
 	mCurrentPos = 0;
 	mValidPackets = 0;
-	mpClient = NULL;
-	mpCurrentRequest = NULL;
 
 	mShortTimeout	= shorttimeout;
 	mTimeout		= timeout;
+
+	mpTimers->Schedule(this, TimeLeft());
 }
 
 XMLConnection::~XMLConnection()
 {
-	if (mpCurrentRequest)
-	{
-		syserr << "A transaction was canceled mid flight (dtor)" << endl;
-		mpCurrentRequest->ClientGone();
-		mpCurrentRequest = NULL;
-	}
-
-	if (mpClient)
-	{
-		mpClient->RemoveListener(this);
-
-		mpSrvProtSrvc->GetRequestQueue()->RemoveRequestsFrom(mpClient);
-		mpClient->ConnectionClosed();
-		mpClientMgr->RemoveClient(mpClient);
-		delete mpClient;
-		mpClient = NULL;
-	}
+	// the scheduler cancels the transaction in flight and drops the client
+	if (mChannel) mpReactor->CloseChannel(mChannel);
 
 	delete mpConnection;
 }
 
 bool XMLConnection::Init()
 {
-	mpClient = mpClientMgr->AddClient(mpConnection);
-	if (!mpClient)
-	{
-		Error("Unable to create client, server overloaded");
-		return false;
-	}
-	mpClient->AddListener(this);
-
+	// the client is created by the scheduler, a rejection arrives as ChannelRejected
+	mChannel = mpReactor->OpenChannel(this, 0);
 	return true;
 }
 
@@ -171,12 +146,12 @@ void XMLConnection::HandleEvent(int flags)
 	}
 }
 
-void XMLConnection::SendResponse(const char* buffer, size_t length)
+void XMLConnection::SendResponse(std::string& data)
 {
-	xmllog.Log(5) << "XML reponse: " << endl << string(buffer, length) << endl;
+	if (xmllog.GetLogLevel() >= 5) xmllog.Log(5) << "XML reponse: " << endl << data << endl;
 
-	mSendBuffer.Fill((void*)buffer, length);
-	mSendBuffer.Fill((void*)"\0", 1);
+	mSendBuffer.Take(data);
+	mSendBuffer.Borrow("", 1); // null terminator of the packet
 	mpConnection->SetSelectMask(NET_WRITE_FLAG | NET_READ_FLAG | NET_EXCEPTION_FLAG);
 }
 
@@ -192,21 +167,32 @@ Net::Socket* XMLConnection::GetSocket()
 
 bool XMLConnection::IsAlive()
 {
-	if (mValidPackets == 0 && mLifeTimer.elapsed() > mShortTimeout) return false;
-	if (mLifeTimer.elapsed() > mTimeout) return false;
-	return true;
+	return TimeLeft() > 0;
 }
 
-bool XMLConnection::Shutdown()
+double XMLConnection::TimeLeft()
+{
+	double timeout = mTimeout;
+	if (mValidPackets == 0 && mShortTimeout < timeout) timeout = mShortTimeout;
+	return timeout - mLifeTimer.elapsed();
+}
+
+void XMLConnection::TimerExpired()
 {
-	if (mpCurrentRequest)
+	// the life timer is restarted on every valid packet, only check it when the deadline passes
+	double left = TimeLeft();
+	if (left > 0)
 	{
-		syserr << "A transaction was canceled mid flight (Shutdown)" << endl;
-		mpCurrentRequest->ClientGone();
-		mpCurrentRequest = NULL;
+		mpTimers->Schedule(this, left);
+		return;
 	}
 
-	if (mpClient) mpClient->ConnectionClosed();
+	syserr << timestamp << "Dead handler: kicking" << endl;
+	Shutdown(); // this will delete us
+}
+
+bool XMLConnection::Shutdown()
+{
 	mpConnection->Disconnect();
 	mpServer->RemoveConnection(this); // this will delete us
 	return true;
@@ -217,10 +203,11 @@ void XMLConnection::Error(std::string error)
 	std::stringstream out;
 	xmlprotocol::XmlProducer::ProduceError(out, error);
 
-	xmllog.Log(5) << timestamp << "XML Error reponse: " << endl << out.str() << endl;
+	std::string response = out.str();
+	xmllog.Log(5) << timestamp << "XML Error reponse: " << endl << response << endl;
 
-	mSendBuffer.Fill((void*)out.str().c_str(), out.str().size());
-	mSendBuffer.Fill((void*)"\0", 1);
+	mSendBuffer.Take(response);
+	mSendBuffer.Borrow("", 1); // null terminator of the packet
 	mState = eClosing;
 	mpConnection->SetSelectMask(NET_WRITE_FLAG | NET_READ_FLAG | NET_EXCEPTION_FLAG);
 }
@@ -229,27 +216,29 @@ void XMLConnection::ParseRequest()
 {
 	char* buffer = (char*) mReceiveBuffer.GetBuffer();
 	size_t length = mReceiveBuffer.GetSize();
-	while(mCurrentPos < length)
-	{
-		if (buffer[mCurrentPos] == '\0')
-		{
-			if (!HandlePacket(buffer, mCurrentPos))
-			{
-				mState = eClosing;
-			}
-			else
-			{
-				mValidPackets++;
-				mLifeTimer.restart();
-			}
+	if (mCurrentPos >= length) return;
 
-			mReceiveBuffer.EraseFront(mCurrentPos+1);
-			mCurrentPos = 0;
-			return;
-		}
+	// packets are null terminated, handled in place in the receive buffer
+	char* pEnd = (char*) memchr(buffer + mCurrentPos, '\0', length - mCurrentPos);
+	if (!pEnd)
+	{
+		mCurrentPos = length;
+		return;
+	}
 
-		mCurrentPos++;
+	mCurrentPos = pEnd - buffer;
+	if (!HandlePacket(buffer, mCurrentPos))
+	{
+		mState = eClosing;
+	}
+	else
+	{
+		mValidPackets++;
+		mLifeTimer.restart();
 	}
+
+	mReceiveBuffer.EraseFront(mCurrentPos+1);
+	mCurrentPos = 0;
 }
 
 void XMLConnection::Close(bool forceful)
@@ -308,56 +297,27 @@ bool XMLConnection::HandlePacket(const char* pData, size_t length)
 		return false;
 	}
 
-	pTransaction->SetIssuer(this);
-	pTransaction->SetOwner(mpClient);
-
-	// hand over ownership to the handler
-	mpCurrentRequest = mpSrvProtSrvc->ProcessTransaction(pTransaction, mpClient);
-	if (mpCurrentRequest == NULL) return false;
-	
-	return true;	
+	// hand over ownership to the scheduler thread
+	mpReactor->Submit(mChannel, pTransaction);
+	return true;
 }
 
-void XMLConnection::TransactionComplete(protocol::Transaction* pTransaction)
+void XMLConnection::ChannelResponse(std::string& response)
 {
-	mpCurrentRequest = NULL;
-
-	Session* pSession = NULL;
-	InstrumentBlock* pBlock = NULL;
-
-	if (mpClient) pSession = mpClient->GetSession();
-	if (pSession) pBlock = pSession->GetBlock();	
-	
-	std::stringstream out;
-	xmlprotocol::XmlProducer::TransactionResponse(pTransaction, pBlock, out, mpSrvProtSrvc);
-
-	protocol::TransactionErrorType errtype = pTransaction->GetErrorState();
-	if (errtype != protocol::NoError)
-	{
-		Error(pTransaction->GetError());
-		return;
-	}
-
-	SendResponse(out.str().c_str(), out.str().size());
+	SendResponse(response);
 }
 
-void XMLConnection::TransactionError(protocol::Transaction* pTransaction, const char* msg, protocol::TransactionErrorType type)
+void XMLConnection::ChannelError(const std::string& msg)
 {
-	mpCurrentRequest = NULL;
 	Error(msg);
 }
 
-
-void XMLConnection::SessionDestroyed()
+void XMLConnection::ChannelSessionGone()
 {
-	syserr << "Session is destroyed while client is connected!" << endl;
-
-	if (mpCurrentRequest)
-	{
-		// Cancel the request by pretending that the client has disconnected
-		mpCurrentRequest->ClientGone();
-		mpCurrentRequest = NULL;
-	}
-
 	Error("Your session has timed out because of inactivity");
+}
+
+void XMLConnection::ChannelRejected(const std::string& msg)
+{
+	Error(msg);
 }
\ No newline at end of file
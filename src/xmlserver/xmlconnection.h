@@ -29,10 +29,11 @@
 #define __XML_CONNECTION_H__
 
 #include <network/sockethandler.h>
+#include <network/timerqueue.h>
 #include <network/iobuffer.h>
 #include <util/timer.h>
 
-#include <measureserver/client.h>
+#include <measureserver/reactor.h>
 
 #include <protocol/protocol.h>
 
@@ -48,13 +49,9 @@ namespace protocol
 	class Transaction;
 }
 
-class ServerProtocolService;
 class XMLServer;
-class ServerProtocolService;
-class TransactionRequest;
-class ClientManager;
 
-class XMLConnection : public Net::SocketHandler, public protocol::TransactionIssuer, public IClientEventListener
+class XMLConnection : public Net::SocketHandler, public Net::TimerHandler, public ChannelEndpoint
 {
 public:
 	virtual void	HandleEvent(int flags);
@@ -62,30 +59,33 @@ public:
 	virtual bool	IsAlive();
 	virtual bool	Shutdown();
 
-	virtual void TransactionComplete(protocol::Transaction* pTransaction);
-	virtual void TransactionError(protocol::Transaction* pTransaction, const char* msg, protocol::TransactionErrorType type);
+	virtual void	TimerExpired();
 
-	virtual void SessionDestroyed();
+	virtual void	ChannelResponse(std::string& response);
+	virtual void	ChannelError(const std::string& msg);
+	virtual void	ChannelSessionGone();
+	virtual void	ChannelRejected(const std::string& msg);
 
 	bool	Init();
 
-	XMLConnection(Net::Connection* pConnection, XMLServer* pServer, ServerProtocolService* pSrvProtSrvc, ClientManager* pClientMgr, double shorttimeout, double timeout);
+	XMLConnection(Net::Connection* pConnection, XMLServer* pServer, Reactor* pReactor, double shorttimeout, double timeout);
 	virtual ~XMLConnection();
 private:
-	void SendResponse(const char* data, size_t length);
+	/// Queue a response, the data is taken over without copying
+	void SendResponse(std::string& data);
 	void SendError(std::string msg);
 	void Close(bool forceful);
 
 	void Error(std::string);
 	void ParseRequest();
+	double TimeLeft();
 
 	Net::Connection*	mpConnection;
 	XMLServer*			mpServer;
-	Client*				mpClient;
-	ServerProtocolService* mpSrvProtSrvc;
+	Net::TimerQueue*	mpTimers;
+	Reactor*			mpReactor;
+	unsigned int		mChannel;
 	timer				mLifeTimer;
-	TransactionRequest*		mpCurrentRequest;
-	ClientManager*		mpClientMgr;
 
 	double mShortTimeout;
 	double mTimeout;
@@ -64,7 +64,7 @@ void InitXMLLog(Config* pConfig)
 class XMLServerHandler : public Net::SocketHandler
 {
 public:
-	bool	ListenOn(int port);
+	bool	ListenOn(int port, bool shared);
 
 	virtual void			HandleEvent(int flags);
 
@@ -92,9 +92,9 @@ XMLServerHandler::~XMLServerHandler()
 	delete mpServerSocket;
 }
 
-bool XMLServerHandler::ListenOn(int port)
+bool XMLServerHandler::ListenOn(int port, bool shared)
 {
-	if (!mpServerSocket->StartServer(port, 100)) return false;
+	if (!mpServerSocket->StartServer(port, 100, shared)) return false;
 	return true;
 }
 
@@ -106,12 +106,11 @@ void XMLServerHandler::HandleEvent(int flags)
 
 ///////////////////
 
-XMLServer::XMLServer(Net::Multiplexer* pServer, ServerProtocolService* pSrvProtSrvc, ClientManager* pClientMgr)
+XMLServer::XMLServer(Reactor* pReactor)
 {
 	mpServerHandler = new XMLServerHandler(this);
-	mpServer	= pServer;
-	mpSrvProtSrvc = pSrvProtSrvc;
-	mpClientMgr = pClientMgr;
+	mpServer	= pReactor->GetMultiplexer();
+	mpReactor	= pReactor;
 }
 
 XMLServer::~XMLServer()
@@ -126,9 +125,9 @@ XMLServer::~XMLServer()
 	delete mpServerHandler;
 }
 
-bool XMLServer::Init(int port, Config* pConfig)
+bool XMLServer::Init(int port, Config* pConfig, bool shared)
 {
-	if (!mpServerHandler->ListenOn(port))
+	if (!mpServerHandler->ListenOn(port, shared))
 	{
 		return false;
 	}
@@ -146,7 +145,7 @@ void XMLServer::AddConnection(Net::Connection* pConnection)
 
 	sysout << timestamp << "XMLServer connection from: " << pConnection->GetPeerIPAsString() << endl;
 
-	XMLConnection* pXMLCon = new XMLConnection(pConnection, this, mpSrvProtSrvc, mpClientMgr, 30.0, 600.0);
+	XMLConnection* pXMLCon = new XMLConnection(pConnection, this, mpReactor, 30.0, 600.0);
 	if (pXMLCon->Init())
 	{
 		mConnections.push_back(pXMLCon);
@@ -39,20 +39,21 @@ namespace Net
 }
 
 class XMLServerHandler;
-class RequestQueue;
 class Config;
+class Reactor;
 
 extern LogModule	xmllog;
 
 class XMLServer
 {
 public:
-	bool Init(int port, Config* pConfig);
+	///	shared: other reactors listen on the same port
+	bool Init(int port, Config* pConfig, bool shared = false);
 
 	void AddConnection(Net::Connection* pConnection);
 	void RemoveConnection(XMLConnection* pHTTPCon);
 
-	XMLServer(Net::Multiplexer* pServer, ServerProtocolService* pSrvProtSrvc, ClientManager* pClientMgr);
+	XMLServer(Reactor* pReactor);
 	virtual ~XMLServer();
 private:
 	XMLServerHandler* mpServerHandler;
@@ -60,8 +61,7 @@ private:
 	typedef std::list<XMLConnection*> tConnections;
 	tConnections			mConnections;
 	Net::Multiplexer*		mpServer;
-	ServerProtocolService*	mpSrvProtSrvc;
-	ClientManager*			mpClientMgr;
+	Reactor*				mpReactor;
 };
 
 #endif